@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+// Where this instance's window goes, in world space
+layout (location = 2) in vec3 instanceOffset;
+
+out vec2 TexCoords;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+  TexCoords = aTexCoords;
+  gl_Position = projection * view * vec4(aPos + instanceOffset, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+flat in int Grass;
+in float ViewDepth;
+
+uniform sampler2D windowTexture;
+uniform sampler2D grassTexture;
+
+void main()
+{
+  // Both are fetched so the mip selection stays in uniform control flow
+  vec4 color = mix(texture(windowTexture, TexCoords),
+                   texture(grassTexture, TexCoords), float(Grass));
+  if (color.a < 0.1)
+    discard;
+  FragColor = color;
+}
@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+// Where this instance goes, in world space, and which texture it uses:
+// 0 for a window, 1 for grass
+layout (location = 2) in vec4 instance;
+
+out vec2 TexCoords;
+flat out int Grass;
+// Distance in front of the camera, for weighting
+out float ViewDepth;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+  TexCoords = aTexCoords;
+  Grass = int(instance.w);
+  vec4 position = view * vec4(aPos + instance.xyz, 1.0);
+  ViewDepth = -position.z;
+  gl_Position = projection * position;
+}
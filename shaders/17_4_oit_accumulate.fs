@@ -0,0 +1,30 @@
+#version 330 core
+// Premultiplied color and alpha, weighted
+layout (location = 0) out vec4 Accumulation;
+// Alpha, for the revealage target to multiply by (1 - alpha)
+layout (location = 1) out float Revealage;
+
+in vec2 TexCoords;
+flat in int Grass;
+in float ViewDepth;
+
+uniform sampler2D windowTexture;
+uniform sampler2D grassTexture;
+
+void main()
+{
+  vec4 color = mix(texture(windowTexture, TexCoords),
+                   texture(grassTexture, TexCoords), float(Grass));
+  if (color.a < 0.1)
+    discard;
+
+  // Equation 9 of McGuire and Bavoil: nearer and more opaque surfaces
+  // dominate the average. Tuned for depths of up to a few hundred units;
+  // the clamp keeps the 16-bit float sums in range.
+  float weight = color.a * clamp(
+      10.0 / (1e-5 + pow(ViewDepth / 5.0, 2.0) +
+              pow(ViewDepth / 200.0, 6.0)),
+      1e-2, 3e3);
+  Accumulation = vec4(color.rgb * color.a, color.a) * weight;
+  Revealage = color.a;
+}
@@ -0,0 +1,22 @@
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D accumulation;
+uniform sampler2D revealage;
+
+void main()
+{
+  ivec2 texel = ivec2(gl_FragCoord.xy);
+  float revealed = texelFetch(revealage, texel, 0).r;
+  // No transparent surface here; leave the opaque scene alone
+  if (revealed == 1.0)
+    discard;
+
+  vec4 sum = texelFetch(accumulation, texel, 0);
+  // Guard against overflow of the half float sums
+  if (isinf(max(max(abs(sum.r), abs(sum.g)), abs(sum.b))))
+    sum.rgb = vec3(sum.a);
+  vec3 average = sum.rgb / max(sum.a, 1e-5);
+  // Blended with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+  FragColor = vec4(average, 1.0 - revealed);
+}
@@ -0,0 +1,15 @@
+#version 420 core
+// The depth prepass decided coverage, so nothing is discarded here and
+// hidden fragments are rejected before shading
+layout (early_fragment_tests) in;
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D texture1;
+
+void main()
+{
+  FragColor = vec4(texture(texture1, TexCoords).rgb, 1.0);
+}
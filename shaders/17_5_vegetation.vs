@@ -0,0 +1,34 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+// x, z, yaw, scale of the card
+layout (location = 2) in vec4 card;
+
+out vec2 TexCoords;
+
+// The depth prepass and the color pass must compute the same depths for
+// the color pass's GL_EQUAL test
+invariant gl_Position;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float groundHeight;
+uniform vec3 cameraPosition;
+// Cards shrink into the ground between these distances
+uniform float fadeStart;
+uniform float fadeEnd;
+
+void main()
+{
+  vec3 base = vec3(card.x, groundHeight, card.y);
+  float fade =
+      1.0 - smoothstep(fadeStart, fadeEnd, distance(base, cameraPosition));
+  vec3 local = aPos * card.w;
+  local.y *= fade;
+  float s = sin(card.z);
+  float c = cos(card.z);
+  vec3 world = base + vec3(c * local.x + s * local.z, local.y,
+                           c * local.z - s * local.x);
+  TexCoords = aTexCoords;
+  gl_Position = projection * view * vec4(world, 1.0);
+}
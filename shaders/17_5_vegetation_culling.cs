@@ -0,0 +1,82 @@
+#version 430 core
+layout (local_size_x = 64) in;
+
+struct DrawArraysIndirectCommand
+{
+  uint count;
+  uint instanceCount;
+  uint first;
+  uint baseInstance;
+};
+
+// Per card: x, z, yaw, scale
+layout (std430, binding = 0) readonly buffer Cards
+{
+  vec4 cards[];
+};
+
+layout (std430, binding = 1) writeonly buffer VisibleCards
+{
+  vec4 visibleCards[];
+};
+
+layout (std430, binding = 2) buffer DrawCommand
+{
+  DrawArraysIndirectCommand command;
+};
+
+// Inward facing (normal, distance) planes
+uniform vec4 frustumPlanes[6];
+uniform uint cardCount;
+uniform float groundHeight;
+uniform vec3 cameraPosition;
+// Cards this far away have shrunk into the ground
+uniform float fadeEnd;
+
+// The group's survivors are counted here first, so the shared command
+// takes one atomic per group instead of one per card
+shared uint groupCount;
+shared uint groupFirst;
+
+bool Visible(vec4 card)
+{
+  vec3 base = vec3(card.x, groundHeight, card.y);
+  if (distance(base, cameraPosition) >= fadeEnd) {
+    return false;
+  }
+  // A unit card's corners lie within sqrt(0.5) of its middle
+  vec3 center = base + vec3(0.0, 0.5 * card.w, 0.0);
+  float radius = 0.71 * card.w;
+  for (int i = 0; i < 6; i++) {
+    if (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void main()
+{
+  if (gl_LocalInvocationIndex == 0u) {
+    groupCount = 0u;
+  }
+  barrier();
+
+  uint index = gl_GlobalInvocationID.x;
+  vec4 card = index < cardCount ? cards[index] : vec4(0.0);
+  bool visible = index < cardCount && Visible(card);
+  uint slot = 0u;
+  if (visible) {
+    slot = atomicAdd(groupCount, 1u);
+  }
+  barrier();
+
+  if (gl_LocalInvocationIndex == 0u) {
+    groupFirst = atomicAdd(command.instanceCount, groupCount);
+  }
+  barrier();
+
+  if (visible) {
+    visibleCards[groupFirst + slot] = card;
+  }
+}
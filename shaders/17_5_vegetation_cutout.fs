@@ -0,0 +1,24 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D texture1;
+// Discard below half alpha; otherwise GL_SAMPLE_ALPHA_TO_COVERAGE turns
+// the alpha into a sample mask
+uniform bool alphaTest;
+
+void main()
+{
+  vec4 color = texture(texture1, TexCoords);
+  if (alphaTest) {
+    if (color.a < 0.5)
+      discard;
+  } else {
+    // Sharpen the edge to about a pixel wide, so coverage antialiases it
+    // instead of dithering a blurry band across the card
+    color.a = clamp((color.a - 0.5) / max(fwidth(color.a), 1e-4) + 0.5,
+                    0.0, 1.0);
+  }
+  FragColor = color;
+}
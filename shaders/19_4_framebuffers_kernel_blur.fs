@@ -5,21 +5,21 @@ in vec2 TexCoords;
 
 uniform sampler2D screenTexture;
 
-float offset = 1.0 / 300.0;
-
 void main()
 {
-  // NOTE: offsets is a constant value that we can customize to our liking.
+  // One texel apart, whatever the resolution. See 19_7 for a blur of any
+  // radius that costs linearly in it.
+  vec2 offset = 1.0 / vec2(textureSize(screenTexture, 0));
   vec2 offsets[9] = vec2[](
-      vec2(-offset, offset),  // top-left
-      vec2(0.0f, offset),     // top-center
-      vec2(offset, offset),   // top-right
-      vec2(-offset, 0.0),     // center-left
-      vec2(0.0, 0.0),         // center-center
-      vec2(offset, 0.0),      // center-right
-      vec2(-offset, -offset), // bottom-left
-      vec2(0.0, -offset),     // bottom-center
-      vec2(offset, -offset)   // bottom-right
+      vec2(-offset.x, offset.y),  // top-left
+      vec2(0.0f, offset.y),       // top-center
+      vec2(offset.x, offset.y),   // top-right
+      vec2(-offset.x, 0.0),       // center-left
+      vec2(0.0, 0.0),             // center-center
+      vec2(offset.x, 0.0),        // center-right
+      vec2(-offset.x, -offset.y), // bottom-left
+      vec2(0.0, -offset.y),       // bottom-center
+      vec2(offset.x, -offset.y)   // bottom-right
       );
 
   // A blur kernel. Because the values add up to 16 and colors are additive (we
@@ -0,0 +1,4 @@
+// Post effect body, PIXEL: see PostEffect in src/post_process.hpp
+// The human eye is more sensitive to green and least to blue
+float average = 0.2126 * color.r + 0.7152 * color.g + 0.0722 * color.b;
+return vec4(vec3(average), color.a);
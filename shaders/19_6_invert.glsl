@@ -0,0 +1,2 @@
+// Post effect body, PIXEL: see PostEffect in src/post_process.hpp
+return vec4(vec3(1.0 - color.rgb), color.a);
@@ -0,0 +1,11 @@
+// Post effect body, NEIGHBORHOOD: see PostEffect in src/post_process.hpp
+// The sharpen kernel of 19_3, one pixel apart whatever the resolution
+vec4 color = Input(uv) * 9.0;
+for (int y = -1; y <= 1; y++) {
+  for (int x = -1; x <= 1; x++) {
+    if (x != 0 || y != 0) {
+      color -= Input(uv + vec2(x, y) * texelSize);
+    }
+  }
+}
+return vec4(color.rgb, 1.0);
@@ -0,0 +1,3 @@
+// Post effect body, PIXEL: see PostEffect in src/post_process.hpp
+// Exposure tone mapping of the half float scene to [0, 1]
+return vec4(vec3(1.0) - exp(-color.rgb * exposure), color.a);
@@ -0,0 +1,5 @@
+// Post effect body, PIXEL: see PostEffect in src/post_process.hpp
+// Darken towards the corners
+vec2 centered = uv - 0.5;
+float falloff = smoothstep(0.8, 0.3, length(centered) * vignetteStrength);
+return vec4(color.rgb * falloff, color.a);
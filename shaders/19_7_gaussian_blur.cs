@@ -0,0 +1,46 @@
+#version 430 core
+// Matches kWorkGroupSize and kMaxBlurRadius in src/gaussian_blur.hpp
+#define GROUP_SIZE 128
+#define MAX_RADIUS 64
+layout (local_size_x = GROUP_SIZE) in;
+
+uniform sampler2D source;
+layout (rgba16f, binding = 0) writeonly uniform image2D target;
+
+uniform int radius;
+// Weights of the texel at each distance from the center, 0 to radius
+uniform float weights[MAX_RADIUS + 1];
+// (1, 0) to blur along rows, (0, 1) along columns
+uniform ivec2 direction;
+
+// A group's stretch of a row or column and the radius of texels on either
+// side, fetched once and read by every invocation it is in reach of
+shared vec4 tile[GROUP_SIZE + 2 * MAX_RADIUS];
+
+void main()
+{
+  ivec2 size = textureSize(source, 0);
+  int lineLength = direction.x == 1 ? size.x : size.y;
+  ivec2 across = ivec2(1) - direction;
+  int line = int(gl_WorkGroupID.y);
+  int first = int(gl_WorkGroupID.x) * GROUP_SIZE - radius;
+
+  // The edges repeat outwards
+  int tileSize = GROUP_SIZE + 2 * radius;
+  for (int i = int(gl_LocalInvocationID.x); i < tileSize; i += GROUP_SIZE) {
+    int along = clamp(first + i, 0, lineLength - 1);
+    tile[i] = texelFetch(source, direction * along + across * line, 0);
+  }
+  barrier();
+
+  int along = int(gl_GlobalInvocationID.x);
+  if (along >= lineLength) {
+    return;
+  }
+  int center = int(gl_LocalInvocationID.x) + radius;
+  vec4 color = tile[center] * weights[0];
+  for (int i = 1; i <= radius; i++) {
+    color += (tile[center - i] + tile[center + i]) * weights[i];
+  }
+  imageStore(target, direction * along + across * line, color);
+}
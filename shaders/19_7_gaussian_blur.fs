@@ -0,0 +1,28 @@
+#version 330 core
+// Matches kMaxBlurTaps in src/gaussian_blur.hpp
+#define MAX_TAPS 33
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+
+// One texel along the blur, in texture coordinates
+uniform vec2 direction;
+// The center tap, then taps mirrored on either side. Every tap but the
+// center lands between two texels, so one bilinear fetch reads both
+// weighted together.
+uniform int tapCount;
+uniform float tapOffsets[MAX_TAPS];
+uniform float tapWeights[MAX_TAPS];
+
+void main()
+{
+  vec4 color = texture(source, TexCoords) * tapWeights[0];
+  for (int i = 1; i < tapCount; i++) {
+    vec2 offset = direction * tapOffsets[i];
+    color += (texture(source, TexCoords - offset) +
+              texture(source, TexCoords + offset)) * tapWeights[i];
+  }
+  FragColor = color;
+}
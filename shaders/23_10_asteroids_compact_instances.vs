@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoords;
+// The instance transform takes two attributes instead of a mat4's four:
+// position and uniform scale, then a unit quaternion (x, y, z, w).
+layout (location = 3) in vec4 instancePositionScale;
+layout (location = 4) in vec4 instanceRotation;
+
+out vec2 TexCoords;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+vec3 Rotate(vec4 q, vec3 v) {
+    vec3 t = 2.0 * cross(q.xyz, v);
+    return v + q.w * t + cross(q.xyz, t);
+}
+
+void main() {
+    TexCoords = aTexCoords;
+    vec3 position = Rotate(instanceRotation, aPos * instancePositionScale.w) +
+                    instancePositionScale.xyz;
+    gl_Position = projection * view * vec4(position, 1.0f);
+}
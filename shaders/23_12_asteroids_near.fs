@@ -0,0 +1,29 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec3 Normal;
+flat in float Fade;
+
+uniform sampler2D texture1;
+uniform vec3 lightDirection;
+
+// A 4x4 ordered dither threshold in (0, 1) for this pixel
+float Dither() {
+  const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0,
+                                  3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+  ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+  return (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+}
+
+void main()
+{
+  // Screen-door cross-fade: the impostor fills exactly the pixels dropped
+  // here, so the transition needs no blending or sorting
+  if (Dither() < Fade) {
+    discard;
+  }
+  float diffuse = max(dot(normalize(Normal), -lightDirection), 0.0);
+  FragColor = vec4(texture(texture1, TexCoords).rgb * (0.3 + 0.7 * diffuse),
+                   1.0);
+}
@@ -0,0 +1,32 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec4 instancePositionScale;
+layout (location = 4) in vec4 instanceRotation;
+
+out vec2 TexCoords;
+out vec3 Normal;
+// 0 up to impostorDistance, rising to 1 across the fade band
+flat out float Fade;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform vec3 cameraPosition;
+uniform float impostorDistance;
+uniform float fadeBand;
+
+vec3 Rotate(vec4 q, vec3 v) {
+    vec3 t = 2.0 * cross(q.xyz, v);
+    return v + q.w * t + cross(q.xyz, t);
+}
+
+void main() {
+    TexCoords = aTexCoords;
+    Normal = Rotate(instanceRotation, aNormal);
+    Fade = clamp((distance(cameraPosition, instancePositionScale.xyz) -
+                  impostorDistance) / fadeBand, 0.0, 1.0);
+    vec3 position = Rotate(instanceRotation, aPos * instancePositionScale.w) +
+                    instancePositionScale.xyz;
+    gl_Position = projection * view * vec4(position, 1.0f);
+}
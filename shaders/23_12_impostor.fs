@@ -0,0 +1,52 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 AtlasCoords;
+in vec3 WorldPosition;
+flat in vec4 Rotation;
+flat in vec3 FrameDirection;
+flat in float Radius;
+flat in float Fade;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform vec3 lightDirection;
+uniform sampler2D impostorAlbedo;
+uniform sampler2D impostorNormalDepth;
+
+vec3 Rotate(vec4 q, vec3 v) {
+  vec3 t = 2.0 * cross(q.xyz, v);
+  return v + q.w * t + cross(q.xyz, t);
+}
+
+// Same pattern as shaders/23_12_asteroids_near.fs
+float Dither() {
+  const float bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0,
+                                  3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+  ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+  return (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+}
+
+void main()
+{
+  // The pixels the mesh keeps in the fade band
+  if (Dither() >= Fade) {
+    discard;
+  }
+  vec4 albedo = texture(impostorAlbedo, AtlasCoords);
+  if (albedo.a < 0.5) {
+    discard;
+  }
+  vec4 normal_depth = texture(impostorNormalDepth, AtlasCoords);
+
+  // Depth 0 is the front of the bounding sphere, 1 the back; moving the
+  // pixel there lets impostors intersect each other and the meshes
+  vec3 position =
+      WorldPosition + FrameDirection * (1.0 - 2.0 * normal_depth.w) * Radius;
+  vec4 clip = projection * view * vec4(position, 1.0);
+  gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+  vec3 normal = normalize(Rotate(Rotation, normal_depth.xyz * 2.0 - 1.0));
+  float diffuse = max(dot(normal, -lightDirection), 0.0);
+  FragColor = vec4(albedo.rgb * (0.3 + 0.7 * diffuse), 1.0);
+}
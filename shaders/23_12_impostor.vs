@@ -0,0 +1,81 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+layout (location = 3) in vec4 instancePositionScale;
+layout (location = 4) in vec4 instanceRotation;
+
+out vec2 AtlasCoords;
+out vec3 WorldPosition;
+flat out vec4 Rotation;
+// World space direction the frame was baked from, towards the viewer
+flat out vec3 FrameDirection;
+flat out float Radius;
+flat out float Fade;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform vec3 cameraPosition;
+uniform float impostorDistance;
+uniform float fadeBand;
+// Set by ImpostorAtlas::Draw()
+uniform vec4 boundingSphere;
+uniform int framesPerSide;
+
+vec3 Rotate(vec4 q, vec3 v) {
+    vec3 t = 2.0 * cross(q.xyz, v);
+    return v + q.w * t + cross(q.xyz, t);
+}
+
+vec2 SignNotZero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Octahedral map of the unit sphere onto [0, 1]^2 with +y at the center and
+// -y folded out to the corners. Must match the bake in impostor.cpp.
+vec2 OctahedronEncode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 p = n.xz;
+    if (n.y < 0.0) {
+        p = (1.0 - abs(p.yx)) * SignNotZero(p);
+    }
+    return p * 0.5 + 0.5;
+}
+
+vec3 OctahedronDecode(vec2 uv) {
+    vec2 p = uv * 2.0 - 1.0;
+    vec3 n = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+    if (n.y < 0.0) {
+        n.xz = (1.0 - abs(n.zx)) * SignNotZero(n.xz);
+    }
+    return normalize(n);
+}
+
+void main() {
+    float scale = instancePositionScale.w;
+    vec3 center = instancePositionScale.xyz +
+                  Rotate(instanceRotation, boundingSphere.xyz * scale);
+    Radius = boundingSphere.w * scale;
+
+    // The baked view closest to the camera's, in model space
+    vec4 inverse_rotation = vec4(-instanceRotation.xyz, instanceRotation.w);
+    vec3 to_camera =
+        Rotate(inverse_rotation, normalize(cameraPosition - center));
+    float frames = float(framesPerSide);
+    vec2 frame = min(floor(OctahedronEncode(to_camera) * frames), frames - 1.0);
+    vec3 direction = OctahedronDecode((frame + 0.5) / frames);
+
+    // The quad lies in the frame's image plane, with the basis of the
+    // lookAt() camera it was baked with
+    vec3 up_hint = abs(direction.y) > 0.999 ? vec3(0.0, 0.0, 1.0)
+                                            : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up_hint, direction));
+    vec3 up = cross(direction, right);
+    WorldPosition = center + Rotate(instanceRotation,
+                                    right * aCorner.x + up * aCorner.y) *
+                                 Radius;
+    AtlasCoords = (frame + aCorner * 0.5 + 0.5) / frames;
+    Rotation = instanceRotation;
+    FrameDirection = Rotate(instanceRotation, direction);
+    Fade = clamp((distance(cameraPosition, instancePositionScale.xyz) -
+                  impostorDistance) / fadeBand, 0.0, 1.0);
+    gl_Position = projection * view * vec4(WorldPosition, 1.0f);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) out vec4 Albedo;
+layout (location = 1) out vec4 NormalDepth;
+
+in vec2 TexCoords;
+in vec3 Normal;
+
+uniform sampler2D texture_diffuse1;
+
+void main()
+{
+  // Alpha marks the texels the model covers
+  Albedo = vec4(texture(texture_diffuse1, TexCoords).rgb, 1.0f);
+  // The orthographic depth runs linearly across the bounding sphere
+  NormalDepth = vec4(normalize(Normal) * 0.5f + 0.5f, gl_FragCoord.z);
+}
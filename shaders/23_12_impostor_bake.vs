@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+// The model is baked in its own space; the impostor rotates the normals
+void main() {
+    TexCoords = aTexCoords;
+    Normal = aNormal;
+    gl_Position = projection * view * vec4(aPos, 1.0f);
+}
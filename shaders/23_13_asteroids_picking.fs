@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+flat in int Picked;
+
+uniform sampler2D texture1;
+
+void main()
+{
+  vec4 color = texture(texture1, TexCoords);
+  // Tint the picked rock
+  if (Picked != 0) {
+    color.rgb = mix(color.rgb, vec3(1.0, 0.6, 0.1), 0.6);
+  }
+  FragColor = color;
+}
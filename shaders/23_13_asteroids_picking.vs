@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec4 instancePositionScale;
+layout (location = 4) in vec4 instanceRotation;
+
+out vec2 TexCoords;
+flat out int Picked;
+
+uniform mat4 projection;
+uniform mat4 view;
+// Instance under the cursor, -1 for none
+uniform int pickedInstance;
+
+vec3 Rotate(vec4 q, vec3 v) {
+    vec3 t = 2.0 * cross(q.xyz, v);
+    return v + q.w * t + cross(q.xyz, t);
+}
+
+void main() {
+    TexCoords = aTexCoords;
+    Picked = gl_InstanceID == pickedInstance ? 1 : 0;
+    vec3 position = Rotate(instanceRotation, aPos * instancePositionScale.w) +
+                    instancePositionScale.xyz;
+    gl_Position = projection * view * vec4(position, 1.0f);
+}
@@ -0,0 +1,163 @@
+#version 430 core
+layout (local_size_x = 64) in;
+
+struct DrawElementsIndirectCommand
+{
+  uint count;
+  uint instanceCount;
+  uint firstIndex;
+  int baseVertex;
+  uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Instances
+{
+  mat4 instances[];
+};
+
+// The main phase appends to the first instanceCount entries, the retest
+// phase to the second
+layout (std430, binding = 1) writeonly buffer VisibleInstances
+{
+  mat4 visibleInstances[];
+};
+
+// commandCount commands per phase, one per mesh; they all draw the same
+// instances
+layout (std430, binding = 2) buffer DrawCommands
+{
+  DrawElementsIndirectCommand commands[];
+};
+
+// Per instance, 1 when the main phase found it occluded
+layout (std430, binding = 3) buffer OcclusionFlags
+{
+  uint occluded[];
+};
+
+// Inward facing (normal, distance) planes
+uniform vec4 frustumPlanes[6];
+// Model space (center, radius)
+uniform vec4 boundingSphere;
+uniform uint instanceCount;
+uniform uint commandCount;
+
+// 0 for the main phase, 1 to retest what the main phase found occluded
+uniform int phase;
+// Test against a Hi-Z pyramid of farthest depths
+uniform bool occlusionCulling;
+uniform sampler2D hiZ;
+uniform vec2 hiZSize;
+uniform int hiZLevels;
+// The matrix the pyramid's depth was rendered with
+uniform mat4 hiZViewProjection;
+
+// The group's survivors are counted here first, so every command takes one
+// atomic per group instead of one per instance
+shared uint groupCount;
+shared uint groupFirst;
+
+bool Occluded(vec3 center, float radius)
+{
+  // Screen rectangle and nearest depth of the sphere's bounding box
+  vec3 lowest = vec3(1.0);
+  vec3 highest = vec3(-1.0);
+  for (int i = 0; i < 8; i++) {
+    vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0 : -1.0,
+                                         (i & 2) != 0 ? 1.0 : -1.0,
+                                         (i & 4) != 0 ? 1.0 : -1.0);
+    vec4 clip = hiZViewProjection * vec4(corner, 1.0);
+    if (clip.w <= 0.0) {
+      // Reaches behind the camera
+      return false;
+    }
+    vec3 ndc = clip.xyz / clip.w;
+    lowest = i == 0 ? ndc : min(lowest, ndc);
+    highest = i == 0 ? ndc : max(highest, ndc);
+  }
+  vec2 uvMin = clamp(lowest.xy * 0.5 + 0.5, 0.0, 1.0);
+  vec2 uvMax = clamp(highest.xy * 0.5 + 0.5, 0.0, 1.0);
+  float nearest = lowest.z * 0.5 + 0.5;
+
+  // The pixels under the rectangle
+  ivec2 size = ivec2(hiZSize);
+  ivec2 pixelMin = min(ivec2(uvMin * hiZSize), size - 1);
+  ivec2 pixelMax = min(ivec2(uvMax * hiZSize), size - 1);
+
+  // The level at which the rectangle covers about 2 x 2 texels
+  vec2 extent = (uvMax - uvMin) * hiZSize;
+  int level = int(ceil(log2(max(max(extent.x, extent.y), 1.0))));
+  level = min(level, hiZLevels - 1);
+
+  // Every level halves the one below, rounding down, and folds an odd last
+  // row or column into its last texel. So the texel covering a pixel is the
+  // pixel shifted down by the level, clamped to the level's last texel;
+  // normalized coordinates would drift off the footprint on odd levels.
+  ivec2 levelSize = textureSize(hiZ, level);
+  ivec2 texelMin = min(pixelMin >> level, levelSize - 1);
+  ivec2 texelMax = min(pixelMax >> level, levelSize - 1);
+  float farthest = 0.0;
+  for (int y = texelMin.y; y <= texelMax.y; y++) {
+    for (int x = texelMin.x; x <= texelMax.x; x++) {
+      farthest = max(farthest, texelFetch(hiZ, ivec2(x, y), level).r);
+    }
+  }
+  return nearest > farthest;
+}
+
+// Whether the instance at `index`, read into `model`, is drawn in this
+// phase. The main phase records which instances it found occluded for the
+// retest.
+bool Visible(uint index, out mat4 model)
+{
+  if (phase == 1 && occluded[index] == 0u) {
+    return false;
+  }
+
+  model = instances[index];
+  vec3 center = (model * vec4(boundingSphere.xyz, 1.0)).xyz;
+  float scale = max(max(length(model[0].xyz), length(model[1].xyz)),
+                    length(model[2].xyz));
+  float radius = boundingSphere.w * scale;
+  for (int i = 0; i < 6; i++) {
+    if (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius) {
+      occluded[index] = 0u;
+      return false;
+    }
+  }
+  bool hidden = occlusionCulling && Occluded(center, radius);
+  if (phase == 0) {
+    occluded[index] = hidden ? 1u : 0u;
+  }
+  return !hidden;
+}
+
+void main()
+{
+  if (gl_LocalInvocationIndex == 0u) {
+    groupCount = 0u;
+  }
+  barrier();
+
+  uint index = gl_GlobalInvocationID.x;
+  mat4 model;
+  bool visible = index < instanceCount && Visible(index, model);
+  uint slot = 0u;
+  if (visible) {
+    slot = atomicAdd(groupCount, 1u);
+  }
+  barrier();
+
+  uint first = uint(phase) * commandCount;
+  if (gl_LocalInvocationIndex == 0u && groupCount > 0u) {
+    groupFirst = atomicAdd(commands[first].instanceCount, groupCount);
+    for (uint i = 1u; i < commandCount; i++) {
+      atomicAdd(commands[first + i].instanceCount, groupCount);
+    }
+  }
+  barrier();
+
+  if (visible) {
+    visibleInstances[uint(phase) * instanceCount + groupFirst + slot] = model;
+  }
+}
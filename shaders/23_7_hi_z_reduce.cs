@@ -0,0 +1,44 @@
+#version 430 core
+layout (local_size_x = 8, local_size_y = 8) in;
+
+uniform sampler2D depthTexture;
+layout (r32f, binding = 0) readonly uniform image2D sourceLevel;
+layout (r32f, binding = 1) writeonly uniform image2D targetLevel;
+
+// Level 0 copies the depth texture, every other level reduces the one below
+uniform bool fromDepth;
+uniform vec2 sourceSize;
+
+void main()
+{
+  ivec2 target = ivec2(gl_GlobalInvocationID.xy);
+  ivec2 targetSize = imageSize(targetLevel);
+  if (any(greaterThanEqual(target, targetSize))) {
+    return;
+  }
+  if (fromDepth) {
+    float depth = texelFetch(depthTexture, target, 0).r;
+    imageStore(targetLevel, target, vec4(depth));
+    return;
+  }
+
+  // Keep the farthest depth. An odd source size folds its last row or column
+  // into the last target texel so no source texel is skipped.
+  ivec2 size = ivec2(sourceSize);
+  ivec2 first = target * 2;
+  ivec2 last = first + 1;
+  if (target.x == targetSize.x - 1 && (size.x & 1) == 1) {
+    last.x++;
+  }
+  if (target.y == targetSize.y - 1 && (size.y & 1) == 1) {
+    last.y++;
+  }
+  last = min(last, size - 1);
+  float depth = 0.0;
+  for (int y = first.y; y <= last.y; y++) {
+    for (int x = first.x; x <= last.x; x++) {
+      depth = max(depth, imageLoad(sourceLevel, ivec2(x, y)).r);
+    }
+  }
+  imageStore(targetLevel, target, vec4(depth));
+}
@@ -0,0 +1,144 @@
+#version 330 core
+out vec4 FragColor;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec4 FragPosLightSpace;
+} fs_in;
+
+uniform sampler2D diffuseTexture;
+uniform sampler2D shadowMap;
+
+// Virtual texture, see virtual_texture.hpp
+uniform bool virtualTextured;
+uniform usampler2D pageTable;
+uniform sampler2D pageCache;
+uniform float virtualSize;
+uniform float pageSize;
+uniform float pageBorder;
+uniform float cacheSize;
+uniform int maxLevel;
+uniform float lodBias;
+
+uniform vec3 lightPosition;
+uniform vec3 viewPosition;
+
+float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 light_direction) {
+    // Transform the light-space fragment position in clip-space to normalized device coordinates.
+    // For gl_Position, OpenGL automatically does a perspective divide to ensure [-w, w] is in the
+    // range [-1, 1]. But we need to do this ourselves for the light space frag position.
+    vec3 projection_coordinates = fragPosLightSpace.xyz / fragPosLightSpace.w;
+
+    // The depth map is in the range [0, 1], so do this for the projection_coordinates also.
+    projection_coordinates = projection_coordinates * 0.5 + 0.5;
+
+    // Z-coordinate is the depth of this fragment from the light's position.
+    float current_depth = projection_coordinates.z;
+
+    // Shadow Acne!
+    // Because the shadow map is limited by resolution, multiple fragments sample the same value when far away
+    // from the light source. This becomes an issue when the lght source looks at an angle from the surface.
+    // Thus, some are "above" the surface, and some are "below" the surface. I.e. some considered to be in
+    // the shadow, some not. Why?
+    // Well, the shadow map is literally just a texture of depth, so you need to sample from some other
+    // neighboring 'ray' (i.e. value), which might be lower or higher, given the angle, to what is actually
+    // the surface.
+    //
+    // To solve, add a shadow bias.
+    //
+    // We COULD use some constant like 0.005 which would work, BUT the value is highly dependent on the angle
+    // between the light source and the surface. If there is a steep angle, we need a larger bias.
+    // A maximum bias of 0.05 and a minimum of 0.005. When the normal and light direction are perpendicular (i.e. light
+    // is travelling in the same direction as a surface vector), then use the maximum bias.
+    float bias = max(0.05 * (1.0 - dot(normal, light_direction)), 0.005);
+
+    // Percentage-Closer Filtering (PCF)!
+    // The shadows are quite blocky because our shadow map is pretty small and one texel usually spans more than one fragment.
+    // With PCF, we produce softer shadows by sampling more than once from the depth map, with different UV coordinates.
+    // We then combine the results.
+    float shadow = 0.0;
+    vec2 texel_size = 1.0 / textureSize(shadowMap, 0);
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            float pcf_depth = texture(shadowMap, projection_coordinates.xy + vec2(x, y) * texel_size).r;
+            shadow += current_depth - bias > pcf_depth ? 1.0 : 0.0;
+        }
+    }
+    shadow /= 9.0;
+
+    // Over-sampling!
+    // Keep the shadow at 0.0 when outside the far_plane region of the light's frustrum. Note that this means anything
+    // outside of the light frustrum will not have visible shadows. In games, usually made sure that this only occurs
+    // in the distance.
+    if (current_depth > 1.0) {
+        shadow = 0.0;
+    }
+
+    return shadow;
+}
+
+// The mip level of the virtual texture, from the screen space derivatives
+// of the texel coordinates like the hardware does for regular textures.
+float VirtualLevel(vec2 uv) {
+    vec2 texel = uv * virtualSize;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float rho_squared = max(dot(dx, dx), dot(dy, dy));
+    return clamp(0.5 * log2(rho_squared) + lodBias, 0.0, float(maxLevel));
+}
+
+// Bilinear sample of one virtual level. Pages that are not resident fall back
+// to the closest resident ancestor; the coarsest page always is.
+vec3 SampleVirtualLevel(vec2 uv, int level) {
+    vec2 texel = clamp(uv, 0.0, 1.0) * virtualSize;
+    ivec2 page = min(ivec2(texel / pageSize), ivec2(virtualSize / pageSize) - 1) >> level;
+    uvec4 entry = texelFetch(pageTable, page, level);
+    while (entry.a == 0u && level < maxLevel) {
+        level++;
+        page >>= 1;
+        entry = texelFetch(pageTable, page, level);
+    }
+
+    vec2 page_texel = texel / exp2(float(level)) - vec2(page) * pageSize;
+    vec2 cache_texel = vec2(entry.xy) * (pageSize + 2.0 * pageBorder) + pageBorder + page_texel;
+    return textureLod(pageCache, cache_texel / cacheSize, 0.0).rgb;
+}
+
+// Trilinear filtering by hand: the cache holds pages of every level side by
+// side, so hardware mip selection cannot be used.
+vec3 SampleVirtualTexture(vec2 uv) {
+    float level = VirtualLevel(uv);
+    int finer = int(floor(level));
+    vec3 finer_color = SampleVirtualLevel(uv, finer);
+    vec3 coarser_color = SampleVirtualLevel(uv, min(finer + 1, maxLevel));
+    return mix(finer_color, coarser_color, fract(level));
+}
+
+void main() {
+    vec3 color = virtualTextured ? SampleVirtualTexture(fs_in.TexCoords)
+                                 : texture(diffuseTexture, fs_in.TexCoords).rgb;
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 light_color = vec3(1.0);
+
+    // Blinn-Phong
+
+    // Ambient
+    vec3 ambient = 0.15 * light_color;
+    // Diffuse
+    vec3 light_direction = normalize(lightPosition - fs_in.FragPos);
+    float diff = max(dot(light_direction, normal), 0.0);
+    vec3 diffuse = diff * light_color;
+    // Specular
+    vec3 view_direction = normalize(viewPosition - fs_in.FragPos);
+    float spec = 0.0;
+    vec3 halfway_direction = normalize(light_direction + view_direction);
+    spec = pow(max(dot(normal, halfway_direction), 0.0), 64.0);
+    vec3 specular = spec * light_color;
+
+    float shadow = ShadowCalculation(fs_in.FragPosLightSpace, normal, light_direction);
+    vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;
+
+    FragColor = vec4(lighting, 1.0);
+}
\ No newline at end of file
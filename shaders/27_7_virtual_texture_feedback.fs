@@ -0,0 +1,36 @@
+#version 330 core
+// Records the virtual texture page every fragment samples. Drawn into a
+// small GL_RGBA16UI framebuffer that the CPU reads back to decide which pages
+// to load. Other geometry writes zero and only occludes.
+layout (location = 0) out uvec4 Feedback;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec4 FragPosLightSpace;
+} fs_in;
+
+uniform bool virtualTextured;
+uniform float virtualSize;
+uniform float pageSize;
+uniform int maxLevel;
+// Compensates for the lower resolution of the feedback framebuffer
+uniform float lodBias;
+
+void main() {
+    if (!virtualTextured) {
+        Feedback = uvec4(0u);
+        return;
+    }
+
+    // Same level selection as the sampling shader
+    vec2 dx = dFdx(fs_in.TexCoords * virtualSize);
+    vec2 dy = dFdy(fs_in.TexCoords * virtualSize);
+    float rho_squared = max(dot(dx, dx), dot(dy, dy));
+    int level = int(floor(clamp(0.5 * log2(rho_squared) + lodBias, 0.0, float(maxLevel))));
+
+    vec2 texel = clamp(fs_in.TexCoords, 0.0, 1.0) * virtualSize;
+    uvec2 page = uvec2(min(ivec2(texel / pageSize), ivec2(virtualSize / pageSize) - 1) >> level);
+    Feedback = uvec4(page, uint(level), 1u);
+}
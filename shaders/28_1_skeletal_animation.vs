@@ -0,0 +1,29 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 7) in uvec4 aBoneIds;
+layout (location = 8) in vec4 aBoneWeights;
+
+out vec2 TexCoords;
+
+// Per instance: the model matrix followed by boneCount palette matrices
+layout (std430, binding = 0) readonly buffer Instances
+{
+  mat4 matrices[];
+};
+
+uniform int boneCount;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+  int base = gl_InstanceID * (boneCount + 1);
+  mat4 skin = aBoneWeights.x * matrices[base + 1 + int(aBoneIds.x)] +
+              aBoneWeights.y * matrices[base + 1 + int(aBoneIds.y)] +
+              aBoneWeights.z * matrices[base + 1 + int(aBoneIds.z)] +
+              aBoneWeights.w * matrices[base + 1 + int(aBoneIds.w)];
+  TexCoords = aTexCoords;
+  gl_Position = projection * view * matrices[base] * skin * vec4(aPos, 1.0);
+}
@@ -8,6 +8,7 @@
 #include <iostream>
 
 #include "camera.hpp"
+#include "mip_builder.hpp"
 #include "shader_m.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_include.hpp"
@@ -169,9 +170,12 @@ int main() {
   unsigned char* data = stbi_load("assets/textures/container2.png", &width,
                                   &height, &channel_count, 0);
   if (data) {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    UploadMipChain(
+        BuildMipChain(data, width, height, channel_count, options),
+        /*srgb_storage=*/false);
   } else {
     std::cerr << "Failed to load texture\n";
     return -1;
@@ -197,9 +201,10 @@ int main() {
     return -1;
   }
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
-               GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+  // Specular intensities are linear, so filter them as stored
+  UploadMipChain(
+      BuildMipChain(data, width, height, channel_count, MipChainOptions()),
+      /*srgb_storage=*/false);
 
   stbi_image_free(data);
 
@@ -7,8 +7,12 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include "camera.hpp"
+#include "mip_builder.hpp"
+#include "frustum_culling.hpp"
+#include "loose_octree.hpp"
 #include "shader_m.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_include.hpp"
@@ -129,6 +133,18 @@ int main() {
       glm::vec3(1.3f, -2.0f, -2.5f),  glm::vec3(1.5f, 2.0f, -2.5f),
       glm::vec3(1.5f, 0.2f, -1.5f),   glm::vec3(-1.3f, 1.0f, -1.5f)};
 
+  // Index the cubes by their bounding spheres to draw only those in view. A
+  // unit cube fits in a sphere of radius sqrt(3) / 2 however it is rotated.
+  // Handles of a fresh octree count up from 0, so they index cube_positions.
+  constexpr float kCubeRadius = 0.8660254f;
+  LooseOctreeOptions octree_options;
+  octree_options.max_depth = 3;
+  LooseOctree cube_index(glm::vec3(0.0f, 0.0f, -7.5f), 10.0f, octree_options);
+  for (const glm::vec3& position : cube_positions) {
+    cube_index.Insert(glm::vec4(position, kCubeRadius));
+  }
+  std::vector<LooseOctree::Handle> visible_cubes;
+
   Shader shader("shaders/11_1_diffuse_map.vs",
                 "shaders/13_1_multiple_lights.fs");
 
@@ -168,9 +184,12 @@ int main() {
   unsigned char* data = stbi_load("assets/textures/container2.png", &width,
                                   &height, &channel_count, 0);
   if (data) {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    UploadMipChain(
+        BuildMipChain(data, width, height, channel_count, options),
+        /*srgb_storage=*/false);
   } else {
     std::cerr << "Failed to load texture\n";
     return -1;
@@ -196,9 +215,10 @@ int main() {
     return -1;
   }
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
-               GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+  // Specular intensities are linear, so filter them as stored
+  UploadMipChain(
+      BuildMipChain(data, width, height, channel_count, MipChainOptions()),
+      /*srgb_storage=*/false);
 
   stbi_image_free(data);
 
@@ -308,8 +328,10 @@ int main() {
 
     glBindVertexArray(vao);
 
-    // Draw all 10 cubes with slight differences
-    for (unsigned int i = 0; i < 10; i++) {
+    // Draw the cubes in view with slight differences
+    visible_cubes.clear();
+    cube_index.QueryFrustum(ExtractFrustum(projection * view), &visible_cubes);
+    for (LooseOctree::Handle i : visible_cubes) {
       glm::mat4 model = glm::mat4(1.0f);
       model = glm::translate(model, cube_positions[i]);
       float angle = 20.0f * (i + 1);
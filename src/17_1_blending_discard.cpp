@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "camera.hpp"
+#include "mip_builder.hpp"
 #include "model.hpp"
 #include "shader_m.hpp"
 #include "stb_include.hpp"
@@ -349,10 +350,17 @@ unsigned int LoadTexture(char const* path) {
         break;
     };
 
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    // Keep the cut-out from thinning in distant mips. The cutoff matches the
+    // discard threshold of the alpha tested shader.
+    options.preserve_alpha_coverage = true;
+    options.alpha_cutoff = 0.1f;
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
 
     // For this tutorial only:
     // Use GL_CLAMP_TO_EDGE to prevent semi-transparent borders. This happens
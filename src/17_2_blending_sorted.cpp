@@ -6,12 +6,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
-#include <map>
+#include <vector>
 
 #include "camera.hpp"
+#include "mip_builder.hpp"
 #include "model.hpp"
 #include "shader_m.hpp"
 #include "stb_include.hpp"
+#include "transparency_sorter.hpp"
 
 // Default settings
 constexpr unsigned int kScreenWidth = 800;
@@ -220,6 +222,7 @@ int main() {
   windows.push_back(glm::vec3(0.0f, 0.0f, 0.7f));
   windows.push_back(glm::vec3(-0.3f, 0.0f, -2.3f));
   windows.push_back(glm::vec3(0.5f, 0.0f, -0.6f));
+  TransparencySorter window_sorter;
 
   // Render loop
   while (!glfwWindowShouldClose(window)) {
@@ -278,18 +281,15 @@ int main() {
     glBindVertexArray(0);
 
     // Window
-    // Sort the windows so that we draw further to closest
-    std::map<float, glm::vec3> sorted;
-    for (unsigned int i = 0; i < windows.size(); i++) {
-      float distance = glm::length(camera.Position() - windows[i]);
-      sorted[distance] = windows[i];
-    }
+    // Sort the windows so that we draw further to closest. Windows at the
+    // same distance are all kept, in a stable order.
+    window_sorter.Sort(windows.data(), windows.size(), camera.Position());
 
     glBindVertexArray(window_vao);
     glBindTexture(GL_TEXTURE_2D, window_texture);
-    for (auto it = sorted.rbegin(); it != sorted.rend(); it++) {
+    for (const unsigned int index : window_sorter.Order()) {
       model = glm::mat4(1.0f);
-      model = glm::translate(model, it->second);
+      model = glm::translate(model, windows[index]);
       shader.SetMat4("model", model);
       glDrawArrays(GL_TRIANGLES, 0, 6);
     }
@@ -358,23 +358,13 @@ unsigned int LoadTexture(char const* path) {
   int component_count;
   auto* data = stbi_load(path, &width, &height, &component_count, 0);
   if (data) {
-    GLenum format;
-    switch (component_count) {
-      case 1:
-        format = GL_RED;
-        break;
-      case 3:
-        format = GL_RGB;
-        break;
-      case 4:
-        format = GL_RGBA;
-        break;
-    };
-
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -0,0 +1,331 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "camera.hpp"
+#include "mip_builder.hpp"
+#include "model.hpp"
+#include "shader_m.hpp"
+#include "stb_include.hpp"
+#include "streaming_buffer.hpp"
+#include "transparency_sorter.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+unsigned int LoadTexture(char const* path);
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+// Press O to draw the windows unsorted, to see what sorting fixes
+bool sort_windows = true;
+bool sort_windows_key_pressed = false;
+
+Camera camera(glm::vec3(0.0f, 2.0f, 60.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+
+  // Enable blending
+  glEnable(GL_BLEND);
+
+  // Set the blending function
+  // Params are source factor and destination factor
+  // GL_SRC_ALPHA = Use the alpha component of the source color vector
+  // GL_ONE_MINUS_SRC_ALPHA = Factor is equal to 1 - alpha of source color
+  // vector
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  // Set the blending equation (src + dst). This is the default.
+  glBlendEquation(GL_FUNC_ADD);
+
+  Shader shader("shaders/17_3_blending_instanced.vs",
+                "shaders/15_1_depth_testing.fs");
+
+  // Position (x, y, z), texture coordinates (swapped y coordinate as texture is
+  // flipped upside down)
+  float window_vertices[] = {
+      0.0f, 0.5f,  0.0f, 0.0f, 0.0f,  //
+      0.0f, -0.5f, 0.0f, 0.0f, 1.0f,  //
+      1.0f, -0.5f, 0.0f, 1.0f, 1.0f,  //
+
+      0.0f, 0.5f,  0.0f, 0.0f, 0.0f,  //
+      1.0f, -0.5f, 0.0f, 1.0f, 1.0f,  //
+      1.0f, 0.5f,  0.0f, 1.0f, 0.0f   //
+  };
+
+  // A field of windows, the same on every run
+  constexpr unsigned int kWindowCount = 100000;
+  std::vector<glm::vec3> windows(kWindowCount);
+  std::mt19937 random(17);
+  std::uniform_real_distribution<float> across(-50.0f, 50.0f);
+  std::uniform_real_distribution<float> height(0.0f, 5.0f);
+  for (auto& position : windows) {
+    position = glm::vec3(across(random), height(random), across(random));
+  }
+  TransparencySorter window_sorter;
+
+  // The window positions in drawing order, rewritten every frame. Each
+  // region holds one frame's worth.
+  StreamingBuffer instances(kWindowCount * sizeof(glm::vec3),
+                            "Window instances");
+
+  // Window VAO
+  unsigned int window_vao;
+  glGenVertexArrays(1, &window_vao);
+  glBindVertexArray(window_vao);
+
+  unsigned int window_vbo;
+  glGenBuffers(1, &window_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, window_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(window_vertices), window_vertices,
+               GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                        (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  // The offset of each window, one per instance. The draw's base instance
+  // selects the region.
+  glBindBuffer(GL_ARRAY_BUFFER, instances.Id());
+  glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+                        (void*)0);
+  glEnableVertexAttribArray(2);
+  glVertexAttribDivisor(2, 1);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // Load textures
+  auto window_texture =
+      LoadTexture("assets/textures/blending_transparent_window.png");
+
+  // Print the average sort time once per second
+  float last_report = 0.0f;
+  unsigned int frames = 0;
+  unsigned int incremental_sorts = 0;
+  float sort_time = 0.0f;
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    // Render
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    shader.Use();
+    shader.SetInt("texture1", 0);
+
+    // Using lookAt...
+    auto view = camera.GetViewMatrix();
+    shader.SetMat4("view", view);
+
+    // Use perspective projection
+    glm::mat4 projection;
+    projection = glm::perspective(
+        glm::radians(camera.GetFieldOfView()),
+        static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+        0.1f, 200.0f);
+    shader.SetMat4("projection", projection);
+
+    // Sort the windows so that we draw further to closest, and write them
+    // out in that order
+    auto* positions = static_cast<glm::vec3*>(instances.BeginFrame());
+    if (sort_windows) {
+      const auto sort_start = std::chrono::steady_clock::now();
+      window_sorter.Sort(windows.data(), windows.size(), camera.Position());
+      const std::chrono::duration<float, std::milli> elapsed =
+          std::chrono::steady_clock::now() - sort_start;
+      sort_time += elapsed.count();
+      if (window_sorter.LastSortIncremental()) {
+        incremental_sorts++;
+      }
+      for (const unsigned int index : window_sorter.Order()) {
+        *positions++ = windows[index];
+      }
+    } else {
+      std::copy(windows.begin(), windows.end(), positions);
+    }
+
+    glBindVertexArray(window_vao);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, window_texture);
+    glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, 6, kWindowCount,
+                                      instances.Region() * kWindowCount);
+    glBindVertexArray(0);
+    instances.EndFrame();
+
+    frames++;
+    if (current_frame - last_report >= 1.0f) {
+      if (sort_windows) {
+        std::cout << "Sort: " << sort_time / frames << " ms, "
+                  << incremental_sorts << " of " << frames
+                  << " frames by insertion sort\n";
+      } else {
+        std::cout << "Unsorted\n";
+      }
+      last_report = current_frame;
+      frames = 0;
+      incremental_sorts = 0;
+      sort_time = 0.0f;
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS &&
+      !sort_windows_key_pressed) {
+    sort_windows_key_pressed = true;
+    sort_windows = !sort_windows;
+  }
+  if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE) {
+    sort_windows_key_pressed = false;
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
+
+unsigned int LoadTexture(char const* path) {
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+
+  int width;
+  int height;
+  int component_count;
+  auto* data = stbi_load(path, &width, &height, &component_count, 0);
+  if (data) {
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stbi_image_free(data);
+  } else {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    stbi_image_free(data);
+  }
+
+  return texture_id;
+}
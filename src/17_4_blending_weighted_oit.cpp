@@ -0,0 +1,615 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "camera.hpp"
+#include "gpu_resources.hpp"
+#include "mip_builder.hpp"
+#include "model.hpp"
+#include "occlusion_query.hpp"
+#include "shader_m.hpp"
+#include "stb_include.hpp"
+#include "streaming_buffer.hpp"
+#include "transparency_sorter.hpp"
+#include "weighted_oit.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+
+// How the transparent surfaces are drawn
+enum class BlendMode {
+  // Sorted far to near on the CPU every frame, then blended in order
+  SORTED,
+  // In any order with weighted blended OIT
+  WEIGHTED_OIT,
+  // Both, the sorted half on the left and the OIT half on the right
+  SIDE_BY_SIDE,
+};
+
+// An offscreen color and depth target the size of the window
+struct SceneTarget {
+  unsigned int framebuffer;
+  unsigned int color;
+  unsigned int depth;
+};
+
+// How far apart two RGBA8 images are, over the color channels
+struct ImageDifference {
+  double rms;
+  int max;
+  // Share of the pixels where a channel differs by more than a few steps
+  double differing;
+};
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+unsigned int LoadTexture(char const* path);
+SceneTarget CreateSceneTarget(const char* owner);
+std::vector<unsigned char> ReadColor(const SceneTarget& target);
+ImageDifference CompareImages(const std::vector<unsigned char>& a,
+                              const std::vector<unsigned char>& b);
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+// Press O to cycle between sorting, OIT and both side by side
+BlendMode blend_mode = BlendMode::SIDE_BY_SIDE;
+bool blend_mode_key_pressed = false;
+
+Camera camera(glm::vec3(0.0f, 2.0f, 60.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+
+  // Blending for the sorted path, and for compositing the OIT result
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glBlendEquation(GL_FUNC_ADD);
+
+  Shader floor_shader("shaders/15_1_depth_testing.vs",
+                      "shaders/15_1_depth_testing.fs");
+  Shader sorted_shader("shaders/17_4_blending_instanced.vs",
+                       "shaders/17_4_blending.fs");
+  Shader accumulate_shader("shaders/17_4_blending_instanced.vs",
+                           "shaders/17_4_oit_accumulate.fs");
+  Shader composite_shader("shaders/17_4_oit_composite.vs",
+                          "shaders/17_4_oit_composite.fs");
+
+  // Position (x, y, z), texture coordinates (swapped y coordinate as texture is
+  // flipped upside down)
+  float quad_vertices[] = {
+      0.0f, 0.5f,  0.0f, 0.0f, 0.0f,  //
+      0.0f, -0.5f, 0.0f, 0.0f, 1.0f,  //
+      1.0f, -0.5f, 0.0f, 1.0f, 1.0f,  //
+
+      0.0f, 0.5f,  0.0f, 0.0f, 0.0f,  //
+      1.0f, -0.5f, 0.0f, 1.0f, 1.0f,  //
+      1.0f, 0.5f,  0.0f, 1.0f, 0.0f   //
+  };
+
+  // An opaque floor under the field. Position (x, y, z), texture
+  // coordinates (s, t), repeating.
+  float floor_vertices[] = {
+      60.0f,  -0.5f, 60.0f,  24.0f, 0.0f,   //
+      -60.0f, -0.5f, 60.0f,  0.0f,  0.0f,   //
+      -60.0f, -0.5f, -60.0f, 0.0f,  24.0f,  //
+
+      60.0f,  -0.5f, 60.0f,  24.0f, 0.0f,   //
+      -60.0f, -0.5f, -60.0f, 0.0f,  24.0f,  //
+      60.0f,  -0.5f, -60.0f, 24.0f, 24.0f   //
+  };
+
+  // A field of windows and grass, the same on every run. Each instance is
+  // its position and 0 for a window or 1 for grass.
+  constexpr unsigned int kWindowCount = 50000;
+  constexpr unsigned int kGrassCount = 50000;
+  constexpr unsigned int kInstanceCount = kWindowCount + kGrassCount;
+  std::vector<glm::vec3> positions(kInstanceCount);
+  std::vector<glm::vec4> instances(kInstanceCount);
+  std::mt19937 random(17);
+  std::uniform_real_distribution<float> across(-50.0f, 50.0f);
+  std::uniform_real_distribution<float> height(0.0f, 5.0f);
+  for (unsigned int i = 0; i < kInstanceCount; i++) {
+    const bool grass = i % 2 == 1;
+    // Grass stands on the floor
+    positions[i] = glm::vec3(across(random), grass ? 0.0f : height(random),
+                             across(random));
+    instances[i] = glm::vec4(positions[i], grass ? 1.0f : 0.0f);
+  }
+  TransparencySorter sorter;
+
+  // OIT draws the instances as they are, so they never change
+  unsigned int unsorted_instances;
+  glGenBuffers(1, &unsorted_instances);
+  glBindBuffer(GL_ARRAY_BUFFER, unsorted_instances);
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec4),
+               instances.data(), GL_STATIC_DRAW);
+  GpuResources().Track(GpuResourceKind::BUFFER, unsorted_instances,
+                       {GpuResourceCategory::BUFFER,
+                        instances.size() * sizeof(glm::vec4), GL_NONE,
+                        "Unsorted instances"});
+  // The sorted path writes them in drawing order every frame. Each region
+  // holds one frame's worth.
+  StreamingBuffer sorted_instances(kInstanceCount * sizeof(glm::vec4),
+                                   "Sorted instances");
+
+  unsigned int quad_vbo;
+  glGenBuffers(1, &quad_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices,
+               GL_STATIC_DRAW);
+
+  // A VAO per instance buffer, sharing the quad
+  const auto create_instanced_vao = [&](unsigned int instance_buffer) {
+    unsigned int vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                          (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                          (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4),
+                          (void*)0);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return vao;
+  };
+  const unsigned int unsorted_vao = create_instanced_vao(unsorted_instances);
+  // The draw's base instance selects the region
+  const unsigned int sorted_vao =
+      create_instanced_vao(sorted_instances.Id());
+
+  // Floor VAO
+  unsigned int floor_vao;
+  glGenVertexArrays(1, &floor_vao);
+  glBindVertexArray(floor_vao);
+
+  unsigned int floor_vbo;
+  glGenBuffers(1, &floor_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, floor_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(floor_vertices), floor_vertices,
+               GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                        (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(0);
+
+  // Load textures
+  auto window_texture =
+      LoadTexture("assets/textures/blending_transparent_window.png");
+  auto grass_texture = LoadTexture("assets/textures/grass.png");
+  auto floor_texture = LoadTexture("assets/textures/metal.png");
+  // Clamp the cutouts so their transparent edges do not wrap around
+  for (const unsigned int texture : {window_texture, grass_texture}) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // Each path renders offscreen, so both can run in one frame and be read
+  // back for comparison
+  const SceneTarget sorted_target = CreateSceneTarget("Sorted scene");
+  const SceneTarget oit_target = CreateSceneTarget("OIT scene");
+  WeightedOit oit(kScreenWidth, kScreenHeight, oit_target.depth);
+
+  // GPU time of each path's transparent pass
+  QueryPool sorted_timer(GL_TIME_ELAPSED);
+  QueryPool oit_timer(GL_TIME_ELAPSED);
+
+  // Report what the setup allocated on the GPU
+  GpuResources().Dump(std::cout);
+
+  // Print the average times, and how far apart the two paths' images are,
+  // once per second
+  float last_report = 0.0f;
+  unsigned int sorted_frames = 0;
+  unsigned int oit_frames = 0;
+  float sort_time = 0.0f;
+  std::uint64_t sorted_gpu_time = 0;
+  unsigned int sorted_gpu_frames = 0;
+  std::uint64_t oit_gpu_time = 0;
+  unsigned int oit_gpu_frames = 0;
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    // Collect the timings of a few frames ago
+    sorted_timer.BeginFrame();
+    sorted_gpu_time += sorted_timer.ResultSum();
+    sorted_gpu_frames += sorted_timer.AvailableCount();
+    oit_timer.BeginFrame();
+    oit_gpu_time += oit_timer.ResultSum();
+    oit_gpu_frames += oit_timer.AvailableCount();
+
+    // Render
+
+    // Using lookAt...
+    auto view = camera.GetViewMatrix();
+
+    // Use perspective projection
+    glm::mat4 projection;
+    projection = glm::perspective(
+        glm::radians(camera.GetFieldOfView()),
+        static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+        0.1f, 200.0f);
+
+    // Clear `target` and draw the opaque floor into it
+    const auto draw_opaque = [&](const SceneTarget& target) {
+      glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+      glViewport(0, 0, kScreenWidth, kScreenHeight);
+      glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      floor_shader.Use();
+      floor_shader.SetInt("texture1", 0);
+      floor_shader.SetMat4("model", glm::mat4(1.0f));
+      floor_shader.SetMat4("view", view);
+      floor_shader.SetMat4("projection", projection);
+      glBindVertexArray(floor_vao);
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, floor_texture);
+      glDrawArrays(GL_TRIANGLES, 0, 6);
+    };
+    // Set up `shader` for the instances and bind their textures
+    const auto use_instance_shader = [&](Shader& shader) {
+      shader.Use();
+      shader.SetInt("windowTexture", 0);
+      shader.SetInt("grassTexture", 1);
+      shader.SetMat4("view", view);
+      shader.SetMat4("projection", projection);
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, window_texture);
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, grass_texture);
+      glActiveTexture(GL_TEXTURE0);
+    };
+
+    if (blend_mode != BlendMode::WEIGHTED_OIT) {
+      draw_opaque(sorted_target);
+
+      // Sort the instances so that we draw further to closest, and write
+      // them out in that order
+      const auto sort_start = std::chrono::steady_clock::now();
+      sorter.Sort(positions.data(), positions.size(), camera.Position());
+      auto* sorted = static_cast<glm::vec4*>(sorted_instances.BeginFrame());
+      for (const unsigned int index : sorter.Order()) {
+        *sorted++ = instances[index];
+      }
+      const std::chrono::duration<float, std::milli> elapsed =
+          std::chrono::steady_clock::now() - sort_start;
+      sort_time += elapsed.count();
+      sorted_frames++;
+
+      glBeginQuery(sorted_timer.Target(), sorted_timer.Acquire());
+      use_instance_shader(sorted_shader);
+      glBindVertexArray(sorted_vao);
+      glDrawArraysInstancedBaseInstance(
+          GL_TRIANGLES, 0, 6, kInstanceCount,
+          sorted_instances.Region() * kInstanceCount);
+      glEndQuery(sorted_timer.Target());
+      sorted_instances.EndFrame();
+    }
+
+    if (blend_mode != BlendMode::SORTED) {
+      draw_opaque(oit_target);
+
+      // Every window and blade of grass in one draw, in any order
+      glBeginQuery(oit_timer.Target(), oit_timer.Acquire());
+      oit.Begin();
+      use_instance_shader(accumulate_shader);
+      glBindVertexArray(unsorted_vao);
+      glDrawArraysInstanced(GL_TRIANGLES, 0, 6, kInstanceCount);
+      oit.Composite(composite_shader, oit_target.framebuffer);
+      glEndQuery(oit_timer.Target());
+      oit_frames++;
+    }
+    glBindVertexArray(0);
+
+    // Show the result, splitting the screen down the middle between the
+    // two paths when both ran
+    const auto present = [](const SceneTarget& target, int x0, int x1) {
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+      glBlitFramebuffer(x0, 0, x1, kScreenHeight, x0, 0, x1, kScreenHeight,
+                        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    };
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    switch (blend_mode) {
+      case BlendMode::SORTED:
+        present(sorted_target, 0, kScreenWidth);
+        break;
+      case BlendMode::WEIGHTED_OIT:
+        present(oit_target, 0, kScreenWidth);
+        break;
+      case BlendMode::SIDE_BY_SIDE:
+        present(sorted_target, 0, kScreenWidth / 2);
+        present(oit_target, kScreenWidth / 2, kScreenWidth);
+        break;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (current_frame - last_report >= 1.0f) {
+      std::cout << std::fixed << std::setprecision(2);
+      if (sorted_frames > 0) {
+        std::cout << "Sorted: " << sort_time / sorted_frames
+                  << " ms sorting, "
+                  << (sorted_gpu_frames > 0
+                          ? sorted_gpu_time / 1e6 / sorted_gpu_frames
+                          : 0.0)
+                  << " ms GPU";
+      }
+      if (sorted_frames > 0 && oit_frames > 0) {
+        std::cout << "; ";
+      }
+      if (oit_frames > 0) {
+        std::cout << "Weighted OIT: "
+                  << (oit_gpu_frames > 0 ? oit_gpu_time / 1e6 / oit_gpu_frames
+                                         : 0.0)
+                  << " ms GPU";
+      }
+      std::cout << "\n";
+      // Reading back waits for the GPU, so only do it once per report
+      if (blend_mode == BlendMode::SIDE_BY_SIDE) {
+        const ImageDifference difference =
+            CompareImages(ReadColor(sorted_target), ReadColor(oit_target));
+        std::cout << "Difference: RMS " << difference.rms << ", max "
+                  << difference.max << ", "
+                  << difference.differing * 100.0 << "% of pixels\n";
+      }
+      last_report = current_frame;
+      sorted_frames = 0;
+      oit_frames = 0;
+      sort_time = 0.0f;
+      sorted_gpu_time = 0;
+      sorted_gpu_frames = 0;
+      oit_gpu_time = 0;
+      oit_gpu_frames = 0;
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS &&
+      !blend_mode_key_pressed) {
+    blend_mode_key_pressed = true;
+    switch (blend_mode) {
+      case BlendMode::SORTED:
+        blend_mode = BlendMode::WEIGHTED_OIT;
+        break;
+      case BlendMode::WEIGHTED_OIT:
+        blend_mode = BlendMode::SIDE_BY_SIDE;
+        break;
+      case BlendMode::SIDE_BY_SIDE:
+        blend_mode = BlendMode::SORTED;
+        break;
+    }
+  }
+  if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE) {
+    blend_mode_key_pressed = false;
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
+
+unsigned int LoadTexture(char const* path) {
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+
+  int width;
+  int height;
+  int component_count;
+  auto* data = stbi_load(path, &width, &height, &component_count, 0);
+  if (data) {
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stbi_image_free(data);
+  } else {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    stbi_image_free(data);
+  }
+
+  return texture_id;
+}
+
+SceneTarget CreateSceneTarget(const char* owner) {
+  SceneTarget target;
+  glGenFramebuffers(1, &target.framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+
+  glGenTextures(1, &target.color);
+  glBindTexture(GL_TEXTURE_2D, target.color);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, kScreenWidth, kScreenHeight);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  GpuResources().Track(GpuResourceKind::TEXTURE, target.color,
+                       {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+                        TextureBytes(GL_RGBA8, kScreenWidth, kScreenHeight),
+                        GL_RGBA8, owner});
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         target.color, 0);
+
+  // A texture rather than a renderbuffer, so the OIT targets can share it
+  glGenTextures(1, &target.depth);
+  glBindTexture(GL_TEXTURE_2D, target.depth);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, kScreenWidth,
+                 kScreenHeight);
+  GpuResources().Track(
+      GpuResourceKind::TEXTURE, target.depth,
+      {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+       TextureBytes(GL_DEPTH_COMPONENT32F, kScreenWidth, kScreenHeight),
+       GL_DEPTH_COMPONENT32F, owner});
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+                         target.depth, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "Unable to complete framebuffer\n";
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  return target;
+}
+
+std::vector<unsigned char> ReadColor(const SceneTarget& target) {
+  std::vector<unsigned char> pixels(kScreenWidth * kScreenHeight * 4);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, kScreenWidth, kScreenHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+               pixels.data());
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  return pixels;
+}
+
+ImageDifference CompareImages(const std::vector<unsigned char>& a,
+                              const std::vector<unsigned char>& b) {
+  // Differences up to this are rounding, not the method
+  constexpr int kTolerance = 4;
+  double squares = 0.0;
+  int max = 0;
+  std::size_t differing = 0;
+  const std::size_t pixels = a.size() / 4;
+  for (std::size_t i = 0; i < pixels; i++) {
+    int pixel_max = 0;
+    for (int channel = 0; channel < 3; channel++) {
+      const int difference = std::abs(a[i * 4 + channel] - b[i * 4 + channel]);
+      squares += difference * difference;
+      pixel_max = std::max(pixel_max, difference);
+    }
+    max = std::max(max, pixel_max);
+    differing += pixel_max > kTolerance ? 1 : 0;
+  }
+  return {std::sqrt(squares / (pixels * 3)), max,
+          static_cast<double>(differing) / pixels};
+}
@@ -0,0 +1,435 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "camera.hpp"
+#include "gpu_resources.hpp"
+#include "mip_builder.hpp"
+#include "model.hpp"
+#include "occlusion_query.hpp"
+#include "shader_m.hpp"
+#include "stb_include.hpp"
+#include "vegetation.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+constexpr int kSamples = 4;
+
+// Grass cards per square unit, selected by density_level
+constexpr float kDensities[] = {1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f};
+constexpr int kDensityLevels = sizeof(kDensities) / sizeof(kDensities[0]);
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+unsigned int LoadTexture(char const* path);
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+// Press = and - to double and halve the grass density
+int density_level = 3;
+bool density_key_pressed = false;
+// Press P to toggle the depth prepass
+bool depth_prepass = true;
+bool depth_prepass_key_pressed = false;
+// Press M to toggle multisampling, and C to toggle alpha-to-coverage, which
+// replaces the alpha test while multisampling is on
+bool multisample = true;
+bool multisample_key_pressed = false;
+bool alpha_to_coverage = true;
+bool alpha_to_coverage_key_pressed = false;
+
+Camera camera(glm::vec3(0.0f, 1.0f, 95.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_SAMPLES, kSamples);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_MULTISAMPLE);
+
+  Shader floor_shader("shaders/15_1_depth_testing.vs",
+                      "shaders/15_1_depth_testing.fs");
+  Shader culling_shader("shaders/17_5_vegetation_culling.cs");
+  // Decides coverage, by alpha test or alpha-to-coverage
+  Shader cutout_shader("shaders/17_5_vegetation.vs",
+                       "shaders/17_5_vegetation_cutout.fs");
+  // Shades what the depth prepass left visible
+  Shader color_shader("shaders/17_5_vegetation.vs",
+                      "shaders/17_5_vegetation.fs");
+
+  // Position (x, y, z), texture coordinates (s, t)
+  // Note: Texture coordinates set higher than (together with GL_REPEAT) to
+  // cause floor repeat.
+  float floor_vertices[] = {
+      100.0f,  -0.5f, 100.0f,  40.0f, 0.0f,   //
+      -100.0f, -0.5f, 100.0f,  0.0f,  0.0f,   //
+      -100.0f, -0.5f, -100.0f, 0.0f,  40.0f,  //
+
+      100.0f,  -0.5f, 100.0f,  40.0f, 0.0f,   //
+      -100.0f, -0.5f, -100.0f, 0.0f,  40.0f,  //
+      100.0f,  -0.5f, -100.0f, 40.0f, 40.0f   //
+  };
+
+  // Floor VAO
+  unsigned int floor_vao;
+  glGenVertexArrays(1, &floor_vao);
+  glBindVertexArray(floor_vao);
+
+  unsigned int floor_vbo;
+  glGenBuffers(1, &floor_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, floor_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(floor_vertices), floor_vertices,
+               GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                        (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(0);
+
+  // Load textures
+  auto floor_texture = LoadTexture("assets/textures/metal.png");
+  auto grass_texture = LoadTexture("assets/textures/grass.png");
+  // Clamp the grass so its transparent top does not wrap onto its roots
+  glBindTexture(GL_TEXTURE_2D, grass_texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // The meadow, regenerated whenever the density changes
+  VegetationOptions vegetation_options;
+  int generated_level = -1;
+  VegetationRenderer vegetation({}, vegetation_options);
+
+  // GPU time of culling and drawing the grass, and the samples its color
+  // pass writes
+  QueryPool gpu_timer(GL_TIME_ELAPSED);
+  QueryPool samples_written(GL_SAMPLES_PASSED);
+
+  // Print the averages once per second
+  float last_report = 0.0f;
+  unsigned int frames = 0;
+  std::uint64_t gpu_time = 0;
+  unsigned int gpu_frames = 0;
+  std::uint64_t samples = 0;
+  unsigned int sample_frames = 0;
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    if (density_level != generated_level) {
+      vegetation_options.density = kDensities[density_level];
+      const auto generate_start = std::chrono::steady_clock::now();
+      vegetation.SetCards(GenerateVegetation(vegetation_options));
+      const std::chrono::duration<float, std::milli> elapsed =
+          std::chrono::steady_clock::now() - generate_start;
+      std::cout << "Density " << vegetation_options.density
+                << " per square unit: " << vegetation.CardCount()
+                << " cards, generated in " << elapsed.count() << " ms\n";
+      generated_level = density_level;
+    }
+
+    // Collect the measurements of a few frames ago
+    gpu_timer.BeginFrame();
+    gpu_time += gpu_timer.ResultSum();
+    gpu_frames += gpu_timer.AvailableCount();
+    samples_written.BeginFrame();
+    samples += samples_written.ResultSum();
+    sample_frames += samples_written.AvailableCount();
+
+    // Render
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Using lookAt...
+    auto view = camera.GetViewMatrix();
+
+    // Use perspective projection
+    glm::mat4 projection;
+    projection = glm::perspective(
+        glm::radians(camera.GetFieldOfView()),
+        static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+        0.1f, 200.0f);
+
+    // Floor
+    floor_shader.Use();
+    floor_shader.SetInt("texture1", 0);
+    floor_shader.SetMat4("model", glm::mat4(1.0f));
+    floor_shader.SetMat4("view", view);
+    floor_shader.SetMat4("projection", projection);
+    glBindVertexArray(floor_vao);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, floor_texture);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+
+    // Grass
+    glBeginQuery(gpu_timer.Target(), gpu_timer.Acquire());
+    vegetation.Cull(culling_shader, projection * view, camera.Position());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, grass_texture);
+    const bool coverage = multisample && alpha_to_coverage;
+    cutout_shader.Use();
+    cutout_shader.SetInt("texture1", 0);
+    cutout_shader.SetBool("alphaTest", !coverage);
+    cutout_shader.SetMat4("view", view);
+    cutout_shader.SetMat4("projection", projection);
+    if (coverage) {
+      glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    }
+    if (depth_prepass) {
+      // Lay down the depth of the covered samples only, so the color pass
+      // shades each visible sample once with early depth testing
+      glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      vegetation.Draw(cutout_shader, camera.Position());
+      glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+      glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+
+      color_shader.Use();
+      color_shader.SetInt("texture1", 0);
+      color_shader.SetMat4("view", view);
+      color_shader.SetMat4("projection", projection);
+      glDepthFunc(GL_EQUAL);
+      glDepthMask(GL_FALSE);
+      glBeginQuery(samples_written.Target(), samples_written.Acquire());
+      vegetation.Draw(color_shader, camera.Position());
+      glEndQuery(samples_written.Target());
+      glDepthMask(GL_TRUE);
+      glDepthFunc(GL_LESS);
+    } else {
+      // Every card fragment in front of what is drawn so far is shaded,
+      // and the alpha test's discard rules out early depth testing
+      glBeginQuery(samples_written.Target(), samples_written.Acquire());
+      vegetation.Draw(cutout_shader, camera.Position());
+      glEndQuery(samples_written.Target());
+      glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    }
+    glEndQuery(gpu_timer.Target());
+
+    frames++;
+    if (current_frame - last_report >= 1.0f) {
+      const double frame_time =
+          (current_frame - last_report) * 1000.0 / frames;
+      const double gpu_ms = gpu_frames > 0 ? gpu_time / 1e6 / gpu_frames : 0.0;
+      const double frame_samples =
+          sample_frames > 0 ? static_cast<double>(samples) / sample_frames
+                            : 0.0;
+      const double screen_samples = static_cast<double>(kScreenWidth) *
+                                    kScreenHeight * (multisample ? kSamples
+                                                                 : 1);
+      std::cout << std::fixed << std::setprecision(2)
+                << "Density " << vegetation_options.density << ": "
+                << vegetation.ReadVisibleCount() << " of "
+                << vegetation.CardCount() << " cards visible, "
+                << (depth_prepass ? "prepass, " : "no prepass, ")
+                << (multisample ? (alpha_to_coverage ? "MSAA with coverage"
+                                                     : "MSAA with alpha test")
+                                : "alpha test")
+                << "\n  Frame " << frame_time << " ms, grass " << gpu_ms
+                << " ms GPU, " << frame_samples / 1e6
+                << "M samples written (" << frame_samples / screen_samples
+                << "x the screen), "
+                << (gpu_ms > 0.0 ? frame_samples / gpu_ms / 1e6 : 0.0)
+                << " Gsamples/s\n";
+      last_report = current_frame;
+      frames = 0;
+      gpu_time = 0;
+      gpu_frames = 0;
+      samples = 0;
+      sample_frames = 0;
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+  const bool denser = glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS;
+  const bool sparser = glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS;
+  if ((denser || sparser) && !density_key_pressed) {
+    density_key_pressed = true;
+    if (denser && density_level + 1 < kDensityLevels) {
+      density_level++;
+    }
+    if (sparser && density_level > 0) {
+      density_level--;
+    }
+  }
+  if (!denser && !sparser) {
+    density_key_pressed = false;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS &&
+      !depth_prepass_key_pressed) {
+    depth_prepass_key_pressed = true;
+    depth_prepass = !depth_prepass;
+  }
+  if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE) {
+    depth_prepass_key_pressed = false;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS &&
+      !multisample_key_pressed) {
+    multisample_key_pressed = true;
+    multisample = !multisample;
+    if (multisample) {
+      glEnable(GL_MULTISAMPLE);
+    } else {
+      glDisable(GL_MULTISAMPLE);
+    }
+  }
+  if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE) {
+    multisample_key_pressed = false;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS &&
+      !alpha_to_coverage_key_pressed) {
+    alpha_to_coverage_key_pressed = true;
+    alpha_to_coverage = !alpha_to_coverage;
+  }
+  if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+    alpha_to_coverage_key_pressed = false;
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
+
+unsigned int LoadTexture(char const* path) {
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+
+  int width;
+  int height;
+  int component_count;
+  auto* data = stbi_load(path, &width, &height, &component_count, 0);
+  if (data) {
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stbi_image_free(data);
+  } else {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    stbi_image_free(data);
+  }
+
+  return texture_id;
+}
@@ -8,6 +8,8 @@
 #include <iostream>
 
 #include "camera.hpp"
+#include "gpu_resources.hpp"
+#include "mip_builder.hpp"
 #include "model.hpp"
 #include "shader_m.hpp"
 #include "stb_include.hpp"
@@ -224,6 +226,10 @@ int main() {
   // NULL as the texture's data parameter.
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 800, 600, 0, GL_RGB, GL_UNSIGNED_BYTE,
                NULL);
+  GpuResources().Track(GpuResourceKind::TEXTURE, texture_color_buffer,
+                       {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+                        TextureBytes(GL_RGB, 800, 600), GL_RGB,
+                        "Framebuffer color"});
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
@@ -243,6 +249,10 @@ int main() {
   glGenRenderbuffers(1, &rbo);
   glBindRenderbuffer(GL_RENDERBUFFER, rbo);
   glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, 800, 600);
+  GpuResources().Track(GpuResourceKind::RENDERBUFFER, rbo,
+                       {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+                        RenderbufferBytes(GL_DEPTH24_STENCIL8, 800, 600),
+                        GL_DEPTH24_STENCIL8, "Framebuffer depth/stencil"});
   glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
   // Finally, attach the renderbuffer object to the depth and stencil attachment
@@ -259,6 +269,9 @@ int main() {
   // To render to the original framebuffer again
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+  // Report what the setup allocated on the GPU
+  GpuResources().Dump(std::cout);
+
   // Render loop
   while (!glfwWindowShouldClose(window)) {
     // Calculate delta time
@@ -359,23 +372,13 @@ unsigned int LoadTexture(char const* path) {
   int component_count;
   auto* data = stbi_load(path, &width, &height, &component_count, 0);
   if (data) {
-    GLenum format;
-    switch (component_count) {
-      case 1:
-        format = GL_RED;
-        break;
-      case 3:
-        format = GL_RGB;
-        break;
-      case 4:
-        format = GL_RGBA;
-        break;
-    };
-
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -0,0 +1,512 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+#include "camera.hpp"
+#include "gaussian_blur.hpp"
+#include "gpu_resources.hpp"
+#include "mip_builder.hpp"
+#include "model.hpp"
+#include "occlusion_query.hpp"
+#include "shader_m.hpp"
+#include "stb_include.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+unsigned int LoadTexture(char const* path);
+void DrawScene(Shader& shader, unsigned int cube_vao, unsigned int cube_texture,
+               unsigned int plane_vao, unsigned int floor_texture);
+void BenchmarkRadii(GaussianBlur& blur, Shader& compute_shader,
+                    Shader& fragment_shader, unsigned int source_texture);
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+// Press = and - to widen and narrow the blur
+int radius = 8;
+bool radius_key_pressed = false;
+
+// Press C to switch between the compute and the fragment blur
+BlurMethod blur_method = BlurMethod::COMPUTE;
+bool blur_method_key_pressed = false;
+
+// Press B to time both methods over a range of radii
+bool benchmark_requested = false;
+bool benchmark_key_pressed = false;
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+
+  // Tell stb_image.h to flip loaded texture's on the y-axis (before loading
+  // model).
+  stbi_set_flip_vertically_on_load(true);
+
+  Shader shader("shaders/15_1_depth_testing.vs",
+                "shaders/15_1_depth_testing.fs");
+  Shader blur_compute_shader("shaders/19_7_gaussian_blur.cs");
+  Shader blur_fragment_shader("shaders/19_7_gaussian_blur.vs",
+                              "shaders/19_7_gaussian_blur.fs");
+
+  // Set up vertex data and buffers and configure vertex attributes
+  // Cube vertices: position (x, y, z), texture coordinates (s, t)
+  float cube_vertices[] = {
+      -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,  //
+      0.5f,  -0.5f, -0.5f, 1.0f, 0.0f,  //
+      0.5f,  0.5f,  -0.5f, 1.0f, 1.0f,  //
+      0.5f,  0.5f,  -0.5f, 1.0f, 1.0f,  //
+      -0.5f, 0.5f,  -0.5f, 0.0f, 1.0f,  //
+      -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,  //
+
+      -0.5f, -0.5f, 0.5f,  0.0f, 0.0f,  //
+      0.5f,  -0.5f, 0.5f,  1.0f, 0.0f,  //
+      0.5f,  0.5f,  0.5f,  1.0f, 1.0f,  //
+      0.5f,  0.5f,  0.5f,  1.0f, 1.0f,  //
+      -0.5f, 0.5f,  0.5f,  0.0f, 1.0f,  //
+      -0.5f, -0.5f, 0.5f,  0.0f, 0.0f,  //
+
+      -0.5f, 0.5f,  0.5f,  1.0f, 0.0f,  //
+      -0.5f, 0.5f,  -0.5f, 1.0f, 1.0f,  //
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,  //
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,  //
+      -0.5f, -0.5f, 0.5f,  0.0f, 0.0f,  //
+      -0.5f, 0.5f,  0.5f,  1.0f, 0.0f,  //
+
+      0.5f,  0.5f,  0.5f,  1.0f, 0.0f,  //
+      0.5f,  0.5f,  -0.5f, 1.0f, 1.0f,  //
+      0.5f,  -0.5f, -0.5f, 0.0f, 1.0f,  //
+      0.5f,  -0.5f, -0.5f, 0.0f, 1.0f,  //
+      0.5f,  -0.5f, 0.5f,  0.0f, 0.0f,  //
+      0.5f,  0.5f,  0.5f,  1.0f, 0.0f,  //
+
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,  //
+      0.5f,  -0.5f, -0.5f, 1.0f, 1.0f,  //
+      0.5f,  -0.5f, 0.5f,  1.0f, 0.0f,  //
+      0.5f,  -0.5f, 0.5f,  1.0f, 0.0f,  //
+      -0.5f, -0.5f, 0.5f,  0.0f, 0.0f,  //
+      -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,  //
+
+      -0.5f, 0.5f,  -0.5f, 0.0f, 1.0f,  //
+      0.5f,  0.5f,  -0.5f, 1.0f, 1.0f,  //
+      0.5f,  0.5f,  0.5f,  1.0f, 0.0f,  //
+      0.5f,  0.5f,  0.5f,  1.0f, 0.0f,  //
+      -0.5f, 0.5f,  0.5f,  0.0f, 0.0f,  //
+      -0.5f, 0.5f,  -0.5f, 0.0f, 1.0f   //
+  };
+
+  // Position (x, y, z), texture coordinates (s, t)
+  // Note: Texture coordinates set higher than (together with GL_REPEAT) to
+  // cause floor repeat.
+  float plane_vertices[] = {
+      5.0f,  -0.5f, 5.0f,  2.0f, 0.0f,  //
+      -5.0f, -0.5f, 5.0f,  0.0f, 0.0f,  //
+      -5.0f, -0.5f, -5.0f, 0.0f, 2.0f,  //
+
+      5.0f,  -0.5f, 5.0f,  2.0f, 0.0f,  //
+      -5.0f, -0.5f, -5.0f, 0.0f, 2.0f,  //
+      5.0f,  -0.5f, -5.0f, 2.0f, 2.0f   //
+  };
+
+  // Cube VAO
+  unsigned int cube_vao;
+  glGenVertexArrays(1, &cube_vao);
+  glBindVertexArray(cube_vao);
+
+  unsigned int cube_vbo;
+  glGenBuffers(1, &cube_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, cube_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), &cube_vertices,
+               GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                        (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(0);
+
+  // Plane VAO
+  unsigned int plane_vao;
+  glGenVertexArrays(1, &plane_vao);
+  glBindVertexArray(plane_vao);
+
+  unsigned int plane_vbo;
+  glGenBuffers(1, &plane_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, plane_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), &plane_vertices,
+               GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                        (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(0);
+
+  // Load textures
+  auto cube_texture = LoadTexture("assets/textures/container.jpg");
+  auto floor_texture = LoadTexture("assets/textures/metal.png");
+
+  // The scene goes into a texture the blur can read, filtered linearly and
+  // clamped for the bilinear taps of the fragment path
+  constexpr GLenum kSceneFormat = GL_RGBA16F;
+  unsigned int fbo;
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+  unsigned int scene_texture;
+  glGenTextures(1, &scene_texture);
+  glBindTexture(GL_TEXTURE_2D, scene_texture);
+  glTexStorage2D(GL_TEXTURE_2D, 1, kSceneFormat, kScreenWidth, kScreenHeight);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  GpuResources().Track(
+      GpuResourceKind::TEXTURE, scene_texture,
+      {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+       TextureBytes(kSceneFormat, kScreenWidth, kScreenHeight), kSceneFormat,
+       "Framebuffer color"});
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         scene_texture, 0);
+
+  // Since we don't need to sample the depth/stencil buffers, we can use a rbo.
+  unsigned int rbo;
+  glGenRenderbuffers(1, &rbo);
+  glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, kScreenWidth,
+                        kScreenHeight);
+  GpuResources().Track(
+      GpuResourceKind::RENDERBUFFER, rbo,
+      {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+       RenderbufferBytes(GL_DEPTH24_STENCIL8, kScreenWidth, kScreenHeight),
+       GL_DEPTH24_STENCIL8, "Framebuffer depth/stencil"});
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, rbo);
+
+  // Check if we actually successfully completed the framebuffer
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "Unable to complete framebuffer\n";
+    return 1;
+  }
+
+  // To render to the original framebuffer again
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  GaussianBlur blur(kScreenWidth, kScreenHeight);
+
+  // Times the blur alone
+  QueryPool blur_timer(GL_TIME_ELAPSED);
+  float last_report = 0.0f;
+  std::uint64_t gpu_time = 0;
+  unsigned int gpu_frames = 0;
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    if (blur.Radius() != radius) {
+      blur.SetRadius(radius);
+      radius = blur.Radius();
+    }
+
+    // Collect the timings of a few frames ago
+    blur_timer.BeginFrame();
+    gpu_time += blur_timer.ResultSum();
+    gpu_frames += blur_timer.AvailableCount();
+
+    // Render
+
+    // First Pass
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, kScreenWidth, kScreenHeight);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    DrawScene(shader, cube_vao, cube_texture, plane_vao, floor_texture);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (benchmark_requested) {
+      benchmark_requested = false;
+      BenchmarkRadii(blur, blur_compute_shader, blur_fragment_shader,
+                     scene_texture);
+      blur.SetRadius(radius);
+    }
+
+    // Blur the scene
+    glBeginQuery(blur_timer.Target(), blur_timer.Acquire());
+    blur.Blur(blur_method == BlurMethod::COMPUTE ? blur_compute_shader
+                                                 : blur_fragment_shader,
+              blur_method, scene_texture);
+    glEndQuery(blur_timer.Target());
+
+    // Second Pass: copy the blurred image to the screen
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, blur.ResultFramebuffer());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, kScreenWidth, kScreenHeight, 0, 0, kScreenWidth,
+                      kScreenHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (current_frame - last_report >= 1.0f) {
+      std::cout << std::fixed << std::setprecision(3) << "Radius " << radius
+                << (blur_method == BlurMethod::COMPUTE ? ", compute: "
+                                                       : ", fragment: ")
+                << (gpu_frames > 0 ? gpu_time / 1e6 / gpu_frames : 0.0)
+                << " ms GPU\n";
+      last_report = current_frame;
+      gpu_time = 0;
+      gpu_frames = 0;
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Cleanup
+  glDeleteFramebuffers(1, &fbo);
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+  const bool wider = glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS;
+  const bool narrower = glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS;
+  if ((wider || narrower) && !radius_key_pressed) {
+    radius_key_pressed = true;
+    radius = wider ? std::min(radius + 2, kMaxBlurRadius)
+                   : std::max(radius - 2, 0);
+  }
+  if (!wider && !narrower) {
+    radius_key_pressed = false;
+  }
+  if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS &&
+      !blur_method_key_pressed) {
+    blur_method_key_pressed = true;
+    blur_method = blur_method == BlurMethod::COMPUTE ? BlurMethod::FRAGMENT
+                                                     : BlurMethod::COMPUTE;
+  }
+  if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+    blur_method_key_pressed = false;
+  }
+  if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS &&
+      !benchmark_key_pressed) {
+    benchmark_key_pressed = true;
+    benchmark_requested = true;
+  }
+  if (glfwGetKey(window, GLFW_KEY_B) == GLFW_RELEASE) {
+    benchmark_key_pressed = false;
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
+
+unsigned int LoadTexture(char const* path) {
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+
+  int width;
+  int height;
+  int component_count;
+  auto* data = stbi_load(path, &width, &height, &component_count, 0);
+  if (data) {
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stbi_image_free(data);
+  } else {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    stbi_image_free(data);
+  }
+
+  return texture_id;
+}
+
+void DrawScene(Shader& shader, unsigned int cube_vao, unsigned int cube_texture,
+               unsigned int plane_vao, unsigned int floor_texture) {
+  shader.Use();
+  shader.SetInt("texture1", 0);
+
+  // Using lookAt...
+  auto view = camera.GetViewMatrix();
+  shader.SetMat4("view", view);
+
+  // Use perspective projection
+  glm::mat4 projection;
+  projection = glm::perspective(
+      glm::radians(camera.GetFieldOfView()),
+      static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+      0.1f, 100.0f);
+  shader.SetMat4("projection", projection);
+
+  auto model = glm::mat4(1.0f);
+
+  // Cubes
+  glBindVertexArray(cube_vao);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, cube_texture);
+  model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
+  shader.SetMat4("model", model);
+  glDrawArrays(GL_TRIANGLES, 0, 36);
+
+  model = glm::mat4(1.0f);
+  model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
+  shader.SetMat4("model", model);
+  glDrawArrays(GL_TRIANGLES, 0, 36);
+
+  // Floor
+  glBindVertexArray(plane_vao);
+  glBindTexture(GL_TEXTURE_2D, floor_texture);
+  shader.SetMat4("model", glm::mat4(1.0f));
+  glDrawArrays(GL_TRIANGLES, 0, 6);
+  glBindVertexArray(0);
+}
+
+void BenchmarkRadii(GaussianBlur& blur, Shader& compute_shader,
+                    Shader& fragment_shader, unsigned int source_texture) {
+  // Enough runs per radius to rise above the timer's resolution
+  constexpr int kRuns = 20;
+  unsigned int query;
+  glGenQueries(1, &query);
+  const auto time = [&](Shader& shader, BlurMethod method) {
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    for (int run = 0; run < kRuns; run++) {
+      blur.Blur(shader, method, source_texture);
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    // Waits for the GPU, which is fine outside the frame loop's timings
+    std::uint64_t nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    return nanoseconds / 1e6 / kRuns;
+  };
+
+  std::cout << std::fixed << std::setprecision(3)
+            << "Radius  Compute ms  Fragment ms\n";
+  for (int radius = 1; radius <= kMaxBlurRadius; radius *= 2) {
+    blur.SetRadius(radius);
+    // Once untimed, so the first run's warm-up is not counted
+    blur.Blur(compute_shader, BlurMethod::COMPUTE, source_texture);
+    blur.Blur(fragment_shader, BlurMethod::FRAGMENT, source_texture);
+    const double compute = time(compute_shader, BlurMethod::COMPUTE);
+    const double fragment = time(fragment_shader, BlurMethod::FRAGMENT);
+    std::cout << std::setw(6) << radius << std::setw(12) << compute
+              << std::setw(13) << fragment << "\n";
+  }
+  glDeleteQueries(1, &query);
+}
@@ -9,6 +9,8 @@
 #include <vector>
 
 #include "camera.hpp"
+#include "ktx2_texture.hpp"
+#include "mip_builder.hpp"
 #include "model.hpp"
 #include "shader_m.hpp"
 #include "stb_include.hpp"
@@ -344,23 +346,13 @@ unsigned int LoadTexture(char const* path) {
   int component_count;
   auto* data = stbi_load(path, &width, &height, &component_count, 0);
   if (data) {
-    GLenum format;
-    switch (component_count) {
-      case 1:
-        format = GL_RED;
-        break;
-      case 3:
-        format = GL_RGB;
-        break;
-      case 4:
-        format = GL_RGBA;
-        break;
-    };
-
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -378,6 +370,14 @@ unsigned int LoadTexture(char const* path) {
 }
 
 unsigned int LoadCubemap(std::vector<std::string> faces) {
+  // Prefer an offline block-compressed cube map named after the faces'
+  // directory, e.g. "assets/textures/skybox.ktx2"
+  const std::string directory = faces[0].substr(0, faces[0].find_last_of('/'));
+  const unsigned int compressed_id = LoadKtx2Texture(Ktx2PathFor(directory));
+  if (compressed_id != 0) {
+    return compressed_id;
+  }
+
   unsigned int texture_id;
   glGenTextures(1, &texture_id);
   glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id);
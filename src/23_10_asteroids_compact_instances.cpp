@@ -0,0 +1,325 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <vector>
+
+#include "asteroid_field.hpp"
+#include "camera.hpp"
+#include "instance_transform.hpp"
+#include "mip_builder.hpp"
+#include "model.hpp"
+#include "shader_m.hpp"
+#include "stb_include.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+unsigned int LoadTexture(char const* path);
+void BindInstanceBuffer(const Model& model, unsigned int buffer, bool compact);
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+// Press C to switch between mat4 and compact instance transforms
+bool compact_instances = true;
+bool compact_instances_key_pressed = false;
+
+Camera camera(glm::vec3(0.0f, 0.0f, 155.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+
+  // Tell stb_image.h to flip loaded texture's on the y-axis (before loading
+  // model).
+  stbi_set_flip_vertically_on_load(true);
+
+  Shader shader("shaders/23_3_asteroids.vs", "shaders/15_1_depth_testing.fs");
+  Shader instanced_shader("shaders/23_4_asteroids_instanced.vs",
+                          "shaders/15_1_depth_testing.fs");
+  Shader compact_shader("shaders/23_10_asteroids_compact_instances.vs",
+                        "shaders/15_1_depth_testing.fs");
+
+  Model planet("assets/models/planet/planet.obj");
+  Model rock("assets/models/rock/rock.obj");
+
+  unsigned int amount = 100000;
+  // The same rocks twice: as matrices, 64 bytes each, and as compact
+  // transforms, 32 bytes each. They are generated straight into the mapped
+  // buffers; the same seed gives the same field on every run.
+  AsteroidField field;
+  field.radius = 150.0f;
+  field.offset = 25.0f;
+
+  unsigned int matrix_buffer;
+  glGenBuffers(1, &matrix_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, matrix_buffer);
+  glBufferStorage(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), nullptr,
+                  GL_MAP_WRITE_BIT);
+  GenerateAsteroidField(
+      field, amount,
+      static_cast<glm::mat4*>(glMapBufferRange(
+          GL_ARRAY_BUFFER, 0, amount * sizeof(glm::mat4), GL_MAP_WRITE_BIT)));
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+
+  unsigned int compact_buffer;
+  glGenBuffers(1, &compact_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, compact_buffer);
+  glBufferStorage(GL_ARRAY_BUFFER, amount * sizeof(InstanceTransform),
+                  nullptr, GL_MAP_WRITE_BIT);
+  GenerateAsteroidField(field, amount,
+                        static_cast<InstanceTransform*>(glMapBufferRange(
+                            GL_ARRAY_BUFFER, 0,
+                            amount * sizeof(InstanceTransform),
+                            GL_MAP_WRITE_BIT)));
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  bool bound_compact = compact_instances;
+  BindInstanceBuffer(rock, bound_compact ? compact_buffer : matrix_buffer,
+                     bound_compact);
+
+  // Print the average frame time once per second
+  float last_report = 0.0f;
+  unsigned int frames = 0;
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    // Render
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    shader.Use();
+    shader.SetInt("texture1", 0);
+
+    // Using lookAt...
+    auto view = camera.GetViewMatrix();
+    shader.SetMat4("view", view);
+
+    // Use perspective projection
+    glm::mat4 projection;
+    projection = glm::perspective(
+        glm::radians(camera.GetFieldOfView()),
+        static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+        0.1f, 1000.0f);
+    shader.SetMat4("projection", projection);
+
+    // Draw planets
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
+    shader.SetMat4("model", model);
+    planet.Draw(shader);
+
+    // Draw rocks
+    if (bound_compact != compact_instances) {
+      bound_compact = compact_instances;
+      BindInstanceBuffer(rock, bound_compact ? compact_buffer : matrix_buffer,
+                         bound_compact);
+    }
+    Shader& rock_shader = compact_instances ? compact_shader : instanced_shader;
+    rock_shader.Use();
+    rock_shader.SetInt("texture1", 0);
+    rock_shader.SetMat4("view", view);
+    rock_shader.SetMat4("projection", projection);
+    for (unsigned int i = 0; i < rock.Meshes().size(); i++) {
+      glBindVertexArray(rock.Meshes()[i].vao());
+      glDrawElementsInstanced(GL_TRIANGLES, rock.Meshes()[i].indices.size(),
+                              GL_UNSIGNED_INT, 0, amount);
+    }
+
+    frames++;
+    if (current_frame - last_report >= 1.0f) {
+      const std::size_t instance_bytes =
+          compact_instances ? sizeof(InstanceTransform) : sizeof(glm::mat4);
+      std::cout << (compact_instances ? "Compact" : "Matrix")
+                << " instances: " << instance_bytes << " bytes each, "
+                << amount * instance_bytes / 1024 << " KiB in total, "
+                << 1000.0f * (current_frame - last_report) / frames
+                << " ms per frame\n";
+      last_report = current_frame;
+      frames = 0;
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS &&
+      !compact_instances_key_pressed) {
+    compact_instances_key_pressed = true;
+    compact_instances = !compact_instances;
+  }
+  if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+    compact_instances_key_pressed = false;
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
+
+unsigned int LoadTexture(char const* path) {
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+
+  int width;
+  int height;
+  int component_count;
+  auto* data = stbi_load(path, &width, &height, &component_count, 0);
+  if (data) {
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stbi_image_free(data);
+  } else {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    stbi_image_free(data);
+  }
+
+  return texture_id;
+}
+
+void BindInstanceBuffer(const Model& model, unsigned int buffer,
+                        bool compact) {
+  // We want to instance each MESH (since each mesh has its own VAO).
+  for (const auto& mesh : model.Meshes()) {
+    glBindVertexArray(mesh.vao());
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (compact) {
+      // Two vec4 attributes, 3 and 4
+      SetInstanceTransformAttributes(3);
+      glDisableVertexAttribArray(5);
+      glDisableVertexAttribArray(6);
+      continue;
+    }
+    // A mat4 takes four vec4 attributes, 3 to 6
+    for (int column = 0; column < 4; column++) {
+      glEnableVertexAttribArray(3 + column);
+      glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE,
+                            sizeof(glm::mat4),
+                            (void*)(column * sizeof(glm::vec4)));
+      glVertexAttribDivisor(3 + column, 1);
+    }
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
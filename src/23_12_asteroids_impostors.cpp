@@ -0,0 +1,333 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "asteroid_field.hpp"
+#include "camera.hpp"
+#include "impostor.hpp"
+#include "instance_transform.hpp"
+#include "mip_builder.hpp"
+#include "model.hpp"
+#include "shader_m.hpp"
+#include "stb_include.hpp"
+#include "streaming_buffer.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+// Rocks further away than this are drawn as impostors, a rock being a few
+// pixels wide there. Across the band after it both are drawn, dithered.
+constexpr float kImpostorDistance = 40.0f;
+constexpr float kFadeBand = 8.0f;
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+unsigned int LoadTexture(char const* path);
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+// Press I to draw every rock as a mesh
+bool impostors = true;
+bool impostors_key_pressed = false;
+
+Camera camera(glm::vec3(0.0f, 0.0f, 155.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+
+  // Tell stb_image.h to flip loaded texture's on the y-axis (before loading
+  // model).
+  stbi_set_flip_vertically_on_load(true);
+
+  Shader shader("shaders/23_3_asteroids.vs", "shaders/15_1_depth_testing.fs");
+  Shader near_shader("shaders/23_12_asteroids_near.vs",
+                     "shaders/23_12_asteroids_near.fs");
+  Shader impostor_shader("shaders/23_12_impostor.vs",
+                         "shaders/23_12_impostor.fs");
+  Shader bake_shader("shaders/23_12_impostor_bake.vs",
+                     "shaders/23_12_impostor_bake.fs");
+
+  Model planet("assets/models/planet/planet.obj");
+  Model rock("assets/models/rock/rock.obj");
+  // Bakes 64 views of the rock, 128 x 128 texels each
+  ImpostorAtlas rock_impostor(rock, bake_shader);
+  // The rock's own texture, which the impostors were baked with, so the
+  // meshes match them across the fade band
+  const unsigned int rock_texture = rock.Meshes()[0].textures[0].id;
+  const glm::vec3 light_direction =
+      glm::normalize(glm::vec3(-0.3f, -1.0f, -0.5f));
+
+  unsigned int amount = 200000;
+  AsteroidField field;
+  field.radius = 150.0f;
+  field.offset = 25.0f;
+  std::vector<InstanceTransform> rocks(amount);
+  GenerateAsteroidField(field, amount, rocks.data());
+
+  // Every frame the rocks are split by distance into two streamed buffers,
+  // one per representation
+  StreamingBuffer mesh_instances(amount * sizeof(InstanceTransform),
+                                 "Asteroid mesh instances");
+  StreamingBuffer impostor_instances(amount * sizeof(InstanceTransform),
+                                     "Asteroid impostor instances");
+  for (const auto& mesh : rock.Meshes()) {
+    glBindVertexArray(mesh.vao());
+    glBindBuffer(GL_ARRAY_BUFFER, mesh_instances.Id());
+    SetInstanceTransformAttributes(3);
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  rock_impostor.SetInstanceBuffer(impostor_instances.Id());
+
+  std::size_t rock_vertices = 0;
+  for (const auto& mesh : rock.Meshes()) {
+    rock_vertices += mesh.indices.size();
+  }
+
+  // Print the split and the frame time once per second
+  float last_report = 0.0f;
+  unsigned int frames = 0;
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    // Render
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    shader.Use();
+    shader.SetInt("texture1", 0);
+
+    // Using lookAt...
+    auto view = camera.GetViewMatrix();
+    shader.SetMat4("view", view);
+
+    // Use perspective projection
+    glm::mat4 projection;
+    projection = glm::perspective(
+        glm::radians(camera.GetFieldOfView()),
+        static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+        0.1f, 1000.0f);
+    shader.SetMat4("projection", projection);
+
+    // Draw planets
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
+    shader.SetMat4("model", model);
+    planet.Draw(shader);
+
+    // Split the rocks straight into this frame's regions. Without
+    // impostors every rock is a mesh and none fades.
+    const float impostor_distance =
+        impostors ? kImpostorDistance : std::numeric_limits<float>::max();
+    auto* mesh_region =
+        static_cast<InstanceTransform*>(mesh_instances.BeginFrame());
+    auto* impostor_region =
+        static_cast<InstanceTransform*>(impostor_instances.BeginFrame());
+    const ImpostorSplit split =
+        SplitByDistance(rocks.data(), amount, camera.Position(),
+                        impostor_distance, kFadeBand, mesh_region,
+                        impostor_region);
+
+    // Draw the near rocks as meshes. The base instance selects the region:
+    // instanced attributes start fetching at it.
+    near_shader.Use();
+    near_shader.SetInt("texture1", 0);
+    near_shader.SetMat4("view", view);
+    near_shader.SetMat4("projection", projection);
+    near_shader.SetVec3("cameraPosition", camera.Position());
+    near_shader.SetFloat("impostorDistance", impostor_distance);
+    near_shader.SetFloat("fadeBand", kFadeBand);
+    near_shader.SetVec3("lightDirection", light_direction);
+    glBindTexture(GL_TEXTURE_2D, rock_texture);
+    for (unsigned int i = 0; i < rock.Meshes().size(); i++) {
+      glBindVertexArray(rock.Meshes()[i].vao());
+      glDrawElementsInstancedBaseInstance(
+          GL_TRIANGLES, rock.Meshes()[i].indices.size(), GL_UNSIGNED_INT, 0,
+          split.mesh_count, mesh_instances.Region() * amount);
+    }
+    glBindVertexArray(0);
+
+    // And the far ones as impostors
+    impostor_shader.Use();
+    impostor_shader.SetMat4("view", view);
+    impostor_shader.SetMat4("projection", projection);
+    impostor_shader.SetVec3("cameraPosition", camera.Position());
+    impostor_shader.SetFloat("impostorDistance", impostor_distance);
+    impostor_shader.SetFloat("fadeBand", kFadeBand);
+    impostor_shader.SetVec3("lightDirection", light_direction);
+    rock_impostor.Draw(impostor_shader, impostor_instances.Region() * amount,
+                       split.impostor_count);
+    mesh_instances.EndFrame();
+    impostor_instances.EndFrame();
+
+    frames++;
+    if (current_frame - last_report >= 1.0f) {
+      std::cout << "Rocks: " << split.mesh_count << " meshes, "
+                << split.impostor_count << " impostors, "
+                << (split.mesh_count * rock_vertices +
+                    split.impostor_count * 4) /
+                       1000
+                << "K vertices, "
+                << 1000.0f * (current_frame - last_report) / frames
+                << " ms per frame\n";
+      last_report = current_frame;
+      frames = 0;
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS &&
+      !impostors_key_pressed) {
+    impostors_key_pressed = true;
+    impostors = !impostors;
+  }
+  if (glfwGetKey(window, GLFW_KEY_I) == GLFW_RELEASE) {
+    impostors_key_pressed = false;
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
+
+unsigned int LoadTexture(char const* path) {
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+
+  int width;
+  int height;
+  int component_count;
+  auto* data = stbi_load(path, &width, &height, &component_count, 0);
+  if (data) {
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stbi_image_free(data);
+  } else {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    stbi_image_free(data);
+  }
+
+  return texture_id;
+}
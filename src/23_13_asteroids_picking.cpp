@@ -0,0 +1,291 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <vector>
+
+#include "asteroid_field.hpp"
+#include "bvh.hpp"
+#include "camera.hpp"
+#include "instance_transform.hpp"
+#include "model.hpp"
+#include "shader_m.hpp"
+#include "stb_include.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+// Press F to free the cursor and pick the rock under it instead of the one
+// at the center of the screen; looking around pauses meanwhile
+bool free_cursor = false;
+bool free_cursor_key_pressed = false;
+float cursor_x = 400;
+float cursor_y = 300;
+
+Camera camera(glm::vec3(0.0f, 0.0f, 155.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+
+  // Tell stb_image.h to flip loaded texture's on the y-axis (before loading
+  // model).
+  stbi_set_flip_vertically_on_load(true);
+
+  Shader shader("shaders/23_3_asteroids.vs", "shaders/15_1_depth_testing.fs");
+  Shader rock_shader("shaders/23_13_asteroids_picking.vs",
+                     "shaders/23_13_asteroids_picking.fs");
+
+  Model planet("assets/models/planet/planet.obj");
+  Model rock("assets/models/rock/rock.obj");
+
+  // The field is kept on the CPU for the instance BVH as well as uploaded
+  unsigned int amount = 100000;
+  AsteroidField field;
+  field.radius = 150.0f;
+  field.offset = 25.0f;
+  std::vector<InstanceTransform> rocks(amount);
+  GenerateAsteroidField(field, amount, rocks.data());
+
+  unsigned int instance_buffer;
+  glGenBuffers(1, &instance_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+  glBufferStorage(GL_ARRAY_BUFFER, amount * sizeof(InstanceTransform),
+                  rocks.data(), 0);
+  for (const auto& mesh : rock.Meshes()) {
+    glBindVertexArray(mesh.vao());
+    SetInstanceTransformAttributes(3);
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  const auto build_start = std::chrono::steady_clock::now();
+  InstanceBvh rock_bvh;
+  rock_bvh.Build(rocks.data(), amount, rock.BoundingSphere());
+  const std::chrono::duration<float, std::milli> build_time =
+      std::chrono::steady_clock::now() - build_start;
+  std::cout << "Instance BVH: " << rock_bvh.NodeCount() << " nodes over "
+            << amount << " rocks in " << build_time.count() << " ms\n";
+
+  // Meshes build their triangle BVHs on first use; do that here rather than
+  // in the first timed pick
+  for (const auto& mesh : rock.Meshes()) {
+    mesh.Bvh();
+  }
+
+  // Rays that reach an instance's bounds go on to the rock's triangles
+  const InstanceBvh::InstanceIntersector intersect_rock =
+      [&rock](std::uint32_t, const Ray& local_ray, RayHit* hit) {
+        return rock.Raycast(local_ray, hit);
+      };
+
+  // Print the average pick time once per second
+  float last_report = 0.0f;
+  unsigned int frames = 0;
+  float pick_time = 0.0f;
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    // Render
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    shader.Use();
+    shader.SetInt("texture1", 0);
+
+    // Using lookAt...
+    auto view = camera.GetViewMatrix();
+    shader.SetMat4("view", view);
+
+    // Use perspective projection
+    glm::mat4 projection;
+    projection = glm::perspective(
+        glm::radians(camera.GetFieldOfView()),
+        static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+        0.1f, 1000.0f);
+    shader.SetMat4("projection", projection);
+
+    // Draw planets
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
+    shader.SetMat4("model", model);
+    planet.Draw(shader);
+
+    // Pick the rock under the cursor, or at the center of the screen
+    glm::vec2 ndc(0.0f);
+    if (free_cursor) {
+      ndc = glm::vec2(2.0f * cursor_x / kScreenWidth - 1.0f,
+                      1.0f - 2.0f * cursor_y / kScreenHeight);
+    }
+    const auto pick_start = std::chrono::steady_clock::now();
+    RayHit hit;
+    const bool picked = rock_bvh.Intersect(camera.ScreenRay(projection, ndc),
+                                           intersect_rock, &hit);
+    const std::chrono::duration<float, std::micro> pick_elapsed =
+        std::chrono::steady_clock::now() - pick_start;
+    pick_time += pick_elapsed.count();
+
+    // Draw rocks
+    rock_shader.Use();
+    rock_shader.SetInt("texture1", 0);
+    rock_shader.SetMat4("view", view);
+    rock_shader.SetMat4("projection", projection);
+    rock_shader.SetInt("pickedInstance",
+                       picked ? static_cast<int>(hit.instance) : -1);
+    glBindTexture(GL_TEXTURE_2D, rock.Meshes()[0].textures[0].id);
+    for (unsigned int i = 0; i < rock.Meshes().size(); i++) {
+      glBindVertexArray(rock.Meshes()[i].vao());
+      glDrawElementsInstanced(GL_TRIANGLES, rock.Meshes()[i].indices.size(),
+                              GL_UNSIGNED_INT, 0, amount);
+    }
+
+    frames++;
+    if (current_frame - last_report >= 1.0f) {
+      std::cout << "Pick: " << pick_time / frames << " us";
+      if (picked) {
+        std::cout << ", rock " << hit.instance << " at distance "
+                  << hit.distance;
+      }
+      std::cout << "\n";
+      last_report = current_frame;
+      frames = 0;
+      pick_time = 0.0f;
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS &&
+      !free_cursor_key_pressed) {
+    free_cursor_key_pressed = true;
+    free_cursor = !free_cursor;
+    glfwSetInputMode(window, GLFW_CURSOR,
+                     free_cursor ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+    // The disabled cursor jumps; start looking from wherever it lands
+    first_mouse_position = true;
+  }
+  if (glfwGetKey(window, GLFW_KEY_F) == GLFW_RELEASE) {
+    free_cursor_key_pressed = false;
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  cursor_x = x_position;
+  cursor_y = y_position;
+  if (free_cursor) {
+    return;
+  }
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
@@ -6,9 +6,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <vector>
 
+#include "asteroid_field.hpp"
 #include "camera.hpp"
+#include "frustum_culling.hpp"
+#include "mip_builder.hpp"
 #include "model.hpp"
+#include "render_queue.hpp"
 #include "shader_m.hpp"
 #include "stb_include.hpp"
 
@@ -80,37 +85,19 @@ int main() {
   Model rock("assets/models/rock/rock.obj");
 
   unsigned int amount = 2000;
-  glm::mat4* model_matrices;
-  model_matrices = new glm::mat4[amount];
-  srand(glfwGetTime());
-  float radius = 50.0f;
-  float offset = 2.5f;
-  for (unsigned int i = 0; i < amount; i++) {
-    glm::mat4 model = glm::mat4(1.0f);
-    // Translation: displace along circle with 'radius' in range [-offset,
-    // offset]
-    float angle = (float)i / (float)amount * 360.0f;
-    float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-    float x = sin(angle) * radius + displacement;
-    displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-    // Keep height of asteroid field smaller compared to width of x and z
-    float y = displacement * 0.4f;
-    displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-    float z = cos(angle) * radius + displacement;
-    model = glm::translate(model, glm::vec3(x, y, z));
-  
-    // Scale: scale between 0.05 and 0.25
-    float scale=  (rand() % 20) / 100.0f + 0.05f;
-    model = glm::scale(model, glm::vec3(scale));
-
-    // Rotationn: Add random rotationn around a (semi) randomly picked rotation
-    // axis vector
-    float rotation_angle = (rand() % 360);
-    model = glm::rotate(model, rotation_angle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-    // Now add to list of matrices
-    model_matrices[i] = model;
-  }
+  // The same seed gives the same field on every run
+  AsteroidField field;
+  std::vector<glm::mat4> model_matrices(amount);
+  GenerateAsteroidField(field, amount, model_matrices.data());
+
+  // Rocks outside the view frustum are skipped before they reach the queue
+  InstanceCuller culler;
+  culler.SetInstances(model_matrices.data(), amount, rock.BoundingSphere());
+  std::vector<glm::mat4> visible_matrices(amount);
+
+  // Draws are recorded every frame and submitted sorted by shader, material
+  // and depth
+  RenderQueue queue;
 
   // Render loop
   while (!glfwWindowShouldClose(window)) {
@@ -146,19 +133,23 @@ int main() {
         0.1f, 100.0f);
     shader.SetMat4("projection", projection);
 
+    queue.Begin(camera.Position(), /*far_plane=*/100.0f);
+
     // Draw planets
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
     model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
-    shader.SetMat4("model", model);
-    planet.Draw(shader);
+    planet.Enqueue(queue, shader, model);
 
-    // Draw rocks
-    for (unsigned int i = 0; i < amount; i++) {
-      shader.SetMat4("model", model_matrices[i]);
-      rock.Draw(shader);
+    // Draw the rocks inside the view frustum
+    const std::size_t visible_count = culler.Cull(
+        ExtractFrustum(projection * view), visible_matrices.data());
+    for (std::size_t i = 0; i < visible_count; i++) {
+      rock.Enqueue(queue, shader, visible_matrices[i]);
     }
 
+    queue.Submit();
+
     // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
     glfwSwapBuffers(window);
     glfwPollEvents();
@@ -223,23 +214,13 @@ unsigned int LoadTexture(char const* path) {
   int component_count;
   auto* data = stbi_load(path, &width, &height, &component_count, 0);
   if (data) {
-    GLenum format;
-    switch (component_count) {
-      case 1:
-        format = GL_RED;
-        break;
-      case 3:
-        format = GL_RGB;
-        break;
-      case 4:
-        format = GL_RGBA;
-        break;
-    };
-
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -2,12 +2,17 @@
 // Do not sort above glad
 #include <GLFW/glfw3.h>
 
+#include <chrono>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <vector>
 
+#include "asteroid_field.hpp"
 #include "camera.hpp"
+#include "frustum_culling.hpp"
+#include "mip_builder.hpp"
 #include "model.hpp"
 #include "shader_m.hpp"
 #include "stb_include.hpp"
@@ -81,44 +86,23 @@ int main() {
   Model rock("assets/models/rock/rock.obj");
 
   unsigned int amount = 5000;
-  glm::mat4* model_matrices;
-  model_matrices = new glm::mat4[amount];
-  srand(glfwGetTime());
-  float radius = 50.0f;
-  float offset = 2.5f;
-  for (unsigned int i = 0; i < amount; i++) {
-    glm::mat4 model = glm::mat4(1.0f);
-    // Translation: displace along circle with 'radius' in range [-offset,
-    // offset]
-    float angle = (float)i / (float)amount * 360.0f;
-    float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-    float x = sin(angle) * radius + displacement;
-    displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-    // Keep height of asteroid field smaller compared to width of x and z
-    float y = displacement * 0.4f;
-    displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-    float z = cos(angle) * radius + displacement;
-    model = glm::translate(model, glm::vec3(x, y, z));
-
-    // Scale: scale between 0.05 and 0.25
-    float scale = (rand() % 20) / 100.0f + 0.05f;
-    model = glm::scale(model, glm::vec3(scale));
-
-    // Rotationn: Add random rotationn around a (semi) randomly picked rotation
-    // axis vector
-    float rotation_angle = (rand() % 360);
-    model = glm::rotate(model, rotation_angle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-    // Now add to list of matrices
-    model_matrices[i] = model;
-  }
+  // The same seed gives the same field on every run
+  AsteroidField field;
+  std::vector<glm::mat4> model_matrices(amount);
+  GenerateAsteroidField(field, amount, model_matrices.data());
+
+  // Only the rocks inside the view frustum are drawn. The survivors'
+  // matrices are packed into the front of the instance buffer every frame.
+  InstanceCuller culler;
+  culler.SetInstances(model_matrices.data(), amount, rock.BoundingSphere());
+  std::vector<glm::mat4> visible_matrices(amount);
 
   // Vertex Buffer for instance matrices
   unsigned int buffer;
   glGenBuffers(1, &buffer);
   glBindBuffer(GL_ARRAY_BUFFER, buffer);
-  glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &model_matrices[0],
-               GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), nullptr,
+               GL_STREAM_DRAW);
 
   for (unsigned int i = 0; i < rock.Meshes().size(); i++) {
     // We want to instance each MESH (since each mesh has its own VAO).
@@ -149,6 +133,9 @@ int main() {
     glBindVertexArray(0);
   }
 
+  // Print the culling statistics once per second
+  float last_report = 0.0f;
+
   // Render loop
   while (!glfwWindowShouldClose(window)) {
     // Calculate delta time
@@ -190,6 +177,20 @@ int main() {
     shader.SetMat4("model", model);
     planet.Draw(shader);
 
+    // Cull the rocks and upload the visible ones, orphaning the storage the
+    // previous frame's draws may still be reading
+    const auto cull_start = std::chrono::steady_clock::now();
+    const std::size_t visible_count = culler.Cull(
+        ExtractFrustum(projection * view), visible_matrices.data());
+    const std::chrono::duration<float, std::milli> cull_time =
+        std::chrono::steady_clock::now() - cull_start;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), nullptr,
+                 GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, visible_count * sizeof(glm::mat4),
+                    visible_matrices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
     // Draw rocks
     instanced_shader.Use();
     instanced_shader.SetInt("texture1", 0);
@@ -198,7 +199,13 @@ int main() {
     for (unsigned int i = 0; i < rock.Meshes().size(); i++) {
       glBindVertexArray(rock.Meshes()[i].vao());
       glDrawElementsInstanced(GL_TRIANGLES, rock.Meshes()[i].indices.size(),
-                              GL_UNSIGNED_INT, 0, amount);
+                              GL_UNSIGNED_INT, 0, visible_count);
+    }
+
+    if (current_frame - last_report >= 1.0f) {
+      last_report = current_frame;
+      std::cout << "Visible rocks: " << visible_count << " of " << amount
+                << ", culled in " << cull_time.count() << " ms\n";
     }
 
     // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
@@ -265,23 +272,13 @@ unsigned int LoadTexture(char const* path) {
   int component_count;
   auto* data = stbi_load(path, &width, &height, &component_count, 0);
   if (data) {
-    GLenum format;
-    switch (component_count) {
-      case 1:
-        format = GL_RED;
-        break;
-      case 3:
-        format = GL_RGB;
-        break;
-      case 4:
-        format = GL_RGBA;
-        break;
-    };
-
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
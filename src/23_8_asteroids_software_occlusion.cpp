@@ -0,0 +1,352 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <future>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <vector>
+
+#include "asteroid_field.hpp"
+#include "camera.hpp"
+#include "frustum_culling.hpp"
+#include "mip_builder.hpp"
+#include "model.hpp"
+#include "shader_m.hpp"
+#include "software_occlusion.hpp"
+#include "stb_include.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+// The occluder sphere is shrunk so it stays inside the planet's faces, with
+// a gap for the pixels it only partly covers
+constexpr float kOccluderScale = 0.9f;
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+unsigned int LoadTexture(char const* path);
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+// Cull rocks hidden behind the planet
+bool occlusion_culling = true;
+bool occlusion_culling_key_pressed = false;
+
+Camera camera(glm::vec3(0.0f, 0.0f, 55.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+
+  // Tell stb_image.h to flip loaded texture's on the y-axis (before loading
+  // model).
+  stbi_set_flip_vertically_on_load(true);
+
+  Shader shader("shaders/23_3_asteroids.vs", "shaders/15_1_depth_testing.fs");
+  Shader instanced_shader("shaders/23_4_asteroids_instanced.vs",
+                          "shaders/15_1_depth_testing.fs");
+
+  Model planet("assets/models/planet/planet.obj");
+  Model rock("assets/models/rock/rock.obj");
+
+  unsigned int amount = 5000;
+  // The same seed gives the same field on every run
+  AsteroidField field;
+  std::vector<glm::mat4> model_matrices(amount);
+  GenerateAsteroidField(field, amount, model_matrices.data());
+
+  // Only the rocks inside the view frustum and not hidden behind the planet
+  // are drawn. The survivors' matrices are packed into the front of the
+  // instance buffer every frame.
+  InstanceCuller culler;
+  culler.SetInstances(model_matrices.data(), amount, rock.BoundingSphere());
+  std::vector<glm::mat4> visible_matrices(amount);
+
+  // The planet is the only occluder, stood in for by a low polygon sphere
+  const glm::vec4 planet_sphere = planet.BoundingSphere();
+  const OccluderMesh planet_occluder = MakeOccluderSphere(
+      glm::vec4(glm::vec3(planet_sphere), planet_sphere.w * kOccluderScale),
+      8, 16);
+  OcclusionBuffer occlusion_buffer;
+
+  // Vertex Buffer for instance matrices
+  unsigned int buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), nullptr,
+               GL_STREAM_DRAW);
+
+  for (unsigned int i = 0; i < rock.Meshes().size(); i++) {
+    // We want to instance each MESH (since each mesh has its own VAO).
+    unsigned int vao = rock.Meshes()[i].vao();
+    glBindVertexArray(vao);
+    // Vertex attributes
+    // NOTE: The maximum amount allowed for a vertex attribute is a vec4.
+    // Because mat4 are basically 4 vec4s, we have to reserve 4 vertex
+    // attributes for this specific matrix - 3, 4, 5, and 6.
+    std::size_t vec4_size = sizeof(glm::vec4);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 4 * vec4_size, (void*)0);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 4 * vec4_size,
+                          (void*)(1 * vec4_size));
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, 4 * vec4_size,
+                          (void*)(2 * vec4_size));
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 4 * vec4_size,
+                          (void*)(3 * vec4_size));
+    glEnableVertexAttribArray(6);
+
+    glVertexAttribDivisor(3, 1);
+    glVertexAttribDivisor(4, 1);
+    glVertexAttribDivisor(5, 1);
+    glVertexAttribDivisor(6, 1);
+
+    glBindVertexArray(0);
+  }
+
+  // Print the culling statistics once per second
+  float last_report = 0.0f;
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    // Render
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    shader.Use();
+    shader.SetInt("texture1", 0);
+
+    // Using lookAt...
+    auto view = camera.GetViewMatrix();
+    shader.SetMat4("view", view);
+
+    // Use perspective projection
+    glm::mat4 projection;
+    projection = glm::perspective(
+        glm::radians(camera.GetFieldOfView()),
+        static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+        0.1f, 100.0f);
+    shader.SetMat4("projection", projection);
+
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
+
+    // Rasterize the occluders on a worker while this thread submits the
+    // planet
+    std::future<void> occluders_ready;
+    if (occlusion_culling) {
+      occlusion_buffer.Begin(projection * view);
+      // The gap between the planet and its occluder must span a pixel of the
+      // buffer, so from far away the planet hides nothing
+      const glm::vec3 planet_center =
+          glm::vec3(model * glm::vec4(glm::vec3(planet_sphere), 1.0f));
+      const float occluder_gap = (1.0f - kOccluderScale) * planet_sphere.w *
+                                 glm::length(glm::vec3(model[0]));
+      if (occluder_gap >= occlusion_buffer.PixelSize(planet_center)) {
+        occlusion_buffer.AddOccluder(planet_occluder, model);
+      }
+      occluders_ready = occlusion_buffer.RasterizeAsync();
+    }
+
+    // Draw planets
+    shader.SetMat4("model", model);
+    planet.Draw(shader);
+
+    // Cull the rocks and upload the visible ones, orphaning the storage the
+    // previous frame's draws may still be reading
+    CullOptions cull_options;
+    if (occlusion_culling) {
+      occluders_ready.wait();
+      cull_options.occluders = &occlusion_buffer;
+    }
+    const auto cull_start = std::chrono::steady_clock::now();
+    const std::size_t visible_count = culler.Cull(
+        ExtractFrustum(projection * view), visible_matrices.data(),
+        cull_options);
+    const std::chrono::duration<float, std::milli> cull_time =
+        std::chrono::steady_clock::now() - cull_start;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), nullptr,
+                 GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, visible_count * sizeof(glm::mat4),
+                    visible_matrices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Draw rocks
+    instanced_shader.Use();
+    instanced_shader.SetInt("texture1", 0);
+    instanced_shader.SetMat4("view", view);
+    instanced_shader.SetMat4("projection", projection);
+    for (unsigned int i = 0; i < rock.Meshes().size(); i++) {
+      glBindVertexArray(rock.Meshes()[i].vao());
+      glDrawElementsInstanced(GL_TRIANGLES, rock.Meshes()[i].indices.size(),
+                              GL_UNSIGNED_INT, 0, visible_count);
+    }
+
+    if (current_frame - last_report >= 1.0f) {
+      last_report = current_frame;
+      std::cout << "Visible rocks: " << visible_count << " of " << amount
+                << ", culled in " << cull_time.count() << " ms";
+      if (occlusion_culling) {
+        std::cout << ", " << culler.OccludedCount()
+                  << " occluded; occluders rasterized in "
+                  << occlusion_buffer.RasterTime() << " ms ("
+                  << occlusion_buffer.TriangleCount() << " triangles)";
+      }
+      std::cout << "\n";
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS &&
+      !occlusion_culling_key_pressed) {
+    occlusion_culling_key_pressed = true;
+    occlusion_culling = !occlusion_culling;
+  }
+  if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE) {
+    occlusion_culling_key_pressed = false;
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
+
+unsigned int LoadTexture(char const* path) {
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+
+  int width;
+  int height;
+  int component_count;
+  auto* data = stbi_load(path, &width, &height, &component_count, 0);
+  if (data) {
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stbi_image_free(data);
+  } else {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    stbi_image_free(data);
+  }
+
+  return texture_id;
+}
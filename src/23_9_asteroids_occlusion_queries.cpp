@@ -0,0 +1,410 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "asteroid_field.hpp"
+#include "camera.hpp"
+#include "frustum_culling.hpp"
+#include "mip_builder.hpp"
+#include "model.hpp"
+#include "occlusion_query.hpp"
+#include "shader_m.hpp"
+#include "stb_include.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+// The ring is split into this many wedges around the planet, each drawn
+// under one occlusion query
+constexpr int kSectorCount = 64;
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+unsigned int LoadTexture(char const* path);
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+// Only draw a sector of rocks when its bounding box is not hidden behind the
+// planet
+bool conditional_rendering = true;
+bool conditional_rendering_key_pressed = false;
+
+Camera camera(glm::vec3(0.0f, 0.0f, 55.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+
+  // Tell stb_image.h to flip loaded texture's on the y-axis (before loading
+  // model).
+  stbi_set_flip_vertically_on_load(true);
+
+  Shader shader("shaders/23_3_asteroids.vs", "shaders/15_1_depth_testing.fs");
+  Shader instanced_shader("shaders/23_4_asteroids_instanced.vs",
+                          "shaders/15_1_depth_testing.fs");
+  Shader box_shader("shaders/8_1_colors.vs", "shaders/8_1_light.fs");
+
+  Model planet("assets/models/planet/planet.obj");
+  Model rock("assets/models/rock/rock.obj");
+
+  unsigned int amount = 5000;
+  // The same seed gives the same field on every run
+  AsteroidField field;
+  std::vector<glm::mat4> model_matrices(amount);
+  GenerateAsteroidField(field, amount, model_matrices.data());
+
+  // Group the rocks by sector, so every sector is one contiguous range of
+  // instances
+  const auto sector_of = [](const glm::mat4& matrix) {
+    const float angle = std::atan2(matrix[3][2], matrix[3][0]);
+    const int sector = static_cast<int>((angle + glm::pi<float>()) /
+                                        glm::two_pi<float>() * kSectorCount);
+    return std::min(sector, kSectorCount - 1);
+  };
+  std::stable_sort(model_matrices.begin(), model_matrices.end(),
+                   [&](const glm::mat4& a, const glm::mat4& b) {
+                     return sector_of(a) < sector_of(b);
+                   });
+  std::vector<unsigned int> sector_first(kSectorCount + 1, 0);
+  for (const auto& matrix : model_matrices) {
+    sector_first[sector_of(matrix) + 1]++;
+  }
+  for (int sector = 0; sector < kSectorCount; sector++) {
+    sector_first[sector + 1] += sector_first[sector];
+  }
+
+  // Every sector is bounded by the box around its rocks' bounding spheres
+  const glm::vec4 rock_sphere = rock.BoundingSphere();
+  std::vector<glm::mat4> sector_boxes(kSectorCount, glm::mat4(1.0f));
+  for (int sector = 0; sector < kSectorCount; sector++) {
+    glm::vec3 minimum(std::numeric_limits<float>::max());
+    glm::vec3 maximum(std::numeric_limits<float>::lowest());
+    for (unsigned int i = sector_first[sector]; i < sector_first[sector + 1];
+         i++) {
+      const glm::mat4& matrix = model_matrices[i];
+      const glm::vec3 center =
+          glm::vec3(matrix * glm::vec4(glm::vec3(rock_sphere), 1.0f));
+      const float radius =
+          rock_sphere.w * std::max({glm::length(glm::vec3(matrix[0])),
+                                    glm::length(glm::vec3(matrix[1])),
+                                    glm::length(glm::vec3(matrix[2]))});
+      minimum = glm::min(minimum, center - radius);
+      maximum = glm::max(maximum, center + radius);
+    }
+    if (sector_first[sector] < sector_first[sector + 1]) {
+      const glm::vec3 center = 0.5f * (minimum + maximum);
+      sector_boxes[sector] =
+          glm::scale(glm::translate(glm::mat4(1.0f), center),
+                     0.5f * (maximum - minimum));
+    }
+  }
+
+  // Only the rocks inside the view frustum are drawn. Every frame the
+  // survivors' matrices are packed into the front of their sector's range
+  // of the instance buffer.
+  std::vector<InstanceCuller> sector_cullers(kSectorCount);
+  for (int sector = 0; sector < kSectorCount; sector++) {
+    sector_cullers[sector].SetInstances(
+        model_matrices.data() + sector_first[sector],
+        sector_first[sector + 1] - sector_first[sector], rock_sphere);
+  }
+  std::vector<glm::mat4> visible_matrices(amount);
+  std::vector<std::size_t> sector_visible(kSectorCount);
+
+  // Vertex Buffer for instance matrices
+  unsigned int buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), nullptr,
+               GL_STREAM_DRAW);
+
+  for (unsigned int i = 0; i < rock.Meshes().size(); i++) {
+    // We want to instance each MESH (since each mesh has its own VAO).
+    unsigned int vao = rock.Meshes()[i].vao();
+    glBindVertexArray(vao);
+    // Vertex attributes
+    // NOTE: The maximum amount allowed for a vertex attribute is a vec4.
+    // Because mat4 are basically 4 vec4s, we have to reserve 4 vertex
+    // attributes for this specific matrix - 3, 4, 5, and 6.
+    std::size_t vec4_size = sizeof(glm::vec4);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 4 * vec4_size, (void*)0);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 4 * vec4_size,
+                          (void*)(1 * vec4_size));
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, 4 * vec4_size,
+                          (void*)(2 * vec4_size));
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 4 * vec4_size,
+                          (void*)(3 * vec4_size));
+    glEnableVertexAttribArray(6);
+
+    glVertexAttribDivisor(3, 1);
+    glVertexAttribDivisor(4, 1);
+    glVertexAttribDivisor(5, 1);
+    glVertexAttribDivisor(6, 1);
+
+    glBindVertexArray(0);
+  }
+
+  // The planet is drawn first, then every sector on the condition that its
+  // bounding box passes the depth test against the planet
+  ConditionalRenderer conditional_renderer;
+  unsigned int sector_queries = 0;
+  unsigned int sector_passed = 0;
+
+  // Print the culling statistics once per second
+  float last_report = 0.0f;
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    // Render
+    conditional_renderer.BeginFrame();
+    sector_queries += conditional_renderer.Queries().AvailableCount();
+    sector_passed += conditional_renderer.Queries().PassedCount();
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    shader.Use();
+    shader.SetInt("texture1", 0);
+
+    // Using lookAt...
+    auto view = camera.GetViewMatrix();
+    shader.SetMat4("view", view);
+
+    // Use perspective projection
+    glm::mat4 projection;
+    projection = glm::perspective(
+        glm::radians(camera.GetFieldOfView()),
+        static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+        0.1f, 100.0f);
+    shader.SetMat4("projection", projection);
+
+    // Cull the rocks and upload the visible ones, orphaning the storage the
+    // previous frame's draws may still be reading
+    const Frustum frustum = ExtractFrustum(projection * view);
+    const auto cull_start = std::chrono::steady_clock::now();
+    std::size_t visible_count = 0;
+    for (int sector = 0; sector < kSectorCount; sector++) {
+      sector_visible[sector] = sector_cullers[sector].Cull(
+          frustum, visible_matrices.data() + sector_first[sector]);
+      visible_count += sector_visible[sector];
+    }
+    const std::chrono::duration<float, std::milli> cull_time =
+        std::chrono::steady_clock::now() - cull_start;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), nullptr,
+                 GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, amount * sizeof(glm::mat4),
+                    visible_matrices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Draw the planet first, it is what hides the rocks
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
+    shader.SetMat4("model", model);
+    planet.Draw(shader);
+
+    // Draw rocks
+    box_shader.Use();
+    box_shader.SetMat4("view", view);
+    box_shader.SetMat4("projection", projection);
+    instanced_shader.Use();
+    instanced_shader.SetInt("texture1", 0);
+    instanced_shader.SetMat4("view", view);
+    instanced_shader.SetMat4("projection", projection);
+    for (int sector = 0; sector < kSectorCount; sector++) {
+      if (sector_visible[sector] == 0) {
+        continue;
+      }
+      const auto draw_sector = [&]() {
+        instanced_shader.Use();
+        for (unsigned int i = 0; i < rock.Meshes().size(); i++) {
+          glBindVertexArray(rock.Meshes()[i].vao());
+          glDrawElementsInstancedBaseInstance(
+              GL_TRIANGLES, rock.Meshes()[i].indices.size(), GL_UNSIGNED_INT,
+              0, sector_visible[sector], sector_first[sector]);
+        }
+      };
+      if (conditional_rendering) {
+        conditional_renderer.Draw(box_shader, sector_boxes[sector],
+                                  camera.Position(), draw_sector);
+      } else {
+        draw_sector();
+      }
+    }
+
+    if (current_frame - last_report >= 1.0f) {
+      last_report = current_frame;
+      std::cout << "Visible rocks: " << visible_count << " of " << amount
+                << ", culled in " << cull_time.count() << " ms\n";
+      if (conditional_rendering) {
+        std::cout << "Sectors drawn in " << sector_passed << " of "
+                  << sector_queries << " queries, "
+                  << conditional_renderer.Queries().Size()
+                  << " query objects\n";
+      }
+      sector_queries = 0;
+      sector_passed = 0;
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS &&
+      !conditional_rendering_key_pressed) {
+    conditional_rendering_key_pressed = true;
+    conditional_rendering = !conditional_rendering;
+  }
+  if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_RELEASE) {
+    conditional_rendering_key_pressed = false;
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
+
+unsigned int LoadTexture(char const* path) {
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+
+  int width;
+  int height;
+  int component_count;
+  auto* data = stbi_load(path, &width, &height, &component_count, 0);
+  if (data) {
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stbi_image_free(data);
+  } else {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    stbi_image_free(data);
+  }
+
+  return texture_id;
+}
@@ -8,8 +8,8 @@
 #include <iostream>
 
 #include "camera.hpp"
+#include "post_process.hpp"
 #include "shader_m.hpp"
-#include "stb_include.hpp"
 
 // Default settings
 constexpr unsigned int kScreenWidth = 800;
@@ -21,7 +21,6 @@ void ProcessInput(GLFWwindow* window);
 void MouseCursorCallback(GLFWwindow* window, double x_position,
                          double y_position);
 void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
-unsigned int LoadTexture(char const* path);
 
 // Time between current frame and last frame
 float delta_time = 0.0f;
@@ -75,14 +74,8 @@ int main() {
   // enabled by default so this is a bit redundant.
   glEnable(GL_MULTISAMPLE);
 
-  // Tell stb_image.h to flip loaded texture's on the y-axis (before loading
-  // model).
-  stbi_set_flip_vertically_on_load(true);
-
   Shader shader("shaders/24_1_anti_aliasing_msaa.vs",
                 "shaders/24_1_anti_aliasing_msaa.fs");
-  Shader screen_shader("shaders/19_1_framebuffers.vs",
-                       "shaders/19_2_framebuffers_grayscale.fs");
 
   // Set up vertex data and buffers and configure vertex attributes
   // Cube vertices: position (x, y, z),
@@ -105,18 +98,6 @@ int main() {
       -0.5f, 0.5f,  -0.5f, 0.5f,  0.5f,  -0.5f, 0.5f,  0.5f,  0.5f,
       0.5f,  0.5f,  0.5f,  -0.5f, 0.5f,  0.5f,  -0.5f, 0.5f,  -0.5};
 
-  // Vertex for quad that fills the entire screen in normalized device
-  // coordinates. Position (x, y), Texture Coordinates (s, t).
-  float quad_vertices[] = {
-      -1.0f, 1.0f,  0.0f, 1.0f,  //
-      -1.0f, -1.0f, 0.0f, 0.0f,  //
-      1.0f,  -1.0f, 1.0f, 0.0f,  //
-
-      -1.0f, 1.0f,  0.0f, 1.0f,  //
-      1.0f,  -1.0f, 1.0f, 0.0f,  //
-      1.0f,  1.0f,  1.0f, 1.0f   //
-  };
-
   // Cube VAO
   unsigned int cube_vao;
   glGenVertexArrays(1, &cube_vao);
@@ -131,22 +112,6 @@ int main() {
   glEnableVertexAttribArray(0);
   glBindVertexArray(0);
 
-  // Quad VAO
-  unsigned int quad_vao;
-  glGenVertexArrays(1, &quad_vao);
-  glBindVertexArray(quad_vao);
-
-  unsigned int quad_vbo;
-  glGenBuffers(1, &quad_vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), &quad_vertices,
-               GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
-                        (void*)(2 * sizeof(float)));
-  glEnableVertexAttribArray(1);
-
   // MSAA: Configure MSAA framebuffer
   // GLSL takes care of creating multisampled buffers, which makes MSAA easy.
   // But, if we want to use our own framebuffers, we have to generate
@@ -161,7 +126,7 @@ int main() {
   glGenTextures(1, &texture_color_buffer_multisampled);
   glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture_color_buffer_multisampled);
   constexpr int sample_count = 4;
-  glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, sample_count, GL_RGB,
+  glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, sample_count, GL_RGBA8,
                           kScreenWidth, kScreenHeight, GL_TRUE);
   glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
 
@@ -191,27 +156,14 @@ int main() {
 
   // If we want to apply post-processing to the multisampled buffer, we can't
   // use the multisampled texture directly in the fragment shader. BUT, we can
-  // blit to a different fbo.
-  unsigned int intermediate_fbo;
-  glGenFramebuffers(1, &intermediate_fbo);
-  glBindFramebuffer(GL_FRAMEBUFFER, intermediate_fbo);
-
-  // Create a color attachment texture which will be rendered to quad
-  unsigned int screen_texture;
-  glGenTextures(1, &screen_texture);
-  glBindTexture(GL_TEXTURE_2D, screen_texture);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, kScreenWidth, kScreenHeight, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, nullptr);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  // Note: We only need a color buffer
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-                         screen_texture, 0);
-
-  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-    std::cerr << "Error: Intermediate framebuffer is not complete\n";
-  }
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  // blit to a different fbo: the post process stack resolves the scene into
+  // a target of its own, whose format must match the multisampled one.
+  PostProcessOptions post_process_options;
+  post_process_options.format = GL_RGBA8;
+  PostProcessStack post_process(kScreenWidth, kScreenHeight,
+                                post_process_options);
+  post_process.Build({{"grayscale", PostEffectAccess::PIXEL,
+                       "shaders/19_6_grayscale.glsl", {}, {}}});
 
   // Render loop
   while (!glfwWindowShouldClose(window)) {
@@ -255,28 +207,9 @@ int main() {
     glBindVertexArray(cube_vao);
     glDrawArrays(GL_TRIANGLES, 0, 36);
 
-    // Render: Blit the multisampled buffer to normal colorbuffer of
-    // intermediate FBO. Image is stored in screen_texture.
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediate_fbo);
-    // Blit transfers a given source region (defined by 4 screen coordinates) to
-    // a target regionn (also defined by 4 screen coordinates).
-    glBlitFramebuffer(0, 0, kScreenWidth, kScreenHeight, 0, 0, kScreenWidth,
-                      kScreenHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-    // Render: Quad with scene's visuals as its texture image
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glDisable(GL_DEPTH_TEST);
-
-    // Draw quad
-    screen_shader.Use();
-    screen_shader.SetInt("screenTexture", 0);
-    glBindVertexArray(quad_vao);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, screen_texture);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    // Render: Resolve the multisampled buffer and draw it to the screen in
+    // grayscale
+    post_process.RunFromFramebuffer(framebuffer, 0);
 
     // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
     glfwSwapBuffers(window);
@@ -347,45 +280,3 @@ void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
 void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
   camera.ProcessFieldOfView(y_offset);
 }
-
-unsigned int LoadTexture(char const* path) {
-  unsigned int texture_id;
-  glGenTextures(1, &texture_id);
-
-  int width;
-  int height;
-  int component_count;
-  auto* data = stbi_load(path, &width, &height, &component_count, 0);
-  if (data) {
-    GLenum format;
-    switch (component_count) {
-      case 1:
-        format = GL_RED;
-        break;
-      case 3:
-        format = GL_RGB;
-        break;
-      case 4:
-        format = GL_RGBA;
-        break;
-    };
-
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                    GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    stbi_image_free(data);
-  } else {
-    std::cerr << "Texture failed to load at path: " << path << "\n";
-    stbi_image_free(data);
-  }
-
-  return texture_id;
-}
@@ -8,6 +8,8 @@
 #include <iostream>
 
 #include "camera.hpp"
+#include "ktx2_texture.hpp"
+#include "mip_builder.hpp"
 #include "model.hpp"
 #include "shader_m.hpp"
 #include "stb_include.hpp"
@@ -251,6 +253,13 @@ void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
 }
 
 unsigned int LoadTexture(char const* path, bool gamma_corrected) {
+  // Prefer the offline block-compressed version of the texture when present
+  const unsigned int compressed_id =
+      LoadKtx2Texture(Ktx2PathFor(path), gamma_corrected);
+  if (compressed_id != 0) {
+    return compressed_id;
+  }
+
   unsigned int texture_id;
   glGenTextures(1, &texture_id);
 
@@ -259,27 +268,13 @@ unsigned int LoadTexture(char const* path, bool gamma_corrected) {
   int component_count;
   auto* data = stbi_load(path, &width, &height, &component_count, 0);
   if (data) {
-    GLenum data_format;
-    GLenum internal_format;
-    switch (component_count) {
-      case 1:
-        internal_format = GL_RED;
-        data_format = GL_RED;
-        break;
-      case 3:
-        data_format = GL_RGB;
-        internal_format = gamma_corrected ? GL_SRGB : GL_RGB;
-        break;
-      case 4:
-        data_format = GL_RGBA;
-        internal_format = gamma_corrected ? GL_SRGB_ALPHA : GL_RGBA;
-        break;
-    };
-
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0,
-                 data_format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/gamma_corrected);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
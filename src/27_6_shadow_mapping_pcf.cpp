@@ -8,6 +8,9 @@
 #include <iostream>
 
 #include "camera.hpp"
+#include "gpu_resources.hpp"
+#include "ktx2_texture.hpp"
+#include "mip_builder.hpp"
 #include "model.hpp"
 #include "shader_m.hpp"
 #include "stb_include.hpp"
@@ -130,6 +133,11 @@ int main() {
   glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, kShadowWidth,
                kShadowHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT,
                /*pixels=*/nullptr);
+  GpuResources().Track(
+      GpuResourceKind::TEXTURE, depth_map,
+      {GpuResourceCategory::SHADOW_MAP,
+       TextureBytes(GL_DEPTH_COMPONENT, kShadowWidth, kShadowHeight),
+       GL_DEPTH_COMPONENT, "Directional light shadow map"});
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -167,6 +175,9 @@ int main() {
   // Light position
   glm::vec3 light_position(-2.0f, 4.0f, -1.0f);
 
+  // Report what the setup allocated on the GPU
+  GpuResources().Dump(std::cout);
+
   // Render loop
   while (!glfwWindowShouldClose(window)) {
     // Calculate delta time
@@ -302,6 +313,12 @@ void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
 }
 
 unsigned int LoadTexture(char const* path) {
+  // Prefer the offline block-compressed version of the texture when present
+  const unsigned int compressed_id = LoadKtx2Texture(Ktx2PathFor(path));
+  if (compressed_id != 0) {
+    return compressed_id;
+  }
+
   unsigned int texture_id;
   glGenTextures(1, &texture_id);
 
@@ -310,23 +327,13 @@ unsigned int LoadTexture(char const* path) {
   int component_count;
   auto* data = stbi_load(path, &width, &height, &component_count, 0);
   if (data) {
-    GLenum format;
-    switch (component_count) {
-      case 1:
-        format = GL_RED;
-        break;
-      case 3:
-        format = GL_RGB;
-        break;
-      case 4:
-        format = GL_RGBA;
-        break;
-    };
-
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
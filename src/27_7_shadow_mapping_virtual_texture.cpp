@@ -0,0 +1,547 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <vector>
+
+#include "camera.hpp"
+#include "gpu_resources.hpp"
+#include "ktx2_texture.hpp"
+#include "mip_builder.hpp"
+#include "model.hpp"
+#include "shader_m.hpp"
+#include "stb_include.hpp"
+#include "virtual_texture.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+unsigned int LoadTexture(char const* path);
+std::vector<MipLevel> LoadMipChainRgba(char const* path);
+
+// Render declarations
+void RenderCube();
+void RenderQuad();
+void RenderScene(const Shader& shader);
+
+// Meshes
+unsigned int plane_vao;
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+
+  Shader depth_shader("shaders/27_1_shadow_mapping_depth.vs",
+                      "shaders/27_1_shadow_mapping_depth.fs");
+  Shader screen_shader("shaders/27_1_shadow_mapping_quad.vs",
+                       "shaders/27_1_shadow_mapping_quad.fs");
+  Shader shader("shaders/27_2_shadow_mapping_base.vs",
+                "shaders/27_7_shadow_mapping_virtual_texture.fs");
+  Shader feedback_shader("shaders/27_2_shadow_mapping_base.vs",
+                         "shaders/27_7_virtual_texture_feedback.fs");
+
+  // Position (x, y, z), normal (x, y, z), texture coordinates (s, t)
+  // Note: The floor is a kilometer across and maps the virtual texture once,
+  // so there is no GL_REPEAT tiling involved.
+  float plane_vertices[] = {
+      500.0f,  -0.5f, 500.0f,  0.0f, 1.0f, 0.0f, 1.0f, 0.0f,  //
+      -500.0f, -0.5f, 500.0f,  0.0f, 1.0f, 0.0f, 0.0f, 0.0f,  //
+      -500.0f, -0.5f, -500.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,  //
+
+      500.0f,  -0.5f, 500.0f,  0.0f, 1.0f, 0.0f, 1.0f, 0.0f,  //
+      -500.0f, -0.5f, -500.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,  //
+      500.0f,  -0.5f, -500.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f   //
+  };
+
+  // Plane VAO
+  glGenVertexArrays(1, &plane_vao);
+  glBindVertexArray(plane_vao);
+
+  unsigned int plane_vbo;
+  glGenBuffers(1, &plane_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, plane_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), &plane_vertices,
+               GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
+                        (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
+                        (void*)(6 * sizeof(float)));
+  glEnableVertexAttribArray(2);
+  glBindVertexArray(0);
+
+  // Shadow map depth buffer
+  unsigned int depth_map_fbo;
+  glGenFramebuffers(1, &depth_map_fbo);
+
+  const unsigned int kShadowWidth = 1024;
+  const unsigned int kShadowHeight = 1024;
+
+  // Create depth texture
+  unsigned int depth_map;
+  glGenTextures(1, &depth_map);
+  glBindTexture(GL_TEXTURE_2D, depth_map);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, kShadowWidth,
+               kShadowHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT,
+               /*pixels=*/nullptr);
+  GpuResources().Track(
+      GpuResourceKind::TEXTURE, depth_map,
+      {GpuResourceCategory::SHADOW_MAP,
+       TextureBytes(GL_DEPTH_COMPONENT, kShadowWidth, kShadowHeight),
+       GL_DEPTH_COMPONENT, "Directional light shadow map"});
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  // Over-sampling!
+  // We want all coordinates outside the depth map's range to have a depth of
+  // 1.0 (i.e. never in shadow).
+  // This only solves part of the problem - a light-space projected fragment
+  // outside of the frustrum has a z-coordinate larger than 1. See the fragment
+  // shader for fix.
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+  float border_color[] = {1.0f, 1.0f, 1.0f, 1.0f};
+  glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_color);
+
+  // Attach depth texture as FBO's depth buffer
+  glBindFramebuffer(GL_FRAMEBUFFER, depth_map_fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+                         depth_map, 0);
+  glDrawBuffer(GL_NONE);
+  glReadBuffer(GL_NONE);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  // Load texture
+  const auto wood_texture = LoadTexture("assets/textures/wood.png");
+
+  // The floor texture: 128 x 128 unique copies of the wood texture, 128K
+  // texels across, far more than fits into GPU memory at once (64 GiB for
+  // the top level alone). Only the pages the feedback pass asks for are
+  // produced, into a cache of 16 x 16 pages.
+  VirtualTexture virtual_texture(
+      /*virtual_size=*/128 * 1024, /*cache_pages_per_side=*/16,
+      TiledImageSource(LoadMipChainRgba("assets/textures/wood.png")),
+      kScreenWidth, kScreenHeight);
+
+  // Print the page statistics once per second
+  float last_report = 0.0f;
+
+  // See any example in the 19_*_framebuffers_* range
+  screen_shader.Use();
+  screen_shader.SetInt("depthMap", 0);
+
+  shader.Use();
+  shader.SetInt("diffuseTexture", 0);
+  shader.SetInt("shadowMap", 1);
+
+  // Light position
+  glm::vec3 light_position(-2.0f, 4.0f, -1.0f);
+
+  // Report what the setup allocated on the GPU
+  GpuResources().Dump(std::cout);
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    // Render
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Render the depth of the scene (from the light's perspective) to the
+    // texture.
+    depth_shader.Use();
+    float near_plane = 1.0f;
+    float far_plane = 7.5f;
+    glm::mat4 light_projection =
+        glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
+    glm::mat4 light_view = glm::lookAt(light_position, glm::vec3(0.0f),
+                                       glm::vec3(0.0f, 1.0f, 0.0));
+    glm::mat4 light_space_matrix = light_projection * light_view;
+    depth_shader.SetMat4("lightSpaceMatrix", light_space_matrix);
+
+    // Peter Panning!
+    // Because of our bias values (see previous example), we're actually
+    // applying an offset to the depth of objects. This CAN result in an offset
+    // of the actual shadow when compared to the object itself.
+    // To offset this, cull the front face. It doesn't matter whether we have
+    // shadows INSIDE the cube so this won't have any impact.
+    // NOTE: Only works for solid objects (insides without openings).
+    glCullFace(GL_FRONT);
+
+    // Shadow mapps often have a different resolution compared to what we
+    // originally render the scene in - otherwise the depth map will either be
+    // incomplete or too small.
+    glViewport(0, 0, kShadowWidth, kShadowHeight);
+    glBindFramebuffer(GL_FRAMEBUFFER, depth_map_fbo);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    RenderScene(depth_shader);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glCullFace(GL_BACK);
+
+    // Using lookAt...
+    auto view = camera.GetViewMatrix();
+
+    // Use perspective projection
+    glm::mat4 projection;
+    projection = glm::perspective(
+        glm::radians(camera.GetFieldOfView()),
+        static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+        0.1f, 1000.0f);
+
+    // Record the virtual texture pages the frame needs at low resolution,
+    // then load what the previous frame's feedback asked for
+    feedback_shader.Use();
+    feedback_shader.SetMat4("view", view);
+    feedback_shader.SetMat4("projection", projection);
+    virtual_texture.SetUniforms(feedback_shader, 2, 3, /*feedback=*/true);
+    virtual_texture.BeginFeedback();
+    RenderScene(feedback_shader);
+    virtual_texture.EndFeedback();
+    virtual_texture.Update();
+
+    // Render the scene as normal using the generated depth/shadow map.
+
+    glViewport(0, 0, kScreenWidth, kScreenHeight);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    shader.Use();
+    shader.SetMat4("view", view);
+    shader.SetMat4("projection", projection);
+    virtual_texture.SetUniforms(shader, 2, 3, /*feedback=*/false);
+
+    // Set light uniforms
+    shader.SetVec3("viewPosition", camera.Position());
+    shader.SetVec3("lightPosition", light_position);
+    shader.SetMat4("lightSpaceMatrix", light_space_matrix);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, wood_texture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, depth_map);
+
+    RenderScene(shader);
+
+    if (current_frame - last_report >= 1.0f) {
+      last_report = current_frame;
+      const VirtualTextureStats& stats = virtual_texture.Stats();
+      std::cout << "Pages resident " << virtual_texture.ResidentPages() << "/"
+                << virtual_texture.CachePages() << ", requested "
+                << stats.requested_pages << " | loaded " << stats.loaded_pages
+                << ", evicted " << stats.evicted_pages << "\n";
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
+
+unsigned int LoadTexture(char const* path) {
+  // Prefer the offline block-compressed version of the texture when present
+  const unsigned int compressed_id = LoadKtx2Texture(Ktx2PathFor(path));
+  if (compressed_id != 0) {
+    return compressed_id;
+  }
+
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+
+  int width;
+  int height;
+  int component_count;
+  auto* data = stbi_load(path, &width, &height, &component_count, 0);
+  if (data) {
+    // Build the mip chain on the CPU, filtering colors in linear space
+    MipChainOptions options;
+    options.srgb = true;
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    UploadMipChain(
+        BuildMipChain(data, width, height, component_count, options),
+        /*srgb_storage=*/false);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stbi_image_free(data);
+  } else {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    stbi_image_free(data);
+  }
+
+  return texture_id;
+}
+
+std::vector<MipLevel> LoadMipChainRgba(char const* path) {
+  int width;
+  int height;
+  int component_count;
+  // Pages are always RGBA
+  auto* data = stbi_load(path, &width, &height, &component_count, 4);
+  if (!data) {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    const unsigned char grey[] = {128, 128, 128, 255};
+    return {MipLevel{1, 1, 4, {grey, grey + 4}}};
+  }
+  MipChainOptions options;
+  options.srgb = true;
+  std::vector<MipLevel> levels = BuildMipChain(data, width, height, 4, options);
+  stbi_image_free(data);
+  return levels;
+}
+
+// RENDER FUNCTIONS BELOW
+
+void RenderScene(const Shader& shader) {
+  // Floor
+  glm::mat4 model = glm::mat4(1.0f);
+  shader.SetMat4("model", model);
+  shader.SetBool("virtualTextured", true);
+  glBindVertexArray(plane_vao);
+  glDrawArrays(GL_TRIANGLES, 0, 6);
+  shader.SetBool("virtualTextured", false);
+
+  // Cubes
+  model = glm::mat4(1.0f);
+  model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0f));
+  model = glm::scale(model, glm::vec3(0.5f));
+  shader.SetMat4("model", model);
+  RenderCube();
+
+  model = glm::mat4(1.0f);
+  model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
+  model = glm::scale(model, glm::vec3(0.5f));
+  shader.SetMat4("model", model);
+  RenderCube();
+
+  model = glm::mat4(1.0f);
+  model = glm::translate(model, glm::vec3(-1.0f, 0.0f, 2.0));
+  model = glm::rotate(model, glm::radians(60.0f),
+                      glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+  model = glm::scale(model, glm::vec3(0.25));
+  shader.SetMat4("model", model);
+  RenderCube();
+}
+
+unsigned int cube_vao = 0;
+unsigned int cube_vbo = 0;
+void RenderCube() {
+  if (cube_vao == 0) {
+    // Position (x, y, z), Normal (x, y, z), Texture Coords (u, v)
+    float vertices[] = {
+        // back face
+        -1.0f, -1.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f,  // bottom-left
+        1.0f, 1.0f, -1.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f,    // top-right
+        1.0f, -1.0f, -1.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f,   // bottom-right
+        1.0f, 1.0f, -1.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f,    // top-right
+        -1.0f, -1.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f,  // bottom-left
+        -1.0f, 1.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f,   // top-left
+        // front face
+        -1.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,  // bottom-left
+        1.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,   // bottom-right
+        1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,    // top-right
+        1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,    // top-right
+        -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f,   // top-left
+        -1.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,  // bottom-left
+        // left face
+        -1.0f, 1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f,    // top-right
+        -1.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f,   // top-left
+        -1.0f, -1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f,  // bottom-left
+        -1.0f, -1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f,  // bottom-left
+        -1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f,   // bottom-right
+        -1.0f, 1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f,    // top-right
+                                                             // right face
+        1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,      // top-left
+        1.0f, -1.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,    // bottom-right
+        1.0f, 1.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,     // top-right
+        1.0f, -1.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,    // bottom-right
+        1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,      // top-left
+        1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,     // bottom-left
+        // bottom face
+        -1.0f, -1.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f,  // top-right
+        1.0f, -1.0f, -1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f,   // top-left
+        1.0f, -1.0f, 1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f,    // bottom-left
+        1.0f, -1.0f, 1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f,    // bottom-left
+        -1.0f, -1.0f, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f,   // bottom-right
+        -1.0f, -1.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f,  // top-right
+        // top face
+        -1.0f, 1.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,  // top-left
+        1.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,    // bottom-right
+        1.0f, 1.0f, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f,   // top-right
+        1.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,    // bottom-right
+        -1.0f, 1.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,  // top-left
+        -1.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f    // bottom-left
+    };
+
+    glGenVertexArrays(1, &cube_vao);
+    glGenBuffers(1, &cube_vbo);
+
+    glBindBuffer(GL_ARRAY_BUFFER, cube_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glBindVertexArray(cube_vao);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
+                          (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
+                          (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
+                          (void*)(6 * sizeof(float)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+  }
+
+  // Render cube
+  glBindVertexArray(cube_vao);
+  glDrawArrays(GL_TRIANGLES, 0, 36);
+  glBindVertexArray(0);
+}
+
+unsigned int quad_vao = 0;
+unsigned int quad_vbo = 0;
+void RenderQuad() {
+  if (quad_vao == 0) {
+    // Position (x, y, z), Texture Coords (u, v)
+    float quad_vertices[] = {
+        -1.0f, 1.0f,  0.0f, 0.0f, 1.0f,  //
+        -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,  //
+        1.0f,  1.0f,  0.0f, 1.0f, 1.0f,  //
+        1.0f,  -1.0f, 0.0f, 1.0f, 0.0f,  //
+    };
+
+    glGenVertexArrays(1, &quad_vao);
+    glGenBuffers(1, &quad_vbo);
+    glBindVertexArray(quad_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), &quad_vertices,
+                 GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                          (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                          (void*)(3 * sizeof(float)));
+  }
+  glBindVertexArray(quad_vao);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glBindVertexArray(0);
+}
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <vector>
+
+#include "animation.hpp"
+#include "camera.hpp"
+#include "model.hpp"
+#include "render_stats.hpp"
+#include "shader_m.hpp"
+#include "skinning.hpp"
+#include "stb_include.hpp"
+#include "thread_pool.hpp"
+
+// Default settings
+constexpr unsigned int kScreenWidth = 800;
+constexpr unsigned int kScreenHeight = 600;
+
+// The characters stand on a kGridSize x kGridSize grid
+constexpr int kGridSize = 20;
+constexpr int kCharacterCount = kGridSize * kGridSize;
+constexpr float kGridSpacing = 1.5f;
+// Characters evaluated per parallel task
+constexpr std::size_t kCharactersPerTask = 16;
+
+// Function declarations
+void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+void ProcessInput(GLFWwindow* window);
+void MouseCursorCallback(GLFWwindow* window, double x_position,
+                         double y_position);
+void MouseScrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+
+// Time between current frame and last frame
+float delta_time = 0.0f;
+// The time of the last frame
+float last_frame = 0.0f;
+
+// Mouse position
+float mouse_last_x = 400;
+float mouse_last_y = 300;
+bool first_mouse_position = true;
+
+// Skin on the CPU instead of in the vertex shader
+bool cpu_skinning = false;
+bool cpu_skinning_key_pressed = false;
+
+Camera camera(glm::vec3(0.0f, 2.0f, 20.0f));
+
+int main() {
+  // Initialize and configure GLFW
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  // Create a GLFW window
+  GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetCursorPosCallback(window, MouseCursorCallback);
+  glfwSetScrollCallback(window, MouseScrollCallback);
+
+  // Disable the cursor and capture it
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+  // Load all OpenGL function pointers
+  // Note that this must be called after MakeContextCurrent
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  // Configure global OpenGL state to include z-buffer depth testing
+  glEnable(GL_DEPTH_TEST);
+
+  // Tell stb_image.h to flip loaded texture's on the y-axis (before loading
+  // model).
+  stbi_set_flip_vertically_on_load(true);
+
+  Shader skinned_shader("shaders/28_1_skeletal_animation.vs",
+                        "shaders/14_1_model_loading.fs");
+  // The CPU path uploads posed vertices and draws them as a rigid model
+  Shader shader("shaders/14_1_model_loading.vs",
+                "shaders/14_1_model_loading.fs");
+
+  // Note: the model and its textures can be downloaded from learnopengl.com
+  // (see Guest Articles > Skeletal Animation).
+  Model character("assets/models/vampire/dancing_vampire.dae");
+  const Skeleton& skeleton = character.GetSkeleton();
+  const int bone_count = skeleton.BoneCount();
+  if (character.Animations().empty()) {
+    std::cerr << "Model has no animations\n";
+    glfwTerminate();
+    return -1;
+  }
+  const AnimationSampler sampler(skeleton, character.Animations()[0]);
+
+  // Every character gets its own place on the grid and its own point in the
+  // clip
+  std::vector<glm::mat4> character_models(kCharacterCount);
+  std::vector<float> time_offsets(kCharacterCount);
+  for (int i = 0; i < kCharacterCount; i++) {
+    const float x = (i % kGridSize - 0.5f * (kGridSize - 1)) * kGridSpacing;
+    const float z = -(i / kGridSize) * kGridSpacing;
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(x, 0.0f, z));
+    model = glm::scale(model, glm::vec3(0.01f));
+    character_models[i] = model;
+    time_offsets[i] = 0.137f * i;
+  }
+
+  // Per character: the model matrix followed by its bone palette, all in one
+  // shader storage buffer
+  const std::size_t stride = static_cast<std::size_t>(bone_count) + 1;
+  std::vector<glm::mat4> instance_matrices(stride * kCharacterCount);
+  PaletteBuffer palette_buffer(/*binding=*/0);
+
+  // Print the timings once per second
+  float last_report = 0.0f;
+
+  // Render loop
+  while (!glfwWindowShouldClose(window)) {
+    // Calculate delta time
+    // People's machines have different processing powers and are able to render
+    // much more frames. This results in some people moving really fast and
+    // others really slow. To account for this, we should calculate
+    // physics/movement based on the time difference between the two frames.
+    float current_frame = glfwGetTime();
+    delta_time = current_frame - last_frame;
+    last_frame = current_frame;
+
+    // Input
+    ProcessInput(window);
+
+    // Render
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    ResetFrameStats();
+
+    // Sample every character's pose in parallel
+    const auto evaluate_start = std::chrono::steady_clock::now();
+    SharedThreadPool().ParallelFor(
+        kCharacterCount, kCharactersPerTask,
+        [&](std::size_t begin, std::size_t end) {
+          // One scratch buffer for the whole range of characters
+          std::vector<glm::mat4> node_transforms;
+          for (std::size_t i = begin; i < end; i++) {
+            instance_matrices[i * stride] = character_models[i];
+            sampler.Evaluate(current_frame + time_offsets[i],
+                             &instance_matrices[i * stride + 1],
+                             &node_transforms);
+          }
+        });
+    const auto skin_start = std::chrono::steady_clock::now();
+
+    // Using lookAt...
+    auto view = camera.GetViewMatrix();
+
+    // Use perspective projection
+    glm::mat4 projection;
+    projection = glm::perspective(
+        glm::radians(camera.GetFieldOfView()),
+        static_cast<float>(kScreenWidth) / static_cast<float>(kScreenHeight),
+        0.1f, 100.0f);
+
+    if (cpu_skinning) {
+      shader.Use();
+      shader.SetMat4("view", view);
+      shader.SetMat4("projection", projection);
+      for (int i = 0; i < kCharacterCount; i++) {
+        character.SkinOnCpu(&instance_matrices[i * stride + 1]);
+        shader.SetMat4("model", character_models[i]);
+        character.DrawCpuSkinned(shader);
+      }
+    } else {
+      palette_buffer.Upload(instance_matrices);
+      skinned_shader.Use();
+      skinned_shader.SetInt("boneCount", bone_count);
+      skinned_shader.SetMat4("view", view);
+      skinned_shader.SetMat4("projection", projection);
+      character.Draw(skinned_shader, kCharacterCount);
+    }
+    const auto skin_end = std::chrono::steady_clock::now();
+
+    if (current_frame - last_report >= 1.0f) {
+      last_report = current_frame;
+      const std::chrono::duration<float, std::milli> evaluate_time =
+          skin_start - evaluate_start;
+      const std::chrono::duration<float, std::milli> skin_time =
+          skin_end - skin_start;
+      std::cout << (cpu_skinning ? "CPU skinning" : "GPU skinning") << ": "
+                << kCharacterCount << " characters, " << bone_count
+                << " bones | pose " << evaluate_time.count() << " ms, "
+                << "skin and submit " << skin_time.count() << " ms, "
+                << FrameStats().draw_calls << " draw calls\n";
+    }
+
+    // Swap buffers and poll I/O events (keys pressed, mouse moved, etc.)
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+  }
+
+  // Terminate, clearing all previously allocated GLFW resources
+  glfwTerminate();
+  return 0;
+}
+
+void ProcessInput(GLFWwindow* window) {
+  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
+    return;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::FORWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::BACKWARD, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::LEFT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    camera.ProcessMovement(CameraMovement::RIGHT, delta_time);
+  }
+  if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS &&
+      !cpu_skinning_key_pressed) {
+    cpu_skinning_key_pressed = true;
+    cpu_skinning = !cpu_skinning;
+  }
+  if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+    cpu_skinning_key_pressed = false;
+  }
+}
+
+void FramebufferSizeCallback(GLFWwindow*, int width, int height) {
+  // Make sure the viewport matches the new window dimensions.
+  glViewport(0, 0, width, height);
+}
+
+void MouseCursorCallback(GLFWwindow*, double x_position, double y_position) {
+  if (first_mouse_position) {
+    first_mouse_position = false;
+    mouse_last_x = x_position;
+    mouse_last_y = y_position;
+    return;
+  }
+
+  float x_offset = x_position - mouse_last_x;
+  float y_offset = (y_position - mouse_last_y) * -1;
+  mouse_last_x = x_position;
+  mouse_last_y = y_position;
+
+  camera.ProcessLook(x_offset, y_offset);
+}
+
+void MouseScrollCallback(GLFWwindow*, double /*x_offset*/, double y_offset) {
+  camera.ProcessFieldOfView(y_offset);
+}
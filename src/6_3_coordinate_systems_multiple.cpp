@@ -6,6 +6,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 
+#include "mip_builder.hpp"
 #include "shader_m.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_include.hpp"
@@ -144,9 +145,12 @@ int main() {
     return -1;
   }
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+  // Build the mip chain on the CPU, filtering colors in linear space
+  MipChainOptions options;
+  options.srgb = true;
+  UploadMipChain(
+      BuildMipChain(data, width, height, channel_count, options),
+      /*srgb_storage=*/false);
 
   stbi_image_free(data);
 
@@ -170,9 +174,9 @@ int main() {
     return -1;
   }
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
-               GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+  UploadMipChain(
+      BuildMipChain(data, width, height, channel_count, options),
+      /*srgb_storage=*/false);
 
   stbi_image_free(data);
 
@@ -0,0 +1,164 @@
+#include "animation.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Index of the last key at or before `time`, clamped so key + 1 is valid
+template <typename Key>
+std::size_t KeyBefore(const std::vector<Key>& keys, float time) {
+  const auto after = std::upper_bound(
+      keys.begin(), keys.end(), time,
+      [](float value, const Key& key) { return value < key.time; });
+  const std::size_t index =
+      after == keys.begin()
+          ? 0
+          : static_cast<std::size_t>(after - keys.begin()) - 1;
+  return std::min(index, keys.size() - 2);
+}
+
+template <typename Key>
+float KeyFactor(const Key& from, const Key& to, float time) {
+  const float span = to.time - from.time;
+  return span > 0.0f ? std::clamp((time - from.time) / span, 0.0f, 1.0f)
+                     : 0.0f;
+}
+
+glm::vec3 SampleVector(const std::vector<VectorKey>& keys, float time,
+                       const glm::vec3& fallback) {
+  if (keys.empty()) {
+    return fallback;
+  }
+  if (keys.size() == 1) {
+    return keys[0].value;
+  }
+  const std::size_t index = KeyBefore(keys, time);
+  const VectorKey& from = keys[index];
+  const VectorKey& to = keys[index + 1];
+  return glm::mix(from.value, to.value, KeyFactor(from, to, time));
+}
+
+glm::quat SampleRotation(const std::vector<RotationKey>& keys, float time) {
+  if (keys.empty()) {
+    return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+  }
+  if (keys.size() == 1) {
+    return keys[0].value;
+  }
+  const std::size_t index = KeyBefore(keys, time);
+  const RotationKey& from = keys[index];
+  const RotationKey& to = keys[index + 1];
+  return glm::normalize(
+      glm::slerp(from.value, to.value, KeyFactor(from, to, time)));
+}
+
+// Translation * rotation * scale without going through three matrix
+// products
+glm::mat4 ComposeTransform(const glm::vec3& position,
+                           const glm::quat& rotation,
+                           const glm::vec3& scale) {
+  glm::mat4 transform = glm::mat4_cast(rotation);
+  transform[0] *= scale.x;
+  transform[1] *= scale.y;
+  transform[2] *= scale.z;
+  transform[3] = glm::vec4(position, 1.0f);
+  return transform;
+}
+
+}  // namespace
+
+SkinWeights PackSkinWeights(std::vector<std::pair<int, float>> influences) {
+  std::sort(influences.begin(), influences.end(),
+            [](const std::pair<int, float>& a, const std::pair<int, float>& b) {
+              return a.second > b.second;
+            });
+  if (influences.size() > kMaxBoneInfluences) {
+    influences.resize(kMaxBoneInfluences);
+  }
+  float total = 0.0f;
+  for (const auto& influence : influences) {
+    total += influence.second;
+  }
+
+  SkinWeights packed = {};
+  if (total <= 0.0f) {
+    // Unweighted vertices follow the first bone rigidly
+    packed.weights[0] = 255;
+    return packed;
+  }
+  int sum = 0;
+  for (std::size_t i = 0; i < influences.size(); i++) {
+    packed.bones[i] = static_cast<std::uint8_t>(influences[i].first);
+    packed.weights[i] = static_cast<std::uint8_t>(
+        std::lround(influences[i].second / total * 255.0f));
+    sum += packed.weights[i];
+  }
+  // Rounding error goes to the heaviest influence so the weights sum to one
+  packed.weights[0] = static_cast<std::uint8_t>(packed.weights[0] + 255 - sum);
+  return packed;
+}
+
+int Skeleton::BoneCount() const {
+  return static_cast<int>(inverse_bind.size());
+}
+
+int Skeleton::BoneFor(const std::string& name,
+                      const glm::mat4& inverse_bind_matrix) {
+  auto node = nodes_by_name.find(name);
+  if (node == nodes_by_name.end()) {
+    // A bone without a node never moves, but still needs a palette entry
+    nodes.push_back({name, -1, glm::mat4(1.0f)});
+    node = nodes_by_name.emplace(name, static_cast<int>(nodes.size()) - 1)
+               .first;
+  }
+  SkeletonNode& bone_node = nodes[node->second];
+  if (bone_node.bone < 0) {
+    if (BoneCount() == kMaxBones) {
+      return -1;
+    }
+    bone_node.bone = BoneCount();
+    inverse_bind.push_back(inverse_bind_matrix);
+  }
+  return bone_node.bone;
+}
+
+AnimationSampler::AnimationSampler(const Skeleton& skeleton,
+                                   const AnimationClip& clip)
+    : skeleton_(skeleton),
+      clip_(clip),
+      channel_by_node_(skeleton.nodes.size(), -1) {
+  for (std::size_t i = 0; i < clip.channels.size(); i++) {
+    const int node = clip.channels[i].node;
+    if (node >= 0 && node < static_cast<int>(channel_by_node_.size())) {
+      channel_by_node_[node] = static_cast<int>(i);
+    }
+  }
+}
+
+void AnimationSampler::Evaluate(float seconds, glm::mat4* palette,
+                                std::vector<glm::mat4>* scratch) const {
+  const float time =
+      clip_.duration > 0.0f
+          ? std::fmod(seconds * clip_.ticks_per_second, clip_.duration)
+          : 0.0f;
+
+  std::vector<glm::mat4>& globals = *scratch;
+  globals.resize(skeleton_.nodes.size());
+  for (std::size_t i = 0; i < skeleton_.nodes.size(); i++) {
+    const SkeletonNode& node = skeleton_.nodes[i];
+    glm::mat4 local = node.transform;
+    if (channel_by_node_[i] >= 0) {
+      const AnimationChannel& channel = clip_.channels[channel_by_node_[i]];
+      local = ComposeTransform(
+          SampleVector(channel.positions, time, glm::vec3(0.0f)),
+          SampleRotation(channel.rotations, time),
+          SampleVector(channel.scales, time, glm::vec3(1.0f)));
+    }
+    globals[i] = node.parent >= 0 ? globals[node.parent] * local : local;
+    if (node.bone >= 0) {
+      palette[node.bone] = skeleton_.global_inverse * globals[i] *
+                           skeleton_.inverse_bind[node.bone];
+    }
+  }
+}
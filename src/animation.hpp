@@ -0,0 +1,98 @@
+#ifndef LEARNGL_ANIMATION_HPP_
+#define LEARNGL_ANIMATION_HPP_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr int kMaxBoneInfluences = 4;
+// Bone indices are stored in 8 bits
+constexpr int kMaxBones = 256;
+
+// The bones moving one vertex, 8 bytes per vertex. Weights are normalized to
+// sum to 255; unused influences have weight 0.
+struct SkinWeights {
+  std::uint8_t bones[kMaxBoneInfluences];
+  std::uint8_t weights[kMaxBoneInfluences];
+};
+
+// Keep the kMaxBoneInfluences heaviest (bone, weight) pairs, renormalize and
+// quantize them.
+SkinWeights PackSkinWeights(std::vector<std::pair<int, float>> influences);
+
+struct SkeletonNode {
+  std::string name;
+  // Index of the parent node, -1 for the root. Parents precede children.
+  int parent;
+  // Bind pose transform relative to the parent
+  glm::mat4 transform;
+  // Palette index when a mesh is skinned to this node, otherwise -1
+  int bone = -1;
+};
+
+// The node hierarchy of a model together with its bones.
+struct Skeleton {
+  std::vector<SkeletonNode> nodes;
+  // Per bone: mesh space to bone space in the bind pose
+  std::vector<glm::mat4> inverse_bind;
+  glm::mat4 global_inverse = glm::mat4(1.0f);
+  std::unordered_map<std::string, int> nodes_by_name;
+
+  int BoneCount() const;
+  // Palette index of the node called `name`, made a bone on first use
+  int BoneFor(const std::string& name, const glm::mat4& inverse_bind_matrix);
+};
+
+struct VectorKey {
+  float time;
+  glm::vec3 value;
+};
+
+struct RotationKey {
+  float time;
+  glm::quat value;
+};
+
+// Keyframes of one node. Nodes without a channel keep their bind pose.
+struct AnimationChannel {
+  int node;
+  std::vector<VectorKey> positions;
+  std::vector<RotationKey> rotations;
+  std::vector<VectorKey> scales;
+};
+
+struct AnimationClip {
+  std::string name;
+  // In ticks
+  float duration = 0.0f;
+  float ticks_per_second = 25.0f;
+  std::vector<AnimationChannel> channels;
+};
+
+// Evaluates one clip of one skeleton into bone matrix palettes. Evaluate()
+// does not modify the sampler, so many characters can be sampled in
+// parallel.
+class AnimationSampler {
+ public:
+  AnimationSampler(const Skeleton& skeleton, const AnimationClip& clip);
+
+  // Write skeleton.BoneCount() matrices that take bind pose mesh space to
+  // the animated pose at `seconds`, looping the clip. `scratch` holds the
+  // nodes' global transforms on the way; reuse it across calls, one per
+  // thread, so evaluating allocates nothing once it has grown.
+  void Evaluate(float seconds, glm::mat4* palette,
+                std::vector<glm::mat4>* scratch) const;
+
+ private:
+  const Skeleton& skeleton_;
+  const AnimationClip& clip_;
+  // Per node, the index of its channel or -1
+  std::vector<int> channel_by_node_;
+};
+
+#endif
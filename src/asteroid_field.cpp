@@ -0,0 +1,399 @@
+#include "asteroid_field.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#include "thread_pool.hpp"
+
+namespace {
+
+// Rocks per chunk of parallel work, a whole number of groups
+constexpr std::size_t kChunkSize = 4096;
+// Rocks evaluated together
+constexpr std::size_t kGroupSize = 8;
+// Random numbers drawn per rock: three displacements, scale and angle
+constexpr std::uint64_t kValuesPerRock = 5;
+// Random numbers drawn per rock of a belt: spin axis, rate and phase
+constexpr std::uint64_t kMotionValuesPerRock = 5;
+// Mixed into the seed so the motion does not reuse the placement's values
+constexpr std::uint64_t kMotionStream = 0x6a09e667f3bcc909ull;
+
+constexpr float kPi = 3.14159265358979f;
+constexpr float kTwoPi = 6.28318530717959f;
+constexpr float kHalfPi = 1.57079632679490f;
+
+// Output of SplitMix64 at position `counter` of the stream seeded by `seed`.
+// Any position can be computed directly, which makes it counter-based.
+std::uint64_t SplitMix64(std::uint64_t seed, std::uint64_t counter) {
+  std::uint64_t z = seed + (counter + 1) * 0x9e3779b97f4a7c15ull;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// The top 24 bits as a float in [0, 1)
+float UnitFloat(std::uint64_t bits) {
+  return static_cast<float>(bits >> 40) * (1.0f / 16777216.0f);
+}
+
+// The same angle in [-pi, pi]
+float Wrap(float angle) {
+  return angle - std::nearbyint(angle * (1.0f / kTwoPi)) * kTwoPi;
+}
+
+// Taylor polynomials around 0, accurate to float precision on
+// [-pi / 2, pi / 2]. The AVX version evaluates them in the same order.
+void SinCos(float angle, float* sine, float* cosine) {
+  float r = Wrap(angle);
+  float cosine_sign = 1.0f;
+  if (r > kHalfPi) {
+    r = kPi - r;
+    cosine_sign = -1.0f;
+  } else if (r < -kHalfPi) {
+    r = -kPi - r;
+    cosine_sign = -1.0f;
+  }
+  const float r2 = r * r;
+  *sine =
+      r * (1.0f +
+           r2 * (-1.0f / 6.0f +
+                 r2 * (1.0f / 120.0f +
+                       r2 * (-1.0f / 5040.0f +
+                             r2 * (1.0f / 362880.0f +
+                                   r2 * (-1.0f / 39916800.0f))))));
+  *cosine =
+      cosine_sign *
+      (1.0f +
+       r2 * (-1.0f / 2.0f +
+             r2 * (1.0f / 24.0f +
+                   r2 * (-1.0f / 720.0f +
+                         r2 * (1.0f / 40320.0f +
+                               r2 * (-1.0f / 3628800.0f +
+                                     r2 * (1.0f / 479001600.0f)))))));
+}
+
+#if defined(__AVX__)
+__m256 Polynomial(__m256 x, const float* coefficients, int count) {
+  // Horner's scheme, highest coefficient first
+  __m256 result = _mm256_set1_ps(coefficients[count - 1]);
+  for (int i = count - 2; i >= 0; i--) {
+    result = _mm256_add_ps(_mm256_set1_ps(coefficients[i]),
+                           _mm256_mul_ps(x, result));
+  }
+  return result;
+}
+
+__m256 Wrap8(__m256 angle) {
+  const __m256 turns = _mm256_round_ps(
+      _mm256_mul_ps(angle, _mm256_set1_ps(1.0f / kTwoPi)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  return _mm256_sub_ps(angle, _mm256_mul_ps(turns, _mm256_set1_ps(kTwoPi)));
+}
+
+void SinCos8(__m256 angle, __m256* sine, __m256* cosine) {
+  static const float kSine[] = {1.0f,           -1.0f / 6.0f,
+                                1.0f / 120.0f,  -1.0f / 5040.0f,
+                                1.0f / 362880.0f, -1.0f / 39916800.0f};
+  static const float kCosine[] = {
+      1.0f,          -1.0f / 2.0f,     1.0f / 24.0f,        -1.0f / 720.0f,
+      1.0f / 40320.0f, -1.0f / 3628800.0f, 1.0f / 479001600.0f};
+  __m256 r = Wrap8(angle);
+  const __m256 above = _mm256_cmp_ps(r, _mm256_set1_ps(kHalfPi), _CMP_GT_OQ);
+  const __m256 below =
+      _mm256_cmp_ps(r, _mm256_set1_ps(-kHalfPi), _CMP_LT_OQ);
+  r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(kPi), r), above);
+  r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(-kPi), r), below);
+  const __m256 cosine_sign =
+      _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_set1_ps(-1.0f),
+                       _mm256_or_ps(above, below));
+  const __m256 r2 = _mm256_mul_ps(r, r);
+  *sine = _mm256_mul_ps(r, Polynomial(r2, kSine, 6));
+  *cosine = _mm256_mul_ps(cosine_sign, Polynomial(r2, kCosine, 7));
+}
+
+// Rows become columns
+void Transpose8(__m256* rows) {
+  const __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+  const __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+  const __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+  const __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+  const __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+  const __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+  const __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+  const __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+  const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+  rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+  rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+  rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+  rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+  rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+  rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+  rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+#endif
+
+// Rocks first to first + kGroupSize, including any past the count
+void GenerateGroup(const AsteroidField& field, std::size_t count,
+                   std::size_t first, bool simd, InstanceTransform* group) {
+  float random[kValuesPerRock][kGroupSize];
+  float ring_angle[kGroupSize];
+  const float angle_step = kTwoPi / static_cast<float>(count);
+  for (std::size_t lane = 0; lane < kGroupSize; lane++) {
+    const std::uint64_t rock = first + lane;
+    for (std::uint64_t value = 0; value < kValuesPerRock; value++) {
+      random[value][lane] =
+          UnitFloat(SplitMix64(field.seed, rock * kValuesPerRock + value));
+    }
+    ring_angle[lane] = static_cast<float>(rock) * angle_step;
+  }
+
+  // Half the rotation angle, which is what the quaternion takes
+  float half_angle[kGroupSize];
+  float ring_sine[kGroupSize];
+  float ring_cosine[kGroupSize];
+  float half_sine[kGroupSize];
+  float half_cosine[kGroupSize];
+  for (std::size_t lane = 0; lane < kGroupSize; lane++) {
+    half_angle[lane] = random[4][lane] * kPi;
+  }
+#if defined(__AVX__)
+  if (simd) {
+    __m256 sine;
+    __m256 cosine;
+    SinCos8(_mm256_loadu_ps(ring_angle), &sine, &cosine);
+    _mm256_storeu_ps(ring_sine, sine);
+    _mm256_storeu_ps(ring_cosine, cosine);
+    SinCos8(_mm256_loadu_ps(half_angle), &sine, &cosine);
+    _mm256_storeu_ps(half_sine, sine);
+    _mm256_storeu_ps(half_cosine, cosine);
+  }
+#else
+  simd = false;
+#endif
+  if (!simd) {
+    for (std::size_t lane = 0; lane < kGroupSize; lane++) {
+      SinCos(ring_angle[lane], &ring_sine[lane], &ring_cosine[lane]);
+      SinCos(half_angle[lane], &half_sine[lane], &half_cosine[lane]);
+    }
+  }
+
+  const glm::vec3 axis = glm::normalize(field.rotation_axis);
+  for (std::size_t lane = 0; lane < kGroupSize; lane++) {
+    const auto displacement = [&](int value) {
+      return (random[value][lane] * 2.0f - 1.0f) * field.offset;
+    };
+    group[lane].position =
+        glm::vec3(ring_sine[lane] * field.radius + displacement(0),
+                  displacement(1) * field.height,
+                  ring_cosine[lane] * field.radius + displacement(2));
+    group[lane].scale =
+        field.min_scale + random[3][lane] * (field.max_scale - field.min_scale);
+    group[lane].rotation =
+        glm::vec4(axis * half_sine[lane], half_cosine[lane]);
+  }
+}
+
+void Store(const InstanceTransform& rock, InstanceTransform* target) {
+  *target = rock;
+}
+
+void Store(const InstanceTransform& rock, glm::mat4* target) {
+  *target = UnpackInstanceTransform(rock);
+}
+
+template <typename Instance>
+void Generate(const AsteroidField& field, std::size_t count, Instance* out,
+              const AsteroidFieldOptions& options) {
+  const auto generate_chunks = [&](std::size_t begin, std::size_t end) {
+    InstanceTransform group[kGroupSize];
+    for (std::size_t chunk = begin; chunk < end; chunk++) {
+      const std::size_t last = std::min((chunk + 1) * kChunkSize, count);
+      for (std::size_t first = chunk * kChunkSize; first < last;
+           first += kGroupSize) {
+        GenerateGroup(field, count, first, options.simd, group);
+        const std::size_t group_count = std::min(kGroupSize, last - first);
+        for (std::size_t lane = 0; lane < group_count; lane++) {
+          Store(group[lane], out + first + lane);
+        }
+      }
+    }
+  };
+
+  const std::size_t chunk_count = (count + kChunkSize - 1) / kChunkSize;
+  if (options.parallel) {
+    SharedThreadPool().ParallelFor(chunk_count, 1, generate_chunks);
+  } else {
+    generate_chunks(0, chunk_count);
+  }
+}
+
+}  // namespace
+
+void GenerateAsteroidField(const AsteroidField& field, std::size_t count,
+                           InstanceTransform* transforms,
+                           const AsteroidFieldOptions& options) {
+  Generate(field, count, transforms, options);
+}
+
+void GenerateAsteroidField(const AsteroidField& field, std::size_t count,
+                           glm::mat4* matrices,
+                           const AsteroidFieldOptions& options) {
+  Generate(field, count, matrices, options);
+}
+
+AsteroidBelt::AsteroidBelt(const AsteroidField& field, std::size_t count)
+    : count_(count) {
+  const std::size_t padded =
+      (count + kGroupSize - 1) / kGroupSize * kGroupSize;
+  for (std::vector<float>* state :
+       {&orbit_angle_, &orbit_radius_, &orbit_speed_, &height_, &scale_,
+        &spin_angle_, &spin_rate_, &spin_axis_x_, &spin_axis_y_,
+        &spin_axis_z_}) {
+    state->resize(padded, 0.0f);
+  }
+
+  std::vector<InstanceTransform> rocks(count);
+  GenerateAsteroidField(field, count, rocks.data());
+  const std::uint64_t motion_seed = field.seed ^ kMotionStream;
+  const auto initialize = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++) {
+      const glm::vec3& position = rocks[i].position;
+      orbit_radius_[i] = std::sqrt(position.x * position.x +
+                                   position.z * position.z);
+      // The ring places rock i at (sin(angle), cos(angle)) * radius
+      orbit_angle_[i] = std::atan2(position.x, position.z);
+      orbit_speed_[i] =
+          field.orbit_speed *
+          std::pow(field.radius / std::max(orbit_radius_[i], 1e-3f), 1.5f);
+      height_[i] = position.y;
+      scale_[i] = rocks[i].scale;
+
+      float random[kMotionValuesPerRock];
+      for (std::uint64_t value = 0; value < kMotionValuesPerRock; value++) {
+        random[value] = UnitFloat(
+            SplitMix64(motion_seed, i * kMotionValuesPerRock + value));
+      }
+      glm::vec3 axis(random[0] * 2.0f - 1.0f, random[1] * 2.0f - 1.0f,
+                     random[2] * 2.0f - 1.0f);
+      if (glm::length(axis) < 1e-3f) {
+        axis = field.rotation_axis;
+      }
+      axis = glm::normalize(axis);
+      spin_axis_x_[i] = axis.x;
+      spin_axis_y_[i] = axis.y;
+      spin_axis_z_[i] = axis.z;
+      spin_rate_[i] = field.min_spin_rate +
+                      random[3] * (field.max_spin_rate - field.min_spin_rate);
+      spin_angle_[i] = (random[4] * 2.0f - 1.0f) * kPi;
+    }
+  };
+  SharedThreadPool().ParallelFor(count, kChunkSize, initialize);
+}
+
+void AsteroidBelt::Update(float delta_time, InstanceTransform* transforms,
+                          const AsteroidFieldOptions& options) {
+  const auto update_groups = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t group = begin; group < end; group++) {
+      const std::size_t first = group * kGroupSize;
+      const std::size_t group_count = std::min(kGroupSize, count_ - first);
+      if (group_count == kGroupSize) {
+        UpdateGroup(first, delta_time, options.simd, transforms + first);
+      } else {
+        // The padding lanes are integrated too but not stored
+        InstanceTransform partial[kGroupSize];
+        UpdateGroup(first, delta_time, options.simd, partial);
+        std::copy(partial, partial + group_count, transforms + first);
+      }
+    }
+  };
+
+  const std::size_t group_count = (count_ + kGroupSize - 1) / kGroupSize;
+  if (options.parallel) {
+    SharedThreadPool().ParallelFor(group_count, kChunkSize / kGroupSize,
+                                   update_groups);
+  } else {
+    update_groups(0, group_count);
+  }
+}
+
+std::size_t AsteroidBelt::Count() const {
+  return count_;
+}
+
+void AsteroidBelt::UpdateGroup(std::size_t first, float delta_time,
+                               bool simd, InstanceTransform* group) {
+#if defined(__AVX__)
+  if (simd) {
+    const __m256 delta = _mm256_set1_ps(delta_time);
+    const __m256 orbit_angle = Wrap8(_mm256_add_ps(
+        _mm256_loadu_ps(&orbit_angle_[first]),
+        _mm256_mul_ps(_mm256_loadu_ps(&orbit_speed_[first]), delta)));
+    const __m256 spin_angle = Wrap8(_mm256_add_ps(
+        _mm256_loadu_ps(&spin_angle_[first]),
+        _mm256_mul_ps(_mm256_loadu_ps(&spin_rate_[first]), delta)));
+    _mm256_storeu_ps(&orbit_angle_[first], orbit_angle);
+    _mm256_storeu_ps(&spin_angle_[first], spin_angle);
+
+    __m256 orbit_sine;
+    __m256 orbit_cosine;
+    SinCos8(orbit_angle, &orbit_sine, &orbit_cosine);
+    __m256 half_sine;
+    __m256 half_cosine;
+    SinCos8(_mm256_mul_ps(spin_angle, _mm256_set1_ps(0.5f)), &half_sine,
+            &half_cosine);
+
+    // One row per InstanceTransform float, one column per rock. Transposed,
+    // each row is a whole rock, so the stores fill the output in order.
+    const __m256 radius = _mm256_loadu_ps(&orbit_radius_[first]);
+    __m256 rows[8] = {
+        _mm256_mul_ps(orbit_sine, radius),
+        _mm256_loadu_ps(&height_[first]),
+        _mm256_mul_ps(orbit_cosine, radius),
+        _mm256_loadu_ps(&scale_[first]),
+        _mm256_mul_ps(_mm256_loadu_ps(&spin_axis_x_[first]), half_sine),
+        _mm256_mul_ps(_mm256_loadu_ps(&spin_axis_y_[first]), half_sine),
+        _mm256_mul_ps(_mm256_loadu_ps(&spin_axis_z_[first]), half_sine),
+        half_cosine};
+    Transpose8(rows);
+    float* target = reinterpret_cast<float*>(group);
+    for (std::size_t lane = 0; lane < kGroupSize; lane++) {
+      _mm256_storeu_ps(target + lane * 8, rows[lane]);
+    }
+    return;
+  }
+#else
+  (void)simd;
+#endif
+  for (std::size_t lane = 0; lane < kGroupSize; lane++) {
+    const std::size_t i = first + lane;
+    orbit_angle_[i] = Wrap(orbit_angle_[i] + orbit_speed_[i] * delta_time);
+    spin_angle_[i] = Wrap(spin_angle_[i] + spin_rate_[i] * delta_time);
+
+    float orbit_sine;
+    float orbit_cosine;
+    SinCos(orbit_angle_[i], &orbit_sine, &orbit_cosine);
+    float half_sine;
+    float half_cosine;
+    SinCos(spin_angle_[i] * 0.5f, &half_sine, &half_cosine);
+
+    group[lane].position =
+        glm::vec3(orbit_sine * orbit_radius_[i], height_[i],
+                  orbit_cosine * orbit_radius_[i]);
+    group[lane].scale = scale_[i];
+    group[lane].rotation =
+        glm::vec4(spin_axis_x_[i] * half_sine, spin_axis_y_[i] * half_sine,
+                  spin_axis_z_[i] * half_sine, half_cosine);
+  }
+}
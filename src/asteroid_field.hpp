@@ -0,0 +1,92 @@
+#ifndef LEARNGL_ASTEROID_FIELD_HPP_
+#define LEARNGL_ASTEROID_FIELD_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "instance_transform.hpp"
+
+// The ring of rocks around the planet in the asteroid samples.
+struct AsteroidField {
+  std::uint64_t seed = 1;
+  float radius = 50.0f;
+  // Rocks are displaced up to this far from the ring along x and z, and
+  // `height` times as far along y
+  float offset = 2.5f;
+  float height = 0.4f;
+  float min_scale = 0.05f;
+  float max_scale = 0.25f;
+  // Every rock is turned around this axis by a random angle
+  glm::vec3 rotation_axis = glm::vec3(0.4f, 0.6f, 0.8f);
+
+  // Motion of an AsteroidBelt, in radians per second. Rocks at `radius`
+  // orbit at `orbit_speed`; closer ones are faster, as in Kepler's third
+  // law. Each spins around a random axis at a random rate in the range.
+  float orbit_speed = 0.05f;
+  float min_spin_rate = 0.2f;
+  float max_spin_rate = 1.5f;
+};
+
+struct AsteroidFieldOptions {
+  // Evaluate 8 rocks (AVX) per iteration instead of one at a time. Both
+  // paths do the same float operations in the same order, so their results
+  // are bit-identical.
+  bool simd = true;
+  // Split the rocks across SharedThreadPool()
+  bool parallel = true;
+};
+
+// Write `count` rocks of `field` to `transforms`. Rock i is drawn from a
+// counter-based generator keyed by the seed and i, so it does not depend on
+// how the work is split: the same seed and count give the same field on
+// every run. `transforms` may point into a mapped buffer.
+void GenerateAsteroidField(const AsteroidField& field, std::size_t count,
+                           InstanceTransform* transforms,
+                           const AsteroidFieldOptions& options = {});
+
+// As above, with the rocks expanded to model matrices.
+void GenerateAsteroidField(const AsteroidField& field, std::size_t count,
+                           glm::mat4* matrices,
+                           const AsteroidFieldOptions& options = {});
+
+// The rocks of an AsteroidField in motion: every rock orbits the planet on
+// its own circle and spins around its own axis. The state is stored as one
+// array per quantity (structure of arrays) so Update() can integrate eight
+// rocks per AVX instruction.
+class AsteroidBelt {
+ public:
+  // Starts from the same rocks GenerateAsteroidField() places.
+  AsteroidBelt(const AsteroidField& field, std::size_t count);
+
+  // Advance every rock by `delta_time` seconds and write its transform to
+  // `transforms`. The transforms are written once, in order and in whole
+  // 32-byte rocks, never read back, so `transforms` may point into
+  // write-combined mapped memory.
+  void Update(float delta_time, InstanceTransform* transforms,
+              const AsteroidFieldOptions& options = {});
+
+  std::size_t Count() const;
+
+ private:
+  // Rocks first to first + 8, which must all be in the padded arrays
+  void UpdateGroup(std::size_t first, float delta_time, bool simd,
+                   InstanceTransform* group);
+
+  std::size_t count_;
+  // Padded to a whole number of groups of eight
+  std::vector<float> orbit_angle_;
+  std::vector<float> orbit_radius_;
+  std::vector<float> orbit_speed_;
+  std::vector<float> height_;
+  std::vector<float> scale_;
+  std::vector<float> spin_angle_;
+  std::vector<float> spin_rate_;
+  std::vector<float> spin_axis_x_;
+  std::vector<float> spin_axis_y_;
+  std::vector<float> spin_axis_z_;
+};
+
+#endif
@@ -0,0 +1,370 @@
+#include "bc_encoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr int kBlockDim = 4;
+constexpr int kBlockTexels = kBlockDim * kBlockDim;
+
+// BC7 interpolation weights for 4-bit indices.
+constexpr int kBc7Weights4[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                  34, 38, 43, 47, 51, 55, 60, 64};
+
+// Gather a 4x4 block of RGBA texels, clamping reads past the image edge.
+void FetchBlock(const unsigned char* rgba, int width, int height, int block_x,
+                int block_y, unsigned char block[kBlockTexels][4]) {
+  for (int y = 0; y < kBlockDim; y++) {
+    const int src_y = std::min(block_y * kBlockDim + y, height - 1);
+    for (int x = 0; x < kBlockDim; x++) {
+      const int src_x = std::min(block_x * kBlockDim + x, width - 1);
+      const unsigned char* texel = rgba + (src_y * width + src_x) * 4;
+      std::memcpy(block[y * kBlockDim + x], texel, 4);
+    }
+  }
+}
+
+// Find the principal axis of the block's first `channels` channels using a
+// few power iterations on the covariance matrix. Returns the mean in `mean`.
+void PrincipalAxis(const unsigned char block[kBlockTexels][4], int channels,
+                   float mean[4], float axis[4]) {
+  for (int c = 0; c < 4; c++) {
+    mean[c] = 0.0f;
+    axis[c] = 0.0f;
+  }
+  for (int i = 0; i < kBlockTexels; i++) {
+    for (int c = 0; c < channels; c++) {
+      mean[c] += block[i][c];
+    }
+  }
+  for (int c = 0; c < channels; c++) {
+    mean[c] /= kBlockTexels;
+  }
+
+  float covariance[4][4] = {};
+  for (int i = 0; i < kBlockTexels; i++) {
+    float delta[4];
+    for (int c = 0; c < channels; c++) {
+      delta[c] = block[i][c] - mean[c];
+    }
+    for (int a = 0; a < channels; a++) {
+      for (int b = 0; b < channels; b++) {
+        covariance[a][b] += delta[a] * delta[b];
+      }
+    }
+  }
+
+  for (int c = 0; c < channels; c++) {
+    axis[c] = 1.0f;
+  }
+  for (int iteration = 0; iteration < 8; iteration++) {
+    float next[4] = {};
+    float largest = 0.0f;
+    for (int a = 0; a < channels; a++) {
+      for (int b = 0; b < channels; b++) {
+        next[a] += covariance[a][b] * axis[b];
+      }
+      largest = std::max(largest, std::abs(next[a]));
+    }
+    if (largest == 0.0f) {
+      // Flat block, any axis will do
+      return;
+    }
+    for (int c = 0; c < channels; c++) {
+      axis[c] = next[c] / largest;
+    }
+  }
+}
+
+// Project the block onto its principal axis and return the two extreme
+// colors, inset slightly to reduce quantization error at the ends.
+void AxisEndpoints(const unsigned char block[kBlockTexels][4], int channels,
+                   float start[4], float end[4]) {
+  float mean[4];
+  float axis[4];
+  PrincipalAxis(block, channels, mean, axis);
+
+  float min_t = 0.0f;
+  float max_t = 0.0f;
+  float axis_length_squared = 0.0f;
+  for (int c = 0; c < channels; c++) {
+    axis_length_squared += axis[c] * axis[c];
+  }
+  if (axis_length_squared > 0.0f) {
+    for (int i = 0; i < kBlockTexels; i++) {
+      float t = 0.0f;
+      for (int c = 0; c < channels; c++) {
+        t += (block[i][c] - mean[c]) * axis[c];
+      }
+      t /= axis_length_squared;
+      min_t = std::min(min_t, t);
+      max_t = std::max(max_t, t);
+    }
+  }
+
+  const float inset = (max_t - min_t) / 16.0f;
+  min_t += inset;
+  max_t -= inset;
+  for (int c = 0; c < 4; c++) {
+    start[c] = std::clamp(mean[c] + axis[c] * min_t, 0.0f, 255.0f);
+    end[c] = std::clamp(mean[c] + axis[c] * max_t, 0.0f, 255.0f);
+  }
+}
+
+int SquaredDistance(const unsigned char* a, const int* b, int channels) {
+  int distance = 0;
+  for (int c = 0; c < channels; c++) {
+    const int delta = a[c] - b[c];
+    distance += delta * delta;
+  }
+  return distance;
+}
+
+std::uint16_t PackRgb565(const float color[4]) {
+  const int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+  const int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+  const int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+  return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void UnpackRgb565(std::uint16_t packed, int color[4]) {
+  const int r = (packed >> 11) & 0x1f;
+  const int g = (packed >> 5) & 0x3f;
+  const int b = packed & 0x1f;
+  color[0] = (r << 3) | (r >> 2);
+  color[1] = (g << 2) | (g >> 4);
+  color[2] = (b << 3) | (b >> 2);
+  color[3] = 255;
+}
+
+// BC1 color block in four-color mode (color0 > color1).
+void EncodeBc1Block(const unsigned char block[kBlockTexels][4],
+                    unsigned char* out) {
+  float start[4];
+  float end[4];
+  AxisEndpoints(block, 3, start, end);
+
+  std::uint16_t color0 = PackRgb565(end);
+  std::uint16_t color1 = PackRgb565(start);
+  if (color0 < color1) {
+    std::swap(color0, color1);
+  }
+
+  std::uint32_t indices = 0;
+  if (color0 != color1) {
+    int palette[4][4];
+    UnpackRgb565(color0, palette[0]);
+    UnpackRgb565(color1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    for (int i = 0; i < kBlockTexels; i++) {
+      int best_index = 0;
+      int best_distance = SquaredDistance(block[i], palette[0], 3);
+      for (int p = 1; p < 4; p++) {
+        const int distance = SquaredDistance(block[i], palette[p], 3);
+        if (distance < best_distance) {
+          best_distance = distance;
+          best_index = p;
+        }
+      }
+      indices |= static_cast<std::uint32_t>(best_index) << (2 * i);
+    }
+  }
+
+  out[0] = color0 & 0xff;
+  out[1] = color0 >> 8;
+  out[2] = color1 & 0xff;
+  out[3] = color1 >> 8;
+  for (int i = 0; i < 4; i++) {
+    out[4 + i] = (indices >> (8 * i)) & 0xff;
+  }
+}
+
+// BC4 single channel block in eight-value mode (value0 > value1).
+void EncodeBc4Block(const unsigned char block[kBlockTexels][4], int channel,
+                    unsigned char* out) {
+  int low = 255;
+  int high = 0;
+  for (int i = 0; i < kBlockTexels; i++) {
+    low = std::min<int>(low, block[i][channel]);
+    high = std::max<int>(high, block[i][channel]);
+  }
+
+  std::uint64_t bits = static_cast<std::uint64_t>(high) |
+                       (static_cast<std::uint64_t>(low) << 8);
+  if (high != low) {
+    int palette[8];
+    palette[0] = high;
+    palette[1] = low;
+    for (int i = 2; i < 8; i++) {
+      palette[i] = ((8 - i) * high + (i - 1) * low) / 7;
+    }
+
+    for (int i = 0; i < kBlockTexels; i++) {
+      const int value = block[i][channel];
+      int best_index = 0;
+      int best_distance = std::abs(value - palette[0]);
+      for (int p = 1; p < 8; p++) {
+        const int distance = std::abs(value - palette[p]);
+        if (distance < best_distance) {
+          best_distance = distance;
+          best_index = p;
+        }
+      }
+      bits |= static_cast<std::uint64_t>(best_index) << (16 + 3 * i);
+    }
+  }
+
+  for (int i = 0; i < 8; i++) {
+    out[i] = (bits >> (8 * i)) & 0xff;
+  }
+}
+
+// Quantize an 8-bit endpoint to BC7 mode 6's 7 bits plus its own p-bit,
+// picking the p-bit that reconstructs the endpoint most accurately.
+void QuantizeBc7Endpoint(const float endpoint[4], int quantized[4],
+                         int* p_bit) {
+  int best_error = -1;
+  for (int p = 0; p < 2; p++) {
+    int candidate[4];
+    int error = 0;
+    for (int c = 0; c < 4; c++) {
+      const int value = static_cast<int>((endpoint[c] - p) / 2.0f + 0.5f);
+      candidate[c] = std::clamp(value, 0, 127);
+      const int delta =
+          ((candidate[c] << 1) | p) - static_cast<int>(endpoint[c]);
+      error += delta * delta;
+    }
+    if (best_error < 0 || error < best_error) {
+      best_error = error;
+      *p_bit = p;
+      std::memcpy(quantized, candidate, sizeof(candidate));
+    }
+  }
+}
+
+void WriteBits(unsigned char* out, int* position, std::uint32_t value,
+               int count) {
+  for (int i = 0; i < count; i++) {
+    if ((value >> i) & 1) {
+      out[*position >> 3] |= 1 << (*position & 7);
+    }
+    (*position)++;
+  }
+}
+
+// BC7 mode 6: a single RGBA subset with 7.7.7.7 endpoints, unique p-bits and
+// 4-bit indices.
+void EncodeBc7Block(const unsigned char block[kBlockTexels][4],
+                    unsigned char* out) {
+  float start[4];
+  float end[4];
+  AxisEndpoints(block, 4, start, end);
+
+  int endpoints[2][4];
+  int p_bits[2];
+  QuantizeBc7Endpoint(start, endpoints[0], &p_bits[0]);
+  QuantizeBc7Endpoint(end, endpoints[1], &p_bits[1]);
+
+  int palette[16][4];
+  for (int c = 0; c < 4; c++) {
+    const int e0 = (endpoints[0][c] << 1) | p_bits[0];
+    const int e1 = (endpoints[1][c] << 1) | p_bits[1];
+    for (int i = 0; i < 16; i++) {
+      palette[i][c] =
+          ((64 - kBc7Weights4[i]) * e0 + kBc7Weights4[i] * e1 + 32) >> 6;
+    }
+  }
+
+  int indices[kBlockTexels];
+  for (int i = 0; i < kBlockTexels; i++) {
+    int best_index = 0;
+    int best_distance = SquaredDistance(block[i], palette[0], 4);
+    for (int p = 1; p < 16; p++) {
+      const int distance = SquaredDistance(block[i], palette[p], 4);
+      if (distance < best_distance) {
+        best_distance = distance;
+        best_index = p;
+      }
+    }
+    indices[i] = best_index;
+  }
+
+  // The anchor index stores only three bits, so its high bit must be zero.
+  if (indices[0] & 8) {
+    std::swap(endpoints[0], endpoints[1]);
+    std::swap(p_bits[0], p_bits[1]);
+    for (int i = 0; i < kBlockTexels; i++) {
+      indices[i] = 15 - indices[i];
+    }
+  }
+
+  std::memset(out, 0, 16);
+  int position = 0;
+  WriteBits(out, &position, 1 << 6, 7);
+  for (int c = 0; c < 4; c++) {
+    WriteBits(out, &position, endpoints[0][c], 7);
+    WriteBits(out, &position, endpoints[1][c], 7);
+  }
+  WriteBits(out, &position, p_bits[0], 1);
+  WriteBits(out, &position, p_bits[1], 1);
+  WriteBits(out, &position, indices[0], 3);
+  for (int i = 1; i < kBlockTexels; i++) {
+    WriteBits(out, &position, indices[i], 4);
+  }
+}
+
+}  // namespace
+
+std::size_t BlockSize(BlockFormat format) {
+  return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+std::size_t CompressedImageSize(BlockFormat format, int width, int height) {
+  const std::size_t blocks_x = (width + kBlockDim - 1) / kBlockDim;
+  const std::size_t blocks_y = (height + kBlockDim - 1) / kBlockDim;
+  return blocks_x * blocks_y * BlockSize(format);
+}
+
+std::vector<unsigned char> CompressImage(const unsigned char* rgba, int width,
+                                         int height, BlockFormat format) {
+  std::vector<unsigned char> compressed(
+      CompressedImageSize(format, width, height));
+  const int blocks_x = (width + kBlockDim - 1) / kBlockDim;
+  const int blocks_y = (height + kBlockDim - 1) / kBlockDim;
+  const std::size_t block_size = BlockSize(format);
+
+  unsigned char block[kBlockTexels][4];
+  for (int by = 0; by < blocks_y; by++) {
+    for (int bx = 0; bx < blocks_x; bx++) {
+      FetchBlock(rgba, width, height, bx, by, block);
+      unsigned char* out =
+          compressed.data() + (by * blocks_x + bx) * block_size;
+      switch (format) {
+        case BlockFormat::BC1:
+          EncodeBc1Block(block, out);
+          break;
+        case BlockFormat::BC3:
+          // Alpha block first, followed by the color block
+          EncodeBc4Block(block, 3, out);
+          EncodeBc1Block(block, out + 8);
+          break;
+        case BlockFormat::BC5:
+          EncodeBc4Block(block, 0, out);
+          EncodeBc4Block(block, 1, out + 8);
+          break;
+        case BlockFormat::BC7:
+          EncodeBc7Block(block, out);
+          break;
+      }
+    }
+  }
+  return compressed;
+}
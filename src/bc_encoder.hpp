@@ -0,0 +1,26 @@
+#ifndef LEARNGL_BC_ENCODER_HPP_
+#define LEARNGL_BC_ENCODER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+// GPU block-compression formats. Every format encodes 4x4 texel blocks.
+enum class BlockFormat {
+  BC1,  // RGB, 8 bytes per block (opaque color textures)
+  BC3,  // RGBA, 16 bytes per block (BC1 color + BC4 alpha)
+  BC5,  // RG, 16 bytes per block (two BC4 channels, e.g. normal maps)
+  BC7,  // RGBA, 16 bytes per block (mode 6 only)
+};
+
+// Number of bytes a single 4x4 block occupies.
+std::size_t BlockSize(BlockFormat format);
+
+// Number of bytes needed to store a width x height image in the format.
+std::size_t CompressedImageSize(BlockFormat format, int width, int height);
+
+// Compress a tightly packed 8-bit RGBA image. Images whose dimensions are not
+// a multiple of four are padded by clamping to the edge texel.
+std::vector<unsigned char> CompressImage(const unsigned char* rgba, int width,
+                                         int height, BlockFormat format);
+
+#endif
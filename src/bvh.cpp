@@ -0,0 +1,639 @@
+#include "bvh.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#include "thread_pool.hpp"
+
+namespace {
+
+constexpr int kBinCount = 16;
+// Triangles per leaf: one AVX pass
+constexpr std::uint32_t kMaxTriangleLeafSize = 8;
+constexpr std::uint32_t kMaxInstanceLeafSize = 4;
+// Cost of a traversal step relative to one primitive test
+constexpr float kTraversalCost = 1.0f;
+// Deeper nodes become leaves whatever their size, which bounds the
+// traversal stack
+constexpr int kMaxDepth = 48;
+constexpr int kStackSize = 64;
+// Nodes with at least this many primitives bin them across the pool;
+// subtrees with fewer are built whole by one thread, in parallel
+constexpr std::uint32_t kParallelBinning = 65536;
+constexpr std::uint32_t kParallelSubtree = 4096;
+// Direction components closer to 0 are replaced so 1 / d stays finite
+constexpr float kMinDirection = 1e-20f;
+
+struct Aabb {
+  glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+  glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+  void Grow(const glm::vec3& point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+  void Grow(const Aabb& box) {
+    min = glm::min(min, box.min);
+    max = glm::max(max, box.max);
+  }
+  float HalfArea() const {
+    const glm::vec3 size = glm::max(max - min, glm::vec3(0.0f));
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+  }
+};
+
+// A primitive's bounds, their centroid and its index, moved as one so the
+// builder reads them in order
+struct Primitive {
+  Aabb bounds;
+  glm::vec3 centroid;
+  std::uint32_t index;
+};
+
+struct Bin {
+  Aabb bounds;
+  std::uint32_t count = 0;
+};
+
+// Primitives of order[begin, end) whose tree goes under nodes[node]
+struct Subtree {
+  std::uint32_t node;
+  std::uint32_t begin;
+  std::uint32_t end;
+  int depth;
+};
+
+// Builds the nodes over primitive bounds with binned SAH. The upper levels
+// are built first, binning across the pool; the subtrees below
+// kParallelSubtree primitives are then built in parallel into their own
+// arrays and appended.
+class Builder {
+ public:
+  // Leaves hold up to `max_leaf_size` primitives, which cost the same to
+  // test in groups of `leaf_granularity`.
+  Builder(const std::vector<Aabb>& bounds, std::uint32_t max_leaf_size,
+          std::uint32_t leaf_granularity, bool parallel)
+      : max_leaf_size_(max_leaf_size),
+        leaf_granularity_(leaf_granularity),
+        parallel_(parallel) {
+    primitives_.resize(bounds.size());
+    for (std::size_t i = 0; i < bounds.size(); i++) {
+      primitives_[i] = {bounds[i], (bounds[i].min + bounds[i].max) * 0.5f,
+                        static_cast<std::uint32_t>(i)};
+    }
+  }
+
+  void Build(std::vector<BvhNode>* nodes, std::vector<std::uint32_t>* order) {
+    nodes->clear();
+    if (primitives_.empty()) {
+      order->clear();
+      return;
+    }
+    nodes->resize(1);
+    std::vector<Subtree> deferred;
+    Subdivide(nodes,
+              {0, 0, static_cast<std::uint32_t>(primitives_.size()), 0},
+              parallel_ ? &deferred : nullptr);
+
+    std::vector<std::vector<BvhNode>> subtrees(deferred.size());
+    const auto build_subtrees = [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; i++) {
+        subtrees[i].resize(1);
+        Subtree root = deferred[i];
+        root.node = 0;
+        Subdivide(&subtrees[i], root, nullptr);
+      }
+    };
+    SharedThreadPool().ParallelFor(deferred.size(), 1, build_subtrees);
+
+    // A subtree's root replaces its placeholder; its other nodes move to
+    // the end, so child indices k >= 1 become base + k - 1
+    for (std::size_t i = 0; i < deferred.size(); i++) {
+      const std::vector<BvhNode>& subtree = subtrees[i];
+      const std::uint32_t base = static_cast<std::uint32_t>(nodes->size());
+      const auto relocate = [base](BvhNode node) {
+        if (node.count == 0) {
+          node.first = base + node.first - 1;
+        }
+        return node;
+      };
+      (*nodes)[deferred[i].node] = relocate(subtree[0]);
+      for (std::size_t k = 1; k < subtree.size(); k++) {
+        nodes->push_back(relocate(subtree[k]));
+      }
+    }
+    order->resize(primitives_.size());
+    for (std::size_t i = 0; i < primitives_.size(); i++) {
+      (*order)[i] = primitives_[i].index;
+    }
+  }
+
+ private:
+  // Reordered into leaf order as the tree is built
+  std::vector<Primitive> primitives_;
+  std::uint32_t max_leaf_size_;
+  std::uint32_t leaf_granularity_;
+  bool parallel_;
+
+  // Run function(begin, end) over primitives_[begin, end), across the pool for
+  // large ranges
+  template <typename Function>
+  void ForRange(std::uint32_t begin, std::uint32_t end, bool parallel,
+                const Function& function) const {
+    if (parallel && end - begin >= kParallelBinning) {
+      SharedThreadPool().ParallelFor(
+          end - begin, kParallelBinning / 8,
+          [&](std::size_t first, std::size_t last) {
+            function(begin + first, begin + last);
+          });
+    } else {
+      function(begin, end);
+    }
+  }
+
+  // SAH cost of testing `count` primitives, which are tested
+  // leaf_granularity_ at a time
+  float PrimitiveCost(std::uint32_t count) const {
+    return static_cast<float>((count + leaf_granularity_ - 1) /
+                              leaf_granularity_);
+  }
+
+  void Subdivide(std::vector<BvhNode>* nodes, const Subtree& range,
+                 std::vector<Subtree>* deferred) {
+    const bool parallel = deferred != nullptr;
+    const std::uint32_t count = range.end - range.begin;
+
+    Aabb bounds;
+    Aabb centroid_bounds;
+    std::mutex mutex;
+    ForRange(range.begin, range.end, parallel,
+             [&](std::size_t begin, std::size_t end) {
+               Aabb local_bounds;
+               Aabb local_centroids;
+               for (std::size_t i = begin; i < end; i++) {
+                 local_bounds.Grow(primitives_[i].bounds);
+                 local_centroids.Grow(primitives_[i].centroid);
+               }
+               std::lock_guard<std::mutex> lock(mutex);
+               bounds.Grow(local_bounds);
+               centroid_bounds.Grow(local_centroids);
+             });
+    BvhNode& node = (*nodes)[range.node];
+    node.min = bounds.min;
+    node.max = bounds.max;
+    node.first = range.begin;
+    node.count = count;
+
+    const bool may_be_leaf = count <= max_leaf_size_;
+    if (count <= 1 || range.depth >= kMaxDepth) {
+      return;
+    }
+
+    // Bin the centroids along every axis with any extent
+    const glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+    glm::vec3 bin_scale(0.0f);
+    for (int axis = 0; axis < 3; axis++) {
+      if (extent[axis] > 0.0f) {
+        bin_scale[axis] = kBinCount / extent[axis];
+      }
+    }
+    const auto bin_of = [&](const Primitive& primitive, int axis) {
+      const float offset =
+          (primitive.centroid[axis] - centroid_bounds.min[axis]) *
+          bin_scale[axis];
+      return std::min(kBinCount - 1, static_cast<int>(offset));
+    };
+    Bin bins[3][kBinCount];
+    ForRange(range.begin, range.end, parallel,
+             [&](std::size_t begin, std::size_t end) {
+               Bin local[3][kBinCount];
+               for (std::size_t i = begin; i < end; i++) {
+                 const Primitive& primitive = primitives_[i];
+                 for (int axis = 0; axis < 3; axis++) {
+                   Bin& bin = local[axis][bin_of(primitive, axis)];
+                   bin.bounds.Grow(primitive.bounds);
+                   bin.count++;
+                 }
+               }
+               std::lock_guard<std::mutex> lock(mutex);
+               for (int axis = 0; axis < 3; axis++) {
+                 for (int b = 0; b < kBinCount; b++) {
+                   bins[axis][b].bounds.Grow(local[axis][b].bounds);
+                   bins[axis][b].count += local[axis][b].count;
+                 }
+               }
+             });
+
+    // Sweep the planes between bins from both sides; a split costs the
+    // area of each side times the cost of its primitives
+    float best_cost = std::numeric_limits<float>::max();
+    int best_axis = -1;
+    int best_split = 0;
+    for (int axis = 0; axis < 3; axis++) {
+      if (bin_scale[axis] == 0.0f) {
+        continue;
+      }
+      float right_cost[kBinCount];
+      Aabb right;
+      std::uint32_t right_count = 0;
+      for (int b = kBinCount - 1; b > 0; b--) {
+        right.Grow(bins[axis][b].bounds);
+        right_count += bins[axis][b].count;
+        right_cost[b] = right.HalfArea() * PrimitiveCost(right_count);
+      }
+      Aabb left;
+      std::uint32_t left_count = 0;
+      for (int b = 0; b < kBinCount - 1; b++) {
+        left.Grow(bins[axis][b].bounds);
+        left_count += bins[axis][b].count;
+        if (left_count == 0 || left_count == count) {
+          continue;
+        }
+        const float cost =
+            left.HalfArea() * PrimitiveCost(left_count) + right_cost[b + 1];
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = axis;
+          best_split = b + 1;
+        }
+      }
+    }
+
+    std::uint32_t middle;
+    if (best_axis >= 0) {
+      const float leaf_cost = bounds.HalfArea() * PrimitiveCost(count);
+      const float split_cost = kTraversalCost * bounds.HalfArea() + best_cost;
+      if (may_be_leaf && leaf_cost <= split_cost) {
+        return;
+      }
+      middle = static_cast<std::uint32_t>(
+          std::partition(primitives_.begin() + range.begin,
+                         primitives_.begin() + range.end,
+                         [&](const Primitive& primitive) {
+                           return bin_of(primitive, best_axis) < best_split;
+                         }) -
+          primitives_.begin());
+    } else if (may_be_leaf) {
+      return;
+    } else {
+      // All centroids coincide; any split is as good as another
+      middle = range.begin + count / 2;
+    }
+
+    const std::uint32_t child = static_cast<std::uint32_t>(nodes->size());
+    nodes->resize(nodes->size() + 2);
+    (*nodes)[range.node].first = child;
+    (*nodes)[range.node].count = 0;
+    const Subtree children[] = {
+        {child, range.begin, middle, range.depth + 1},
+        {child + 1, middle, range.end, range.depth + 1}};
+    for (const Subtree& subtree : children) {
+      if (deferred != nullptr &&
+          subtree.end - subtree.begin < kParallelSubtree) {
+        deferred->push_back(subtree);
+      } else {
+        Subdivide(nodes, subtree, deferred);
+      }
+    }
+  }
+};
+
+glm::vec3 SafeInverse(const glm::vec3& direction) {
+  glm::vec3 inverse;
+  for (int axis = 0; axis < 3; axis++) {
+    const float d = direction[axis];
+    inverse[axis] =
+        1.0f / (std::abs(d) < kMinDirection ? std::copysign(kMinDirection, d)
+                                            : d);
+  }
+  return inverse;
+}
+
+// Distance at which the ray enters `node`, or infinity if it misses it or
+// only enters at or beyond `limit`
+float EntryDistance(const BvhNode& node, const glm::vec3& origin,
+                    const glm::vec3& inverse, float limit) {
+  const glm::vec3 t1 = (node.min - origin) * inverse;
+  const glm::vec3 t2 = (node.max - origin) * inverse;
+  const glm::vec3 near = glm::min(t1, t2);
+  const glm::vec3 far = glm::max(t1, t2);
+  const float entry =
+      std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+  const float exit = std::min(std::min(far.x, far.y), far.z);
+  return entry <= exit && entry < limit
+             ? entry
+             : std::numeric_limits<float>::infinity();
+}
+
+// Walk the nodes front to back, calling leaf(first, count) on every leaf
+// the ray enters closer than hit->distance
+template <typename Leaf>
+void Traverse(const std::vector<BvhNode>& nodes, const Ray& ray,
+              const RayHit* hit, const Leaf& leaf) {
+  if (nodes.empty()) {
+    return;
+  }
+  const glm::vec3 inverse = SafeInverse(ray.direction);
+  struct Entry {
+    std::uint32_t node;
+    float distance;
+  };
+  Entry stack[kStackSize];
+  int size = 0;
+  float distance = EntryDistance(nodes[0], ray.origin, inverse,
+                                 hit->distance);
+  std::uint32_t current = 0;
+  while (true) {
+    if (distance < hit->distance) {
+      const BvhNode& node = nodes[current];
+      if (node.count > 0) {
+        leaf(node.first, node.count);
+      } else {
+        // Visit the nearer child first and come back for the other
+        std::uint32_t near = node.first;
+        std::uint32_t far = node.first + 1;
+        float near_distance =
+            EntryDistance(nodes[near], ray.origin, inverse, hit->distance);
+        float far_distance =
+            EntryDistance(nodes[far], ray.origin, inverse, hit->distance);
+        if (far_distance < near_distance) {
+          std::swap(near, far);
+          std::swap(near_distance, far_distance);
+        }
+        if (far_distance < hit->distance) {
+          stack[size++] = {far, far_distance};
+        }
+        current = near;
+        distance = near_distance;
+        continue;
+      }
+    }
+    if (size == 0) {
+      return;
+    }
+    size--;
+    current = stack[size].node;
+    distance = stack[size].distance;
+  }
+}
+
+// Rotate `v` by the unit quaternion `q` (x, y, z, w)
+glm::vec3 Rotate(const glm::vec4& q, const glm::vec3& v) {
+  const glm::vec3 axis(q);
+  const glm::vec3 t = 2.0f * glm::cross(axis, v);
+  return v + q.w * t + glm::cross(axis, t);
+}
+
+}  // namespace
+
+void TriangleBvh::Build(const std::vector<glm::vec3>& positions,
+                        const std::vector<unsigned int>& indices,
+                        const BvhOptions& options) {
+  const std::size_t count = indices.size() / 3;
+  std::vector<Aabb> bounds(count);
+  for (std::size_t i = 0; i < count; i++) {
+    for (int corner = 0; corner < 3; corner++) {
+      bounds[i].Grow(positions[indices[3 * i + corner]]);
+    }
+  }
+  // A leaf of 1 to 8 triangles costs one AVX pass
+  Builder builder(bounds, kMaxTriangleLeafSize, kMaxTriangleLeafSize,
+                  options.parallel);
+  builder.Build(&nodes_, &triangles_);
+
+  // Padding up to the next full AVX load past the last triangle; the
+  // padding lanes are masked off
+  const std::size_t padded = count + 7;
+  for (std::vector<float>* array :
+       {&v0_x_, &v0_y_, &v0_z_, &edge1_x_, &edge1_y_, &edge1_z_, &edge2_x_,
+        &edge2_y_, &edge2_z_}) {
+    array->assign(padded, 0.0f);
+  }
+  for (std::size_t i = 0; i < count; i++) {
+    const std::uint32_t triangle = triangles_[i];
+    const glm::vec3& v0 = positions[indices[3 * triangle]];
+    const glm::vec3 edge1 = positions[indices[3 * triangle + 1]] - v0;
+    const glm::vec3 edge2 = positions[indices[3 * triangle + 2]] - v0;
+    v0_x_[i] = v0.x;
+    v0_y_[i] = v0.y;
+    v0_z_[i] = v0.z;
+    edge1_x_[i] = edge1.x;
+    edge1_y_[i] = edge1.y;
+    edge1_z_[i] = edge1.z;
+    edge2_x_[i] = edge2.x;
+    edge2_y_[i] = edge2.y;
+    edge2_z_[i] = edge2.z;
+  }
+}
+
+bool TriangleBvh::Intersect(const Ray& ray, RayHit* hit,
+                            const BvhOptions& options) const {
+  bool found = false;
+  const glm::vec3& o = ray.origin;
+  const glm::vec3& d = ray.direction;
+
+  // Moller-Trumbore for triangle i, the same arithmetic as the AVX lanes
+  const auto intersect_one = [&](std::uint32_t i) {
+    const glm::vec3 edge1(edge1_x_[i], edge1_y_[i], edge1_z_[i]);
+    const glm::vec3 edge2(edge2_x_[i], edge2_y_[i], edge2_z_[i]);
+    const glm::vec3 p = glm::cross(d, edge2);
+    const float determinant = glm::dot(edge1, p);
+    if (determinant == 0.0f) {
+      return;
+    }
+    const float inverse = 1.0f / determinant;
+    const glm::vec3 s = o - glm::vec3(v0_x_[i], v0_y_[i], v0_z_[i]);
+    const float u = glm::dot(s, p) * inverse;
+    const glm::vec3 q = glm::cross(s, edge1);
+    const float v = glm::dot(d, q) * inverse;
+    const float t = glm::dot(edge2, q) * inverse;
+    if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f &&
+        t < hit->distance) {
+      hit->distance = t;
+      hit->triangle = triangles_[i];
+      hit->u = u;
+      hit->v = v;
+      found = true;
+    }
+  };
+
+#if defined(__AVX__)
+  const bool simd = options.simd;
+#else
+  const bool simd = false;
+  (void)options;
+#endif
+  Traverse(nodes_, ray, hit, [&](std::uint32_t first, std::uint32_t count) {
+    std::uint32_t i = first;
+#if defined(__AVX__)
+    if (simd) {
+      const __m256 ox = _mm256_set1_ps(o.x);
+      const __m256 oy = _mm256_set1_ps(o.y);
+      const __m256 oz = _mm256_set1_ps(o.z);
+      const __m256 dx = _mm256_set1_ps(d.x);
+      const __m256 dy = _mm256_set1_ps(d.y);
+      const __m256 dz = _mm256_set1_ps(d.z);
+      const __m256 zero = _mm256_setzero_ps();
+      const __m256 one = _mm256_set1_ps(1.0f);
+      const __m256 lane_index =
+          _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+      for (; i < first + count; i += 8) {
+        const __m256 e1x = _mm256_loadu_ps(&edge1_x_[i]);
+        const __m256 e1y = _mm256_loadu_ps(&edge1_y_[i]);
+        const __m256 e1z = _mm256_loadu_ps(&edge1_z_[i]);
+        const __m256 e2x = _mm256_loadu_ps(&edge2_x_[i]);
+        const __m256 e2y = _mm256_loadu_ps(&edge2_y_[i]);
+        const __m256 e2z = _mm256_loadu_ps(&edge2_z_[i]);
+        // p = d x edge2
+        const __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z),
+                                        _mm256_mul_ps(dz, e2y));
+        const __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x),
+                                        _mm256_mul_ps(dx, e2z));
+        const __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y),
+                                        _mm256_mul_ps(dy, e2x));
+        const __m256 determinant = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)),
+            _mm256_mul_ps(e1z, pz));
+        const __m256 inverse = _mm256_div_ps(one, determinant);
+        // s = o - v0
+        const __m256 sx = _mm256_sub_ps(ox, _mm256_loadu_ps(&v0_x_[i]));
+        const __m256 sy = _mm256_sub_ps(oy, _mm256_loadu_ps(&v0_y_[i]));
+        const __m256 sz = _mm256_sub_ps(oz, _mm256_loadu_ps(&v0_z_[i]));
+        const __m256 u = _mm256_mul_ps(
+            _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)),
+                _mm256_mul_ps(sz, pz)),
+            inverse);
+        // q = s x edge1
+        const __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z),
+                                        _mm256_mul_ps(sz, e1y));
+        const __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x),
+                                        _mm256_mul_ps(sx, e1z));
+        const __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y),
+                                        _mm256_mul_ps(sy, e1x));
+        const __m256 v = _mm256_mul_ps(
+            _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)),
+                _mm256_mul_ps(dz, qz)),
+            inverse);
+        const __m256 t = _mm256_mul_ps(
+            _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)),
+                _mm256_mul_ps(e2z, qz)),
+            inverse);
+
+        const __m256 remaining =
+            _mm256_set1_ps(static_cast<float>(first + count - i));
+        __m256 mask = _mm256_cmp_ps(lane_index, remaining, _CMP_LT_OQ);
+        mask = _mm256_and_ps(
+            mask, _mm256_cmp_ps(determinant, zero, _CMP_NEQ_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+        mask = _mm256_and_ps(
+            mask, _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+        mask = _mm256_and_ps(
+            mask, _mm256_cmp_ps(t, _mm256_set1_ps(hit->distance),
+                                _CMP_LT_OQ));
+        int lanes = _mm256_movemask_ps(mask);
+        if (lanes == 0) {
+          continue;
+        }
+        float distances[8];
+        float us[8];
+        float vs[8];
+        _mm256_storeu_ps(distances, t);
+        _mm256_storeu_ps(us, u);
+        _mm256_storeu_ps(vs, v);
+        for (int lane = 0; lanes != 0; lane++, lanes >>= 1) {
+          if ((lanes & 1) != 0 && distances[lane] < hit->distance) {
+            hit->distance = distances[lane];
+            hit->triangle = triangles_[i + lane];
+            hit->u = us[lane];
+            hit->v = vs[lane];
+            found = true;
+          }
+        }
+      }
+      return;
+    }
+#endif
+    (void)simd;
+    for (; i < first + count; i++) {
+      intersect_one(i);
+    }
+  });
+  return found;
+}
+
+std::size_t TriangleBvh::NodeCount() const {
+  return nodes_.size();
+}
+
+std::size_t TriangleBvh::TriangleCount() const {
+  return triangles_.size();
+}
+
+void InstanceBvh::Build(const InstanceTransform* transforms,
+                        std::size_t count, const glm::vec4& local_sphere,
+                        const BvhOptions& options) {
+  local_sphere_ = local_sphere;
+  std::vector<Aabb> bounds(count);
+  const auto bound = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++) {
+      const InstanceTransform& instance = transforms[i];
+      const glm::vec3 center =
+          instance.position +
+          Rotate(instance.rotation, glm::vec3(local_sphere) * instance.scale);
+      const glm::vec3 radius(local_sphere.w * instance.scale);
+      bounds[i].min = center - radius;
+      bounds[i].max = center + radius;
+    }
+  };
+  if (options.parallel) {
+    SharedThreadPool().ParallelFor(count, kParallelSubtree, bound);
+  } else {
+    bound(0, count);
+  }
+
+  Builder builder(bounds, kMaxInstanceLeafSize, 1, options.parallel);
+  builder.Build(&nodes_, &instances_);
+  transforms_.resize(count);
+  for (std::size_t i = 0; i < count; i++) {
+    transforms_[i] = transforms[instances_[i]];
+  }
+}
+
+bool InstanceBvh::Intersect(const Ray& ray,
+                            const InstanceIntersector& intersect,
+                            RayHit* hit) const {
+  bool found = false;
+  Traverse(nodes_, ray, hit, [&](std::uint32_t first, std::uint32_t count) {
+    for (std::uint32_t i = first; i < first + count; i++) {
+      // Into model space: undo the translation, rotation and scale. The
+      // direction is scaled along with the origin, which keeps t.
+      const InstanceTransform& instance = transforms_[i];
+      const glm::vec4 inverse_rotation(-glm::vec3(instance.rotation),
+                                       instance.rotation.w);
+      const float inverse_scale = 1.0f / instance.scale;
+      const Ray local = {
+          Rotate(inverse_rotation, ray.origin - instance.position) *
+              inverse_scale,
+          Rotate(inverse_rotation, ray.direction) * inverse_scale};
+      if (intersect(instances_[i], local, hit)) {
+        hit->instance = instances_[i];
+        found = true;
+      }
+    }
+  });
+  return found;
+}
+
+std::size_t InstanceBvh::NodeCount() const {
+  return nodes_.size();
+}
@@ -0,0 +1,121 @@
+#ifndef LEARNGL_BVH_HPP_
+#define LEARNGL_BVH_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "instance_transform.hpp"
+#include "ray.hpp"
+
+constexpr std::uint32_t kNoHit = 0xffffffffu;
+
+// The closest hit found so far. Intersect() only reports hits nearer than
+// `distance`, so one RayHit can be passed through several tests.
+struct RayHit {
+  float distance = std::numeric_limits<float>::infinity();
+  // Triangle within its mesh; its indices start at 3 * triangle
+  std::uint32_t triangle = kNoHit;
+  std::uint32_t mesh = kNoHit;
+  std::uint32_t instance = kNoHit;
+  // Barycentric weights of the triangle's second and third vertex
+  float u = 0.0f;
+  float v = 0.0f;
+};
+
+struct BvhOptions {
+  // Intersect 8 (AVX) triangles of a leaf at once instead of one at a time
+  bool simd = true;
+  // Build large trees across SharedThreadPool()
+  bool parallel = true;
+};
+
+// 32 bytes, two to a cache line. The two children of a node are stored
+// next to each other, so a traversal step reads one line.
+struct BvhNode {
+  glm::vec3 min;
+  // Interior node: index of the first child, the second follows it.
+  // Leaf: index of the first primitive.
+  std::uint32_t first;
+  glm::vec3 max;
+  // Primitives in a leaf, 0 for an interior node
+  std::uint32_t count;
+};
+
+static_assert(sizeof(BvhNode) == 32, "BvhNode should fill half a line");
+
+// A bounding volume hierarchy over the triangles of one mesh, built with
+// the surface area heuristic over 16 bins per axis. The triangles are
+// copied in leaf order as separate arrays of the first vertex and the two
+// edges from it, so a leaf of up to 8 triangles is tested with one AVX
+// Moller-Trumbore pass.
+class TriangleBvh {
+ public:
+  // Build over the triangles (indices[3i], indices[3i + 1],
+  // indices[3i + 2]) of `positions`.
+  void Build(const std::vector<glm::vec3>& positions,
+             const std::vector<unsigned int>& indices,
+             const BvhOptions& options = {});
+
+  // Whether `ray` hits a triangle closer than hit->distance. If so, `hit`
+  // is updated with it; its mesh and instance are left alone.
+  bool Intersect(const Ray& ray, RayHit* hit,
+                 const BvhOptions& options = {}) const;
+
+  std::size_t NodeCount() const;
+  std::size_t TriangleCount() const;
+
+ private:
+  std::vector<BvhNode> nodes_;
+  // Per triangle in leaf order, padded to a whole number of AVX lanes
+  std::vector<float> v0_x_;
+  std::vector<float> v0_y_;
+  std::vector<float> v0_z_;
+  std::vector<float> edge1_x_;
+  std::vector<float> edge1_y_;
+  std::vector<float> edge1_z_;
+  std::vector<float> edge2_x_;
+  std::vector<float> edge2_y_;
+  std::vector<float> edge2_z_;
+  // The index of each triangle in the mesh
+  std::vector<std::uint32_t> triangles_;
+};
+
+// A bounding volume hierarchy over many instances of one model, built over
+// the bounds of each instance's bounding sphere. Rays are handed to the
+// instances' own geometry in model space.
+class InstanceBvh {
+ public:
+  // Test `local_ray`, in the model space of `instance`, against its
+  // geometry, e.g. with Model::Raycast(), and update `hit` as
+  // TriangleBvh::Intersect() does.
+  using InstanceIntersector = std::function<bool(
+      std::uint32_t instance, const Ray& local_ray, RayHit* hit)>;
+
+  // Instance i is bounded by `local_sphere` (center, radius) placed by
+  // transforms[i].
+  void Build(const InstanceTransform* transforms, std::size_t count,
+             const glm::vec4& local_sphere, const BvhOptions& options = {});
+
+  // Whether `ray` hits an instance closer than hit->distance. Only the
+  // instances whose bounds the ray enters are tested; hit->instance is set
+  // to the closest. The instance transforms only rotate and scale
+  // uniformly, so distances are the same in model and world space.
+  bool Intersect(const Ray& ray, const InstanceIntersector& intersect,
+                 RayHit* hit) const;
+
+  std::size_t NodeCount() const;
+
+ private:
+  std::vector<BvhNode> nodes_;
+  glm::vec4 local_sphere_ = glm::vec4(0.0f);
+  // In leaf order
+  std::vector<InstanceTransform> transforms_;
+  std::vector<std::uint32_t> instances_;
+};
+
+#endif
@@ -33,6 +33,17 @@ glm::vec3 Camera::Front() const {
   return front_;
 }
 
+Ray Camera::ScreenRay(const glm::mat4& projection,
+                      const glm::vec2& ndc) const {
+  // Unproject the point on the near and the far plane
+  const glm::mat4 inverse = glm::inverse(projection * GetViewMatrix());
+  glm::vec4 near = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+  glm::vec4 far = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+  near /= near.w;
+  far /= far.w;
+  return {glm::vec3(near), glm::normalize(glm::vec3(far) - glm::vec3(near))};
+}
+
 void Camera::UpdateCameraVectors() {
   // Imagine the yaw as an angle offset from the x-axis when looking at a
   // top-down view (looking at x/z plane). x = cos(yaw) and z = sin(yaw).
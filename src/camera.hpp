@@ -3,6 +3,8 @@
 
 #include <glm/glm.hpp>
 
+#include "ray.hpp"
+
 enum class CameraMovement {
   FORWARD,
   BACKWARD,
@@ -20,6 +22,10 @@ class Camera {
     glm::mat4 GetViewMatrix() const;
     glm::vec3 Position() const;
     glm::vec3 Front() const;
+    // The ray from the camera through `ndc` in normalized device
+    // coordinates ([-1, 1], +y up) of `projection`, in world space with a
+    // unit direction
+    Ray ScreenRay(const glm::mat4& projection, const glm::vec2& ndc) const;
 
     void ProcessMovement(CameraMovement movement, float delta_time);
     void ProcessLook(float x_offset, float y_offset);
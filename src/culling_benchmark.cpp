@@ -0,0 +1,89 @@
+// Times InstanceCuller on an asteroid ring with a camera inside it, scalar
+// against SIMD and on one thread against the shared thread pool.
+//
+// Usage:
+//   culling_benchmark [instances] [iterations]
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asteroid_field.hpp"
+#include "frustum_culling.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+constexpr std::size_t kDefaultInstances = 1000000;
+constexpr int kDefaultIterations = 20;
+
+// Same ring as the asteroid samples, scaled up with the instance count
+std::vector<glm::mat4> MakeRing(std::size_t count) {
+  AsteroidField field;
+  field.radius = 50.0f * std::sqrt(count / 5000.0f);
+  std::vector<glm::mat4> matrices(count);
+  GenerateAsteroidField(field, count, matrices.data());
+  return matrices;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::size_t instances = kDefaultInstances;
+  int iterations = kDefaultIterations;
+  if (argc > 1) {
+    instances = std::max<std::size_t>(std::stoull(argv[1]), 1);
+  }
+  if (argc > 2) {
+    iterations = std::max(std::stoi(argv[2]), 1);
+  }
+
+  const std::vector<glm::mat4> matrices = MakeRing(instances);
+  InstanceCuller culler;
+  // Roughly the bounds of the rock model
+  culler.SetInstances(matrices.data(), matrices.size(),
+                      glm::vec4(0.0f, 0.0f, 0.0f, 1.5f));
+  std::vector<glm::mat4> visible(instances);
+
+  // Standing on the ring, looking along it
+  const float radius = 50.0f * std::sqrt(instances / 5000.0f);
+  const glm::mat4 view =
+      glm::lookAt(glm::vec3(0.0f, 0.0f, radius),
+                  glm::vec3(radius, 0.0f, radius), glm::vec3(0.0f, 1.0f, 0.0f));
+  const glm::mat4 projection =
+      glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+  const Frustum frustum = ExtractFrustum(projection * view);
+
+  std::cout << "Instances: " << instances << "\n"
+            << "Threads: " << SharedThreadPool().Concurrency() << "\n"
+            << "Iterations: " << iterations << "\n\n";
+  std::cout << std::fixed << std::setprecision(2);
+
+  const struct {
+    const char* name;
+    CullOptions options;
+  } variants[] = {{"Scalar, one thread:", {false, false}},
+                  {"SIMD, one thread:", {true, false}},
+                  {"Scalar, all threads:", {false, true}},
+                  {"SIMD, all threads:", {true, true}}};
+  for (const auto& variant : variants) {
+    std::size_t visible_count = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      visible_count = culler.Cull(frustum, visible.data(), variant.options);
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << std::left << std::setw(22) << variant.name
+              << elapsed.count() / iterations << " ms, " << visible_count
+              << " visible\n";
+  }
+  return 0;
+}
@@ -0,0 +1,230 @@
+#include "frustum_culling.hpp"
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+namespace {
+
+// Instances per block. Blocks are culled independently and then
+// concatenated, so the output order does not depend on the thread count.
+constexpr std::size_t kBlockSize = 16384;
+
+struct SphereArrays {
+  const float* x;
+  const float* y;
+  const float* z;
+  const float* radius;
+};
+
+bool SphereVisible(const Frustum& frustum, float x, float y, float z,
+                   float radius) {
+  for (const auto& plane : frustum.planes) {
+    if (plane.x * x + plane.y * y + plane.z * z + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void CullBlock(const Frustum& frustum, const SphereArrays& spheres,
+               std::size_t begin, std::size_t end, bool simd,
+               const OcclusionBuffer* occluders,
+               std::vector<std::uint32_t>* visible, std::size_t* occluded) {
+  visible->clear();
+  *occluded = 0;
+  // Called for the instances inside the frustum
+  const auto keep = [&](std::size_t index) {
+    if (occluders != nullptr &&
+        !occluders->SphereVisible(glm::vec4(spheres.x[index], spheres.y[index],
+                                            spheres.z[index],
+                                            spheres.radius[index]))) {
+      (*occluded)++;
+      return;
+    }
+    visible->push_back(static_cast<std::uint32_t>(index));
+  };
+  std::size_t i = begin;
+#if defined(__AVX__)
+  if (simd) {
+    __m256 plane_x[6];
+    __m256 plane_y[6];
+    __m256 plane_z[6];
+    __m256 plane_w[6];
+    for (int p = 0; p < 6; p++) {
+      plane_x[p] = _mm256_set1_ps(frustum.planes[p].x);
+      plane_y[p] = _mm256_set1_ps(frustum.planes[p].y);
+      plane_z[p] = _mm256_set1_ps(frustum.planes[p].z);
+      plane_w[p] = _mm256_set1_ps(frustum.planes[p].w);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= end; i += 8) {
+      const __m256 x = _mm256_loadu_ps(spheres.x + i);
+      const __m256 y = _mm256_loadu_ps(spheres.y + i);
+      const __m256 z = _mm256_loadu_ps(spheres.z + i);
+      const __m256 negative_radius =
+          _mm256_sub_ps(zero, _mm256_loadu_ps(spheres.radius + i));
+      __m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+      for (int p = 0; p < 6; p++) {
+        const __m256 distance = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(plane_x[p], x),
+                          _mm256_mul_ps(plane_y[p], y)),
+            _mm256_add_ps(_mm256_mul_ps(plane_z[p], z), plane_w[p]));
+        inside = _mm256_and_ps(
+            inside, _mm256_cmp_ps(distance, negative_radius, _CMP_GE_OQ));
+      }
+      const int mask = _mm256_movemask_ps(inside);
+      for (int lane = 0; lane < 8; lane++) {
+        if (mask & (1 << lane)) {
+          keep(i + lane);
+        }
+      }
+    }
+  }
+#elif defined(__SSE__)
+  if (simd) {
+    __m128 plane_x[6];
+    __m128 plane_y[6];
+    __m128 plane_z[6];
+    __m128 plane_w[6];
+    for (int p = 0; p < 6; p++) {
+      plane_x[p] = _mm_set1_ps(frustum.planes[p].x);
+      plane_y[p] = _mm_set1_ps(frustum.planes[p].y);
+      plane_z[p] = _mm_set1_ps(frustum.planes[p].z);
+      plane_w[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= end; i += 4) {
+      const __m128 x = _mm_loadu_ps(spheres.x + i);
+      const __m128 y = _mm_loadu_ps(spheres.y + i);
+      const __m128 z = _mm_loadu_ps(spheres.z + i);
+      const __m128 negative_radius =
+          _mm_sub_ps(zero, _mm_loadu_ps(spheres.radius + i));
+      __m128 inside = _mm_cmpeq_ps(zero, zero);
+      for (int p = 0; p < 6; p++) {
+        const __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(plane_x[p], x), _mm_mul_ps(plane_y[p], y)),
+            _mm_add_ps(_mm_mul_ps(plane_z[p], z), plane_w[p]));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negative_radius));
+      }
+      const int mask = _mm_movemask_ps(inside);
+      for (int lane = 0; lane < 4; lane++) {
+        if (mask & (1 << lane)) {
+          keep(i + lane);
+        }
+      }
+    }
+  }
+#else
+  (void)simd;
+#endif
+  for (; i < end; i++) {
+    if (SphereVisible(frustum, spheres.x[i], spheres.y[i], spheres.z[i],
+                      spheres.radius[i])) {
+      keep(i);
+    }
+  }
+}
+
+}  // namespace
+
+Frustum ExtractFrustum(const glm::mat4& view_projection) {
+  // glm matrices are column-major, so row r is m[0][r] ... m[3][r]
+  const auto row = [&](int r) {
+    return glm::vec4(view_projection[0][r], view_projection[1][r],
+                     view_projection[2][r], view_projection[3][r]);
+  };
+  Frustum frustum;
+  frustum.planes[0] = row(3) + row(0);  // Left
+  frustum.planes[1] = row(3) - row(0);  // Right
+  frustum.planes[2] = row(3) + row(1);  // Bottom
+  frustum.planes[3] = row(3) - row(1);  // Top
+  frustum.planes[4] = row(3) + row(2);  // Near
+  frustum.planes[5] = row(3) - row(2);  // Far
+  for (auto& plane : frustum.planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+  return frustum;
+}
+
+void InstanceCuller::SetInstances(const glm::mat4* matrices,
+                                  std::size_t count,
+                                  const glm::vec4& local_sphere) {
+  matrices_.assign(matrices, matrices + count);
+  center_x_.resize(count);
+  center_y_.resize(count);
+  center_z_.resize(count);
+  radius_.resize(count);
+  const glm::vec4 local_center(glm::vec3(local_sphere), 1.0f);
+  for (std::size_t i = 0; i < count; i++) {
+    const glm::mat4& matrix = matrices[i];
+    const glm::vec4 center = matrix * local_center;
+    const float scale = std::max({glm::length(glm::vec3(matrix[0])),
+                                  glm::length(glm::vec3(matrix[1])),
+                                  glm::length(glm::vec3(matrix[2]))});
+    center_x_[i] = center.x;
+    center_y_[i] = center.y;
+    center_z_[i] = center.z;
+    radius_[i] = local_sphere.w * scale;
+  }
+}
+
+std::size_t InstanceCuller::Cull(const Frustum& frustum, glm::mat4* visible,
+                                 const CullOptions& options) {
+  const std::size_t count = Size();
+  const std::size_t block_count = (count + kBlockSize - 1) / kBlockSize;
+  block_visible_.resize(block_count);
+  block_offsets_.resize(block_count);
+  block_occluded_.resize(block_count);
+  const SphereArrays spheres = {center_x_.data(), center_y_.data(),
+                                center_z_.data(), radius_.data()};
+
+  const auto cull_blocks = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t block = begin; block < end; block++) {
+      const std::size_t first = block * kBlockSize;
+      CullBlock(frustum, spheres, first,
+                std::min(first + kBlockSize, count), options.simd,
+                options.occluders, &block_visible_[block],
+                &block_occluded_[block]);
+    }
+  };
+  const auto copy_blocks = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t block = begin; block < end; block++) {
+      glm::mat4* target = visible + block_offsets_[block];
+      for (const std::uint32_t index : block_visible_[block]) {
+        *target++ = matrices_[index];
+      }
+    }
+  };
+
+  if (options.parallel) {
+    SharedThreadPool().ParallelFor(block_count, 1, cull_blocks);
+  } else {
+    cull_blocks(0, block_count);
+  }
+  std::size_t visible_count = 0;
+  occluded_count_ = 0;
+  for (std::size_t block = 0; block < block_count; block++) {
+    block_offsets_[block] = visible_count;
+    visible_count += block_visible_[block].size();
+    occluded_count_ += block_occluded_[block];
+  }
+  if (options.parallel) {
+    SharedThreadPool().ParallelFor(block_count, 1, copy_blocks);
+  } else {
+    copy_blocks(0, block_count);
+  }
+  return visible_count;
+}
+
+std::size_t InstanceCuller::Size() const {
+  return matrices_.size();
+}
+
+std::size_t InstanceCuller::OccludedCount() const {
+  return occluded_count_;
+}
@@ -0,0 +1,68 @@
+#ifndef LEARNGL_FRUSTUM_CULLING_HPP_
+#define LEARNGL_FRUSTUM_CULLING_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "software_occlusion.hpp"
+
+// The six planes of a view frustum as (normal, distance) with the normals
+// facing inwards: a point p is inside when dot(normal, p) + distance >= 0
+// for every plane.
+struct Frustum {
+  glm::vec4 planes[6];
+};
+
+// Extract the world space frustum planes from projection * view.
+Frustum ExtractFrustum(const glm::mat4& view_projection);
+
+struct CullOptions {
+  // Test 8 (AVX) or 4 (SSE) spheres per iteration instead of one at a time
+  bool simd = true;
+  // Split the instances across SharedThreadPool()
+  bool parallel = true;
+  // Also drop the instances inside the frustum hidden behind these, if set.
+  // The buffer must be rasterized with the same camera.
+  const OcclusionBuffer* occluders = nullptr;
+};
+
+// Culls many instances of one model against a frustum. The bounding spheres
+// are kept as separate x, y, z and radius arrays so the kernel loads the
+// centers of 8 instances with one instruction per axis.
+class InstanceCuller {
+ public:
+  // Replace the instances. Instance i is bounded by `local_sphere` (center,
+  // radius) transformed by matrices[i], with the radius grown by the largest
+  // axis scale.
+  void SetInstances(const glm::mat4* matrices, std::size_t count,
+                    const glm::vec4& local_sphere);
+
+  // Copy the matrices of the instances intersecting `frustum` to `visible`,
+  // in their original order, and return how many were copied. `visible`
+  // needs room for Size() matrices.
+  std::size_t Cull(const Frustum& frustum, glm::mat4* visible,
+                   const CullOptions& options = {});
+
+  std::size_t Size() const;
+
+  // Instances inside the frustum that the last Cull() dropped as occluded
+  std::size_t OccludedCount() const;
+
+ private:
+  std::vector<glm::mat4> matrices_;
+  std::vector<float> center_x_;
+  std::vector<float> center_y_;
+  std::vector<float> center_z_;
+  std::vector<float> radius_;
+  // Per block of instances, the indices that survived the last Cull() and
+  // where they start in the output
+  std::vector<std::vector<std::uint32_t>> block_visible_;
+  std::vector<std::size_t> block_offsets_;
+  std::vector<std::size_t> block_occluded_;
+  std::size_t occluded_count_ = 0;
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "gaussian_blur.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include "gpu_resources.hpp"
+
+namespace {
+
+// Matches GROUP_SIZE in the compute shader
+constexpr int kWorkGroupSize = 128;
+// The compute shader writes through an rgba16f image
+constexpr GLenum kFormat = GL_RGBA16F;
+
+void SetFloats(Shader& shader, const std::string& name,
+               const std::vector<float>& values) {
+  glUniform1fv(glGetUniformLocation(shader.id(), (name + "[0]").c_str()),
+               static_cast<GLsizei>(values.size()), values.data());
+}
+
+}  // namespace
+
+std::vector<float> GaussianWeights(int radius) {
+  radius = std::max(radius, 0);
+  std::vector<float> weights(radius + 1, 1.0f);
+  if (radius == 0) {
+    return weights;
+  }
+  const float sigma = radius / 3.0f;
+  float sum = 0.0f;
+  for (int i = 0; i <= radius; i++) {
+    weights[i] = std::exp(-0.5f * i * i / (sigma * sigma));
+    // Every weight but the center's is used on both sides
+    sum += i == 0 ? weights[i] : 2.0f * weights[i];
+  }
+  for (float& weight : weights) {
+    weight /= sum;
+  }
+  return weights;
+}
+
+BilinearTaps MergeBilinearTaps(const std::vector<float>& weights) {
+  BilinearTaps taps;
+  if (weights.empty()) {
+    return taps;
+  }
+  taps.offsets.push_back(0.0f);
+  taps.weights.push_back(weights[0]);
+  const int radius = static_cast<int>(weights.size()) - 1;
+  for (int i = 1; i <= radius; i += 2) {
+    const float near = weights[i];
+    // An odd radius leaves the last texel without a partner
+    const float far = i + 1 <= radius ? weights[i + 1] : 0.0f;
+    const float weight = near + far;
+    taps.offsets.push_back(weight > 0.0f ? (i * near + (i + 1) * far) / weight
+                                         : static_cast<float>(i));
+    taps.weights.push_back(weight);
+  }
+  return taps;
+}
+
+GaussianBlur::GaussianBlur(int width, int height)
+    : width_(width), height_(height) {
+  for (Target* target : {&intermediate_, &result_}) {
+    glGenTextures(1, &target->texture);
+    glBindTexture(GL_TEXTURE_2D, target->texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, kFormat, width_, height_);
+    // The fragment path reads the intermediate image with bilinear taps
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    GpuResources().Track(GpuResourceKind::TEXTURE, target->texture,
+                         {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+                          TextureBytes(kFormat, width_, height_), kFormat,
+                          target == &result_ ? "Blur result"
+                                             : "Blur intermediate"});
+
+    glGenFramebuffers(1, &target->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, target->texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+        GL_FRAMEBUFFER_COMPLETE) {
+      std::cerr << "Unable to complete blur framebuffer\n";
+    }
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  glGenVertexArrays(1, &vao_);
+  SetRadius(0);
+}
+
+void GaussianBlur::SetRadius(int radius) {
+  radius_ = std::clamp(radius, 0, kMaxBlurRadius);
+  weights_ = GaussianWeights(radius_);
+  taps_ = MergeBilinearTaps(weights_);
+}
+
+int GaussianBlur::Radius() const {
+  return radius_;
+}
+
+void GaussianBlur::Blur(Shader& shader, BlurMethod method,
+                        unsigned int source_texture) {
+  switch (method) {
+    case BlurMethod::COMPUTE:
+      BlurCompute(shader, source_texture);
+      break;
+    case BlurMethod::FRAGMENT:
+      BlurFragment(shader, source_texture);
+      break;
+  }
+}
+
+void GaussianBlur::BlurCompute(Shader& shader, unsigned int source_texture) {
+  shader.Use();
+  shader.SetInt("source", 0);
+  shader.SetInt("radius", radius_);
+  SetFloats(shader, "weights", weights_);
+  glActiveTexture(GL_TEXTURE0);
+
+  // The source may just have been rendered to
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+  // Rows: a group per stretch of a row
+  glUniform2i(glGetUniformLocation(shader.id(), "direction"), 1, 0);
+  glBindTexture(GL_TEXTURE_2D, source_texture);
+  glBindImageTexture(0, intermediate_.texture, 0, GL_FALSE, 0, GL_WRITE_ONLY,
+                     kFormat);
+  glDispatchCompute((width_ + kWorkGroupSize - 1) / kWorkGroupSize, height_,
+                    1);
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+  // Columns: a group per stretch of a column
+  glUniform2i(glGetUniformLocation(shader.id(), "direction"), 0, 1);
+  glBindTexture(GL_TEXTURE_2D, intermediate_.texture);
+  glBindImageTexture(0, result_.texture, 0, GL_FALSE, 0, GL_WRITE_ONLY,
+                     kFormat);
+  glDispatchCompute((height_ + kWorkGroupSize - 1) / kWorkGroupSize, width_,
+                    1);
+  // The result is sampled or blitted next
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GaussianBlur::BlurFragment(Shader& shader, unsigned int source_texture) {
+  shader.Use();
+  shader.SetInt("source", 0);
+  shader.SetInt("tapCount", static_cast<int>(taps_.offsets.size()));
+  SetFloats(shader, "tapOffsets", taps_.offsets);
+  SetFloats(shader, "tapWeights", taps_.weights);
+  glActiveTexture(GL_TEXTURE0);
+  glDisable(GL_DEPTH_TEST);
+  glViewport(0, 0, width_, height_);
+  glBindVertexArray(vao_);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, intermediate_.framebuffer);
+  shader.SetVec2("direction", glm::vec2(1.0f / width_, 0.0f));
+  glBindTexture(GL_TEXTURE_2D, source_texture);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, result_.framebuffer);
+  shader.SetVec2("direction", glm::vec2(0.0f, 1.0f / height_));
+  glBindTexture(GL_TEXTURE_2D, intermediate_.texture);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glBindVertexArray(0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glEnable(GL_DEPTH_TEST);
+}
+
+unsigned int GaussianBlur::Result() const {
+  return result_.texture;
+}
+
+unsigned int GaussianBlur::ResultFramebuffer() const {
+  return result_.framebuffer;
+}
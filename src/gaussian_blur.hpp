@@ -0,0 +1,94 @@
+#ifndef LEARNGL_GAUSSIAN_BLUR_HPP_
+#define LEARNGL_GAUSSIAN_BLUR_HPP_
+
+#include <vector>
+
+#include "shader_m.hpp"
+
+// Largest radius the shaders have room for. Matches MAX_RADIUS in
+// shaders/19_7_gaussian_blur.cs.
+constexpr int kMaxBlurRadius = 64;
+// Taps of the fragment path at kMaxBlurRadius. Matches MAX_TAPS in
+// shaders/19_7_gaussian_blur.fs.
+constexpr int kMaxBlurTaps = (kMaxBlurRadius + 1) / 2 + 1;
+
+// Weights of a normalized Gaussian of `radius`, for the texels 0 to
+// `radius` away from the center. The standard deviation is a third of the
+// radius, so the kernel ends where the curve has all but vanished.
+std::vector<float> GaussianWeights(int radius);
+
+// Texel weights folded into bilinear fetches: the center texel on its own,
+// then every pair of neighbors (1, 2), (3, 4) and so on as one fetch
+// between the two, placed so the hardware filter weights them as the
+// kernel does. Radius r takes (r + 1) / 2 + 1 taps rather than r + 1.
+struct BilinearTaps {
+  // Distance from the center, in texels
+  std::vector<float> offsets;
+  std::vector<float> weights;
+};
+BilinearTaps MergeBilinearTaps(const std::vector<float>& weights);
+
+enum class BlurMethod {
+  // Two compute passes that share every fetched texel across a work group
+  COMPUTE,
+  // Two fullscreen passes of bilinear taps, for when compute shaders are
+  // out of reach
+  FRAGMENT,
+};
+
+// A separable Gaussian blur of any radius up to kMaxBlurRadius. A
+// two-dimensional Gaussian is the product of two one-dimensional ones, so
+// blurring the rows and then the columns costs 2 (2r + 1) weighted texels
+// per pixel, growing with the radius rather than its square.
+//
+// The compute shader (see shaders/19_7_gaussian_blur.cs) gives every work
+// group a stretch of one row or column. The group fetches its stretch and
+// the radius on either side into shared memory once, and each invocation
+// weights its neighbors from there. The fragment shader (see
+// shaders/19_7_gaussian_blur.fs, with shaders/19_7_gaussian_blur.vs) halves
+// the fetches with bilinear filtering instead.
+//
+// Both read the source from texture unit 0. The result is GL_RGBA16F, as
+// the compute shader writes it through an image.
+class GaussianBlur {
+ public:
+  // Blur images of `width` x `height`.
+  GaussianBlur(int width, int height);
+
+  GaussianBlur(const GaussianBlur&) = delete;
+  GaussianBlur& operator=(const GaussianBlur&) = delete;
+
+  // Clamped to [0, kMaxBlurRadius]; 0 copies the source.
+  void SetRadius(int radius);
+  int Radius() const;
+
+  // Blur `source_texture` into Result() with `shader`, the compute or the
+  // fragment shader as `method` says. The fragment path needs the source to
+  // filter linearly and clamp to its edges.
+  void Blur(Shader& shader, BlurMethod method, unsigned int source_texture);
+
+  unsigned int Result() const;
+  // With Result() attached, e.g. to blit from
+  unsigned int ResultFramebuffer() const;
+
+ private:
+  struct Target {
+    unsigned int texture = 0;
+    unsigned int framebuffer = 0;
+  };
+
+  int width_;
+  int height_;
+  int radius_ = 0;
+  std::vector<float> weights_;
+  BilinearTaps taps_;
+  // The rows blurred, then both
+  Target intermediate_;
+  Target result_;
+  unsigned int vao_ = 0;
+
+  void BlurCompute(Shader& shader, unsigned int source_texture);
+  void BlurFragment(Shader& shader, unsigned int source_texture);
+};
+
+#endif
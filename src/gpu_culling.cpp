@@ -0,0 +1,208 @@
+#include "gpu_culling.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <string>
+
+#include "frustum_culling.hpp"
+#include "gpu_resources.hpp"
+#include "render_stats.hpp"
+
+namespace {
+
+// Matches the local size of the culling shader
+constexpr unsigned int kWorkGroupSize = 64;
+// Texture unit of the Hi-Z pyramid while culling
+constexpr int kHiZUnit = 0;
+
+// Layout of a glDrawElementsIndirect command
+struct DrawElementsIndirectCommand {
+  unsigned int count;
+  unsigned int instance_count;
+  unsigned int first_index;
+  int base_vertex;
+  unsigned int base_instance;
+};
+
+}  // namespace
+
+GpuInstanceCuller::GpuInstanceCuller(const Model& model,
+                                     const std::vector<glm::mat4>& instances)
+    : model_(model),
+      instance_count_(static_cast<unsigned int>(instances.size())),
+      command_count_(static_cast<unsigned int>(model.Meshes().size())) {
+  const std::size_t bytes = instances.size() * sizeof(glm::mat4);
+  const std::size_t command_bytes =
+      2 * command_count_ * sizeof(DrawElementsIndirectCommand);
+  glGenBuffers(1, &instance_buffer_);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, instance_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, instances.data(),
+               GL_STATIC_DRAW);
+
+  // Written by the compute shader only, room for both phases
+  glGenBuffers(1, &visible_buffer_);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, visible_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * bytes, nullptr, GL_DYNAMIC_COPY);
+
+  glGenBuffers(1, &command_buffer_);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, command_bytes, nullptr,
+               GL_DYNAMIC_COPY);
+
+  // Every mesh draws all of its indices; the shader fills in the instance
+  // counts. The retest phase's instances start after the main phase's.
+  std::vector<DrawElementsIndirectCommand> commands;
+  for (unsigned int phase = 0; phase < 2; phase++) {
+    for (const auto& mesh : model.Meshes()) {
+      commands.push_back({static_cast<unsigned int>(mesh.indices.size()), 0,
+                          0, 0, phase * instance_count_});
+    }
+  }
+  glGenBuffers(1, &initial_command_buffer_);
+  glBindBuffer(GL_COPY_READ_BUFFER, initial_command_buffer_);
+  glBufferData(GL_COPY_READ_BUFFER, command_bytes, commands.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+  // Nothing starts out occluded
+  const std::vector<unsigned int> flags(instances.size(), 0);
+  glGenBuffers(1, &occlusion_buffer_);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, occlusion_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, flags.size() * sizeof(unsigned int),
+               flags.data(), GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  GpuResources().Track(GpuResourceKind::BUFFER, instance_buffer_,
+                       {GpuResourceCategory::BUFFER, bytes, GL_NONE,
+                        "Culling instances"});
+  GpuResources().Track(GpuResourceKind::BUFFER, visible_buffer_,
+                       {GpuResourceCategory::BUFFER, 2 * bytes, GL_NONE,
+                        "Culling visible instances"});
+  GpuResources().Track(GpuResourceKind::BUFFER, command_buffer_,
+                       {GpuResourceCategory::BUFFER, command_bytes, GL_NONE,
+                        "Culling draw commands"});
+  GpuResources().Track(GpuResourceKind::BUFFER, initial_command_buffer_,
+                       {GpuResourceCategory::BUFFER, command_bytes, GL_NONE,
+                        "Culling initial draw commands"});
+  GpuResources().Track(GpuResourceKind::BUFFER, occlusion_buffer_,
+                       {GpuResourceCategory::BUFFER,
+                        flags.size() * sizeof(unsigned int), GL_NONE,
+                        "Culling occlusion flags"});
+
+  for (const auto& mesh : model.Meshes()) {
+    glBindVertexArray(mesh.vao());
+    glBindBuffer(GL_ARRAY_BUFFER, visible_buffer_);
+    // A mat4 attribute takes four vec4 locations, 3 to 6
+    for (int column = 0; column < 4; column++) {
+      glEnableVertexAttribArray(3 + column);
+      glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE,
+                            sizeof(glm::mat4),
+                            (void*)(column * sizeof(glm::vec4)));
+      glVertexAttribDivisor(3 + column, 1);
+    }
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GpuInstanceCuller::Cull(Shader& culling_shader,
+                             const glm::mat4& view_projection,
+                             const HiZPyramid* occluders) {
+  // Zero the instance counts by copying the commands over on the GPU
+  glBindBuffer(GL_COPY_READ_BUFFER, initial_command_buffer_);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, command_buffer_);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                      2 * command_count_ *
+                          sizeof(DrawElementsIndirectCommand));
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  view_projection_ = view_projection;
+  Dispatch(culling_shader, CullPhase::MAIN,
+           occluders != nullptr && occluders->Valid() ? occluders : nullptr);
+}
+
+void GpuInstanceCuller::CullRejected(Shader& culling_shader,
+                                     const HiZPyramid& occluders) {
+  Dispatch(culling_shader, CullPhase::RETEST, &occluders);
+}
+
+void GpuInstanceCuller::Dispatch(Shader& culling_shader, CullPhase phase,
+                                 const HiZPyramid* occluders) {
+  const Frustum frustum = ExtractFrustum(view_projection_);
+  culling_shader.Use();
+  for (int i = 0; i < 6; i++) {
+    culling_shader.SetVec4("frustumPlanes[" + std::to_string(i) + "]",
+                           frustum.planes[i]);
+  }
+  culling_shader.SetVec4("boundingSphere", model_.BoundingSphere());
+  glUniform1ui(glGetUniformLocation(culling_shader.id(), "instanceCount"),
+               instance_count_);
+  glUniform1ui(glGetUniformLocation(culling_shader.id(), "commandCount"),
+               command_count_);
+  culling_shader.SetInt("phase", phase == CullPhase::RETEST ? 1 : 0);
+  culling_shader.SetBool("occlusionCulling", occluders != nullptr);
+  if (occluders != nullptr) {
+    occluders->Bind(culling_shader, kHiZUnit);
+  }
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instance_buffer_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visible_buffer_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, command_buffer_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, occlusion_buffer_);
+  glDispatchCompute((instance_count_ + kWorkGroupSize - 1) / kWorkGroupSize,
+                    1, 1);
+
+  // The draws read the commands and the visible matrices as attributes; the
+  // retest phase reads the occlusion flags, and the next Cull() copies over
+  // the commands
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT |
+                  GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+                  GL_SHADER_STORAGE_BARRIER_BIT |
+                  GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void GpuInstanceCuller::Draw(Shader& shader, CullPhase phase) const {
+  shader.Use();
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+  const auto& meshes = model_.Meshes();
+  const std::size_t first_command =
+      phase == CullPhase::RETEST ? command_count_ : 0;
+  for (std::size_t i = 0; i < meshes.size(); i++) {
+    if (!meshes[i].textures.empty()) {
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, TextureId(meshes[i].textures[0]));
+      FrameStats().texture_binds++;
+    }
+    glBindVertexArray(meshes[i].vao());
+    glDrawElementsIndirect(
+        GL_TRIANGLES, GL_UNSIGNED_INT,
+        (void*)((first_command + i) * sizeof(DrawElementsIndirectCommand)));
+    FrameStats().draw_calls++;
+  }
+
+  // Always good practice to set everything back to defaults once configured
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+unsigned int GpuInstanceCuller::ReadVisibleCount(CullPhase phase) const {
+  if (command_count_ == 0) {
+    return 0;
+  }
+  const std::size_t command = phase == CullPhase::RETEST ? command_count_ : 0;
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  unsigned int count = 0;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer_);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER,
+                     command * sizeof(DrawElementsIndirectCommand) +
+                         offsetof(DrawElementsIndirectCommand, instance_count),
+                     sizeof(count), &count);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  return count;
+}
+
+unsigned int GpuInstanceCuller::InstanceCount() const {
+  return instance_count_;
+}
@@ -0,0 +1,78 @@
+#ifndef LEARNGL_GPU_CULLING_HPP_
+#define LEARNGL_GPU_CULLING_HPP_
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "hi_z.hpp"
+#include "model.hpp"
+#include "shader_m.hpp"
+
+// With occlusion culling, the main phase tests against the previous frame's
+// depth. The retest phase runs after the main phase's instances are drawn
+// and re-tests what the main phase found occluded against the current
+// frame's depth, so objects coming into view do not pop in a frame late.
+enum class CullPhase { MAIN, RETEST };
+
+// Culls the instances of a model on the GPU. A compute shader tests every
+// instance's bounding sphere against the frustum and appends the survivors
+// to a visible instance buffer. It also counts them into one
+// glDrawElementsIndirect command per mesh, so the CPU does no per-instance
+// work and never reads the count back to draw.
+//
+// The compute shader (see shaders/23_6_instance_culling.cs) reads the
+// instances from shader storage binding 0. It writes the visible ones to
+// binding 1, the draw commands to binding 2 and per-instance occlusion
+// flags to binding 3. The vertex shader reads the visible model matrices as
+// a mat4 attribute at locations 3 to 6. The retest phase's instances follow
+// the main phase's in the same buffer, reached through the commands'
+// baseInstance.
+class GpuInstanceCuller {
+ public:
+  // Upload `instances` once and set up the instanced attribute in the VAO of
+  // every mesh of `model`. The model must outlive the culler.
+  GpuInstanceCuller(const Model& model,
+                    const std::vector<glm::mat4>& instances);
+
+  GpuInstanceCuller(const GpuInstanceCuller&) = delete;
+  GpuInstanceCuller& operator=(const GpuInstanceCuller&) = delete;
+
+  // Reset the draw commands of both phases and run the main phase for the
+  // frustum of `view_projection`. With valid `occluders`, instances hidden
+  // behind their depth are culled as well.
+  void Cull(Shader& culling_shader, const glm::mat4& view_projection,
+            const HiZPyramid* occluders = nullptr);
+
+  // Re-test the instances the last Cull() found occluded against
+  // `occluders`, built from the current frame's depth.
+  void CullRejected(Shader& culling_shader, const HiZPyramid& occluders);
+
+  // Draw every mesh with the instances that survived `phase`, with the
+  // mesh's first texture on unit 0.
+  void Draw(Shader& shader, CullPhase phase = CullPhase::MAIN) const;
+
+  // The number of instances that survived `phase`. Reading it back waits
+  // for the GPU, so only call it for statistics.
+  unsigned int ReadVisibleCount(CullPhase phase = CullPhase::MAIN) const;
+
+  unsigned int InstanceCount() const;
+
+ private:
+  const Model& model_;
+  unsigned int instance_count_;
+  // Draw commands per phase, one per mesh
+  unsigned int command_count_;
+  glm::mat4 view_projection_ = glm::mat4(1.0f);
+  unsigned int instance_buffer_ = 0;
+  unsigned int visible_buffer_ = 0;
+  unsigned int command_buffer_ = 0;
+  // The commands with zero instances, copied over command_buffer_ by Cull()
+  unsigned int initial_command_buffer_ = 0;
+  unsigned int occlusion_buffer_ = 0;
+
+  void Dispatch(Shader& culling_shader, CullPhase phase,
+                const HiZPyramid* occluders);
+};
+
+#endif
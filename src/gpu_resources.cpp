@@ -0,0 +1,257 @@
+#include "gpu_resources.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+namespace {
+
+int CategoryIndex(GpuResourceCategory category) {
+  return static_cast<int>(category);
+}
+
+const char* KindName(GpuResourceKind kind) {
+  switch (kind) {
+    case GpuResourceKind::BUFFER:
+      return "buffer";
+    case GpuResourceKind::TEXTURE:
+      return "texture";
+    case GpuResourceKind::RENDERBUFFER:
+      return "renderbuffer";
+  }
+  return "";
+}
+
+// Depth formats are counted at the 32 bits per texel drivers store them in.
+std::size_t BytesPerTexel(GLenum internal_format) {
+  switch (internal_format) {
+    case GL_R8:
+    case GL_R8UI:
+    case GL_RED:
+      return 1;
+    case GL_RG8:
+    case GL_RG8UI:
+    case GL_RG:
+    case GL_R16F:
+    case GL_R16UI:
+    case GL_DEPTH_COMPONENT16:
+      return 2;
+    case GL_RGB8:
+    case GL_SRGB8:
+    case GL_RGB:
+    case GL_SRGB:
+      return 3;
+    case GL_RGB16F:
+      return 6;
+    case GL_RGBA16F:
+    case GL_RGBA16:
+    case GL_RGBA16UI:
+    case GL_RG32F:
+    case GL_RG32UI:
+    case GL_DEPTH32F_STENCIL8:
+      return 8;
+    case GL_RGB32F:
+      return 12;
+    case GL_RGBA32F:
+    case GL_RGBA32UI:
+      return 16;
+    default:
+      // GL_RGBA8, GL_RGBA8UI, GL_SRGB8_ALPHA8, GL_R32F, GL_R32UI,
+      // GL_RG16F, GL_RG16UI, GL_R11F_G11F_B10F, GL_DEPTH_COMPONENT(24|32F),
+      // GL_DEPTH24_STENCIL8, ...
+      return 4;
+  }
+}
+
+// Bytes per 4 x 4 block of the block-compressed formats, 0 for others
+std::size_t BytesPerBlock(GLenum internal_format) {
+  switch (internal_format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_SIGNED_RED_RGTC1:
+      return 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_SIGNED_RG_RGTC2:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+const char* FormatName(GLenum format) {
+  switch (format) {
+    case GL_NONE:
+      return "-";
+    case GL_R8:
+      return "GL_R8";
+    case GL_RED:
+      return "GL_RED";
+    case GL_RG8:
+      return "GL_RG8";
+    case GL_RGB:
+      return "GL_RGB";
+    case GL_RGB8:
+      return "GL_RGB8";
+    case GL_SRGB:
+      return "GL_SRGB";
+    case GL_SRGB8:
+      return "GL_SRGB8";
+    case GL_RGBA:
+      return "GL_RGBA";
+    case GL_RGBA8:
+      return "GL_RGBA8";
+    case GL_SRGB8_ALPHA8:
+      return "GL_SRGB8_ALPHA8";
+    case GL_RGB16F:
+      return "GL_RGB16F";
+    case GL_RGBA16F:
+      return "GL_RGBA16F";
+    case GL_DEPTH_COMPONENT:
+      return "GL_DEPTH_COMPONENT";
+    case GL_DEPTH_COMPONENT24:
+      return "GL_DEPTH_COMPONENT24";
+    case GL_DEPTH_COMPONENT32F:
+      return "GL_DEPTH_COMPONENT32F";
+    case GL_DEPTH24_STENCIL8:
+      return "GL_DEPTH24_STENCIL8";
+    default:
+      return "compressed/other";
+  }
+}
+
+double Mebibytes(std::size_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+}  // namespace
+
+void GpuResourceRegistry::Track(GpuResourceKind kind, unsigned int id,
+                                const GpuResource& info) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto key = std::make_pair(kind, id);
+  const auto existing = resources_.find(key);
+  if (existing != resources_.end()) {
+    category_bytes_[CategoryIndex(existing->second.category)] -=
+        existing->second.bytes;
+    total_bytes_ -= existing->second.bytes;
+  }
+  resources_[key] = info;
+  category_bytes_[CategoryIndex(info.category)] += info.bytes;
+  total_bytes_ += info.bytes;
+  high_water_bytes_ = std::max(high_water_bytes_, total_bytes_);
+}
+
+void GpuResourceRegistry::Release(GpuResourceKind kind, unsigned int id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto existing = resources_.find(std::make_pair(kind, id));
+  if (existing == resources_.end()) {
+    return;
+  }
+  category_bytes_[CategoryIndex(existing->second.category)] -=
+      existing->second.bytes;
+  total_bytes_ -= existing->second.bytes;
+  resources_.erase(existing);
+}
+
+std::size_t GpuResourceRegistry::TotalBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return total_bytes_;
+}
+
+std::size_t GpuResourceRegistry::CategoryBytes(
+    GpuResourceCategory category) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return category_bytes_[CategoryIndex(category)];
+}
+
+std::size_t GpuResourceRegistry::HighWaterBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return high_water_bytes_;
+}
+
+void GpuResourceRegistry::Dump(std::ostream& out) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto flags = out.flags();
+  out << std::fixed << std::setprecision(2);
+  out << "GPU memory: " << Mebibytes(total_bytes_) << " MiB in "
+      << resources_.size() << " resources (peak "
+      << Mebibytes(high_water_bytes_) << " MiB)\n";
+  for (int i = 0; i < kGpuResourceCategoryCount; i++) {
+    out << "  " << std::left << std::setw(24)
+        << GpuResourceCategoryName(static_cast<GpuResourceCategory>(i))
+        << std::right << std::setw(10) << Mebibytes(category_bytes_[i])
+        << " MiB\n";
+  }
+
+  std::vector<const std::pair<const std::pair<GpuResourceKind, unsigned int>,
+                              GpuResource>*>
+      sorted;
+  for (const auto& entry : resources_) {
+    sorted.push_back(&entry);
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) {
+    return a->second.bytes > b->second.bytes;
+  });
+  for (const auto* entry : sorted) {
+    const GpuResource& resource = entry->second;
+    out << "  " << std::setw(10) << Mebibytes(resource.bytes) << " MiB  "
+        << KindName(entry->first.first) << " " << entry->first.second << "  "
+        << FormatName(resource.format) << "  "
+        << GpuResourceCategoryName(resource.category) << "  "
+        << resource.owner << "\n";
+  }
+  out.flags(flags);
+}
+
+GpuResourceRegistry& GpuResources() {
+  static GpuResourceRegistry registry;
+  return registry;
+}
+
+std::size_t TextureBytes(GLenum internal_format, int width, int height,
+                         int levels, int layers) {
+  const std::size_t block_bytes = BytesPerBlock(internal_format);
+  const std::size_t texel_bytes = BytesPerTexel(internal_format);
+  std::size_t bytes = 0;
+  for (int level = 0; level < levels; level++) {
+    if (block_bytes > 0) {
+      bytes += static_cast<std::size_t>((width + 3) / 4) *
+               ((height + 3) / 4) * block_bytes;
+    } else {
+      bytes += static_cast<std::size_t>(width) * height * texel_bytes;
+    }
+    width = std::max(width / 2, 1);
+    height = std::max(height / 2, 1);
+  }
+  return bytes * layers;
+}
+
+std::size_t RenderbufferBytes(GLenum internal_format, int width, int height,
+                              int samples) {
+  return static_cast<std::size_t>(width) * height *
+         BytesPerTexel(internal_format) * std::max(samples, 1);
+}
+
+const char* GpuResourceCategoryName(GpuResourceCategory category) {
+  switch (category) {
+    case GpuResourceCategory::MESH_BUFFER:
+      return "Mesh buffers";
+    case GpuResourceCategory::MODEL_TEXTURE:
+      return "Model textures";
+    case GpuResourceCategory::TEXTURE:
+      return "Textures";
+    case GpuResourceCategory::FRAMEBUFFER_ATTACHMENT:
+      return "Framebuffer attachments";
+    case GpuResourceCategory::SHADOW_MAP:
+      return "Shadow maps";
+    case GpuResourceCategory::BUFFER:
+      return "Other buffers";
+  }
+  return "";
+}
@@ -0,0 +1,94 @@
+#ifndef LEARNGL_GPU_RESOURCES_HPP_
+#define LEARNGL_GPU_RESOURCES_HPP_
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+// S3TC is an extension rather than core OpenGL, so the loader may not define
+// its enums.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+enum class GpuResourceKind {
+  BUFFER,
+  TEXTURE,
+  RENDERBUFFER,
+};
+
+// What an allocation is used for. Totals are kept per category.
+enum class GpuResourceCategory {
+  MESH_BUFFER,
+  MODEL_TEXTURE,
+  TEXTURE,
+  FRAMEBUFFER_ATTACHMENT,
+  SHADOW_MAP,
+  BUFFER,
+};
+constexpr int kGpuResourceCategoryCount = 6;
+
+struct GpuResource {
+  GpuResourceCategory category;
+  std::size_t bytes;
+  // Internal format of textures and renderbuffers, GL_NONE for buffers
+  GLenum format;
+  std::string owner;
+};
+
+// Book-keeping of the GPU memory the samples allocate. Sizes are what the
+// allocation requires at its nominal format; drivers may pad or compress, so
+// treat the totals as an estimate for capacity planning.
+class GpuResourceRegistry {
+ public:
+  // Record an allocation under its GL name. Tracking a name again replaces
+  // the previous record, e.g. when storage is reallocated on resize.
+  void Track(GpuResourceKind kind, unsigned int id, const GpuResource& info);
+  void Release(GpuResourceKind kind, unsigned int id);
+
+  std::size_t TotalBytes() const;
+  std::size_t CategoryBytes(GpuResourceCategory category) const;
+  // Highest TotalBytes() seen so far
+  std::size_t HighWaterBytes() const;
+
+  // Per category totals followed by every live allocation, largest first.
+  void Dump(std::ostream& out) const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::map<std::pair<GpuResourceKind, unsigned int>, GpuResource> resources_;
+  std::size_t category_bytes_[kGpuResourceCategoryCount] = {};
+  std::size_t total_bytes_ = 0;
+  std::size_t high_water_bytes_ = 0;
+};
+
+// Process wide registry.
+GpuResourceRegistry& GpuResources();
+
+// Bytes of a texture with `levels` mips of `layers` layers each, halving
+// width and height per level. Handles uncompressed formats and the BCn
+// formats, whose levels round up to whole 4 x 4 blocks.
+std::size_t TextureBytes(GLenum internal_format, int width, int height,
+                         int levels = 1, int layers = 1);
+
+// Bytes of a renderbuffer or multisampled texture.
+std::size_t RenderbufferBytes(GLenum internal_format, int width, int height,
+                              int samples = 1);
+
+const char* GpuResourceCategoryName(GpuResourceCategory category);
+
+#endif
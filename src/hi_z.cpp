@@ -0,0 +1,89 @@
+#include "hi_z.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+#include "gpu_resources.hpp"
+
+namespace {
+
+// Matches the local size of the reduction shader
+constexpr int kWorkGroupSize = 8;
+
+int LevelCount(int width, int height) {
+  int levels = 1;
+  while (std::max(width, height) >> levels > 0) {
+    levels++;
+  }
+  return levels;
+}
+
+}  // namespace
+
+HiZPyramid::HiZPyramid(int width, int height)
+    : width_(width), height_(height), levels_(LevelCount(width, height)) {
+  glGenTextures(1, &texture_);
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  glTexStorage2D(GL_TEXTURE_2D, levels_, GL_R32F, width_, height_);
+  // Lookups pick one exact level; filtering would mix depths
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  GpuResources().Track(
+      GpuResourceKind::TEXTURE, texture_,
+      {GpuResourceCategory::TEXTURE,
+       TextureBytes(GL_R32F, width_, height_, levels_), GL_R32F,
+       "Hi-Z pyramid"});
+}
+
+void HiZPyramid::Build(Shader& reduce_shader, unsigned int depth_texture,
+                       const glm::mat4& view_projection) {
+  reduce_shader.Use();
+  reduce_shader.SetInt("depthTexture", 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, depth_texture);
+
+  // The depth attachment was just rendered to
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  for (int level = 0; level < levels_; level++) {
+    const int source_width = std::max(width_ >> std::max(level - 1, 0), 1);
+    const int source_height = std::max(height_ >> std::max(level - 1, 0), 1);
+    const int width = std::max(width_ >> level, 1);
+    const int height = std::max(height_ >> level, 1);
+    reduce_shader.SetBool("fromDepth", level == 0);
+    reduce_shader.SetVec2("sourceSize",
+                          glm::vec2(source_width, source_height));
+    if (level > 0) {
+      glBindImageTexture(0, texture_, level - 1, GL_FALSE, 0, GL_READ_ONLY,
+                         GL_R32F);
+    }
+    glBindImageTexture(1, texture_, level, GL_FALSE, 0, GL_WRITE_ONLY,
+                       GL_R32F);
+    glDispatchCompute((width + kWorkGroupSize - 1) / kWorkGroupSize,
+                      (height + kWorkGroupSize - 1) / kWorkGroupSize, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  view_projection_ = view_projection;
+  valid_ = true;
+}
+
+void HiZPyramid::Bind(Shader& shader, int unit) const {
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  glActiveTexture(GL_TEXTURE0);
+  shader.SetInt("hiZ", unit);
+  shader.SetVec2("hiZSize", glm::vec2(width_, height_));
+  shader.SetInt("hiZLevels", levels_);
+  shader.SetMat4("hiZViewProjection", view_projection_);
+}
+
+bool HiZPyramid::Valid() const {
+  return valid_;
+}
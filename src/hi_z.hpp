@@ -0,0 +1,52 @@
+#ifndef LEARNGL_HI_Z_HPP_
+#define LEARNGL_HI_Z_HPP_
+
+#include <glm/glm.hpp>
+
+#include "shader_m.hpp"
+
+// A hierarchical depth buffer: a GL_R32F mip chain where every texel holds
+// the farthest depth of the texels it covers one level down. An object
+// whose nearest depth lies behind the farthest depth under its screen
+// rectangle is hidden. With the level picked so the rectangle spans about
+// 2 x 2 texels, a few fetches decide that.
+//
+// Every level is the one below halved, rounding down, with an odd last row
+// or column folded into the last texel. Lookups must therefore find their
+// texels per level, as `min(pixel >> level, textureSize(hiZ, level) - 1)`;
+// the same normalized coordinates land on different footprints once a
+// level is odd-sized.
+//
+// The reduction shader (see shaders/23_7_hi_z_reduce.cs) reads the depth
+// texture from unit 0 or the previous level from image unit 0, and writes
+// the next level to image unit 1.
+class HiZPyramid {
+ public:
+  // Level 0 has the size of the depth buffer it is built from.
+  HiZPyramid(int width, int height);
+
+  HiZPyramid(const HiZPyramid&) = delete;
+  HiZPyramid& operator=(const HiZPyramid&) = delete;
+
+  // Reduce `depth_texture`, rendered with `view_projection`, into the
+  // pyramid.
+  void Build(Shader& reduce_shader, unsigned int depth_texture,
+             const glm::mat4& view_projection);
+
+  // Bind the pyramid to texture `unit` and set `hiZ`, `hiZSize`,
+  // `hiZLevels` and `hiZViewProjection` on `shader`, which must be in use.
+  void Bind(Shader& shader, int unit) const;
+
+  // Whether Build() has run, i.e. whether the pyramid holds any depth
+  bool Valid() const;
+
+ private:
+  unsigned int texture_ = 0;
+  int width_;
+  int height_;
+  int levels_;
+  glm::mat4 view_projection_ = glm::mat4(1.0f);
+  bool valid_ = false;
+};
+
+#endif
@@ -0,0 +1,218 @@
+#include "impostor.hpp"
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+#include "gpu_resources.hpp"
+#include "render_stats.hpp"
+
+namespace {
+
+// Mips stop where a frame is this many texels wide; below that neighboring
+// frames would bleed into each other
+constexpr int kSmallestFrameSize = 8;
+
+float SignNotZero(float value) {
+  return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+// The unit vector that `uv` in [0, 1]^2 maps to, +y at the center and -y
+// folded out to the corners. Matches OctahedronDecode() in the impostor
+// shader.
+glm::vec3 OctahedronDecode(const glm::vec2& uv) {
+  const glm::vec2 p = uv * 2.0f - 1.0f;
+  glm::vec3 n(p.x, 1.0f - std::abs(p.x) - std::abs(p.y), p.y);
+  if (n.y < 0.0f) {
+    const float x = n.x;
+    n.x = (1.0f - std::abs(n.z)) * SignNotZero(x);
+    n.z = (1.0f - std::abs(x)) * SignNotZero(n.z);
+  }
+  return glm::normalize(n);
+}
+
+// Up vector of the frame camera looking along -direction. Matches the
+// impostor shader.
+glm::vec3 FrameUpHint(const glm::vec3& direction) {
+  return std::abs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f)
+                                        : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+int MipLevels(int frame_size) {
+  int levels = 1;
+  while (frame_size >> levels >= kSmallestFrameSize) {
+    levels++;
+  }
+  return levels;
+}
+
+unsigned int CreateAtlasTexture(int size, int levels, const char* owner) {
+  unsigned int texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, size, size);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  GpuResources().Track(
+      GpuResourceKind::TEXTURE, texture,
+      {GpuResourceCategory::TEXTURE,
+       TextureBytes(GL_RGBA8, size, size, levels), GL_RGBA8, owner});
+  return texture;
+}
+
+}  // namespace
+
+ImpostorAtlas::ImpostorAtlas(Model& model, Shader& bake_shader,
+                             const ImpostorOptions& options)
+    : options_(options), bounding_sphere_(model.BoundingSphere()) {
+  const int frames = options_.frames_per_side;
+  const int size = frames * options_.frame_size;
+  const int levels = MipLevels(options_.frame_size);
+  albedo_ = CreateAtlasTexture(size, levels, "Impostor albedo");
+  normal_depth_ = CreateAtlasTexture(size, levels, "Impostor normal/depth");
+
+  // Render target for the bake, thrown away afterwards
+  int previous_framebuffer;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_framebuffer);
+  int previous_viewport[4];
+  glGetIntegerv(GL_VIEWPORT, previous_viewport);
+
+  unsigned int framebuffer;
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         albedo_, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D,
+                         normal_depth_, 0);
+  unsigned int depth;
+  glGenRenderbuffers(1, &depth);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depth);
+  const GLenum attachments[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  glDrawBuffers(2, attachments);
+  const GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+  glEnable(GL_DEPTH_TEST);
+
+  // Uncovered texels: transparent, and a flat normal at the back of the
+  // sphere
+  const float clear_albedo[] = {0.0f, 0.0f, 0.0f, 0.0f};
+  const float clear_normal_depth[] = {0.5f, 0.5f, 0.5f, 1.0f};
+  glClearBufferfv(GL_COLOR, 0, clear_albedo);
+  glClearBufferfv(GL_COLOR, 1, clear_normal_depth);
+  glClear(GL_DEPTH_BUFFER_BIT);
+
+  // Orthographic views that fit the bounding sphere exactly, with the near
+  // and far planes touching its front and back
+  const glm::vec3 center = glm::vec3(bounding_sphere_);
+  const float radius = bounding_sphere_.w;
+  const glm::mat4 projection =
+      glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius);
+  bake_shader.Use();
+  bake_shader.SetMat4("projection", projection);
+  for (int j = 0; j < frames; j++) {
+    for (int i = 0; i < frames; i++) {
+      const glm::vec3 direction = OctahedronDecode(
+          (glm::vec2(i, j) + 0.5f) / static_cast<float>(frames));
+      const glm::mat4 view =
+          glm::lookAt(center + direction * 2.0f * radius, center,
+                      FrameUpHint(direction));
+      glViewport(i * options_.frame_size, j * options_.frame_size,
+                 options_.frame_size, options_.frame_size);
+      bake_shader.SetMat4("view", view);
+      model.Draw(bake_shader);
+    }
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, previous_framebuffer);
+  glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2],
+             previous_viewport[3]);
+  if (!depth_test) {
+    glDisable(GL_DEPTH_TEST);
+  }
+  glDeleteRenderbuffers(1, &depth);
+  glDeleteFramebuffers(1, &framebuffer);
+
+  for (const unsigned int texture : {albedo_, normal_depth_}) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // One quad, as a triangle strip of corners in [-1, 1]^2
+  const float corners[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                           -1.0f, 1.0f,  1.0f, 1.0f};
+  glGenVertexArrays(1, &quad_vao_);
+  glGenBuffers(1, &quad_vbo_);
+  glBindVertexArray(quad_vao_);
+  glBindBuffer(GL_ARRAY_BUFFER, quad_vbo_);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float),
+                        (void*)0);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  GpuResources().Track(GpuResourceKind::BUFFER, quad_vbo_,
+                       {GpuResourceCategory::MESH_BUFFER, sizeof(corners),
+                        GL_NONE, "Impostor quad"});
+}
+
+void ImpostorAtlas::SetInstanceBuffer(unsigned int buffer) {
+  glBindVertexArray(quad_vao_);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  SetInstanceTransformAttributes(3);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ImpostorAtlas::Draw(Shader& shader, std::size_t first,
+                         std::size_t count, int unit) const {
+  if (count == 0) {
+    return;
+  }
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_2D, albedo_);
+  glActiveTexture(GL_TEXTURE0 + unit + 1);
+  glBindTexture(GL_TEXTURE_2D, normal_depth_);
+  glActiveTexture(GL_TEXTURE0);
+  FrameStats().texture_binds += 2;
+  shader.SetInt("impostorAlbedo", unit);
+  shader.SetInt("impostorNormalDepth", unit + 1);
+  shader.SetVec4("boundingSphere", bounding_sphere_);
+  shader.SetInt("framesPerSide", options_.frames_per_side);
+
+  glBindVertexArray(quad_vao_);
+  glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, count, first);
+  FrameStats().draw_calls++;
+  glBindVertexArray(0);
+}
+
+glm::vec4 ImpostorAtlas::BoundingSphere() const {
+  return bounding_sphere_;
+}
+
+ImpostorSplit SplitByDistance(const InstanceTransform* instances,
+                              std::size_t count, const glm::vec3& camera,
+                              float distance, float fade_band,
+                              InstanceTransform* meshes,
+                              InstanceTransform* impostors) {
+  const float impostor_distance2 = distance * distance;
+  const float mesh_distance2 = (distance + fade_band) * (distance + fade_band);
+  ImpostorSplit split;
+  for (std::size_t i = 0; i < count; i++) {
+    const glm::vec3 offset = instances[i].position - camera;
+    const float distance2 = glm::dot(offset, offset);
+    if (distance2 < mesh_distance2) {
+      meshes[split.mesh_count++] = instances[i];
+    }
+    if (distance2 >= impostor_distance2) {
+      impostors[split.impostor_count++] = instances[i];
+    }
+  }
+  return split;
+}
@@ -0,0 +1,85 @@
+#ifndef LEARNGL_IMPOSTOR_HPP_
+#define LEARNGL_IMPOSTOR_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+#include "instance_transform.hpp"
+#include "model.hpp"
+#include "shader_m.hpp"
+
+struct ImpostorOptions {
+  // The atlas holds frames_per_side^2 views, frame_size^2 texels each
+  int frames_per_side = 8;
+  int frame_size = 128;
+};
+
+// Pictures of a model from many directions, drawn instead of the model when
+// it only covers a few pixels. The view directions come from an octahedral
+// map: frame (i, j) of the atlas shows the model seen from the direction
+// that (i + 0.5, j + 0.5) / frames_per_side decodes to, so directions are
+// spread evenly over the whole sphere and the frame closest to any view is
+// found with a few arithmetic operations.
+//
+// Each frame is an orthographic view of the model's bounding sphere. The
+// albedo texture holds the color with coverage in alpha; the normal texture
+// holds the model space normal, and in alpha the depth across the sphere
+// from the front (0) to the back (1).
+//
+// The impostor shader (see shaders/23_12_impostor.vs) draws one quad per
+// instance, in the plane of the frame closest to the camera, and rebuilds
+// lighting and depth per pixel from the atlas.
+class ImpostorAtlas {
+ public:
+  // Render `model` into the atlas with `bake_shader` (see
+  // shaders/23_12_impostor_bake.vs). The current framebuffer, viewport and
+  // depth test state are restored afterwards.
+  ImpostorAtlas(Model& model, Shader& bake_shader,
+                const ImpostorOptions& options = {});
+
+  ImpostorAtlas(const ImpostorAtlas&) = delete;
+  ImpostorAtlas& operator=(const ImpostorAtlas&) = delete;
+
+  // Read the instances' InstanceTransforms from `buffer` at attributes 3
+  // and 4.
+  void SetInstanceBuffer(unsigned int buffer);
+
+  // Draw instances [first, first + count) of the instance buffer as
+  // impostors. `shader` must be in use with its view, projection and
+  // camera uniforms set; this binds the atlas to texture `unit` and
+  // `unit` + 1 and sets `impostorAlbedo`, `impostorNormalDepth`,
+  // `boundingSphere` and `framesPerSide`.
+  void Draw(Shader& shader, std::size_t first, std::size_t count,
+            int unit = 0) const;
+
+  // Model space bounds the frames were framed around, as (center, radius)
+  glm::vec4 BoundingSphere() const;
+
+ private:
+  ImpostorOptions options_;
+  glm::vec4 bounding_sphere_;
+  unsigned int albedo_ = 0;
+  unsigned int normal_depth_ = 0;
+  unsigned int quad_vao_ = 0;
+  unsigned int quad_vbo_ = 0;
+};
+
+// The number of instances SplitByDistance() wrote to each output
+struct ImpostorSplit {
+  std::size_t mesh_count = 0;
+  std::size_t impostor_count = 0;
+};
+
+// Copy the instances closer to `camera` than `distance` + `fade_band` to
+// `meshes` and those at least `distance` away to `impostors`, in their
+// original order. Instances in the band go to both and are cross-faded by
+// the shaders. Each output needs room for `count` instances and is only
+// written, in order, so it may point into mapped memory.
+ImpostorSplit SplitByDistance(const InstanceTransform* instances,
+                              std::size_t count, const glm::vec3& camera,
+                              float distance, float fade_band,
+                              InstanceTransform* meshes,
+                              InstanceTransform* impostors);
+
+#endif
@@ -0,0 +1,40 @@
+#include "instance_transform.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+InstanceTransform PackInstanceTransform(const glm::vec3& position,
+                                        float scale,
+                                        const glm::quat& rotation) {
+  const glm::quat unit = glm::normalize(rotation);
+  return {position, scale, glm::vec4(unit.x, unit.y, unit.z, unit.w)};
+}
+
+InstanceTransform PackInstanceTransform(const glm::mat4& matrix) {
+  const float scale = glm::length(glm::vec3(matrix[0]));
+  const glm::mat3 rotation = glm::mat3(matrix) / scale;
+  return PackInstanceTransform(glm::vec3(matrix[3]), scale,
+                               glm::quat_cast(rotation));
+}
+
+glm::mat4 UnpackInstanceTransform(const InstanceTransform& instance) {
+  const glm::quat rotation(instance.rotation.w, instance.rotation.x,
+                           instance.rotation.y, instance.rotation.z);
+  glm::mat4 matrix = glm::mat4_cast(rotation) * instance.scale;
+  matrix[3] = glm::vec4(instance.position, 1.0f);
+  return matrix;
+}
+
+void SetInstanceTransformAttributes(unsigned int location) {
+  glEnableVertexAttribArray(location);
+  glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE,
+                        sizeof(InstanceTransform),
+                        (void*)offsetof(InstanceTransform, position));
+  glVertexAttribDivisor(location, 1);
+  glEnableVertexAttribArray(location + 1);
+  glVertexAttribPointer(location + 1, 4, GL_FLOAT, GL_FALSE,
+                        sizeof(InstanceTransform),
+                        (void*)offsetof(InstanceTransform, rotation));
+  glVertexAttribDivisor(location + 1, 1);
+}
@@ -0,0 +1,35 @@
+#ifndef LEARNGL_INSTANCE_TRANSFORM_HPP_
+#define LEARNGL_INSTANCE_TRANSFORM_HPP_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// A rigid transform with uniform scale, 32 bytes per instance against 64
+// for a mat4, and two vertex attributes instead of four. The vertex shader
+// applies it directly (see shaders/23_10_asteroids_compact_instances.vs).
+struct InstanceTransform {
+  glm::vec3 position;
+  float scale;
+  // Unit quaternion as (x, y, z, w)
+  glm::vec4 rotation;
+};
+
+static_assert(sizeof(InstanceTransform) == 32,
+              "InstanceTransform must match the vertex attribute layout");
+
+InstanceTransform PackInstanceTransform(const glm::vec3& position,
+                                        float scale,
+                                        const glm::quat& rotation);
+
+// Decompose a translation * rotation * uniform scale matrix. Any shear or
+// non-uniform scale is lost; the scale is taken from the first column.
+InstanceTransform PackInstanceTransform(const glm::mat4& matrix);
+
+glm::mat4 UnpackInstanceTransform(const InstanceTransform& instance);
+
+// Point attributes `location` (position and scale) and `location` + 1
+// (rotation) of the bound vertex array at the InstanceTransform array in
+// the bound GL_ARRAY_BUFFER, advancing once per instance.
+void SetInstanceTransformAttributes(unsigned int location);
+
+#endif
@@ -0,0 +1,404 @@
+#include "ktx2_texture.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+
+namespace {
+
+constexpr unsigned char kKtx2Identifier[12] = {0xAB, 'K',  'T',  'X',
+                                               ' ',  '2',  '0',  0xBB,
+                                               '\r', '\n', 0x1A, '\n'};
+// Identifier + nine 32-bit header fields + 32-bit and 64-bit index fields
+constexpr std::size_t kHeaderSize = 80;
+constexpr std::size_t kLevelIndexEntrySize = 24;
+
+// Khronos data format descriptor color models for the BCn formats.
+constexpr unsigned char kDfdModelBc1 = 128;
+constexpr unsigned char kDfdModelBc3 = 130;
+constexpr unsigned char kDfdModelBc5 = 132;
+constexpr unsigned char kDfdModelBc7 = 134;
+
+std::size_t BlockSizeForVkFormat(std::uint32_t vk_format) {
+  switch (vk_format) {
+    case kVkFormatBc1RgbUnorm:
+    case kVkFormatBc1RgbSrgb:
+      return 8;
+    case kVkFormatBc3Unorm:
+    case kVkFormatBc3Srgb:
+    case kVkFormatBc5Unorm:
+    case kVkFormatBc7Unorm:
+    case kVkFormatBc7Srgb:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+bool IsSrgbVkFormat(std::uint32_t vk_format) {
+  return vk_format == kVkFormatBc1RgbSrgb || vk_format == kVkFormatBc3Srgb ||
+         vk_format == kVkFormatBc7Srgb;
+}
+
+GLenum GlInternalFormat(std::uint32_t vk_format, bool srgb) {
+  switch (vk_format) {
+    case kVkFormatBc1RgbUnorm:
+    case kVkFormatBc1RgbSrgb:
+      return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+                  : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case kVkFormatBc3Unorm:
+    case kVkFormatBc3Srgb:
+      return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+                  : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case kVkFormatBc5Unorm:
+      // BC5 has no sRGB variant
+      return GL_COMPRESSED_RG_RGTC2;
+    case kVkFormatBc7Unorm:
+    case kVkFormatBc7Srgb:
+      return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+                  : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default:
+      return 0;
+  }
+}
+
+bool HasExtension(const std::string& name) {
+  // Read once; the samples only ever create one context
+  static const std::set<std::string> extensions = [] {
+    std::set<std::string> names;
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+      names.insert(reinterpret_cast<const char*>(
+          glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))));
+    }
+    return names;
+  }();
+  return extensions.count(name) > 0;
+}
+
+bool HasVersion(GLint major, GLint minor) {
+  GLint context_major = 0;
+  GLint context_minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &context_major);
+  glGetIntegerv(GL_MINOR_VERSION, &context_minor);
+  return context_major > major ||
+         (context_major == major && context_minor >= minor);
+}
+
+// Whether the context can sample `internal_format`. S3TC is an extension
+// on every version, and its sRGB variants need one more; BPTC is core from
+// 4.2 and RGTC from 3.0.
+bool SupportsFormat(GLenum internal_format) {
+  switch (internal_format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+      return HasExtension("GL_EXT_texture_compression_s3tc");
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+      return HasExtension("GL_EXT_texture_compression_s3tc") &&
+             (HasExtension("GL_EXT_texture_sRGB") ||
+              HasExtension("GL_EXT_texture_compression_s3tc_srgb"));
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+      return HasVersion(4, 2) ||
+             HasExtension("GL_ARB_texture_compression_bptc");
+    case GL_COMPRESSED_RG_RGTC2:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::size_t LevelFaceSize(std::uint32_t vk_format, std::uint32_t width,
+                          std::uint32_t height) {
+  const std::size_t blocks_x = (width + 3) / 4;
+  const std::size_t blocks_y = (height + 3) / 4;
+  return blocks_x * blocks_y * BlockSizeForVkFormat(vk_format);
+}
+
+std::uint32_t ReadU32(const unsigned char* data) {
+  std::uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+std::uint64_t ReadU64(const unsigned char* data) {
+  std::uint64_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+void AppendU8(std::vector<unsigned char>* out, unsigned char value) {
+  out->push_back(value);
+}
+
+void AppendU16(std::vector<unsigned char>* out, std::uint16_t value) {
+  const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+  out->insert(out->end(), bytes, bytes + sizeof(value));
+}
+
+void AppendU32(std::vector<unsigned char>* out, std::uint32_t value) {
+  const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+  out->insert(out->end(), bytes, bytes + sizeof(value));
+}
+
+void AppendU64(std::vector<unsigned char>* out, std::uint64_t value) {
+  const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+  out->insert(out->end(), bytes, bytes + sizeof(value));
+}
+
+// Build a basic data format descriptor block, which KTX2 requires even though
+// the loader only needs vkFormat.
+std::vector<unsigned char> BuildDfd(std::uint32_t vk_format) {
+  unsigned char model;
+  std::vector<std::pair<std::uint16_t, unsigned char>> samples;
+  switch (vk_format) {
+    case kVkFormatBc1RgbUnorm:
+    case kVkFormatBc1RgbSrgb:
+      model = kDfdModelBc1;
+      samples = {{0, 0}};
+      break;
+    case kVkFormatBc3Unorm:
+    case kVkFormatBc3Srgb:
+      model = kDfdModelBc3;
+      // Alpha (channel 15) in the first half, color in the second
+      samples = {{0, 15}, {64, 0}};
+      break;
+    case kVkFormatBc5Unorm:
+      model = kDfdModelBc5;
+      samples = {{0, 0}, {64, 1}};
+      break;
+    default:
+      model = kDfdModelBc7;
+      samples = {{0, 0}};
+      break;
+  }
+
+  const auto block_size = static_cast<unsigned char>(
+      BlockSizeForVkFormat(vk_format));
+  const auto descriptor_size =
+      static_cast<std::uint16_t>(24 + 16 * samples.size());
+
+  std::vector<unsigned char> dfd;
+  AppendU32(&dfd, 4 + descriptor_size);  // Total size
+  AppendU32(&dfd, 0);                    // Vendor id and descriptor type
+  AppendU16(&dfd, 2);                    // Version number
+  AppendU16(&dfd, descriptor_size);
+  AppendU8(&dfd, model);
+  AppendU8(&dfd, 1);  // BT.709 primaries
+  AppendU8(&dfd, IsSrgbVkFormat(vk_format) ? 2 : 1);
+  AppendU8(&dfd, 0);  // Straight alpha
+  // Texel block dimensions, stored minus one
+  AppendU8(&dfd, 3);
+  AppendU8(&dfd, 3);
+  AppendU8(&dfd, 0);
+  AppendU8(&dfd, 0);
+  // Bytes per plane
+  AppendU8(&dfd, block_size);
+  for (int i = 1; i < 8; i++) {
+    AppendU8(&dfd, 0);
+  }
+  for (const auto& sample : samples) {
+    AppendU16(&dfd, sample.first);
+    // Bit length minus one: each sample spans half of a 128-bit block, or
+    // the whole block for BC1 and BC7.
+    AppendU8(&dfd, static_cast<unsigned char>(
+                       8 * block_size / samples.size() - 1));
+    AppendU8(&dfd, sample.second);
+    AppendU32(&dfd, 0);           // Sample position
+    AppendU32(&dfd, 0);           // Lower
+    AppendU32(&dfd, 0xffffffff);  // Upper
+  }
+  return dfd;
+}
+
+}  // namespace
+
+bool ReadKtx2(const std::string& path, Ktx2Image* image) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::vector<unsigned char> contents((std::istreambuf_iterator<char>(file)),
+                                      std::istreambuf_iterator<char>());
+
+  if (contents.size() < kHeaderSize ||
+      std::memcmp(contents.data(), kKtx2Identifier,
+                  sizeof(kKtx2Identifier)) != 0) {
+    std::cerr << "Not a KTX2 file: " << path << "\n";
+    return false;
+  }
+
+  const unsigned char* header = contents.data() + sizeof(kKtx2Identifier);
+  image->vk_format = ReadU32(header + 0);
+  image->width = ReadU32(header + 8);
+  image->height = ReadU32(header + 12);
+  const auto layer_count = ReadU32(header + 20);
+  image->face_count = ReadU32(header + 24);
+  const auto level_count = std::max<std::uint32_t>(ReadU32(header + 28), 1);
+  const auto supercompression = ReadU32(header + 32);
+
+  if (BlockSizeForVkFormat(image->vk_format) == 0 || supercompression != 0 ||
+      layer_count > 1 || (image->face_count != 1 && image->face_count != 6) ||
+      contents.size() < kHeaderSize + level_count * kLevelIndexEntrySize) {
+    std::cerr << "Unsupported KTX2 file: " << path << "\n";
+    return false;
+  }
+
+  image->levels.resize(level_count);
+  for (std::uint32_t level = 0; level < level_count; level++) {
+    const unsigned char* entry =
+        contents.data() + kHeaderSize + level * kLevelIndexEntrySize;
+    const auto offset = ReadU64(entry);
+    const auto length = ReadU64(entry + 8);
+    const auto expected =
+        image->face_count *
+        LevelFaceSize(image->vk_format, std::max(image->width >> level, 1u),
+                      std::max(image->height >> level, 1u));
+    if (length != expected || offset + length > contents.size()) {
+      std::cerr << "Corrupt KTX2 level " << level << " in " << path << "\n";
+      return false;
+    }
+    image->levels[level].assign(contents.begin() + offset,
+                                contents.begin() + offset + length);
+  }
+  return true;
+}
+
+bool WriteKtx2(const std::string& path, const Ktx2Image& image) {
+  const std::size_t block_size = BlockSizeForVkFormat(image.vk_format);
+  if (block_size == 0 || image.levels.empty()) {
+    std::cerr << "Cannot write KTX2 with format " << image.vk_format << "\n";
+    return false;
+  }
+
+  const auto level_count = static_cast<std::uint32_t>(image.levels.size());
+  const std::vector<unsigned char> dfd = BuildDfd(image.vk_format);
+  const std::size_t dfd_offset =
+      kHeaderSize + level_count * kLevelIndexEntrySize;
+
+  // Mip levels are stored smallest first, each aligned to the block size.
+  std::vector<std::uint64_t> level_offsets(level_count);
+  std::size_t offset = dfd_offset + dfd.size();
+  for (std::uint32_t level = level_count; level-- > 0;) {
+    offset = (offset + block_size - 1) / block_size * block_size;
+    level_offsets[level] = offset;
+    offset += image.levels[level].size();
+  }
+
+  std::vector<unsigned char> out(kKtx2Identifier,
+                                 kKtx2Identifier + sizeof(kKtx2Identifier));
+  AppendU32(&out, image.vk_format);
+  AppendU32(&out, 1);  // Type size
+  AppendU32(&out, image.width);
+  AppendU32(&out, image.height);
+  AppendU32(&out, 0);  // Depth
+  AppendU32(&out, 0);  // Layer count
+  AppendU32(&out, image.face_count);
+  AppendU32(&out, level_count);
+  AppendU32(&out, 0);  // No supercompression
+  AppendU32(&out, static_cast<std::uint32_t>(dfd_offset));
+  AppendU32(&out, static_cast<std::uint32_t>(dfd.size()));
+  AppendU32(&out, 0);  // Key/value data offset
+  AppendU32(&out, 0);  // Key/value data length
+  AppendU64(&out, 0);  // Supercompression global data offset
+  AppendU64(&out, 0);  // Supercompression global data length
+
+  for (std::uint32_t level = 0; level < level_count; level++) {
+    AppendU64(&out, level_offsets[level]);
+    AppendU64(&out, image.levels[level].size());
+    AppendU64(&out, image.levels[level].size());
+  }
+  out.insert(out.end(), dfd.begin(), dfd.end());
+
+  for (std::uint32_t level = level_count; level-- > 0;) {
+    out.resize(level_offsets[level], 0);
+    out.insert(out.end(), image.levels[level].begin(),
+               image.levels[level].end());
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << "Failed to open " << path << " for writing\n";
+    return false;
+  }
+  file.write(reinterpret_cast<const char*>(out.data()), out.size());
+  return static_cast<bool>(file);
+}
+
+std::string Ktx2PathFor(const std::string& path) {
+  const auto slash = path.find_last_of('/');
+  const auto dot = path.find_last_of('.');
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) {
+    return path + ".ktx2";
+  }
+  return path.substr(0, dot) + ".ktx2";
+}
+
+unsigned int LoadKtx2Texture(const std::string& path, bool gamma_corrected,
+                             GpuResourceCategory category) {
+  Ktx2Image image;
+  if (!ReadKtx2(path, &image)) {
+    return 0;
+  }
+  // The caller decides how the texels decode, as with the PNG fallbacks; the
+  // sRGB and UNORM variants share the same blocks
+  const GLenum internal_format =
+      GlInternalFormat(image.vk_format, gamma_corrected);
+  if (!SupportsFormat(internal_format)) {
+    std::cerr << "Compressed format of " << path
+              << " unsupported by this context\n";
+    return 0;
+  }
+
+  const GLenum target =
+      image.face_count == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+  const auto level_count = static_cast<GLsizei>(image.levels.size());
+
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+  glBindTexture(target, texture_id);
+  glTexStorage2D(target, level_count, internal_format, image.width,
+                 image.height);
+
+  std::size_t total_size = 0;
+  for (GLsizei level = 0; level < level_count; level++) {
+    total_size += image.levels[level].size();
+    const auto width = std::max(image.width >> level, 1u);
+    const auto height = std::max(image.height >> level, 1u);
+    const std::size_t face_size =
+        image.levels[level].size() / image.face_count;
+    for (std::uint32_t face = 0; face < image.face_count; face++) {
+      const GLenum face_target =
+          target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face
+                                        : GL_TEXTURE_2D;
+      glCompressedTexSubImage2D(face_target, level, 0, 0, width, height,
+                                internal_format, face_size,
+                                image.levels[level].data() + face * face_size);
+    }
+  }
+
+  const GLenum min_filter =
+      level_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+  if (target == GL_TEXTURE_CUBE_MAP) {
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  } else {
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  }
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, min_filter);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  GpuResources().Track(GpuResourceKind::TEXTURE, texture_id,
+                       {category, total_size, internal_format, path});
+  return texture_id;
+}
@@ -0,0 +1,50 @@
+#ifndef LEARNGL_KTX2_TEXTURE_HPP_
+#define LEARNGL_KTX2_TEXTURE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gpu_resources.hpp"
+
+// Vulkan format identifiers used by KTX2 for the block-compressed formats we
+// read and write.
+constexpr std::uint32_t kVkFormatBc1RgbUnorm = 131;
+constexpr std::uint32_t kVkFormatBc1RgbSrgb = 132;
+constexpr std::uint32_t kVkFormatBc3Unorm = 137;
+constexpr std::uint32_t kVkFormatBc3Srgb = 138;
+constexpr std::uint32_t kVkFormatBc5Unorm = 141;
+constexpr std::uint32_t kVkFormatBc7Unorm = 145;
+constexpr std::uint32_t kVkFormatBc7Srgb = 146;
+
+// An in-memory KTX2 texture holding a complete, precomputed mip chain.
+struct Ktx2Image {
+  std::uint32_t vk_format = 0;
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  // 1 for 2D textures, 6 for cube maps (+X, -X, +Y, -Y, +Z, -Z).
+  std::uint32_t face_count = 1;
+  // levels[0] is the full resolution image. Each level stores every face
+  // back to back.
+  std::vector<std::vector<unsigned char>> levels;
+};
+
+bool ReadKtx2(const std::string& path, Ktx2Image* image);
+bool WriteKtx2(const std::string& path, const Ktx2Image& image);
+
+// Path of the offline compressed counterpart of a texture, e.g.
+// "assets/textures/wood.png" -> "assets/textures/wood.ktx2".
+std::string Ktx2PathFor(const std::string& path);
+
+// Upload a KTX2 file with immutable storage and glCompressedTexSubImage2D.
+// Returns 0 when the file is missing or its format is unknown or not
+// supported by the context (S3TC needs GL_EXT_texture_compression_s3tc,
+// BPTC OpenGL 4.2), so callers can fall back to decoding the source image.
+// `gamma_corrected` selects the sRGB variant of the block format, whichever
+// variant the file records. The storage is accounted under `category` in
+// GpuResources().
+unsigned int LoadKtx2Texture(
+    const std::string& path, bool gamma_corrected = false,
+    GpuResourceCategory category = GpuResourceCategory::TEXTURE);
+
+#endif
@@ -0,0 +1,369 @@
+#include "loose_octree.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "thread_pool.hpp"
+
+namespace {
+
+// A cell key holds the level in the top 4 bits and the x, y and z cell
+// coordinates at that level in 20 bits each; the root is key 0
+constexpr int kLevelShift = 60;
+constexpr int kCoordinateBits = 20;
+constexpr std::uint64_t kCoordinateMask = (1ull << kCoordinateBits) - 1;
+// The deepest level the 4 level bits can hold
+constexpr int kMaxDepth = 15;
+// Not a valid key: coordinates at level kMaxDepth or above use at most
+// kMaxDepth of their bits, never all 20
+constexpr std::uint64_t kNoCell = ~0ull;
+// Object::slot of a removed object
+constexpr std::uint32_t kFree = 0xffffffffu;
+// Objects per MoveMany() task
+constexpr std::size_t kMoveGrain = 4096;
+
+std::uint64_t MakeKey(int level, const glm::uvec3& coordinates) {
+  return static_cast<std::uint64_t>(level) << kLevelShift |
+         static_cast<std::uint64_t>(coordinates.x) << (2 * kCoordinateBits) |
+         static_cast<std::uint64_t>(coordinates.y) << kCoordinateBits |
+         coordinates.z;
+}
+
+int LevelOf(std::uint64_t key) {
+  return static_cast<int>(key >> kLevelShift);
+}
+
+glm::uvec3 CoordinatesOf(std::uint64_t key) {
+  return glm::uvec3(
+      static_cast<unsigned int>(key >> (2 * kCoordinateBits) &
+                                kCoordinateMask),
+      static_cast<unsigned int>(key >> kCoordinateBits & kCoordinateMask),
+      static_cast<unsigned int>(key & kCoordinateMask));
+}
+
+std::uint64_t ParentOf(std::uint64_t key) {
+  const glm::uvec3 c = CoordinatesOf(key);
+  return MakeKey(LevelOf(key) - 1, glm::uvec3(c.x >> 1, c.y >> 1, c.z >> 1));
+}
+
+// Which of its parent's eight children `key` is: bit 2 is x, 1 is y, 0 is z
+int ChildIndexOf(std::uint64_t key) {
+  const glm::uvec3 c = CoordinatesOf(key);
+  return static_cast<int>((c.x & 1) << 2 | (c.y & 1) << 1 | (c.z & 1));
+}
+
+// Squared distance from `point` to the box, 0 inside it
+float DistanceSquared(const glm::vec3& point, const glm::vec3& min,
+                      const glm::vec3& max) {
+  const glm::vec3 offset =
+      glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+  return glm::dot(offset, offset);
+}
+
+}  // namespace
+
+LooseOctree::LooseOctree(const glm::vec3& center, float half_size,
+                         const LooseOctreeOptions& options)
+    : options_(options),
+      min_(center - half_size),
+      size_(2.0f * half_size) {
+  options_.max_depth = std::min(std::max(options_.max_depth, 0), kMaxDepth);
+}
+
+LooseOctree::Handle LooseOctree::Insert(const glm::vec4& sphere) {
+  Handle handle;
+  if (free_handles_.empty()) {
+    handle = static_cast<Handle>(objects_.size());
+    objects_.push_back({});
+  } else {
+    handle = free_handles_.back();
+    free_handles_.pop_back();
+  }
+  objects_[handle].sphere = sphere;
+  Link(handle, CellOf(sphere), kNoCell);
+  return handle;
+}
+
+void LooseOctree::Move(Handle handle, const glm::vec4& sphere) {
+  const std::uint64_t cell = CellOf(sphere);
+  objects_[handle].sphere = sphere;
+  if (cell != objects_[handle].cell) {
+    Relink(handle, cell);
+  }
+}
+
+void LooseOctree::Remove(Handle handle) {
+  Unlink(handle, kNoCell);
+  objects_[handle].slot = kFree;
+  free_handles_.push_back(handle);
+}
+
+void LooseOctree::MoveMany(const Handle* handles, const glm::vec4* spheres,
+                           std::size_t count) {
+  new_cells_.resize(count);
+  // Objects staying in their cell are finished here; the handles are
+  // distinct, so no two tasks write the same object
+  const auto find_cells = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++) {
+      Object& object = objects_[handles[i]];
+      const std::uint64_t cell = CellOf(spheres[i]);
+      object.sphere = spheres[i];
+      new_cells_[i] = cell == object.cell ? kNoCell : cell;
+    }
+  };
+  if (options_.parallel) {
+    SharedThreadPool().ParallelFor(count, kMoveGrain, find_cells);
+  } else {
+    find_cells(0, count);
+  }
+  for (std::size_t i = 0; i < count; i++) {
+    if (new_cells_[i] != kNoCell) {
+      Relink(handles[i], new_cells_[i]);
+    }
+  }
+}
+
+template <typename Classify, typename Intersects>
+void LooseOctree::Query(const Classify& classify,
+                        const Intersects& intersects,
+                        std::vector<Handle>* results) const {
+  const auto root = cells_.find(0);
+  if (root == cells_.end()) {
+    return;
+  }
+  struct Entry {
+    const Cell* cell;
+    // Corner and edge length of the cell, which its loose bounds extend by
+    // half the edge length on every side
+    glm::vec3 corner;
+    float size;
+    // The whole subtree is inside the query
+    bool inside;
+  };
+  // Depth-first, so the stack holds at most 7 siblings per level
+  Entry stack[8 * (kMaxDepth + 1)];
+  int size = 0;
+  // The root's bounds do not hold the objects outside them, so it is
+  // always partially inside
+  stack[size++] = {&root->second, min_, size_, false};
+  while (size > 0) {
+    const Entry entry = stack[--size];
+    if (entry.inside) {
+      results->insert(results->end(), entry.cell->objects.begin(),
+                      entry.cell->objects.end());
+    } else {
+      for (const Handle handle : entry.cell->objects) {
+        if (intersects(objects_[handle].sphere)) {
+          results->push_back(handle);
+        }
+      }
+    }
+    const float child_size = 0.5f * entry.size;
+    for (int child = 0; child < 8; child++) {
+      const Cell* cell = entry.cell->children[child];
+      if (cell == nullptr) {
+        continue;
+      }
+      // Child bits as in ChildIndexOf()
+      const glm::vec3 offset(static_cast<float>(child >> 2),
+                             static_cast<float>(child >> 1 & 1),
+                             static_cast<float>(child & 1));
+      const glm::vec3 corner = entry.corner + child_size * offset;
+      bool inside = entry.inside;
+      if (!inside) {
+        const Overlap overlap =
+            classify(corner - 0.5f * child_size, corner + 1.5f * child_size);
+        if (overlap == Overlap::OUTSIDE) {
+          continue;
+        }
+        inside = overlap == Overlap::INSIDE;
+      }
+      stack[size++] = {cell, corner, child_size, inside};
+    }
+  }
+}
+
+void LooseOctree::QueryFrustum(const Frustum& frustum,
+                               std::vector<Handle>* results) const {
+  const auto classify = [&](const glm::vec3& min, const glm::vec3& max) {
+    Overlap overlap = Overlap::INSIDE;
+    for (const auto& plane : frustum.planes) {
+      const glm::vec3 normal(plane);
+      // The corners farthest along and against the normal
+      const glm::vec3 positive(normal.x >= 0.0f ? max.x : min.x,
+                               normal.y >= 0.0f ? max.y : min.y,
+                               normal.z >= 0.0f ? max.z : min.z);
+      const glm::vec3 negative(normal.x >= 0.0f ? min.x : max.x,
+                               normal.y >= 0.0f ? min.y : max.y,
+                               normal.z >= 0.0f ? min.z : max.z);
+      if (glm::dot(normal, positive) + plane.w < 0.0f) {
+        return Overlap::OUTSIDE;
+      }
+      if (glm::dot(normal, negative) + plane.w < 0.0f) {
+        overlap = Overlap::PARTIAL;
+      }
+    }
+    return overlap;
+  };
+  const auto intersects = [&](const glm::vec4& sphere) {
+    for (const auto& plane : frustum.planes) {
+      if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w <
+          -sphere.w) {
+        return false;
+      }
+    }
+    return true;
+  };
+  Query(classify, intersects, results);
+}
+
+void LooseOctree::QuerySphere(const glm::vec4& sphere,
+                              std::vector<Handle>* results) const {
+  const glm::vec3 center(sphere);
+  const float radius2 = sphere.w * sphere.w;
+  const auto classify = [&](const glm::vec3& min, const glm::vec3& max) {
+    if (DistanceSquared(center, min, max) > radius2) {
+      return Overlap::OUTSIDE;
+    }
+    // Inside when the corner farthest from the center is
+    const glm::vec3 farthest = glm::max(center - min, max - center);
+    return glm::dot(farthest, farthest) <= radius2 ? Overlap::INSIDE
+                                                   : Overlap::PARTIAL;
+  };
+  const auto intersects = [&](const glm::vec4& object) {
+    const glm::vec3 offset = glm::vec3(object) - center;
+    const float reach = object.w + sphere.w;
+    return glm::dot(offset, offset) <= reach * reach;
+  };
+  Query(classify, intersects, results);
+}
+
+void LooseOctree::QueryBox(const glm::vec3& min, const glm::vec3& max,
+                           std::vector<Handle>* results) const {
+  const auto classify = [&](const glm::vec3& cell_min,
+                            const glm::vec3& cell_max) {
+    for (int axis = 0; axis < 3; axis++) {
+      if (cell_min[axis] > max[axis] || cell_max[axis] < min[axis]) {
+        return Overlap::OUTSIDE;
+      }
+    }
+    for (int axis = 0; axis < 3; axis++) {
+      if (cell_min[axis] < min[axis] || cell_max[axis] > max[axis]) {
+        return Overlap::PARTIAL;
+      }
+    }
+    return Overlap::INSIDE;
+  };
+  const auto intersects = [&](const glm::vec4& sphere) {
+    return DistanceSquared(glm::vec3(sphere), min, max) <= sphere.w * sphere.w;
+  };
+  Query(classify, intersects, results);
+}
+
+glm::vec4 LooseOctree::Sphere(Handle handle) const {
+  return objects_[handle].sphere;
+}
+
+std::size_t LooseOctree::Size() const {
+  return objects_.size() - free_handles_.size();
+}
+
+std::size_t LooseOctree::CellCount() const {
+  return cells_.size();
+}
+
+std::uint64_t LooseOctree::CellOf(const glm::vec4& sphere) const {
+  const glm::vec3 position = (glm::vec3(sphere) - min_) / size_;
+  for (int axis = 0; axis < 3; axis++) {
+    // Also false for NaN
+    if (!(position[axis] >= 0.0f && position[axis] < 1.0f)) {
+      return 0;
+    }
+  }
+  // The deepest level whose cells are at least twice as wide as the
+  // sphere, so that the loose cell around the center contains it
+  int level = options_.max_depth;
+  if (sphere.w > 0.0f) {
+    const float fit = std::floor(std::log2(size_ / (2.0f * sphere.w)));
+    level = static_cast<int>(
+        std::min(std::max(fit, 0.0f), static_cast<float>(level)));
+    // Undo any rounding in log2 that picked a level too deep
+    while (level > 0 && sphere.w > 0.5f * std::ldexp(size_, -level)) {
+      level--;
+    }
+  }
+  const float cells = std::ldexp(1.0f, level);
+  const unsigned int last = static_cast<unsigned int>(cells) - 1;
+  glm::uvec3 coordinates;
+  for (int axis = 0; axis < 3; axis++) {
+    coordinates[axis] = std::min(
+        last, static_cast<unsigned int>(position[axis] * cells));
+  }
+  return MakeKey(level, coordinates);
+}
+
+LooseOctree::Cell& LooseOctree::FindOrCreate(std::uint64_t key) {
+  // Elements of the map stay in place while others are added or erased,
+  // so the links between cells stay valid
+  const auto inserted = cells_.try_emplace(key);
+  Cell& cell = inserted.first->second;
+  if (inserted.second) {
+    cell.key = key;
+    if (LevelOf(key) > 0) {
+      cell.parent = &FindOrCreate(ParentOf(key));
+      cell.parent->children[ChildIndexOf(key)] = &cell;
+    }
+  }
+  return cell;
+}
+
+void LooseOctree::Link(Handle handle, std::uint64_t cell,
+                       std::uint64_t above) {
+  Cell& target = FindOrCreate(cell);
+  objects_[handle].cell = cell;
+  objects_[handle].slot = static_cast<std::uint32_t>(target.objects.size());
+  target.objects.push_back(handle);
+  for (Cell* c = &target; c != nullptr && c->key != above; c = c->parent) {
+    c->total++;
+  }
+}
+
+void LooseOctree::Unlink(Handle handle, std::uint64_t above) {
+  const Object& object = objects_[handle];
+  Cell* c = &cells_.find(object.cell)->second;
+  const Handle last = c->objects.back();
+  c->objects[object.slot] = last;
+  objects_[last].slot = object.slot;
+  c->objects.pop_back();
+
+  // Drop the counts, and the cells left empty
+  while (c != nullptr && c->key != above) {
+    Cell* parent = c->parent;
+    if (--c->total == 0) {
+      if (parent != nullptr) {
+        parent->children[ChildIndexOf(c->key)] = nullptr;
+      }
+      cells_.erase(c->key);
+    }
+    c = parent;
+  }
+}
+
+void LooseOctree::Relink(Handle handle, std::uint64_t cell) {
+  // The object stays below the deepest cell that holds both the old and
+  // the new cell, so the counts from there up do not change
+  std::uint64_t from = objects_[handle].cell;
+  std::uint64_t to = cell;
+  while (from != to) {
+    const int from_level = LevelOf(from);
+    const int to_level = LevelOf(to);
+    if (from_level >= to_level) {
+      from = ParentOf(from);
+    }
+    if (to_level >= from_level) {
+      to = ParentOf(to);
+    }
+  }
+  Unlink(handle, from);
+  Link(handle, cell, from);
+}
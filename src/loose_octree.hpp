@@ -0,0 +1,124 @@
+#ifndef LEARNGL_LOOSE_OCTREE_HPP_
+#define LEARNGL_LOOSE_OCTREE_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "frustum_culling.hpp"
+
+struct LooseOctreeOptions {
+  // Levels below the root; cells at the deepest level are
+  // 2 * half_size / 2^max_depth wide. At most 15.
+  int max_depth = 6;
+  // Let MoveMany() find the new cells across SharedThreadPool()
+  bool parallel = true;
+};
+
+// A spatial index over moving bounding spheres. Every cell's bounds are
+// loosened to twice its size, so an object is stored in exactly one cell,
+// found directly from its radius and center: the level whose cells are at
+// least twice as wide as the sphere, and the cell there holding the
+// center. Inserting, moving and removing an object touches that cell and
+// its ancestors' object counts only, a bounded amount of work whatever the
+// number of objects.
+//
+// Only cells holding objects, or with such cells below them, exist. They
+// are found by level and cell coordinates in a hash map and linked to their
+// parent and children for walking the tree. Objects whose center is outside
+// the root cube, or which are too large for level 1, are kept at the root,
+// which queries always test. `max_depth` is best set so that the deepest
+// cells hold a few objects each: deeper cells mostly add cells to visit.
+class LooseOctree {
+ public:
+  using Handle = std::uint32_t;
+
+  // Index the cube of `half_size` around `center`.
+  LooseOctree(const glm::vec3& center, float half_size,
+              const LooseOctreeOptions& options = {});
+
+  // Cells point at each other
+  LooseOctree(const LooseOctree&) = delete;
+  LooseOctree& operator=(const LooseOctree&) = delete;
+
+  // Add an object bounded by `sphere` (center, radius). Handles of removed
+  // objects are reused.
+  Handle Insert(const glm::vec4& sphere);
+  void Move(Handle handle, const glm::vec4& sphere);
+  void Remove(Handle handle);
+  // Move handles[i] to spheres[i]. The handles must be distinct. The new
+  // cells are found in parallel; only the objects that change cell are then
+  // relinked, one at a time.
+  void MoveMany(const Handle* handles, const glm::vec4* spheres,
+                std::size_t count);
+
+  // Append the handles of the objects whose spheres intersect the query to
+  // `results`, in no particular order.
+  void QueryFrustum(const Frustum& frustum,
+                    std::vector<Handle>* results) const;
+  void QuerySphere(const glm::vec4& sphere,
+                   std::vector<Handle>* results) const;
+  void QueryBox(const glm::vec3& min, const glm::vec3& max,
+                std::vector<Handle>* results) const;
+
+  glm::vec4 Sphere(Handle handle) const;
+  // Objects currently inserted
+  std::size_t Size() const;
+  std::size_t CellCount() const;
+
+ private:
+  struct Object {
+    glm::vec4 sphere;
+    std::uint64_t cell;
+    // Index within the cell's objects, or kFree when removed
+    std::uint32_t slot;
+  };
+  struct Cell {
+    std::uint64_t key;
+    std::vector<Handle> objects;
+    // Objects in this cell and all cells below it
+    std::uint32_t total = 0;
+    // Null for the root and for missing children
+    Cell* parent = nullptr;
+    Cell* children[8] = {};
+  };
+
+  // How a cell's loose bounds relate to a query volume
+  enum class Overlap {
+    OUTSIDE,
+    PARTIAL,
+    INSIDE,
+  };
+
+  LooseOctreeOptions options_;
+  // Corner and edge length of the root cube
+  glm::vec3 min_;
+  float size_;
+  std::vector<Object> objects_;
+  std::vector<Handle> free_handles_;
+  std::unordered_map<std::uint64_t, Cell> cells_;
+  // MoveMany() scratch: the new cell per moved object
+  std::vector<std::uint64_t> new_cells_;
+
+  std::uint64_t CellOf(const glm::vec4& sphere) const;
+  // The cell for `key`, created along with any missing ancestors
+  Cell& FindOrCreate(std::uint64_t key);
+  // Add the object to `cell` and count it in the cells up to, but not
+  // including, `above`
+  void Link(Handle handle, std::uint64_t cell, std::uint64_t above);
+  // Take the object out of its cell and uncount it up to `above`
+  void Unlink(Handle handle, std::uint64_t above);
+  void Relink(Handle handle, std::uint64_t cell);
+
+  // Walk the cells for which classify(min, max) is not OUTSIDE, keeping the
+  // objects of PARTIAL cells that pass intersects(sphere) and every object
+  // below an INSIDE cell.
+  template <typename Classify, typename Intersects>
+  void Query(const Classify& classify, const Intersects& intersects,
+             std::vector<Handle>* results) const;
+};
+
+#endif
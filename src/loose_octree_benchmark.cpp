@@ -0,0 +1,246 @@
+// Times LooseOctree on objects drifting through a box: moving all of them
+// per frame on one thread against the shared thread pool, and frustum,
+// light and neighbor queries against testing every object. Every query is
+// checked to find the same objects as the brute force test.
+//
+// Usage:
+//   loose_octree_benchmark [objects] [frames]
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frustum_culling.hpp"
+#include "loose_octree.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+constexpr std::size_t kDefaultObjects = 100000;
+constexpr int kDefaultFrames = 60;
+// Objects stay within the box of this half size, which the octree covers
+constexpr float kHalfSize = 200.0f;
+constexpr float kMaxSpeed = 2.0f;
+constexpr float kTimeStep = 1.0f / 60.0f;
+constexpr int kLights = 64;
+constexpr float kLightRadius = 20.0f;
+constexpr int kNeighborQueries = 1000;
+constexpr float kNeighborRadius = 4.0f;
+
+struct Scene {
+  std::vector<glm::vec4> spheres;
+  std::vector<glm::vec3> velocities;
+};
+
+// Mostly small objects with a few large ones
+Scene MakeScene(std::size_t count) {
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> positive(0.0f, 1.0f);
+  Scene scene;
+  scene.spheres.resize(count);
+  scene.velocities.resize(count);
+  for (std::size_t i = 0; i < count; i++) {
+    const float size = positive(random);
+    scene.spheres[i] = glm::vec4(unit(random) * kHalfSize,
+                                 unit(random) * kHalfSize,
+                                 unit(random) * kHalfSize,
+                                 0.2f + 8.0f * size * size * size);
+    scene.velocities[i] =
+        glm::vec3(unit(random), unit(random), unit(random)) * kMaxSpeed;
+  }
+  return scene;
+}
+
+// Advance every object, bouncing off the walls of the box
+void Step(Scene* scene) {
+  for (std::size_t i = 0; i < scene->spheres.size(); i++) {
+    glm::vec4& sphere = scene->spheres[i];
+    glm::vec3& velocity = scene->velocities[i];
+    for (int axis = 0; axis < 3; axis++) {
+      sphere[axis] += velocity[axis] * kTimeStep;
+      if (std::abs(sphere[axis]) > kHalfSize) {
+        velocity[axis] = -velocity[axis];
+        sphere[axis] = std::copysign(kHalfSize, sphere[axis]);
+      }
+    }
+  }
+}
+
+template <typename Intersects>
+std::vector<LooseOctree::Handle> BruteForce(const Scene& scene,
+                                            const Intersects& intersects) {
+  std::vector<LooseOctree::Handle> results;
+  for (std::size_t i = 0; i < scene.spheres.size(); i++) {
+    if (intersects(scene.spheres[i])) {
+      results.push_back(static_cast<LooseOctree::Handle>(i));
+    }
+  }
+  return results;
+}
+
+bool SameObjects(std::vector<LooseOctree::Handle> a,
+                 std::vector<LooseOctree::Handle> b) {
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  return a == b;
+}
+
+bool SpheresOverlap(const glm::vec4& a, const glm::vec4& b) {
+  const glm::vec3 offset = glm::vec3(a) - glm::vec3(b);
+  return glm::dot(offset, offset) <= (a.w + b.w) * (a.w + b.w);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::size_t objects = kDefaultObjects;
+  int frames = kDefaultFrames;
+  if (argc > 1) {
+    objects = std::max<std::size_t>(std::stoull(argv[1]), 1);
+  }
+  if (argc > 2) {
+    frames = std::max(std::stoi(argv[2]), 1);
+  }
+
+  std::cout << "Objects: " << objects << "\n"
+            << "Threads: " << SharedThreadPool().Concurrency() << "\n"
+            << "Frames: " << frames << "\n\n";
+  std::cout << std::fixed << std::setprecision(2);
+
+  // Handles are given out in order, so handle i is object i
+  const Scene start = MakeScene(objects);
+  std::vector<LooseOctree::Handle> handles(objects);
+  for (std::size_t i = 0; i < objects; i++) {
+    handles[i] = static_cast<LooseOctree::Handle>(i);
+  }
+
+  Scene scene;
+  for (const bool parallel : {false, true}) {
+    scene = start;
+    LooseOctreeOptions options;
+    options.parallel = parallel;
+    LooseOctree octree(glm::vec3(0.0f), kHalfSize, options);
+    const auto insert_start = std::chrono::steady_clock::now();
+    for (const glm::vec4& sphere : scene.spheres) {
+      octree.Insert(sphere);
+    }
+    const std::chrono::duration<double, std::milli> insert_time =
+        std::chrono::steady_clock::now() - insert_start;
+
+    std::chrono::duration<double, std::milli> move_time(0.0);
+    for (int frame = 0; frame < frames; frame++) {
+      Step(&scene);
+      const auto move_start = std::chrono::steady_clock::now();
+      octree.MoveMany(handles.data(), scene.spheres.data(), objects);
+      move_time += std::chrono::steady_clock::now() - move_start;
+    }
+    std::cout << (parallel ? "All threads: " : "One thread:  ")
+              << insert_time.count() << " ms to insert, "
+              << move_time.count() / frames << " ms to move all per frame, "
+              << octree.CellCount() << " cells\n";
+  }
+
+  // Queries on the final positions
+  LooseOctree octree(glm::vec3(0.0f), kHalfSize);
+  for (const glm::vec4& sphere : scene.spheres) {
+    octree.Insert(sphere);
+  }
+  std::vector<LooseOctree::Handle> results;
+  bool identical = true;
+  std::chrono::duration<double, std::micro> octree_time(0.0);
+  std::chrono::duration<double, std::micro> brute_force_time(0.0);
+  // Time `query` filling `results` and compare it with testing every
+  // object with `intersects`
+  const auto measure = [&](const auto& query, const auto& intersects) {
+    results.clear();
+    auto start = std::chrono::steady_clock::now();
+    query();
+    octree_time += std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    const std::vector<LooseOctree::Handle> expected =
+        BruteForce(scene, intersects);
+    brute_force_time += std::chrono::steady_clock::now() - start;
+    identical = identical && SameObjects(results, expected);
+  };
+  const auto report = [&](const char* name, int count) {
+    std::cout << std::left << std::setw(22) << name
+              << octree_time.count() / count << " us octree, "
+              << brute_force_time.count() / count << " us brute force, "
+              << (identical ? "identical" : "differs") << "\n";
+    octree_time = brute_force_time = {};
+    identical = true;
+  };
+  std::cout << "\nPer query:\n";
+
+  // A camera at the edge of the box looking in
+  const glm::mat4 projection =
+      glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+  const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 50.0f, kHalfSize),
+                                     glm::vec3(0.0f), glm::vec3(0.0f, 1.0f,
+                                                                0.0f));
+  const Frustum frustum = ExtractFrustum(projection * view);
+  measure([&] { octree.QueryFrustum(frustum, &results); },
+          [&](const glm::vec4& sphere) {
+            for (const auto& plane : frustum.planes) {
+              if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w <
+                  -sphere.w) {
+                return false;
+              }
+            }
+            return true;
+          });
+  report("Frustum:", 1);
+
+  // Point lights spread through the box, finding the objects they reach
+  for (int i = 0; i < kLights; i++) {
+    const glm::vec4 light(scene.spheres[i * objects / kLights].x,
+                          scene.spheres[i * objects / kLights].y,
+                          scene.spheres[i * objects / kLights].z,
+                          kLightRadius);
+    measure([&] { octree.QuerySphere(light, &results); },
+            [&](const glm::vec4& sphere) {
+              return SpheresOverlap(sphere, light);
+            });
+  }
+  report("Light sphere:", kLights);
+
+  // Objects within reach of an object, and within a box around it
+  const int neighbor_queries =
+      static_cast<int>(std::min<std::size_t>(kNeighborQueries, objects));
+  for (int i = 0; i < neighbor_queries; i++) {
+    const glm::vec4 sphere = scene.spheres[i];
+    measure([&] {
+              octree.QuerySphere(
+                  glm::vec4(glm::vec3(sphere), sphere.w + kNeighborRadius),
+                  &results);
+            },
+            [&](const glm::vec4& other) {
+              return SpheresOverlap(
+                  other,
+                  glm::vec4(glm::vec3(sphere), sphere.w + kNeighborRadius));
+            });
+  }
+  report("Neighbor sphere:", neighbor_queries);
+  for (int i = 0; i < neighbor_queries; i++) {
+    const glm::vec3 min = glm::vec3(scene.spheres[i]) - kNeighborRadius;
+    const glm::vec3 max = glm::vec3(scene.spheres[i]) + kNeighborRadius;
+    measure([&] { octree.QueryBox(min, max, &results); },
+            [&](const glm::vec4& other) {
+              const glm::vec3 center(other);
+              const glm::vec3 offset = glm::max(
+                  glm::max(min - center, center - max), glm::vec3(0.0f));
+              return glm::dot(offset, offset) <= other.w * other.w;
+            });
+  }
+  report("Neighbor box:", neighbor_queries);
+  return 0;
+}
@@ -1,14 +1,86 @@
 #include "mesh.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 
+#include "gpu_resources.hpp"
+#include "render_stats.hpp"
+#include "skinning.hpp"
+
+namespace {
+
+// Footprints are measured from at least this far, e.g. with the camera
+// inside the bounds
+constexpr float kMinFootprintDistance = 0.1f;
+
+}  // namespace
+
+unsigned int TextureId(const Texture& texture) {
+  return texture.residency != nullptr
+             ? texture.residency->Acquire(texture.residency_handle)
+             : texture.id;
+}
+
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-           std::vector<Texture> textures) {
+           std::vector<Texture> textures,
+           std::vector<SkinWeights> skin_weights) {
   this->vertices = vertices;
   this->indices = indices;
   this->textures = textures;
+  this->skin_weights = skin_weights;
 
   SetupMesh();
+
+  // Same sampler naming as Draw()
+  unsigned int diffuse_count = 1;
+  unsigned int specular_count = 1;
+  for (const auto& texture : this->textures) {
+    if (material_.texture_count == kMaxMaterialTextures) {
+      break;
+    }
+    std::string number;
+    if (texture.type == "texture_diffuse") {
+      number = std::to_string(diffuse_count++);
+    } else if (texture.type == "texture_specular") {
+      number = std::to_string(specular_count++);
+    }
+    material_.textures[material_.texture_count] = texture.id;
+    material_.samplers[material_.texture_count] = texture.type + number;
+    material_.texture_count++;
+  }
+
+  glm::vec3 minimum(0.0f);
+  glm::vec3 maximum(0.0f);
+  if (!this->vertices.empty()) {
+    minimum = maximum = this->vertices[0].position;
+  }
+  for (const auto& vertex : this->vertices) {
+    minimum = glm::min(minimum, vertex.position);
+    maximum = glm::max(maximum, vertex.position);
+  }
+  center_ = 0.5f * (minimum + maximum);
+  for (const auto& vertex : this->vertices) {
+    radius_ = std::max(radius_, glm::length(vertex.position - center_));
+  }
+
+  // Ratio of the UV area to the surface area, which also covers meshes that
+  // tile or only map part of the texture
+  float surface_area = 0.0f;
+  float uv_area = 0.0f;
+  for (std::size_t i = 0; i + 2 < this->indices.size(); i += 3) {
+    const Vertex& a = this->vertices[this->indices[i]];
+    const Vertex& b = this->vertices[this->indices[i + 1]];
+    const Vertex& c = this->vertices[this->indices[i + 2]];
+    surface_area += 0.5f * glm::length(glm::cross(b.position - a.position,
+                                                  c.position - a.position));
+    const glm::vec2 uv_ab = b.tex_coords - a.tex_coords;
+    const glm::vec2 uv_ac = c.tex_coords - a.tex_coords;
+    uv_area += 0.5f * std::abs(uv_ab.x * uv_ac.y - uv_ab.y * uv_ac.x);
+  }
+  if (surface_area > 0.0f) {
+    uv_density_ = std::sqrt(uv_area / surface_area);
+  }
 }
 
 void Mesh::SetupMesh() {
@@ -26,6 +98,44 @@ void Mesh::SetupMesh() {
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
                &indices[0], GL_STATIC_DRAW);
 
+  GpuResources().Track(GpuResourceKind::BUFFER, vbo_,
+                       {GpuResourceCategory::MESH_BUFFER,
+                        vertices.size() * sizeof(Vertex), GL_NONE,
+                        "Mesh vertices"});
+  GpuResources().Track(GpuResourceKind::BUFFER, ebo_,
+                       {GpuResourceCategory::MESH_BUFFER,
+                        indices.size() * sizeof(unsigned int), GL_NONE,
+                        "Mesh indices"});
+
+  SetupVertexAttributes();
+
+  if (!skin_weights.empty()) {
+    glGenBuffers(1, &skin_vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, skin_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, skin_weights.size() * sizeof(SkinWeights),
+                 skin_weights.data(), GL_STATIC_DRAW);
+    GpuResources().Track(GpuResourceKind::BUFFER, skin_vbo_,
+                         {GpuResourceCategory::MESH_BUFFER,
+                          skin_weights.size() * sizeof(SkinWeights), GL_NONE,
+                          "Mesh skin weights"});
+    // Bone indices
+    glEnableVertexAttribArray(7);
+    glVertexAttribIPointer(7, kMaxBoneInfluences, GL_UNSIGNED_BYTE,
+                           sizeof(SkinWeights),
+                           (void*)offsetof(SkinWeights, bones));
+    // Bone weights
+    glEnableVertexAttribArray(8);
+    glVertexAttribPointer(8, kMaxBoneInfluences, GL_UNSIGNED_BYTE, GL_TRUE,
+                          sizeof(SkinWeights),
+                          (void*)offsetof(SkinWeights, weights));
+  }
+
+  glBindVertexArray(0);
+}
+
+// Positions, normals and texture coordinates of the Vertex buffer bound to
+// GL_ARRAY_BUFFER
+void Mesh::SetupVertexAttributes() {
   // Vertex positions
   glEnableVertexAttribArray(0);
   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -37,11 +147,9 @@ void Mesh::SetupMesh() {
   glEnableVertexAttribArray(2);
   glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                         (void*)offsetof(Vertex, tex_coords));
-
-  glBindVertexArray(0);
 }
 
-void Mesh::Draw(Shader& shader) {
+void Mesh::BindTextures(Shader& shader) {
   unsigned int diffuse_count = 1;
   unsigned int specular_count = 1;
 
@@ -59,18 +167,118 @@ void Mesh::Draw(Shader& shader) {
     }
     std::string fname = name + number;
     shader.SetFloat(fname, i);
-    glBindTexture(GL_TEXTURE_2D, textures[i].id);
+    glBindTexture(GL_TEXTURE_2D, TextureId(textures[i]));
+    FrameStats().texture_binds++;
   }
+}
+
+void Mesh::Draw(Shader& shader, int instance_count) {
+  BindTextures(shader);
 
   // Draw mesh
   glBindVertexArray(vao_);
-  glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+  if (instance_count == 1) {
+    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+  } else {
+    glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0,
+                            instance_count);
+  }
+  FrameStats().draw_calls++;
 
   // Always good practice to set everything back to defaults once configured
   glBindVertexArray(0);
   glActiveTexture(GL_TEXTURE0);
 }
 
+void Mesh::SkinOnCpu(const glm::mat4* palette) {
+  if (skin_weights.empty()) {
+    return;
+  }
+  SkinVertices(vertices, skin_weights, palette, &cpu_skinned_vertices_);
+
+  const std::size_t bytes = vertices.size() * sizeof(Vertex);
+  if (cpu_skinned_vao_ == 0) {
+    glGenVertexArrays(1, &cpu_skinned_vao_);
+    glGenBuffers(1, &cpu_skinned_vbo_);
+    glBindVertexArray(cpu_skinned_vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, cpu_skinned_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    SetupVertexAttributes();
+    glBindVertexArray(0);
+    GpuResources().Track(GpuResourceKind::BUFFER, cpu_skinned_vbo_,
+                         {GpuResourceCategory::MESH_BUFFER, bytes, GL_NONE,
+                          "Mesh CPU skinned vertices"});
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, cpu_skinned_vbo_);
+  // Orphan the storage the previous draw may still be reading
+  glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, cpu_skinned_vertices_.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Mesh::DrawCpuSkinned(Shader& shader) {
+  if (cpu_skinned_vao_ == 0) {
+    Draw(shader);
+    return;
+  }
+  BindTextures(shader);
+
+  glBindVertexArray(cpu_skinned_vao_);
+  glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+  FrameStats().draw_calls++;
+
+  glBindVertexArray(0);
+  glActiveTexture(GL_TEXTURE0);
+}
+
+void Mesh::Enqueue(RenderQueue& queue, Shader& shader,
+                   const glm::mat4& model) const {
+  for (int i = 0; i < material_.texture_count; i++) {
+    if (textures[i].residency != nullptr) {
+      material_.textures[i] = TextureId(textures[i]);
+    }
+  }
+  queue.Add(shader, material_, vao_, static_cast<GLsizei>(indices.size()),
+            model, glm::vec3(model * glm::vec4(center_, 1.0f)));
+}
+
+void Mesh::RequestTextureDetail(const glm::mat4& model,
+                                const StreamingView& view) const {
+  const float scale = std::max({glm::length(glm::vec3(model[0])),
+                                glm::length(glm::vec3(model[1])),
+                                glm::length(glm::vec3(model[2]))});
+  const glm::vec3 center = glm::vec3(model * glm::vec4(center_, 1.0f));
+  // The closest point of the bounding sphere sees the largest footprint
+  const float distance =
+      std::max(glm::length(center - view.camera_position) - radius_ * scale,
+               kMinFootprintDistance);
+  const float uv_per_pixel =
+      uv_density_ * distance / (scale * view.pixels_per_unit);
+  for (const auto& texture : textures) {
+    if (texture.streamer != nullptr) {
+      texture.streamer->RequestFootprint(texture.streaming_handle,
+                                         uv_per_pixel);
+    }
+  }
+}
+
 unsigned int Mesh::vao() const {
   return vao_;
+}
+
+glm::vec4 Mesh::BoundingSphere() const {
+  return glm::vec4(center_, radius_);
+}
+
+const TriangleBvh& Mesh::Bvh() const {
+  if (!bvh_built_) {
+    std::vector<glm::vec3> positions(vertices.size());
+    for (std::size_t i = 0; i < positions.size(); i++) {
+      positions[i] = vertices[i].position;
+    }
+    bvh_.Build(positions, indices);
+    bvh_built_ = true;
+  }
+  return bvh_;
 }
\ No newline at end of file
@@ -5,7 +5,12 @@
 #include <string>
 #include <vector>
 
+#include "animation.hpp"
+#include "bvh.hpp"
+#include "render_queue.hpp"
 #include "shader_m.hpp"
+#include "texture_residency.hpp"
+#include "texture_streamer.hpp"
 
 struct Vertex {
   glm::vec3 position;
@@ -18,26 +23,83 @@ struct Texture {
   std::string type;
   // Store the path of the texture to compare with other textures
   std::string path;
+  // Layer within `id` when the texture was packed into a GL_TEXTURE_2D_ARRAY,
+  // -1 for a plain GL_TEXTURE_2D
+  int layer = -1;
+  // Set when the texture is loaded on demand; `id` is unused then and the
+  // current name comes from residency->Acquire(residency_handle)
+  TextureResidencyManager* residency = nullptr;
+  TextureResidencyManager::Handle residency_handle = 0;
+  // Set when the texture's mip levels are streamed; `id` stays valid
+  TextureStreamer* streamer = nullptr;
+  TextureStreamer::Handle streaming_handle = 0;
 };
 
+// The name to bind `texture` by this frame: `id`, or for a residency
+// managed texture whatever Acquire() returns, which loads it on first use.
+unsigned int TextureId(const Texture& texture);
+
 class Mesh {
  public:
   // Mesh data
   std::vector<Vertex> vertices;
   std::vector<unsigned int> indices;
   std::vector<Texture> textures;
+  // Per vertex bones, empty for a rigid mesh
+  std::vector<SkinWeights> skin_weights;
   unsigned int vao() const;
+  // Model space bounds as (center, radius)
+  glm::vec4 BoundingSphere() const;
+  // Over the triangles in model space, in bind pose for a skinned mesh.
+  // Built by the first call, so meshes that are never ray cast skip it.
+  const TriangleBvh& Bvh() const;
 
+  // A skinned mesh feeds `skin_weights` to the vertex shader as a `uvec4`
+  // of bone indices at location 7 and a normalized `vec4` of weights at
+  // location 8.
   Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-       std::vector<Texture> textures);
-  void Draw(Shader &shader);
+       std::vector<Texture> textures,
+       std::vector<SkinWeights> skin_weights = {});
+  // Draw `instance_count` instances, e.g. of a skinned mesh whose shader
+  // picks each instance's palette by gl_InstanceID.
+  void Draw(Shader &shader, int instance_count = 1);
+  // Pose a skinned mesh on the CPU with one palette and keep the result for
+  // DrawCpuSkinned(), for shaders without bone attributes.
+  void SkinOnCpu(const glm::mat4* palette);
+  void DrawCpuSkinned(Shader& shader);
+  // Record the same draw as Draw() into `queue` instead of issuing it.
+  void Enqueue(RenderQueue& queue, Shader& shader,
+               const glm::mat4& model) const;
+  // Report the screen footprint of the streamed textures when the mesh is
+  // drawn with `model` this frame.
+  void RequestTextureDetail(const glm::mat4& model,
+                            const StreamingView& view) const;
 
  private:
   unsigned int vao_;
   unsigned int vbo_;
   unsigned int ebo_;
+  unsigned int skin_vbo_ = 0;
+  // CPU skinning target, created by the first SkinOnCpu() and sharing
+  // `ebo_`
+  unsigned int cpu_skinned_vao_ = 0;
+  unsigned int cpu_skinned_vbo_ = 0;
+  std::vector<Vertex> cpu_skinned_vertices_;
+  // The textures as the render queue binds them. Enqueue() refreshes the
+  // names of residency managed textures, which can change between frames.
+  mutable RenderMaterial material_;
+  // Center of the vertices' bounding box, in model space
+  glm::vec3 center_;
+  // Distance from `center_` to the farthest vertex
+  float radius_ = 0.0f;
+  // Average UV distance per unit of model space distance
+  float uv_density_ = 0.0f;
+  mutable TriangleBvh bvh_;
+  mutable bool bvh_built_ = false;
 
   void SetupMesh();
+  void SetupVertexAttributes();
+  void BindTextures(Shader& shader);
 };
 
 #endif
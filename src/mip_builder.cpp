@@ -0,0 +1,302 @@
+#include "mip_builder.hpp"
+
+#if defined(__SSE2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#include "thread_pool.hpp"
+
+namespace {
+
+// Every level is filtered as four linear floats per texel, whatever the
+// source channel count, so one texel maps to one SSE register.
+constexpr int kFloatChannels = 4;
+constexpr std::size_t kLinearToSrgbSize = 4096;
+// Roughly 16K texels per parallel task
+constexpr std::size_t kTexelsPerTask = 16 * 1024;
+constexpr int kCoverageSearchSteps = 10;
+
+struct ConversionTables {
+  float srgb_to_linear[256];
+  unsigned char linear_to_srgb[kLinearToSrgbSize];
+};
+
+const ConversionTables& Tables() {
+  static const ConversionTables tables = []() {
+    ConversionTables result;
+    for (int i = 0; i < 256; i++) {
+      const float value = i / 255.0f;
+      result.srgb_to_linear[i] =
+          value <= 0.04045f ? value / 12.92f
+                            : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+    for (std::size_t i = 0; i < kLinearToSrgbSize; i++) {
+      const float value = i / static_cast<float>(kLinearToSrgbSize - 1);
+      const float encoded =
+          value <= 0.0031308f
+              ? value * 12.92f
+              : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+      result.linear_to_srgb[i] =
+          static_cast<unsigned char>(encoded * 255.0f + 0.5f);
+    }
+    return result;
+  }();
+  return tables;
+}
+
+bool IsColorChannel(int channel, int channels) {
+  // Single and dual channel images (specular, roughness, ...) are data
+  return channels >= 3 && channel < 3;
+}
+
+std::size_t RowGrain(int width) {
+  return std::max<std::size_t>(1, kTexelsPerTask / std::max(width, 1));
+}
+
+void ExpandRows(const unsigned char* pixels, int width, int channels,
+                bool srgb, float* out, std::size_t row_begin,
+                std::size_t row_end) {
+  const ConversionTables& tables = Tables();
+  for (std::size_t y = row_begin; y < row_end; y++) {
+    for (int x = 0; x < width; x++) {
+      const std::size_t texel = y * width + x;
+      const unsigned char* source = pixels + texel * channels;
+      float* target = out + texel * kFloatChannels;
+      target[0] = target[1] = target[2] = 0.0f;
+      target[3] = 1.0f;
+      for (int c = 0; c < channels; c++) {
+        target[c] = srgb && IsColorChannel(c, channels)
+                        ? tables.srgb_to_linear[source[c]]
+                        : source[c] / 255.0f;
+      }
+    }
+  }
+}
+
+void QuantizeRows(const float* level, int width, int channels, bool srgb,
+                  float alpha_scale, unsigned char* out,
+                  std::size_t row_begin, std::size_t row_end) {
+  const ConversionTables& tables = Tables();
+  for (std::size_t y = row_begin; y < row_end; y++) {
+    for (int x = 0; x < width; x++) {
+      const std::size_t texel = y * width + x;
+      const float* source = level + texel * kFloatChannels;
+      unsigned char* target = out + texel * channels;
+      for (int c = 0; c < channels; c++) {
+        float value = source[c];
+        if (c == 3) {
+          value *= alpha_scale;
+        }
+        value = std::clamp(value, 0.0f, 1.0f);
+        if (srgb && IsColorChannel(c, channels)) {
+          target[c] = tables.linear_to_srgb[static_cast<std::size_t>(
+              value * (kLinearToSrgbSize - 1) + 0.5f)];
+        } else {
+          target[c] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+        }
+      }
+    }
+  }
+}
+
+// 2x2 box filter of `source` into rows [row_begin, row_end) of `target`.
+// The target is half the source, rounding down, so an odd source drops its
+// last row or column; a source 1 texel wide or high is read twice instead.
+void DownsampleRows(const float* source, int source_width, int source_height,
+                    float* target, int target_width, std::size_t row_begin,
+                    std::size_t row_end) {
+  const std::size_t source_stride =
+      static_cast<std::size_t>(source_width) * kFloatChannels;
+  for (std::size_t y = row_begin; y < row_end; y++) {
+    const int y0 = std::min(static_cast<int>(2 * y), source_height - 1);
+    const int y1 = std::min(static_cast<int>(2 * y + 1), source_height - 1);
+    const float* row0 = source + y0 * source_stride;
+    const float* row1 = source + y1 * source_stride;
+    float* out = target + y * target_width * kFloatChannels;
+
+    int x = 0;
+#if defined(__AVX__)
+    // Two output texels per iteration while all four source columns exist
+    const __m256 quarter8 = _mm256_set1_ps(0.25f);
+    for (; x + 1 < target_width && 2 * x + 3 < source_width; x += 2) {
+      const __m256 sum01 = _mm256_add_ps(_mm256_loadu_ps(row0 + 8 * x),
+                                         _mm256_loadu_ps(row1 + 8 * x));
+      const __m256 sum23 = _mm256_add_ps(_mm256_loadu_ps(row0 + 8 * x + 8),
+                                         _mm256_loadu_ps(row1 + 8 * x + 8));
+      // Gather the even and odd source columns of both output texels
+      const __m256 even = _mm256_permute2f128_ps(sum01, sum23, 0x20);
+      const __m256 odd = _mm256_permute2f128_ps(sum01, sum23, 0x31);
+      _mm256_storeu_ps(out + kFloatChannels * x,
+                       _mm256_mul_ps(_mm256_add_ps(even, odd), quarter8));
+    }
+#endif
+    for (; x < target_width; x++) {
+      const int x0 = std::min(2 * x, source_width - 1) * kFloatChannels;
+      const int x1 = std::min(2 * x + 1, source_width - 1) * kFloatChannels;
+#if defined(__SSE2__)
+      const __m128 top =
+          _mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1));
+      const __m128 bottom =
+          _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1));
+      _mm_storeu_ps(out + kFloatChannels * x,
+                    _mm_mul_ps(_mm_add_ps(top, bottom), _mm_set1_ps(0.25f)));
+#else
+      for (int c = 0; c < kFloatChannels; c++) {
+        out[kFloatChannels * x + c] =
+            0.25f * (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] +
+                     row1[x1 + c]);
+      }
+#endif
+    }
+  }
+}
+
+float AlphaCoverage(const std::vector<float>& level, float cutoff,
+                    float scale) {
+  const std::size_t texel_count = level.size() / kFloatChannels;
+  std::size_t covered = 0;
+  for (std::size_t i = 0; i < texel_count; i++) {
+    if (level[i * kFloatChannels + 3] * scale > cutoff) {
+      covered++;
+    }
+  }
+  return static_cast<float>(covered) / texel_count;
+}
+
+// Binary search the alpha scale that makes the level's coverage match the
+// base level's.
+float CoverageScale(const std::vector<float>& level, float cutoff,
+                    float target_coverage) {
+  const float coverage = AlphaCoverage(level, cutoff, 1.0f);
+  const float tolerance = 1.0f / (level.size() / kFloatChannels);
+  if (std::abs(coverage - target_coverage) <= tolerance) {
+    // Already matches, which also leaves fully opaque images untouched
+    return 1.0f;
+  }
+  float low = coverage < target_coverage ? 1.0f : 0.0f;
+  float high = coverage < target_coverage ? 4.0f : 1.0f;
+  for (int step = 0; step < kCoverageSearchSteps; step++) {
+    const float middle = 0.5f * (low + high);
+    if (AlphaCoverage(level, cutoff, middle) < target_coverage) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return 0.5f * (low + high);
+}
+
+}  // namespace
+
+std::vector<MipLevel> BuildMipChain(const unsigned char* pixels, int width,
+                                    int height, int channels,
+                                    const MipChainOptions& options) {
+  ThreadPool& pool = SharedThreadPool();
+  std::vector<MipLevel> levels;
+
+  MipLevel base{width, height, channels, {}};
+  base.pixels.assign(pixels, pixels + static_cast<std::size_t>(width) *
+                                          height * channels);
+  levels.push_back(std::move(base));
+
+  std::vector<float> current(static_cast<std::size_t>(width) * height *
+                             kFloatChannels);
+  pool.ParallelFor(height, RowGrain(width),
+                   [&](std::size_t begin, std::size_t end) {
+                     ExpandRows(pixels, width, channels, options.srgb,
+                                current.data(), begin, end);
+                   });
+
+  const bool preserve_coverage =
+      options.preserve_alpha_coverage && channels == 4;
+  const float target_coverage =
+      preserve_coverage ? AlphaCoverage(current, options.alpha_cutoff, 1.0f)
+                        : 0.0f;
+
+  std::vector<float> next;
+  while (width > 1 || height > 1) {
+    const int next_width = std::max(width / 2, 1);
+    const int next_height = std::max(height / 2, 1);
+    next.resize(static_cast<std::size_t>(next_width) * next_height *
+                kFloatChannels);
+    pool.ParallelFor(next_height, RowGrain(next_width),
+                     [&](std::size_t begin, std::size_t end) {
+                       DownsampleRows(current.data(), width, height,
+                                      next.data(), next_width, begin, end);
+                     });
+
+    const float alpha_scale =
+        preserve_coverage
+            ? CoverageScale(next, options.alpha_cutoff, target_coverage)
+            : 1.0f;
+
+    MipLevel level{next_width, next_height, channels, {}};
+    level.pixels.resize(static_cast<std::size_t>(next_width) * next_height *
+                        channels);
+    pool.ParallelFor(next_height, RowGrain(next_width),
+                     [&](std::size_t begin, std::size_t end) {
+                       QuantizeRows(next.data(), next_width, channels,
+                                    options.srgb, alpha_scale,
+                                    level.pixels.data(), begin, end);
+                     });
+    levels.push_back(std::move(level));
+
+    std::swap(current, next);
+    width = next_width;
+    height = next_height;
+  }
+  return levels;
+}
+
+GLenum MipChainInternalFormat(int channels, bool srgb_storage) {
+  switch (channels) {
+    case 1:
+      return GL_R8;
+    case 2:
+      return GL_RG8;
+    case 3:
+      return srgb_storage ? GL_SRGB8 : GL_RGB8;
+    default:
+      return srgb_storage ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+  }
+}
+
+GLenum MipChainPixelFormat(int channels) {
+  switch (channels) {
+    case 1:
+      return GL_RED;
+    case 2:
+      return GL_RG;
+    case 3:
+      return GL_RGB;
+    default:
+      return GL_RGBA;
+  }
+}
+
+void UploadMipChain(const std::vector<MipLevel>& levels, bool srgb_storage) {
+  if (levels.empty()) {
+    return;
+  }
+
+  const GLenum internal_format =
+      MipChainInternalFormat(levels[0].channels, srgb_storage);
+  const GLenum format = MipChainPixelFormat(levels[0].channels);
+
+  glTexStorage2D(GL_TEXTURE_2D, static_cast<GLsizei>(levels.size()),
+                 internal_format, levels[0].width, levels[0].height);
+  // Rows of 1 and 3 channel images are not 4-byte aligned
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  for (std::size_t i = 0; i < levels.size(); i++) {
+    glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), 0, 0,
+                    levels[i].width, levels[i].height, format,
+                    GL_UNSIGNED_BYTE, levels[i].pixels.data());
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
@@ -0,0 +1,45 @@
+#ifndef LEARNGL_MIP_BUILDER_HPP_
+#define LEARNGL_MIP_BUILDER_HPP_
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// One level of a mip chain, tightly packed with `channels` 8-bit components
+// per texel.
+struct MipLevel {
+  int width;
+  int height;
+  int channels;
+  std::vector<unsigned char> pixels;
+};
+
+struct MipChainOptions {
+  // Color channels hold sRGB encoded data and are filtered in linear space.
+  // Alpha is always linear.
+  bool srgb = false;
+  // Rescale alpha in every level so the fraction of texels passing
+  // `alpha_cutoff` matches the base level. Keeps alpha tested cut-outs like
+  // grass from thinning out in the distance.
+  bool preserve_alpha_coverage = false;
+  float alpha_cutoff = 0.5f;
+};
+
+// Build the complete chain down to 1x1 on the CPU with a 2x2 box filter. Rows
+// are split across SharedThreadPool() and filtered with SSE/AVX when
+// available. levels[0] is a copy of the source image.
+std::vector<MipLevel> BuildMipChain(const unsigned char* pixels, int width,
+                                    int height, int channels,
+                                    const MipChainOptions& options);
+
+// Internal format UploadMipChain() allocates for `channels` 8-bit components.
+GLenum MipChainInternalFormat(int channels, bool srgb_storage);
+// Pixel transfer format of a level with `channels` components.
+GLenum MipChainPixelFormat(int channels);
+
+// Allocate immutable storage with glTexStorage2D for the texture bound to
+// GL_TEXTURE_2D and upload every level. `srgb_storage` selects an sRGB
+// internal format for 3 and 4 channel images.
+void UploadMipChain(const std::vector<MipLevel>& levels, bool srgb_storage);
+
+#endif
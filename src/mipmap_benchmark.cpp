@@ -0,0 +1,153 @@
+// Compares driver mip generation (glTexImage2D + glGenerateMipmap) against
+// the CPU path (BuildMipChain + UploadMipChain) for the sample textures. Both
+// paths finish with glFinish so the timings include the GPU work.
+//
+// Usage:
+//   mipmap_benchmark [iterations] [texture...]
+
+#include <glad/glad.h>
+// Do not sort above glad
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mip_builder.hpp"
+#include "thread_pool.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_include.hpp"
+
+namespace {
+
+constexpr int kDefaultIterations = 20;
+
+struct Image {
+  int width = 0;
+  int height = 0;
+  int channels = 0;
+  std::vector<unsigned char> pixels;
+};
+
+bool LoadImage(const std::string& path, Image* image) {
+  unsigned char* data = stbi_load(path.c_str(), &image->width,
+                                  &image->height, &image->channels, 0);
+  if (!data) {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    return false;
+  }
+  image->pixels.assign(data, data + static_cast<std::size_t>(image->width) *
+                                        image->height * image->channels);
+  stbi_image_free(data);
+  return true;
+}
+
+GLenum FormatFor(int channels) {
+  switch (channels) {
+    case 1:
+      return GL_RED;
+    case 2:
+      return GL_RG;
+    case 3:
+      return GL_RGB;
+    default:
+      return GL_RGBA;
+  }
+}
+
+template <typename Function>
+double AverageMilliseconds(int iterations, Function function) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    unsigned int texture_id;
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    function();
+    glFinish();
+    glDeleteTextures(1, &texture_id);
+  }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int iterations = kDefaultIterations;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++) {
+    if (i == 1 && std::isdigit(static_cast<unsigned char>(argv[i][0]))) {
+      iterations = std::max(std::stoi(argv[i]), 1);
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (paths.empty()) {
+    paths = {"assets/textures/wood.png", "assets/textures/grass.png",
+             "assets/textures/container2.png",
+             "assets/textures/container2_specular.png"};
+  }
+
+  // A hidden window is enough for a context
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  GLFWwindow* window =
+      glfwCreateWindow(64, 64, "LearnOpenGL", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cerr << "Failed to create GLFW window\n";
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::cerr << "Failed to initialize GLAD\n";
+    return -1;
+  }
+
+  std::cout << "Renderer: " << glGetString(GL_RENDERER) << "\n"
+            << "Mip threads: " << SharedThreadPool().Concurrency() << "\n"
+            << "Iterations: " << iterations << "\n\n";
+  std::cout << std::fixed << std::setprecision(2);
+
+  for (const auto& path : paths) {
+    Image image;
+    if (!LoadImage(path, &image)) {
+      continue;
+    }
+    const GLenum format = FormatFor(image.channels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    const double driver_ms = AverageMilliseconds(iterations, [&]() {
+      glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0,
+                   format, GL_UNSIGNED_BYTE, image.pixels.data());
+      glGenerateMipmap(GL_TEXTURE_2D);
+    });
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    MipChainOptions options;
+    options.srgb = image.channels >= 3;
+    const double cpu_ms = AverageMilliseconds(iterations, [&]() {
+      UploadMipChain(BuildMipChain(image.pixels.data(), image.width,
+                                   image.height, image.channels, options),
+                     /*srgb_storage=*/false);
+    });
+
+    std::cout << path << " (" << image.width << "x" << image.height << "x"
+              << image.channels << ")\n"
+              << "  glGenerateMipmap:       " << driver_ms << " ms\n"
+              << "  BuildMipChain + upload: " << cpu_ms << " ms\n";
+  }
+
+  glfwTerminate();
+  return 0;
+}
@@ -4,18 +4,121 @@
 #include <assimp/postprocess.h>
 
 #include <assimp/Importer.hpp>
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <utility>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "gpu_resources.hpp"
+#include "ktx2_texture.hpp"
+#include "mip_builder.hpp"
+#include "render_stats.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_include.hpp"
 
-unsigned int TextureFromFile(const char* path, const std::string& directory);
+namespace {
+
+// Layout of a glMultiDrawElementsIndirect command
+struct DrawElementsIndirectCommand {
+  unsigned int count;
+  unsigned int instance_count;
+  unsigned int first_index;
+  int base_vertex;
+  unsigned int base_instance;
+};
+
+// Assimp matrices are row-major
+glm::mat4 ToGlm(const aiMatrix4x4& matrix) {
+  return glm::transpose(glm::make_mat4(&matrix.a1));
+}
+
+int LayerOf(const Mesh& mesh, const std::string& type,
+            unsigned int* array_id) {
+  for (const auto& texture : mesh.textures) {
+    if (texture.type == type) {
+      *array_id = texture.id;
+      return texture.layer;
+    }
+  }
+  *array_id = 0;
+  return -1;
+}
+
+}  // namespace
 
-Model::Model(std::string path) { LoadModel(path); }
+unsigned int TextureFromFile(const char* path, const std::string& directory,
+                             bool color_data);
 
-void Model::Draw(Shader& shader) {
+Model::Model(std::string path, const ModelOptions& options)
+    : residency_(options.residency),
+      streamer_(options.streamer),
+      texture_arrays_(options.texture_arrays),
+      texture_packer_(GpuResourceCategory::MODEL_TEXTURE) {
+  const int texture_modes = (texture_arrays_ ? 1 : 0) +
+                            (residency_ != nullptr ? 1 : 0) +
+                            (streamer_ != nullptr ? 1 : 0);
+  if (texture_modes > 1) {
+    std::cerr << "Model " << path
+              << ": texture_arrays, residency and streamer exclude each "
+                 "other; not loading it\n";
+    texture_arrays_ = false;
+    return;
+  }
+  LoadModel(path);
+  if (texture_arrays_) {
+    texture_packer_.Upload();
+    SetupBatches();
+  }
+}
+
+void Model::Draw(Shader& shader, int instance_count) {
+  if (texture_arrays_) {
+    DrawBatches(shader);
+    return;
+  }
   for (unsigned int i = 0; i < meshes_.size(); i++) {
-    meshes_[i].Draw(shader);
+    meshes_[i].Draw(shader, instance_count);
+  }
+}
+
+void Model::SkinOnCpu(const glm::mat4* palette) {
+  for (auto& mesh : meshes_) {
+    mesh.SkinOnCpu(palette);
+  }
+}
+
+void Model::DrawCpuSkinned(Shader& shader) {
+  for (auto& mesh : meshes_) {
+    mesh.DrawCpuSkinned(shader);
+  }
+}
+
+void Model::Enqueue(RenderQueue& queue, Shader& shader,
+                    const glm::mat4& model) const {
+  if (texture_arrays_) {
+    // RenderMaterial binds GL_TEXTURE_2D only. Say so once rather than
+    // losing the model without a trace.
+    static bool reported = false;
+    if (!reported) {
+      reported = true;
+      std::cerr << "Model::Enqueue: texture array models are not queued; "
+                   "draw them with Draw()\n";
+    }
+    return;
+  }
+  for (const auto& mesh : meshes_) {
+    mesh.Enqueue(queue, shader, model);
+  }
+}
+
+void Model::RequestTextureDetail(const glm::mat4& model,
+                                 const StreamingView& view) const {
+  for (const auto& mesh : meshes_) {
+    mesh.RequestTextureDetail(model, view);
   }
 }
 
@@ -23,6 +126,51 @@ const std::vector<Mesh>& Model::Meshes() const {
   return meshes_;
 }
 
+glm::vec4 Model::BoundingSphere() const {
+  if (meshes_.empty()) {
+    return glm::vec4(0.0f);
+  }
+  glm::vec3 minimum(std::numeric_limits<float>::max());
+  glm::vec3 maximum(std::numeric_limits<float>::lowest());
+  for (const auto& mesh : meshes_) {
+    const glm::vec4 sphere = mesh.BoundingSphere();
+    minimum = glm::min(minimum, glm::vec3(sphere) - sphere.w);
+    maximum = glm::max(maximum, glm::vec3(sphere) + sphere.w);
+  }
+  const glm::vec3 center = 0.5f * (minimum + maximum);
+  float radius = 0.0f;
+  for (const auto& mesh : meshes_) {
+    const glm::vec4 sphere = mesh.BoundingSphere();
+    radius = std::max(radius, glm::length(glm::vec3(sphere) - center) +
+                                  sphere.w);
+  }
+  return glm::vec4(center, radius);
+}
+
+bool Model::Raycast(const Ray& ray, RayHit* hit,
+                    const BvhOptions& options) const {
+  bool found = false;
+  for (std::size_t i = 0; i < meshes_.size(); i++) {
+    if (meshes_[i].Bvh().Intersect(ray, hit, options)) {
+      hit->mesh = static_cast<std::uint32_t>(i);
+      found = true;
+    }
+  }
+  return found;
+}
+
+bool Model::HasSkeleton() const {
+  return skeleton_.BoneCount() > 0;
+}
+
+const Skeleton& Model::GetSkeleton() const {
+  return skeleton_;
+}
+
+const std::vector<AnimationClip>& Model::Animations() const {
+  return animations_;
+}
+
 void Model::LoadModel(std::string path) {
   Assimp::Importer import;
   const aiScene* scene =
@@ -35,7 +183,66 @@ void Model::LoadModel(std::string path) {
   }
   directory_ = path.substr(0, path.find_last_of('/'));
 
+  LoadSkeleton(scene->mRootNode, -1);
+  skeleton_.global_inverse =
+      glm::inverse(ToGlm(scene->mRootNode->mTransformation));
   ProcessNode(scene->mRootNode, scene);
+  if (HasSkeleton()) {
+    LoadAnimations(scene);
+  }
+}
+
+void Model::LoadSkeleton(const aiNode* node, int parent) {
+  const int index = static_cast<int>(skeleton_.nodes.size());
+  skeleton_.nodes.push_back(
+      {node->mName.C_Str(), parent, ToGlm(node->mTransformation)});
+  skeleton_.nodes_by_name.emplace(node->mName.C_Str(), index);
+  for (unsigned int i = 0; i < node->mNumChildren; i++) {
+    LoadSkeleton(node->mChildren[i], index);
+  }
+}
+
+void Model::LoadAnimations(const aiScene* scene) {
+  for (unsigned int i = 0; i < scene->mNumAnimations; i++) {
+    const aiAnimation* animation = scene->mAnimations[i];
+    AnimationClip clip;
+    clip.name = animation->mName.C_Str();
+    clip.duration = static_cast<float>(animation->mDuration);
+    if (animation->mTicksPerSecond > 0.0) {
+      clip.ticks_per_second = static_cast<float>(animation->mTicksPerSecond);
+    }
+    for (unsigned int j = 0; j < animation->mNumChannels; j++) {
+      const aiNodeAnim* source = animation->mChannels[j];
+      const auto node =
+          skeleton_.nodes_by_name.find(source->mNodeName.C_Str());
+      if (node == skeleton_.nodes_by_name.end()) {
+        continue;
+      }
+      AnimationChannel channel;
+      channel.node = node->second;
+      for (unsigned int k = 0; k < source->mNumPositionKeys; k++) {
+        const aiVectorKey& key = source->mPositionKeys[k];
+        channel.positions.push_back(
+            {static_cast<float>(key.mTime),
+             glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z)});
+      }
+      for (unsigned int k = 0; k < source->mNumRotationKeys; k++) {
+        const aiQuatKey& key = source->mRotationKeys[k];
+        channel.rotations.push_back(
+            {static_cast<float>(key.mTime),
+             glm::quat(key.mValue.w, key.mValue.x, key.mValue.y,
+                       key.mValue.z)});
+      }
+      for (unsigned int k = 0; k < source->mNumScalingKeys; k++) {
+        const aiVectorKey& key = source->mScalingKeys[k];
+        channel.scales.push_back(
+            {static_cast<float>(key.mTime),
+             glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z)});
+      }
+      clip.channels.push_back(std::move(channel));
+    }
+    animations_.push_back(std::move(clip));
+  }
 }
 
 void Model::ProcessNode(aiNode* node, const aiScene* scene) {
@@ -87,6 +294,31 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
     }
   }
 
+  // Process bones
+  std::vector<SkinWeights> skin_weights;
+  if (mesh->HasBones() && !texture_arrays_) {
+    std::vector<std::vector<std::pair<int, float>>> influences(
+        mesh->mNumVertices);
+    for (unsigned int i = 0; i < mesh->mNumBones; i++) {
+      const aiBone* bone = mesh->mBones[i];
+      const int index =
+          skeleton_.BoneFor(bone->mName.C_Str(), ToGlm(bone->mOffsetMatrix));
+      if (index < 0) {
+        std::cerr << "Model has more than " << kMaxBones << " bones"
+                  << std::endl;
+        continue;
+      }
+      for (unsigned int j = 0; j < bone->mNumWeights; j++) {
+        const aiVertexWeight& weight = bone->mWeights[j];
+        influences[weight.mVertexId].emplace_back(index, weight.mWeight);
+      }
+    }
+    skin_weights.reserve(influences.size());
+    for (auto& vertex_influences : influences) {
+      skin_weights.push_back(PackSkinWeights(std::move(vertex_influences)));
+    }
+  }
+
   // Process material
   aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
   std::vector<Texture> diffuse_maps =
@@ -96,7 +328,7 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
       material, aiTextureType_SPECULAR, "texture_specular");
   textures.insert(textures.end(), specular_maps.begin(), specular_maps.end());
 
-  return Mesh(vertices, indices, textures);
+  return Mesh(vertices, indices, textures, skin_weights);
 }
 
 std::vector<Texture> Model::LoadMaterialTextures(aiMaterial* material,
@@ -116,7 +348,31 @@ std::vector<Texture> Model::LoadMaterialTextures(aiMaterial* material,
     }
     if (!skip) {
       Texture texture;
-      texture.id = TextureFromFile(str.C_Str(), directory_);
+      // Diffuse maps hold sRGB colors, specular maps hold linear data
+      const bool color_data = type == aiTextureType_DIFFUSE;
+      if (texture_arrays_) {
+        const TextureLayer layer =
+            LayerFromFile(str.C_Str(), directory_, color_data);
+        if (layer.layer < 0) {
+          continue;
+        }
+        texture.id = layer.array_id;
+        texture.layer = layer.layer;
+      } else if (residency_ != nullptr) {
+        texture.id = 0;
+        texture.residency = residency_;
+        texture.residency_handle = residency_->Register(
+            directory_ + '/' + str.C_Str(), color_data,
+            GpuResourceCategory::MODEL_TEXTURE);
+      } else if (streamer_ != nullptr) {
+        texture.streamer = streamer_;
+        texture.streaming_handle = streamer_->Register(
+            directory_ + '/' + str.C_Str(), color_data,
+            GpuResourceCategory::MODEL_TEXTURE);
+        texture.id = streamer_->TextureId(texture.streaming_handle);
+      } else {
+        texture.id = TextureFromFile(str.C_Str(), directory_, color_data);
+      }
       texture.type = type_name;
       texture.path = str.C_Str();
       textures.push_back(texture);
@@ -126,11 +382,19 @@ std::vector<Texture> Model::LoadMaterialTextures(aiMaterial* material,
   return textures;
 }
 
-unsigned int TextureFromFile(const char* path, const std::string& directory
-                             ) {
+unsigned int TextureFromFile(const char* path, const std::string& directory,
+                             bool color_data) {
   std::string filename = std::string(path);
   filename = directory + '/' + filename;
 
+  // Prefer the offline block-compressed version of the texture when present
+  const unsigned int compressed_id = LoadKtx2Texture(
+      Ktx2PathFor(filename), /*gamma_corrected=*/false,
+      GpuResourceCategory::MODEL_TEXTURE);
+  if (compressed_id != 0) {
+    return compressed_id;
+  }
+
   unsigned int texture_id;
   glGenTextures(1, &texture_id);
 
@@ -140,27 +404,27 @@ unsigned int TextureFromFile(const char* path, const std::string& directory
   unsigned char* data =
       stbi_load(filename.c_str(), &width, &height, &component_count, 0);
   if (data) {
-    GLenum format;
-    switch (component_count) {
-      case 1:
-        format = GL_RED;
-        break;
-      case 3:
-        format = GL_RGB;
-        break;
-      case 4:
-        format = GL_RGBA;
-        break;
-      default:
-        std::cerr << "Unsupported texture at path: " << path << std::endl;
-        stbi_image_free(data);
-        return texture_id;
+    if (component_count < 1 || component_count > 4) {
+      std::cerr << "Unsupported texture at path: " << path << std::endl;
+      stbi_image_free(data);
+      return texture_id;
     }
 
+    MipChainOptions options;
+    options.srgb = color_data;
+    const std::vector<MipLevel> levels =
+        BuildMipChain(data, width, height, component_count, options);
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 00, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    UploadMipChain(levels, /*srgb_storage=*/false);
+
+    const GLenum internal_format =
+        MipChainInternalFormat(component_count, /*srgb_storage=*/false);
+    GpuResources().Track(
+        GpuResourceKind::TEXTURE, texture_id,
+        {GpuResourceCategory::MODEL_TEXTURE,
+         TextureBytes(internal_format, width, height,
+                      static_cast<int>(levels.size())),
+         internal_format, filename});
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -175,3 +439,163 @@ unsigned int TextureFromFile(const char* path, const std::string& directory
   }
   return texture_id;
 }
+
+TextureLayer Model::LayerFromFile(const char* path,
+                                  const std::string& directory,
+                                  bool color_data) {
+  const std::string filename = directory + '/' + std::string(path);
+
+  // Arrays need one format for every layer, so always expand to RGBA
+  int width;
+  int height;
+  int component_count;
+  unsigned char* data = stbi_load(filename.c_str(), &width, &height,
+                                  &component_count, /*desired_channels=*/4);
+  if (!data) {
+    std::cerr << "Texture failed to load at path: " << path << std::endl;
+    return TextureLayer();
+  }
+  const TextureLayer layer =
+      texture_packer_.Add(data, width, height, color_data);
+  stbi_image_free(data);
+  return layer;
+}
+
+void Model::SetupBatches() {
+  // Concatenate every mesh into one set of buffers
+  std::vector<Vertex> vertices;
+  std::vector<unsigned int> indices;
+  std::vector<DrawElementsIndirectCommand> mesh_commands;
+  // Per mesh (diffuse, specular) layers, fetched through base_instance
+  std::vector<int> layers;
+  std::vector<std::pair<unsigned int, unsigned int>> mesh_arrays;
+  for (const auto& mesh : meshes_) {
+    DrawElementsIndirectCommand command;
+    command.count = static_cast<unsigned int>(mesh.indices.size());
+    command.instance_count = 1;
+    command.first_index = static_cast<unsigned int>(indices.size());
+    command.base_vertex = static_cast<int>(vertices.size());
+    command.base_instance = static_cast<unsigned int>(mesh_commands.size());
+    mesh_commands.push_back(command);
+
+    vertices.insert(vertices.end(), mesh.vertices.begin(),
+                    mesh.vertices.end());
+    indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+
+    std::pair<unsigned int, unsigned int> arrays;
+    layers.push_back(LayerOf(mesh, "texture_diffuse", &arrays.first));
+    layers.push_back(LayerOf(mesh, "texture_specular", &arrays.second));
+    mesh_arrays.push_back(arrays);
+  }
+
+  // Group the commands by the arrays they sample so each group is a single
+  // multi-draw
+  std::map<std::pair<unsigned int, unsigned int>, std::vector<std::size_t>>
+      groups;
+  for (std::size_t i = 0; i < mesh_commands.size(); i++) {
+    groups[mesh_arrays[i]].push_back(i);
+  }
+  std::vector<DrawElementsIndirectCommand> commands;
+  for (const auto& group : groups) {
+    DrawBatch batch;
+    batch.diffuse_array = group.first.first;
+    batch.specular_array = group.first.second;
+    batch.first_command = commands.size();
+    batch.command_count = static_cast<int>(group.second.size());
+    batches_.push_back(batch);
+    for (std::size_t mesh_index : group.second) {
+      commands.push_back(mesh_commands[mesh_index]);
+    }
+  }
+
+  glGenVertexArrays(1, &batch_vao_);
+  glGenBuffers(1, &batch_vbo_);
+  glGenBuffers(1, &batch_ebo_);
+  glGenBuffers(1, &layer_buffer_);
+  glGenBuffers(1, &indirect_buffer_);
+
+  glBindVertexArray(batch_vao_);
+
+  glBindBuffer(GL_ARRAY_BUFFER, batch_vbo_);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex),
+               vertices.data(), GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        (void*)offsetof(Vertex, normal));
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        (void*)offsetof(Vertex, tex_coords));
+
+  glBindBuffer(GL_ARRAY_BUFFER, layer_buffer_);
+  glBufferData(GL_ARRAY_BUFFER, layers.size() * sizeof(int), layers.data(),
+               GL_STATIC_DRAW);
+  glEnableVertexAttribArray(3);
+  glVertexAttribIPointer(3, 2, GL_INT, 2 * sizeof(int), (void*)0);
+  glVertexAttribDivisor(3, 1);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch_ebo_);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
+               indices.data(), GL_STATIC_DRAW);
+
+  glBindVertexArray(0);
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER,
+               commands.size() * sizeof(DrawElementsIndirectCommand),
+               commands.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  const std::string owner = "Model batch: " + directory_;
+  GpuResources().Track(GpuResourceKind::BUFFER, batch_vbo_,
+                       {GpuResourceCategory::MESH_BUFFER,
+                        vertices.size() * sizeof(Vertex), GL_NONE, owner});
+  GpuResources().Track(GpuResourceKind::BUFFER, batch_ebo_,
+                       {GpuResourceCategory::MESH_BUFFER,
+                        indices.size() * sizeof(unsigned int), GL_NONE,
+                        owner});
+  GpuResources().Track(GpuResourceKind::BUFFER, layer_buffer_,
+                       {GpuResourceCategory::BUFFER,
+                        layers.size() * sizeof(int), GL_NONE, owner});
+  GpuResources().Track(
+      GpuResourceKind::BUFFER, indirect_buffer_,
+      {GpuResourceCategory::BUFFER,
+       commands.size() * sizeof(DrawElementsIndirectCommand), GL_NONE,
+       owner});
+}
+
+void Model::DrawBatches(Shader& shader) {
+  shader.SetInt("texture_diffuse_array", 0);
+  shader.SetInt("texture_specular_array", 1);
+
+  glBindVertexArray(batch_vao_);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+  unsigned int bound_diffuse = 0;
+  unsigned int bound_specular = 0;
+  for (const auto& batch : batches_) {
+    // Only rebind when consecutive batches sample different arrays
+    if (batch.diffuse_array != bound_diffuse) {
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, batch.diffuse_array);
+      bound_diffuse = batch.diffuse_array;
+      FrameStats().texture_binds++;
+    }
+    if (batch.specular_array != bound_specular) {
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, batch.specular_array);
+      bound_specular = batch.specular_array;
+      FrameStats().texture_binds++;
+    }
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES, GL_UNSIGNED_INT,
+        (void*)(batch.first_command * sizeof(DrawElementsIndirectCommand)),
+        batch.command_count, 0);
+    FrameStats().draw_calls++;
+  }
+
+  // Always good practice to set everything back to defaults once configured
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+  glActiveTexture(GL_TEXTURE0);
+}
@@ -5,29 +5,121 @@
 #include <assimp/scene.h>
 #include <assimp/texture.h>
 
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <unordered_set>
 
+#include "animation.hpp"
+#include "bvh.hpp"
 #include "mesh.hpp"
+#include "render_queue.hpp"
 #include "shader_m.hpp"
+#include "texture_array.hpp"
+#include "texture_residency.hpp"
+#include "texture_streamer.hpp"
+
+// How a Model gets its material textures to the GPU. The default uploads
+// every texture when the model loads. At most one of the other ways may be
+// chosen.
+struct ModelOptions {
+  // Material textures of the same size are packed into GL_TEXTURE_2D_ARRAY
+  // layers and Draw() submits the whole model with one multi-draw per pair
+  // of arrays instead of binding textures per mesh. The shader then needs
+  // `sampler2DArray texture_diffuse_array` and `texture_specular_array`,
+  // and reads the mesh's (diffuse, specular) layers from an `ivec2`
+  // attribute at location 3. A missing texture has layer -1.
+  bool texture_arrays = false;
+  // Material textures are registered with the manager and loaded on first
+  // use instead of being uploaded here. It must outlive the model.
+  TextureResidencyManager* residency = nullptr;
+  // Material textures start out with their coarse mips and finer levels are
+  // streamed in as RequestTextureDetail() asks for them. It must outlive
+  // the model.
+  TextureStreamer* streamer = nullptr;
+};
 
 class Model {
  public:
-  Model(std::string path);
-  void Draw(Shader& shader);
+  // Options choosing more than one way of handling textures are rejected:
+  // the error goes to std::cerr and the model is left without meshes.
+  explicit Model(std::string path, const ModelOptions& options = {});
+  // Draw every mesh `instance_count` times. Texture array models are drawn
+  // once.
+  void Draw(Shader& shader, int instance_count = 1);
+  // Pose every skinned mesh on the CPU with one palette of
+  // GetSkeleton().BoneCount() matrices, then draw the posed meshes with a
+  // plain model shader.
+  void SkinOnCpu(const glm::mat4* palette);
+  void DrawCpuSkinned(Shader& shader);
+  // Record every mesh into `queue` with the given model matrix. Texture array
+  // models are drawn through Draw() only; enqueueing one records nothing
+  // and reports it on std::cerr the first time.
+  void Enqueue(RenderQueue& queue, Shader& shader,
+               const glm::mat4& model) const;
+  // Report the screen footprint of every mesh's streamed textures for one
+  // draw of the model this frame.
+  void RequestTextureDetail(const glm::mat4& model,
+                            const StreamingView& view) const;
   const std::vector<Mesh>& Meshes() const;
+  // Model space bounds of all meshes as (center, radius)
+  glm::vec4 BoundingSphere() const;
+  // Whether the model space `ray` hits a mesh closer than hit->distance, as
+  // TriangleBvh::Intersect(); hit->mesh is set to the mesh hit. Skinned
+  // meshes are tested in bind pose.
+  bool Raycast(const Ray& ray, RayHit* hit,
+               const BvhOptions& options = {}) const;
+  // Meshes with bones get SkinWeights; the node hierarchy and the clips
+  // animating it are kept here. Skinning is not combined with
+  // `texture_arrays`.
+  bool HasSkeleton() const;
+  const Skeleton& GetSkeleton() const;
+  const std::vector<AnimationClip>& Animations() const;
 
  private:
+  // Meshes sharing the same pair of texture arrays, drawn with one
+  // glMultiDrawElementsIndirect call.
+  struct DrawBatch {
+    unsigned int diffuse_array;
+    unsigned int specular_array;
+    std::size_t first_command;
+    int command_count;
+  };
+
   // Model data
   std::vector<Mesh> meshes_;
   std::string directory_;
   std::vector<Texture> loaded_textures_;
+  Skeleton skeleton_;
+  std::vector<AnimationClip> animations_;
+
+  // Where material textures come from; at most one is set, see
+  // ModelOptions
+  TextureResidencyManager* residency_;
+  TextureStreamer* streamer_;
+  bool texture_arrays_;
+
+  // Texture array mode: the packed layers and the batched draws over them
+  TextureArrayPacker texture_packer_;
+  std::vector<DrawBatch> batches_;
+  unsigned int batch_vao_ = 0;
+  unsigned int batch_vbo_ = 0;
+  unsigned int batch_ebo_ = 0;
+  unsigned int layer_buffer_ = 0;
+  unsigned int indirect_buffer_ = 0;
+
+  void SetupBatches();
+  void DrawBatches(Shader& shader);
 
   void LoadModel(std::string path);
+  void LoadSkeleton(const aiNode* node, int parent);
+  void LoadAnimations(const aiScene* scene);
   void ProcessNode(aiNode* node, const aiScene* scene);
   Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene);
 
+  TextureLayer LayerFromFile(const char* path, const std::string& directory,
+                             bool color_data);
+
   std::vector<Texture> LoadMaterialTextures(aiMaterial* material,
                                             aiTextureType type,
                                             std::string type_name);
@@ -0,0 +1,170 @@
+#include "occlusion_query.hpp"
+
+#include <cmath>
+
+#include "gpu_resources.hpp"
+#include "render_stats.hpp"
+
+namespace {
+
+// World space distance from the box within which the box is not trusted.
+// Larger than the samples' near plane distance.
+constexpr float kNearMargin = 0.5f;
+
+}  // namespace
+
+QueryPool::QueryPool(GLenum target) : target_(target) {}
+
+void QueryPool::BeginFrame() {
+  frame_ = (frame_ + 1) % kFramesInFlight;
+  available_count_ = 0;
+  passed_count_ = 0;
+  result_sum_ = 0;
+  for (const unsigned int query : in_flight_[frame_]) {
+    // Only poll; a result still pending after this many frames is dropped
+    unsigned int available = 0;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+      GLuint64 result = 0;
+      glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+      available_count_++;
+      passed_count_ += result != 0 ? 1 : 0;
+      result_sum_ += result;
+    }
+    free_.push_back(query);
+  }
+  in_flight_[frame_].clear();
+}
+
+unsigned int QueryPool::Acquire() {
+  unsigned int query;
+  if (free_.empty()) {
+    glGenQueries(1, &query);
+    size_++;
+  } else {
+    query = free_.back();
+    free_.pop_back();
+  }
+  in_flight_[frame_].push_back(query);
+  return query;
+}
+
+GLenum QueryPool::Target() const {
+  return target_;
+}
+
+std::size_t QueryPool::Size() const {
+  return size_;
+}
+
+unsigned int QueryPool::AvailableCount() const {
+  return available_count_;
+}
+
+unsigned int QueryPool::PassedCount() const {
+  return passed_count_;
+}
+
+std::uint64_t QueryPool::ResultSum() const {
+  return result_sum_;
+}
+
+ConditionalRenderer::ConditionalRenderer()
+    : queries_(GL_ANY_SAMPLES_PASSED_CONSERVATIVE) {
+  const float vertices[] = {
+      -1.0f, -1.0f, -1.0f,  // 0
+      1.0f,  -1.0f, -1.0f,  // 1
+      1.0f,  1.0f,  -1.0f,  // 2
+      -1.0f, 1.0f,  -1.0f,  // 3
+      -1.0f, -1.0f, 1.0f,   // 4
+      1.0f,  -1.0f, 1.0f,   // 5
+      1.0f,  1.0f,  1.0f,   // 6
+      -1.0f, 1.0f,  1.0f,   // 7
+  };
+  // Face culling is off while the box is drawn, so the winding is free
+  const unsigned int indices[] = {
+      0, 1, 2, 2, 3, 0,  // Back
+      4, 5, 6, 6, 7, 4,  // Front
+      0, 4, 7, 7, 3, 0,  // Left
+      1, 5, 6, 6, 2, 1,  // Right
+      0, 1, 5, 5, 4, 0,  // Bottom
+      3, 2, 6, 6, 7, 3,  // Top
+  };
+
+  glGenVertexArrays(1, &vao_);
+  glGenBuffers(1, &vbo_);
+  glGenBuffers(1, &ebo_);
+  glBindVertexArray(vao_);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
+               GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
+                        (void*)0);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  GpuResources().Track(GpuResourceKind::BUFFER, vbo_,
+                       {GpuResourceCategory::MESH_BUFFER, sizeof(vertices),
+                        GL_NONE, "Occlusion query box vertices"});
+  GpuResources().Track(GpuResourceKind::BUFFER, ebo_,
+                       {GpuResourceCategory::MESH_BUFFER, sizeof(indices),
+                        GL_NONE, "Occlusion query box indices"});
+}
+
+void ConditionalRenderer::BeginFrame() {
+  queries_.BeginFrame();
+}
+
+void ConditionalRenderer::Draw(Shader& box_shader, const glm::mat4& box,
+                               const glm::vec3& camera_position,
+                               const std::function<void()>& draw) {
+  // From inside the box, or close enough for the near plane to cut it, its
+  // faces can be hidden while the object in it is not
+  const glm::vec3 camera =
+      glm::vec3(glm::inverse(box) * glm::vec4(camera_position, 1.0f));
+  bool inside = true;
+  for (int axis = 0; axis < 3; axis++) {
+    const float margin = kNearMargin / glm::length(glm::vec3(box[axis]));
+    inside = inside && std::abs(camera[axis]) <= 1.0f + margin;
+  }
+  if (inside) {
+    draw();
+    return;
+  }
+
+  const unsigned int query = queries_.Acquire();
+  // The box only has to reach the depth test. The state it changes is put
+  // back as it was afterwards.
+  const GLboolean face_culling = glIsEnabled(GL_CULL_FACE);
+  GLboolean color_mask[4];
+  glGetBooleanv(GL_COLOR_WRITEMASK, color_mask);
+  GLboolean depth_mask;
+  glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_mask);
+  glDisable(GL_CULL_FACE);
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  glDepthMask(GL_FALSE);
+  box_shader.Use();
+  box_shader.SetMat4("model", box);
+  glBeginQuery(queries_.Target(), query);
+  glBindVertexArray(vao_);
+  glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+  FrameStats().draw_calls++;
+  glEndQuery(queries_.Target());
+  glBindVertexArray(0);
+  glColorMask(color_mask[0], color_mask[1], color_mask[2], color_mask[3]);
+  glDepthMask(depth_mask);
+  if (face_culling) {
+    glEnable(GL_CULL_FACE);
+  }
+
+  glBeginConditionalRender(query, GL_QUERY_NO_WAIT);
+  draw();
+  glEndConditionalRender();
+}
+
+const QueryPool& ConditionalRenderer::Queries() const {
+  return queries_;
+}
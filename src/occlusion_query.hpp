@@ -0,0 +1,90 @@
+#ifndef LEARNGL_OCCLUSION_QUERY_HPP_
+#define LEARNGL_OCCLUSION_QUERY_HPP_
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "shader_m.hpp"
+
+// Hands out query objects for one frame and takes them back a few frames
+// later, when the GPU is long done with them, so reusing a query never waits
+// on its result. Results are only ever polled, never waited for.
+class QueryPool {
+ public:
+  explicit QueryPool(GLenum target);
+
+  QueryPool(const QueryPool&) = delete;
+  QueryPool& operator=(const QueryPool&) = delete;
+
+  // Start a new frame, recycling the queries of the oldest frame in flight.
+  void BeginFrame();
+
+  // A query for `Target()` that is free until the frame is recycled
+  unsigned int Acquire();
+
+  GLenum Target() const;
+  // Query objects created so far
+  std::size_t Size() const;
+  // Of the queries recycled by the last BeginFrame(), how many had a result
+  // and how many of those counted any samples
+  unsigned int AvailableCount() const;
+  unsigned int PassedCount() const;
+  // The sum of those results, e.g. nanoseconds for GL_TIME_ELAPSED
+  std::uint64_t ResultSum() const;
+
+ private:
+  static constexpr int kFramesInFlight = 3;
+
+  GLenum target_;
+  std::vector<unsigned int> free_;
+  std::vector<unsigned int> in_flight_[kFramesInFlight];
+  int frame_ = 0;
+  std::size_t size_ = 0;
+  unsigned int available_count_ = 0;
+  unsigned int passed_count_ = 0;
+  std::uint64_t result_sum_ = 0;
+};
+
+// Skips expensive draws that are hidden. A cheap bounding box goes into a
+// GL_ANY_SAMPLES_PASSED_CONSERVATIVE query first, with color and depth
+// writes off, and the real draw runs under conditional rendering of that
+// query. The GPU drops the draw when no sample of the box passed the depth
+// test. The CPU never waits: with GL_QUERY_NO_WAIT a result that is not
+// ready yet simply lets the draw through.
+//
+// Draw the occluders first so the boxes are tested against them.
+class ConditionalRenderer {
+ public:
+  ConditionalRenderer();
+
+  ConditionalRenderer(const ConditionalRenderer&) = delete;
+  ConditionalRenderer& operator=(const ConditionalRenderer&) = delete;
+
+  // Call once per frame before any Draw().
+  void BeginFrame();
+
+  // Draw the box `box` * [-1, 1]^3 with `box_shader`, which has its view
+  // and projection set and takes the box as `model`, then run `draw` on
+  // the condition that the box was visible. `draw` must bind its own
+  // program. With the camera at `camera_position` inside or right next to
+  // the box, `draw` runs unconditionally. Face culling and the color and
+  // depth write masks are restored before `draw` runs.
+  void Draw(Shader& box_shader, const glm::mat4& box,
+            const glm::vec3& camera_position,
+            const std::function<void()>& draw);
+
+  const QueryPool& Queries() const;
+
+ private:
+  QueryPool queries_;
+  unsigned int vao_ = 0;
+  unsigned int vbo_ = 0;
+  unsigned int ebo_ = 0;
+};
+
+#endif
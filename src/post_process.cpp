@@ -0,0 +1,397 @@
+#include "post_process.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "gpu_resources.hpp"
+
+namespace {
+
+constexpr char kSceneImage[] = "scene";
+// Occupant of a pooled target nothing is in; -1 is the scene
+constexpr int kFreeTarget = -2;
+
+// One triangle covering the screen, made without vertex buffers
+constexpr char kVertexSource[] = R"(#version 330 core
+out vec2 TexCoords;
+
+void main()
+{
+  vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  TexCoords = position;
+  gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+std::string EffectFunction(int effect) {
+  return "Effect" + std::to_string(effect);
+}
+
+std::string Sampler(int image) {
+  return "image" + std::to_string(image);
+}
+
+}  // namespace
+
+PostProcessStack::PostProcessStack(int width, int height,
+                                   const PostProcessOptions& options)
+    : width_(width), height_(height), options_(options) {
+  glGenVertexArrays(1, &vao_);
+  Build({});
+}
+
+void PostProcessStack::Build(const std::vector<PostEffect>& effects) {
+  effects_ = effects;
+  const int count = static_cast<int>(effects_.size());
+
+  // Resolve the inputs to effect indices, -1 for the scene
+  const auto find = [&](const std::string& name, int before) {
+    for (int i = before - 1; i >= 0; i--) {
+      if (effects_[i].name == name) {
+        return i;
+      }
+    }
+    if (name != kSceneImage) {
+      std::cerr << "Post effect input not found: " << name << "\n";
+    }
+    return -1;
+  };
+  std::vector<std::vector<int>> inputs(count);
+  // How often each output is read as the image processed, and whether it
+  // is read as a further input
+  std::vector<int> processed_by(count, 0);
+  std::vector<bool> read_further(count, false);
+  for (int i = 0; i < count; i++) {
+    const auto& names = effects_[i].inputs;
+    inputs[i].push_back(names.empty() || names[0].empty()
+                            ? i - 1
+                            : find(names[0], i));
+    for (std::size_t j = 1; j < names.size(); j++) {
+      inputs[i].push_back(find(names[j], i));
+    }
+    if (inputs[i][0] >= 0) {
+      processed_by[inputs[i][0]]++;
+    }
+    for (std::size_t j = 1; j < inputs[i].size(); j++) {
+      if (inputs[i][j] >= 0) {
+        read_further[inputs[i][j]] = true;
+      }
+    }
+  }
+
+  // Group the effects into passes
+  passes_.clear();
+  for (int i = 0; i < count; i++) {
+    const bool neighborhood =
+        effects_[i].access == PostEffectAccess::NEIGHBORHOOD;
+    const bool joins =
+        options_.fuse && i > 0 && inputs[i][0] == i - 1 &&
+        processed_by[i - 1] == 1 && !read_further[i - 1] &&
+        (!neighborhood || passes_.back().neighborhood < 0);
+    if (!joins) {
+      passes_.emplace_back();
+    }
+    Pass& pass = passes_.back();
+    if (neighborhood) {
+      pass.neighborhood = static_cast<int>(pass.effects.size());
+    }
+    pass.effects.push_back(i);
+  }
+  if (passes_.empty()) {
+    // Copy the scene through
+    passes_.emplace_back();
+  }
+
+  // The images each pass reads, by effect index, and the last pass to read
+  // each; the scene is -1
+  std::map<int, int> last_read;
+  std::vector<std::vector<int>> pass_images(passes_.size());
+  for (std::size_t p = 0; p < passes_.size(); p++) {
+    Pass& pass = passes_[p];
+    std::vector<int>& images = pass_images[p];
+    images.push_back(pass.effects.empty() ? -1
+                                          : inputs[pass.effects[0]][0]);
+    for (const int effect : pass.effects) {
+      for (std::size_t j = 1; j < inputs[effect].size(); j++) {
+        if (std::find(images.begin(), images.end(), inputs[effect][j]) ==
+            images.end()) {
+          images.push_back(inputs[effect][j]);
+        }
+      }
+    }
+    for (const int image : images) {
+      last_read[image] = static_cast<int>(p);
+      pass.images.push_back(image < 0 ? kSceneImage : effects_[image].name);
+    }
+  }
+
+  // Assign pooled targets: a pass writes to a target no image still to be
+  // read occupies. The scene takes the first, for RunFromFramebuffer().
+  std::map<int, int> image_target = {{-1, 0}};
+  std::vector<int> occupant = {-1};
+  scene_target_ = 0;
+  for (std::size_t p = 0; p < passes_.size(); p++) {
+    Pass& pass = passes_[p];
+    for (const int image : pass_images[p]) {
+      pass.image_targets.push_back(image < 0 ? -1 : image_target[image]);
+    }
+    const bool last = p + 1 == passes_.size();
+    if (!last) {
+      const int output = pass.effects.back();
+      // Free the targets of images no pass from this one on reads; a
+      // pass never writes a target it samples
+      for (auto& image : occupant) {
+        const auto read = last_read.find(image);
+        if (image != kFreeTarget &&
+            (read == last_read.end() || read->second < static_cast<int>(p))) {
+          image = kFreeTarget;
+        }
+      }
+      auto free = std::find(occupant.begin(), occupant.end(), kFreeTarget);
+      if (free == occupant.end()) {
+        free = occupant.insert(occupant.end(), kFreeTarget);
+      }
+      *free = output;
+      pass.output_target = static_cast<int>(free - occupant.begin());
+      image_target[output] = pass.output_target;
+    }
+  }
+  target_count_ = static_cast<int>(occupant.size());
+
+  for (Shader& shader : shaders_) {
+    glDeleteProgram(shader.id());
+  }
+  shaders_.clear();
+  for (Pass& pass : passes_) {
+    pass.source = Generate(pass);
+    shaders_.push_back(Shader::FromSource(kVertexSource, pass.source));
+  }
+  for (const auto& [name, value] : floats_) {
+    SetFloat(name, value);
+  }
+}
+
+void PostProcessStack::SetFuse(bool fuse) {
+  options_.fuse = fuse;
+  Build(std::vector<PostEffect>(effects_));
+}
+
+const std::string& PostProcessStack::Body(const std::string& path) {
+  const auto found = bodies_.find(path);
+  if (found != bodies_.end()) {
+    return found->second;
+  }
+  std::ifstream file(path);
+  std::stringstream body;
+  if (file) {
+    body << file.rdbuf();
+  } else {
+    std::cerr << "Post effect file not read successfully: " << path << "\n";
+  }
+  return bodies_[path] = body.str();
+}
+
+std::string PostProcessStack::Generate(const Pass& pass) {
+  std::ostringstream out;
+  out << "#version 330 core\n"
+      << "out vec4 FragColor;\n\n"
+      << "in vec2 TexCoords;\n\n";
+  for (std::size_t i = 0; i < pass.images.size(); i++) {
+    out << "// " << pass.images[i] << "\n"
+        << "uniform sampler2D " << Sampler(static_cast<int>(i)) << ";\n";
+  }
+  out << "uniform vec2 texelSize;\n";
+  std::vector<std::string> uniforms;
+  for (const int effect : pass.effects) {
+    for (const auto& uniform : effects_[effect].uniforms) {
+      if (std::find(uniforms.begin(), uniforms.end(), uniform) ==
+          uniforms.end()) {
+        uniforms.push_back(uniform);
+        out << "uniform " << uniform << ";\n";
+      }
+    }
+  }
+
+  // The source, through the PIXEL effects ahead of a NEIGHBORHOOD effect
+  const int taps = pass.neighborhood < 0
+                       ? static_cast<int>(pass.effects.size())
+                       : pass.neighborhood;
+  for (std::size_t i = 0; i < pass.effects.size(); i++) {
+    const PostEffect& effect = effects_[pass.effects[i]];
+    const std::string function = EffectFunction(static_cast<int>(i));
+    if (static_cast<int>(i) == pass.neighborhood) {
+      out << "\nvec4 Tap(vec2 uv)\n{\n"
+          << "  vec4 color = texture(" << Sampler(0) << ", uv);\n";
+      for (int tap = 0; tap < taps; tap++) {
+        out << "  color = " << EffectFunction(tap) << "(color, uv);\n";
+      }
+      out << "  return color;\n}\n";
+    }
+    out << "\n// " << effect.name << "\n";
+    const bool neighborhood = static_cast<int>(i) == pass.neighborhood;
+    out << "vec4 " << function
+        << (neighborhood ? "(vec2 uv)\n{\n" : "(vec4 color, vec2 uv)\n{\n");
+    if (neighborhood) {
+      out << "#define Input(at) Tap(at)\n";
+    }
+    // Further inputs, by their sampler in this pass
+    const auto& names = effect.inputs;
+    for (std::size_t j = 1; j < names.size(); j++) {
+      const auto image =
+          std::find(pass.images.begin(), pass.images.end(), names[j]) -
+          pass.images.begin();
+      out << "#define Input" << j << "(at) texture("
+          << Sampler(static_cast<int>(image)) << ", at)\n";
+    }
+    out << Body(effect.source_path);
+    if (neighborhood) {
+      out << "#undef Input\n";
+    }
+    for (std::size_t j = 1; j < names.size(); j++) {
+      out << "#undef Input" << j << "\n";
+    }
+    out << "}\n";
+  }
+
+  out << "\nvoid main()\n{\n";
+  if (pass.neighborhood < 0) {
+    out << "  vec4 color = texture(" << Sampler(0) << ", TexCoords);\n";
+    for (std::size_t i = 0; i < pass.effects.size(); i++) {
+      out << "  color = " << EffectFunction(static_cast<int>(i))
+          << "(color, TexCoords);\n";
+    }
+  } else {
+    out << "  vec4 color = " << EffectFunction(pass.neighborhood)
+        << "(TexCoords);\n";
+    for (std::size_t i = pass.neighborhood + 1; i < pass.effects.size();
+         i++) {
+      out << "  color = " << EffectFunction(static_cast<int>(i))
+          << "(color, TexCoords);\n";
+    }
+  }
+  out << "  FragColor = color;\n}\n";
+  return out.str();
+}
+
+const PostProcessStack::Target& PostProcessStack::EnsureTarget(int index) {
+  while (static_cast<int>(targets_.size()) <= index) {
+    Target target;
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, options_.format, width_, height_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    GpuResources().Track(
+        GpuResourceKind::TEXTURE, target.texture,
+        {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+         TextureBytes(options_.format, width_, height_), options_.format,
+         "Post-processing target"});
+
+    glGenFramebuffers(1, &target.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, target.texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+        GL_FRAMEBUFFER_COMPLETE) {
+      std::cerr << "Unable to complete post-processing framebuffer\n";
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    targets_.push_back(target);
+  }
+  return targets_[index];
+}
+
+void PostProcessStack::Run(unsigned int scene_texture,
+                           unsigned int framebuffer) {
+  RunPasses(scene_texture, framebuffer);
+}
+
+void PostProcessStack::RunFromFramebuffer(unsigned int scene_framebuffer,
+                                          unsigned int framebuffer) {
+  const Target& scene = EnsureTarget(scene_target_);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, scene_framebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, scene.framebuffer);
+  glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_,
+                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  RunPasses(scene.texture, framebuffer);
+}
+
+void PostProcessStack::RunPasses(unsigned int scene_texture,
+                                 unsigned int framebuffer) {
+  glDisable(GL_DEPTH_TEST);
+  glBindVertexArray(vao_);
+  for (std::size_t p = 0; p < passes_.size(); p++) {
+    const Pass& pass = passes_[p];
+    glBindFramebuffer(GL_FRAMEBUFFER, pass.output_target < 0
+                                          ? framebuffer
+                                          : EnsureTarget(pass.output_target)
+                                                .framebuffer);
+    glViewport(0, 0, width_, height_);
+    shaders_[p].Use();
+    shaders_[p].SetVec2("texelSize",
+                        glm::vec2(1.0f / width_, 1.0f / height_));
+    for (std::size_t i = 0; i < pass.images.size(); i++) {
+      shaders_[p].SetInt(Sampler(static_cast<int>(i)), static_cast<int>(i));
+      glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
+      glBindTexture(GL_TEXTURE_2D,
+                    pass.image_targets[i] < 0
+                        ? scene_texture
+                        : EnsureTarget(pass.image_targets[i]).texture);
+    }
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  }
+  glBindVertexArray(0);
+  glActiveTexture(GL_TEXTURE0);
+  glEnable(GL_DEPTH_TEST);
+}
+
+void PostProcessStack::SetFloat(const std::string& name, float value) {
+  floats_[name] = value;
+  for (const Shader& shader : shaders_) {
+    shader.Use();
+    shader.SetFloat(name, value);
+  }
+}
+
+int PostProcessStack::PassCount() const {
+  return static_cast<int>(passes_.size());
+}
+
+std::size_t PostProcessStack::BytesPerRun() const {
+  const std::size_t image = TextureBytes(options_.format, width_, height_);
+  std::size_t bytes = 0;
+  for (const Pass& pass : passes_) {
+    bytes += (pass.images.size() + 1) * image;
+  }
+  return bytes;
+}
+
+void PostProcessStack::Describe(std::ostream& out, bool with_source) const {
+  for (std::size_t p = 0; p < passes_.size(); p++) {
+    const Pass& pass = passes_[p];
+    out << "Pass " << p + 1 << ":";
+    for (std::size_t i = 0; i < pass.effects.size(); i++) {
+      out << (i == 0 ? " " : ", ") << effects_[pass.effects[i]].name;
+      if (static_cast<int>(i) < pass.neighborhood) {
+        out << " (per tap)";
+      }
+    }
+    out << " reading";
+    for (const auto& image : pass.images) {
+      out << " " << image;
+    }
+    if (pass.output_target < 0) {
+      out << ", writing the result\n";
+    } else {
+      out << ", writing target " << pass.output_target << "\n";
+    }
+    if (with_source) {
+      out << pass.source << "\n";
+    }
+  }
+}
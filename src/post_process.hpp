@@ -0,0 +1,146 @@
+#ifndef LEARNGL_POST_PROCESS_HPP_
+#define LEARNGL_POST_PROCESS_HPP_
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "shader_m.hpp"
+
+// How an effect reads the image it processes
+enum class PostEffectAccess {
+  // Only the texel at its own pixel
+  PIXEL,
+  // Texels around its pixel
+  NEIGHBORHOOD,
+};
+
+// One step of a PostProcessStack. The body is plain GLSL from a file; the
+// stack wraps it into a function and strings the functions of several
+// effects together into one fragment shader where it can.
+struct PostEffect {
+  // Later effects read the effect's output by this name
+  std::string name;
+  PostEffectAccess access = PostEffectAccess::PIXEL;
+  // The function body. Both kinds are given `vec2 uv`, the position of
+  // their pixel. PIXEL effects are also given `vec4 color`, their input
+  // there; NEIGHBORHOOD effects read their input at any point with
+  // `Input(uv)`. Both return the output color, and may read further inputs
+  // with `Input1(uv)`, `Input2(uv)` and so on, and use `texelSize`, the
+  // size of one pixel in texture coordinates.
+  std::string source_path;
+  // The images read: "scene", the stack's input, or an earlier effect's
+  // name. The first is the one processed; empty means the previous
+  // effect's output.
+  std::vector<std::string> inputs;
+  // Uniforms the body uses, e.g. "float exposure". Declared once per pass
+  // whatever the number of effects sharing them; set with SetFloat().
+  std::vector<std::string> uniforms;
+};
+
+struct PostProcessOptions {
+  // Format of the intermediate targets
+  GLenum format = GL_RGBA16F;
+  // Fuse effects into as few passes as possible. Off, every effect is a
+  // pass of its own, for comparison.
+  bool fuse = true;
+};
+
+// Runs a chain of effects over an image in fullscreen passes. At Build()
+// the effects are grouped into passes and a fragment shader is generated
+// for each group, so effects only go through memory where they must:
+//
+//  - A PIXEL effect whose input is the previous effect's output, read by
+//    nothing else, runs in the same pass as that effect.
+//  - A NEIGHBORHOOD effect needs its input at several points. When that
+//    input comes from a pass with no NEIGHBORHOOD effect yet, the pass's
+//    PIXEL effects are applied to every texel the effect fetches, trading
+//    arithmetic for a round trip through memory.
+//  - Anything else, e.g. an output read by several effects or as a
+//    further input, is written to a target.
+//
+// So a chain of PIXEL effects around at most one NEIGHBORHOOD effect costs
+// one read and one write of the image. The intermediate targets are pooled:
+// a target is reused as soon as the last pass reading it has run, so a
+// linear chain ping-pongs between two.
+class PostProcessStack {
+ public:
+  // Process images of `width` x `height`.
+  PostProcessStack(int width, int height,
+                   const PostProcessOptions& options = {});
+
+  PostProcessStack(const PostProcessStack&) = delete;
+  PostProcessStack& operator=(const PostProcessStack&) = delete;
+
+  // Plan the passes for `effects`, in order, and compile their shaders.
+  // The last effect's output is the stack's result.
+  void Build(const std::vector<PostEffect>& effects);
+  void SetFuse(bool fuse);
+
+  // Run the effects on `scene_texture` and write the result to
+  // `framebuffer`. With no effects the scene is copied through.
+  void Run(unsigned int scene_texture, unsigned int framebuffer);
+  // Resolve or copy the color of `scene_framebuffer`, e.g. a multisampled
+  // one, into a pooled target first, then Run() on it. The framebuffer's
+  // color format must match the options' format.
+  void RunFromFramebuffer(unsigned int scene_framebuffer,
+                          unsigned int framebuffer);
+
+  // Set a uniform of every pass that declares it.
+  void SetFloat(const std::string& name, float value);
+
+  int PassCount() const;
+  // Bytes read from and written to textures per run, counting each texel
+  // once per pass
+  std::size_t BytesPerRun() const;
+  // The passes, their effects and their generated shaders
+  void Describe(std::ostream& out, bool with_source = false) const;
+
+ private:
+  struct Pass {
+    // Indices into effects_; all but at most one NEIGHBORHOOD effect are
+    // PIXEL effects
+    std::vector<int> effects;
+    // Position within `effects` of the NEIGHBORHOOD effect, or -1
+    int neighborhood = -1;
+    // Images sampled, each on the texture unit of its position
+    std::vector<std::string> images;
+    // Pooled target of each image, -1 for the scene
+    std::vector<int> image_targets;
+    // Target written, -1 for the stack's result
+    int output_target = -1;
+    std::string source;
+  };
+  struct Target {
+    unsigned int texture;
+    unsigned int framebuffer;
+  };
+
+  int width_;
+  int height_;
+  PostProcessOptions options_;
+  std::vector<PostEffect> effects_;
+  // Effect bodies by path, read once
+  std::map<std::string, std::string> bodies_;
+  std::vector<Pass> passes_;
+  // One per pass
+  std::vector<Shader> shaders_;
+  // Created the first time a pass needs them
+  std::vector<Target> targets_;
+  int target_count_ = 0;
+  // The target the scene is resolved into by RunFromFramebuffer()
+  int scene_target_ = 0;
+  std::map<std::string, float> floats_;
+  unsigned int vao_ = 0;
+
+  const std::string& Body(const std::string& path);
+  std::string Generate(const Pass& pass);
+  const Target& EnsureTarget(int index);
+  void RunPasses(unsigned int scene_texture, unsigned int framebuffer);
+};
+
+#endif
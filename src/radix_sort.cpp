@@ -0,0 +1,54 @@
+#include "radix_sort.hpp"
+
+#include <cstddef>
+#include <utility>
+
+namespace {
+
+constexpr int kRadixBits = 8;
+constexpr int kBucketCount = 1 << kRadixBits;
+constexpr int kPassCount = 64 / kRadixBits;
+
+}  // namespace
+
+void RadixSort(std::vector<SortItem>* items, std::vector<SortItem>* scratch) {
+  const std::size_t count = items->size();
+  if (count < 2) {
+    return;
+  }
+  scratch->resize(count);
+
+  // Histogram every byte in a single read of the keys
+  std::size_t histograms[kPassCount][kBucketCount] = {};
+  for (const SortItem& item : *items) {
+    for (int pass = 0; pass < kPassCount; pass++) {
+      histograms[pass][(item.key >> (pass * kRadixBits)) & 0xff]++;
+    }
+  }
+
+  std::vector<SortItem>* source = items;
+  std::vector<SortItem>* target = scratch;
+  for (int pass = 0; pass < kPassCount; pass++) {
+    std::size_t* histogram = histograms[pass];
+    const int shift = pass * kRadixBits;
+    // All keys share this byte, the pass would not move anything
+    if (histogram[((*source)[0].key >> shift) & 0xff] == count) {
+      continue;
+    }
+
+    std::size_t offset = 0;
+    for (int bucket = 0; bucket < kBucketCount; bucket++) {
+      const std::size_t bucket_size = histogram[bucket];
+      histogram[bucket] = offset;
+      offset += bucket_size;
+    }
+    for (const SortItem& item : *source) {
+      (*target)[histogram[(item.key >> shift) & 0xff]++] = item;
+    }
+    std::swap(source, target);
+  }
+
+  if (source != items) {
+    items->swap(*source);
+  }
+}
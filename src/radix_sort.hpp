@@ -0,0 +1,19 @@
+#ifndef LEARNGL_RADIX_SORT_HPP_
+#define LEARNGL_RADIX_SORT_HPP_
+
+#include <cstdint>
+#include <vector>
+
+// A sort key and the index of the item it belongs to.
+struct SortItem {
+  std::uint64_t key;
+  std::uint32_t index;
+};
+
+// Stable LSD radix sort on the full 64-bit key, one byte per pass. Passes
+// where every key shares the same byte are skipped, so narrow keys only pay
+// for the bytes they use. `scratch` is resized as needed and can be reused
+// across calls to avoid reallocating.
+void RadixSort(std::vector<SortItem>* items, std::vector<SortItem>* scratch);
+
+#endif
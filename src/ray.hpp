@@ -0,0 +1,13 @@
+#ifndef LEARNGL_RAY_HPP_
+#define LEARNGL_RAY_HPP_
+
+#include <glm/glm.hpp>
+
+// The points origin + t * direction for t > 0. The direction need not be
+// unit length; hit distances are in multiples of it.
+struct Ray {
+  glm::vec3 origin;
+  glm::vec3 direction;
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+
+#include "render_stats.hpp"
+
+namespace {
+
+// Opaque key, most significant first:
+//   [63] 0 | [62:51] program | [50:35] material | [34:11] depth
+// Transparent key:
+//   [63] 1 | [62:39] inverted depth | [38:27] program | [26:11] material
+constexpr int kProgramBits = 12;
+constexpr int kMaterialBits = 16;
+constexpr int kDepthBits = 24;
+constexpr std::uint64_t kTransparentBit = std::uint64_t{1} << 63;
+constexpr std::uint64_t kDepthMax = (std::uint64_t{1} << kDepthBits) - 1;
+
+std::uint64_t QuantizeDepth(float distance, float far_plane) {
+  const float normalized = std::clamp(distance / far_plane, 0.0f, 1.0f);
+  return static_cast<std::uint64_t>(normalized * kDepthMax);
+}
+
+// Hashes the textures only; materials differing in samplers alone are
+// rare and still told apart by operator==
+std::size_t MaterialHash(const RenderMaterial& material) {
+  std::uint64_t hash = static_cast<std::uint64_t>(material.texture_count);
+  for (int i = 0; i < material.texture_count; i++) {
+    hash = (hash ^ material.textures[i]) * 0x9e3779b97f4a7c15u;
+  }
+  return static_cast<std::size_t>(hash ^ hash >> 32);
+}
+
+}  // namespace
+
+bool operator==(const RenderMaterial& a, const RenderMaterial& b) {
+  if (a.texture_count != b.texture_count) {
+    return false;
+  }
+  for (int i = 0; i < a.texture_count; i++) {
+    if (a.textures[i] != b.textures[i] || a.samplers[i] != b.samplers[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RenderQueue::Begin(const glm::vec3& camera_position, float far_plane) {
+  camera_position_ = camera_position;
+  far_plane_ = far_plane;
+  packets_.clear();
+  keys_.clear();
+  programs_.clear();
+  ClearMaterials();
+}
+
+void RenderQueue::Add(Shader& shader, const RenderMaterial& material,
+                      unsigned int vao, GLsizei index_count,
+                      const glm::mat4& model, const glm::vec3& center,
+                      bool transparent) {
+  const std::uint64_t program = ProgramIndex(shader.id());
+  const std::uint64_t material_index = MaterialIndex(material);
+  const std::uint64_t depth =
+      QuantizeDepth(glm::length(center - camera_position_), far_plane_);
+
+  std::uint64_t key;
+  if (transparent) {
+    key = kTransparentBit | (kDepthMax - depth) << 39 | program << 27 |
+          material_index << 11;
+  } else {
+    key = program << 51 | material_index << 35 | depth << 11;
+  }
+
+  keys_.push_back({key, static_cast<std::uint32_t>(packets_.size())});
+  packets_.push_back({&shader, &material, vao, index_count, model});
+}
+
+void RenderQueue::Submit() {
+  RadixSort(&keys_, &scratch_);
+
+  RenderStats& stats = FrameStats();
+  unsigned int bound_program = 0;
+  const RenderMaterial* bound_material = nullptr;
+  unsigned int bound_vao = 0;
+  unsigned int bound_textures[kMaxMaterialTextures] = {};
+  for (const SortItem& item : keys_) {
+    const DrawPacket& packet = packets_[item.index];
+    const bool program_changed = packet.shader->id() != bound_program;
+    if (program_changed) {
+      packet.shader->Use();
+      bound_program = packet.shader->id();
+      stats.program_binds++;
+    }
+
+    // Equal materials recorded by different meshes share an index, so only
+    // compare contents when the pointer changes
+    const RenderMaterial& material = *packet.material;
+    const bool material_changed =
+        bound_material == nullptr ||
+        (bound_material != &material && !(*bound_material == material));
+    if (program_changed || material_changed) {
+      for (int unit = 0; unit < material.texture_count; unit++) {
+        if (bound_textures[unit] != material.textures[unit]) {
+          glActiveTexture(GL_TEXTURE0 + unit);
+          glBindTexture(GL_TEXTURE_2D, material.textures[unit]);
+          bound_textures[unit] = material.textures[unit];
+          stats.texture_binds++;
+        }
+        packet.shader->SetInt(material.samplers[unit], unit);
+      }
+      bound_material = &material;
+    }
+
+    if (packet.vao != bound_vao) {
+      glBindVertexArray(packet.vao);
+      bound_vao = packet.vao;
+    }
+    packet.shader->SetMat4("model", packet.model);
+    glDrawElements(GL_TRIANGLES, packet.index_count, GL_UNSIGNED_INT, 0);
+    stats.draw_calls++;
+  }
+
+  // Always good practice to set everything back to defaults once configured
+  glBindVertexArray(0);
+  glActiveTexture(GL_TEXTURE0);
+
+  packets_.clear();
+  keys_.clear();
+  programs_.clear();
+  ClearMaterials();
+}
+
+std::size_t RenderQueue::size() const { return packets_.size(); }
+
+std::uint64_t RenderQueue::ProgramIndex(unsigned int program) {
+  auto it = std::find(programs_.begin(), programs_.end(), program);
+  if (it == programs_.end()) {
+    it = programs_.insert(programs_.end(), program);
+  }
+  // Past the key's range, programs share the last index and simply sort
+  // together
+  return std::min<std::uint64_t>(it - programs_.begin(),
+                                 (1 << kProgramBits) - 1);
+}
+
+std::uint64_t RenderQueue::MaterialIndex(const RenderMaterial& material) {
+  if (material_table_.size() < 2 * (materials_.size() + 1)) {
+    // Grow and reinsert; only happens when a frame has more materials than
+    // any before
+    material_table_.assign(std::max<std::size_t>(material_table_.size() * 2,
+                                                 64),
+                           -1);
+    const std::size_t mask = material_table_.size() - 1;
+    for (std::size_t i = 0; i < materials_.size(); i++) {
+      std::size_t slot = MaterialHash(*materials_[i]) & mask;
+      while (material_table_[slot] >= 0) {
+        slot = (slot + 1) & mask;
+      }
+      material_table_[slot] = static_cast<int>(i);
+    }
+  }
+
+  const std::size_t mask = material_table_.size() - 1;
+  std::size_t slot = MaterialHash(material) & mask;
+  std::size_t index;
+  while (true) {
+    const int found = material_table_[slot];
+    if (found < 0) {
+      index = materials_.size();
+      material_table_[slot] = static_cast<int>(index);
+      materials_.push_back(&material);
+      break;
+    }
+    if (materials_[found] == &material || *materials_[found] == material) {
+      index = static_cast<std::size_t>(found);
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return std::min<std::uint64_t>(index, (1 << kMaterialBits) - 1);
+}
+
+void RenderQueue::ClearMaterials() {
+  materials_.clear();
+  std::fill(material_table_.begin(), material_table_.end(), -1);
+}
@@ -0,0 +1,80 @@
+#ifndef LEARNGL_RENDER_QUEUE_HPP_
+#define LEARNGL_RENDER_QUEUE_HPP_
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "radix_sort.hpp"
+#include "shader_m.hpp"
+
+constexpr int kMaxMaterialTextures = 4;
+
+// GL_TEXTURE_2D textures bound to consecutive units starting at GL_TEXTURE0,
+// and the sampler uniform that reads each of them.
+struct RenderMaterial {
+  int texture_count = 0;
+  unsigned int textures[kMaxMaterialTextures] = {};
+  std::string samplers[kMaxMaterialTextures];
+};
+
+bool operator==(const RenderMaterial& a, const RenderMaterial& b);
+
+// Collects indexed draws for a frame and submits them sorted to minimize
+// state changes. Opaque packets go first, grouped by program, then material,
+// then front to back for early depth rejection. Transparent packets follow
+// back to front. Blend state for the transparent part is up to the caller.
+//
+// Packets only reference shaders and materials, which must stay alive until
+// Submit(). The packet and key storage is reused from frame to frame, so
+// recording does not allocate once the queue has seen its largest frame.
+class RenderQueue {
+ public:
+  // Start recording a frame. Depth is quantized over [0, far_plane] from
+  // `camera_position`.
+  void Begin(const glm::vec3& camera_position, float far_plane);
+
+  // Record glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT) of
+  // `vao`. `model` is set as the shader's `model` uniform, `center` is the
+  // world space point used for depth sorting.
+  void Add(Shader& shader, const RenderMaterial& material, unsigned int vao,
+           GLsizei index_count, const glm::mat4& model,
+           const glm::vec3& center, bool transparent = false);
+
+  // Sort and issue every recorded packet, then clear the queue.
+  void Submit();
+
+  std::size_t size() const;
+
+ private:
+  struct DrawPacket {
+    Shader* shader;
+    const RenderMaterial* material;
+    unsigned int vao;
+    GLsizei index_count;
+    glm::mat4 model;
+  };
+
+  glm::vec3 camera_position_ = glm::vec3(0.0f);
+  float far_plane_ = 100.0f;
+
+  std::vector<DrawPacket> packets_;
+  std::vector<SortItem> keys_;
+  std::vector<SortItem> scratch_;
+  // Small per-frame ids for the sort key, indexed by first appearance
+  std::vector<unsigned int> programs_;
+  std::vector<const RenderMaterial*> materials_;
+  // Open addressing table of indices into materials_ by content, -1 for an
+  // empty slot. Its size is a power of two at least twice the material
+  // count, so probes stay short.
+  std::vector<int> material_table_;
+
+  std::uint64_t ProgramIndex(unsigned int program);
+  std::uint64_t MaterialIndex(const RenderMaterial& material);
+  void ClearMaterials();
+};
+
+#endif
@@ -0,0 +1,8 @@
+#include "render_stats.hpp"
+
+RenderStats& FrameStats() {
+  static RenderStats stats;
+  return stats;
+}
+
+void ResetFrameStats() { FrameStats() = RenderStats(); }
@@ -0,0 +1,15 @@
+#ifndef LEARNGL_RENDER_STATS_HPP_
+#define LEARNGL_RENDER_STATS_HPP_
+
+// Counters for the work submitted to OpenGL during one frame. Mesh and Model
+// update them as they draw; samples reset them at the start of every frame.
+struct RenderStats {
+  unsigned int draw_calls = 0;
+  unsigned int program_binds = 0;
+  unsigned int texture_binds = 0;
+};
+
+RenderStats& FrameStats();
+void ResetFrameStats();
+
+#endif
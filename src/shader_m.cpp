@@ -12,11 +12,15 @@ void Shader::Init(const char *vertex_path, const char *fragment_path,
   const auto geometry = geometry_path != nullptr
                             ? CompileShader(GL_GEOMETRY_SHADER, geometry_path)
                             : 0;
+  Link(vertex, fragment, geometry);
+}
 
+void Shader::Link(unsigned int vertex, unsigned int fragment,
+                  unsigned int geometry) {
   id_ = glCreateProgram();
   glAttachShader(id_, vertex);
   glAttachShader(id_, fragment);
-  if (geometry_path != nullptr) {
+  if (geometry != 0) {
     glAttachShader(id_, geometry);
   }
   glLinkProgram(id_);
@@ -31,7 +35,7 @@ void Shader::Init(const char *vertex_path, const char *fragment_path,
 
   glDeleteShader(vertex);
   glDeleteShader(fragment);
-  if (geometry_path != nullptr) {
+  if (geometry != 0) {
     glDeleteShader(geometry);
   }
 }
@@ -45,6 +49,32 @@ Shader::Shader(const char *vertex_path, const char *fragment_path,
   Init(vertex_path, fragment_path, geometry_path);
 }
 
+Shader::Shader(const char *compute_path) {
+  const auto compute = CompileShader(GL_COMPUTE_SHADER, compute_path);
+
+  id_ = glCreateProgram();
+  glAttachShader(id_, compute);
+  glLinkProgram(id_);
+
+  int success;
+  glGetProgramiv(id_, GL_LINK_STATUS, &success);
+  if (!success) {
+    char info_log[512];
+    glGetProgramInfoLog(id_, 512, nullptr, info_log);
+    std::cerr << "Program compilation failed:\n" << info_log << "\n";
+  }
+
+  glDeleteShader(compute);
+}
+
+Shader Shader::FromSource(const std::string &vertex_source,
+                          const std::string &fragment_source) {
+  Shader shader;
+  shader.Link(CompileSource(GL_VERTEX_SHADER, vertex_source),
+              CompileSource(GL_FRAGMENT_SHADER, fragment_source), 0);
+  return shader;
+}
+
 unsigned int Shader::CompileShader(GLenum shader_type, const char *path) {
   std::ifstream shader_file;
   shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
@@ -62,8 +92,12 @@ unsigned int Shader::CompileShader(GLenum shader_type, const char *path) {
     std::cerr << "Shader file not read successfully\n";
     return 0;
   }
+  return CompileSource(shader_type, shader_content);
+}
 
-  const char *shader_content_c = shader_content.c_str();
+unsigned int Shader::CompileSource(GLenum shader_type,
+                                   const std::string &source) {
+  const char *shader_content_c = source.c_str();
 
   unsigned int shader = glCreateShader(shader_type);
   glShaderSource(shader, 1, &shader_content_c, nullptr);
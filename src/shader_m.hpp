@@ -5,11 +5,18 @@
 
 #include <glm/glm.hpp>
 #include <iostream>
+#include <string>
 
 class Shader {
  public:
   Shader(const char* vertex_path, const char* fragment_path);
   Shader(const char* vertex_path, const char* fragment_path, const char* geometry_path);
+  // A compute-only program
+  explicit Shader(const char* compute_path);
+  // A program built from GLSL source rather than files, e.g. generated
+  // at run time
+  static Shader FromSource(const std::string& vertex_source,
+                           const std::string& fragment_source);
   unsigned int id() { return id_; }
   void Use() const;
 
@@ -27,9 +34,14 @@ class Shader {
   void SetMat4(const std::string& name, const glm::mat4& value) const;
 
  private:
+  Shader() = default;
   void Init(const char* vertex_path, const char* fragment_path, const char* geometry_path);
+  // Link the compiled stages into id_ and delete them. `geometry` may be 0.
+  void Link(unsigned int vertex, unsigned int fragment, unsigned int geometry);
   unsigned int id_;
   unsigned int CompileShader(GLenum shader_type, const char* path);
+  static unsigned int CompileSource(GLenum shader_type,
+                                    const std::string& source);
 };
 
 #endif
@@ -0,0 +1,113 @@
+#include "skinning.hpp"
+
+#include <glad/glad.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "gpu_resources.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+// Vertices per parallel task
+constexpr std::size_t kVerticesPerTask = 4096;
+
+void SkinRange(const Vertex* vertices, const SkinWeights* weights,
+               const glm::mat4* palette, Vertex* skinned, std::size_t begin,
+               std::size_t end) {
+  for (std::size_t i = begin; i < end; i++) {
+    const Vertex& vertex = vertices[i];
+    const SkinWeights& skin = weights[i];
+    Vertex& out = skinned[i];
+    out.tex_coords = vertex.tex_coords;
+#if defined(__AVX__)
+    // The blended matrix as columns (0, 1) and (2, 3) in two registers
+    __m256 columns01 = _mm256_setzero_ps();
+    __m256 columns23 = _mm256_setzero_ps();
+    for (int k = 0; k < kMaxBoneInfluences; k++) {
+      if (skin.weights[k] == 0) {
+        continue;
+      }
+      const __m256 weight = _mm256_set1_ps(skin.weights[k] / 255.0f);
+      const float* matrix = glm::value_ptr(palette[skin.bones[k]]);
+      columns01 = _mm256_add_ps(
+          columns01, _mm256_mul_ps(weight, _mm256_loadu_ps(matrix)));
+      columns23 = _mm256_add_ps(
+          columns23, _mm256_mul_ps(weight, _mm256_loadu_ps(matrix + 8)));
+    }
+    const __m128 column0 = _mm256_castps256_ps128(columns01);
+    const __m128 column1 = _mm256_extractf128_ps(columns01, 1);
+    const __m128 column2 = _mm256_castps256_ps128(columns23);
+    const __m128 column3 = _mm256_extractf128_ps(columns23, 1);
+
+    const __m128 linear = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(vertex.position.x)),
+                   _mm_mul_ps(column1, _mm_set1_ps(vertex.position.y))),
+        _mm_mul_ps(column2, _mm_set1_ps(vertex.position.z)));
+    const __m128 normal = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(vertex.normal.x)),
+                   _mm_mul_ps(column1, _mm_set1_ps(vertex.normal.y))),
+        _mm_mul_ps(column2, _mm_set1_ps(vertex.normal.z)));
+    float position_values[4];
+    float normal_values[4];
+    _mm_storeu_ps(position_values, _mm_add_ps(linear, column3));
+    _mm_storeu_ps(normal_values, normal);
+    out.position = glm::vec3(position_values[0], position_values[1],
+                             position_values[2]);
+    out.normal =
+        glm::vec3(normal_values[0], normal_values[1], normal_values[2]);
+#else
+    glm::mat4 matrix(0.0f);
+    for (int k = 0; k < kMaxBoneInfluences; k++) {
+      if (skin.weights[k] != 0) {
+        matrix += palette[skin.bones[k]] * (skin.weights[k] / 255.0f);
+      }
+    }
+    out.position = glm::vec3(matrix * glm::vec4(vertex.position, 1.0f));
+    out.normal = glm::vec3(matrix * glm::vec4(vertex.normal, 0.0f));
+#endif
+    // Blending rotations shortens the normal
+    const float length = glm::length(out.normal);
+    if (length > 0.0f) {
+      out.normal /= length;
+    }
+  }
+}
+
+}  // namespace
+
+void SkinVertices(const std::vector<Vertex>& vertices,
+                  const std::vector<SkinWeights>& weights,
+                  const glm::mat4* palette, std::vector<Vertex>* skinned) {
+  skinned->resize(vertices.size());
+  SharedThreadPool().ParallelFor(
+      vertices.size(), kVerticesPerTask,
+      [&](std::size_t begin, std::size_t end) {
+        SkinRange(vertices.data(), weights.data(), palette, skinned->data(),
+                  begin, end);
+      });
+}
+
+PaletteBuffer::PaletteBuffer(unsigned int binding) : binding_(binding) {
+  glGenBuffers(1, &buffer_);
+}
+
+void PaletteBuffer::Upload(const std::vector<glm::mat4>& matrices) {
+  const std::size_t bytes = matrices.size() * sizeof(glm::mat4);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer_);
+  if (bytes > capacity_bytes_) {
+    capacity_bytes_ = bytes;
+    GpuResources().Track(GpuResourceKind::BUFFER, buffer_,
+                         {GpuResourceCategory::BUFFER, capacity_bytes_,
+                          GL_NONE, "Bone palettes"});
+  }
+  glBufferData(GL_SHADER_STORAGE_BUFFER, capacity_bytes_, nullptr,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, matrices.data());
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding_, buffer_);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
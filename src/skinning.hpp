@@ -0,0 +1,42 @@
+#ifndef LEARNGL_SKINNING_HPP_
+#define LEARNGL_SKINNING_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "animation.hpp"
+#include "mesh.hpp"
+
+// Skin `vertices` on the CPU into `skinned`: blend each vertex's palette
+// matrices by weight and transform its position and normal. Texture
+// coordinates are copied. Vectorized with AVX when compiled with it, and
+// split across SharedThreadPool() for large meshes. For the shadow pass or
+// GPUs that cannot fit palettes into shader storage.
+void SkinVertices(const std::vector<Vertex>& vertices,
+                  const std::vector<SkinWeights>& weights,
+                  const glm::mat4* palette, std::vector<Vertex>* skinned);
+
+// One shader storage buffer holding the matrices of every animated character
+// drawn in a frame, so hundreds of palettes cost a single upload and the
+// characters can be drawn instanced.
+class PaletteBuffer {
+ public:
+  explicit PaletteBuffer(unsigned int binding);
+
+  PaletteBuffer(const PaletteBuffer&) = delete;
+  PaletteBuffer& operator=(const PaletteBuffer&) = delete;
+
+  // Replace the contents and bind the buffer to its binding point. The old
+  // storage is orphaned so the upload does not wait for draws still reading
+  // the previous frame's matrices.
+  void Upload(const std::vector<glm::mat4>& matrices);
+
+ private:
+  unsigned int binding_;
+  unsigned int buffer_ = 0;
+  std::size_t capacity_bytes_ = 0;
+};
+
+#endif
@@ -0,0 +1,343 @@
+#include "software_occlusion.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "thread_pool.hpp"
+
+namespace {
+
+constexpr int kTileSize = 32;
+
+// Keeps far off-screen coordinates in range before converting them to int
+int ClampToPixel(float value, int size) {
+  return static_cast<int>(
+      std::clamp(value, -1.0f, static_cast<float>(size)));
+}
+
+}  // namespace
+
+OccluderMesh MakeOccluderSphere(const glm::vec4& sphere, int rings,
+                                int segments) {
+  const float pi = glm::pi<float>();
+  OccluderMesh mesh;
+  for (int ring = 0; ring <= rings; ring++) {
+    const float phi = pi * ring / rings;
+    for (int segment = 0; segment <= segments; segment++) {
+      const float theta = 2.0f * pi * segment / segments;
+      mesh.positions.push_back(
+          glm::vec3(sphere) +
+          sphere.w * glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi),
+                               std::sin(phi) * std::sin(theta)));
+    }
+  }
+  const auto vertex = [segments](int ring, int segment) {
+    return static_cast<unsigned int>(ring * (segments + 1) + segment);
+  };
+  for (int ring = 0; ring < rings; ring++) {
+    for (int segment = 0; segment < segments; segment++) {
+      // The quads touching the poles collapse into one triangle
+      if (ring > 0) {
+        mesh.indices.insert(mesh.indices.end(),
+                            {vertex(ring, segment), vertex(ring, segment + 1),
+                             vertex(ring + 1, segment)});
+      }
+      if (ring < rings - 1) {
+        mesh.indices.insert(
+            mesh.indices.end(),
+            {vertex(ring, segment + 1), vertex(ring + 1, segment + 1),
+             vertex(ring + 1, segment)});
+      }
+    }
+  }
+  return mesh;
+}
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : width_(width),
+      height_(height),
+      tiles_x_((width + kTileSize - 1) / kTileSize),
+      tiles_y_((height + kTileSize - 1) / kTileSize),
+      depth_(static_cast<std::size_t>(width) * height, 1.0f),
+      tile_triangles_(static_cast<std::size_t>(tiles_x_) * tiles_y_) {}
+
+void OcclusionBuffer::Begin(const glm::mat4& view_projection) {
+  view_projection_ = view_projection;
+  std::fill(depth_.begin(), depth_.end(), 1.0f);
+  occluders_.clear();
+}
+
+void OcclusionBuffer::AddOccluder(const OccluderMesh& mesh,
+                                  const glm::mat4& model) {
+  occluders_.push_back({&mesh, model});
+}
+
+void OcclusionBuffer::Rasterize(const OcclusionOptions& options) {
+  const auto start = std::chrono::steady_clock::now();
+  SetupTriangles();
+
+  for (auto& tile : tile_triangles_) {
+    tile.clear();
+  }
+  for (std::size_t i = 0; i < triangles_.size(); i++) {
+    const ScreenTriangle& triangle = triangles_[i];
+    for (int y = triangle.min_y / kTileSize; y <= triangle.max_y / kTileSize;
+         y++) {
+      for (int x = triangle.min_x / kTileSize;
+           x <= triangle.max_x / kTileSize; x++) {
+        tile_triangles_[y * tiles_x_ + x].push_back(
+            static_cast<std::uint32_t>(i));
+      }
+    }
+  }
+
+  const auto rasterize_tiles = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t tile = begin; tile < end; tile++) {
+      RasterizeTile(static_cast<int>(tile), options.simd);
+    }
+  };
+  if (options.parallel) {
+    SharedThreadPool().ParallelFor(tile_triangles_.size(), 1,
+                                   rasterize_tiles);
+  } else {
+    rasterize_tiles(0, tile_triangles_.size());
+  }
+
+  const std::chrono::duration<float, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  raster_time_ = elapsed.count();
+}
+
+std::future<void> OcclusionBuffer::RasterizeAsync(
+    const OcclusionOptions& options) {
+  return SharedThreadPool().Submit([this, options]() { Rasterize(options); });
+}
+
+void OcclusionBuffer::SetupTriangles() {
+  triangles_.clear();
+  std::vector<glm::vec3> screen;
+  std::vector<bool> in_front;
+  for (const auto& occluder : occluders_) {
+    const glm::mat4 transform = view_projection_ * occluder.model;
+    const auto& positions = occluder.mesh->positions;
+    screen.resize(positions.size());
+    in_front.resize(positions.size());
+    for (std::size_t i = 0; i < positions.size(); i++) {
+      const glm::vec4 clip = transform * glm::vec4(positions[i], 1.0f);
+      in_front[i] = clip.w > 0.0f && clip.z >= -clip.w;
+      if (in_front[i]) {
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * width_,
+                              (ndc.y * 0.5f + 0.5f) * height_,
+                              ndc.z * 0.5f + 0.5f);
+      }
+    }
+
+    const auto& indices = occluder.mesh->indices;
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+      const unsigned int corners[3] = {indices[i], indices[i + 1],
+                                       indices[i + 2]};
+      // Triangles crossing the near plane are dropped rather than clipped.
+      // Missing an occluder only makes the culling less effective.
+      if (!in_front[corners[0]] || !in_front[corners[1]] ||
+          !in_front[corners[2]]) {
+        continue;
+      }
+      const glm::vec3 v[3] = {screen[corners[0]], screen[corners[1]],
+                              screen[corners[2]]};
+      // Back facing or degenerate
+      const float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+                         (v[2].x - v[0].x) * (v[1].y - v[0].y);
+      if (area <= 0.0f) {
+        continue;
+      }
+
+      ScreenTriangle triangle;
+      const float min_x = std::min({v[0].x, v[1].x, v[2].x});
+      const float max_x = std::max({v[0].x, v[1].x, v[2].x});
+      const float min_y = std::min({v[0].y, v[1].y, v[2].y});
+      const float max_y = std::max({v[0].y, v[1].y, v[2].y});
+      triangle.min_x =
+          std::max(ClampToPixel(std::ceil(min_x - 0.5f), width_), 0);
+      triangle.max_x =
+          std::min(ClampToPixel(std::floor(max_x - 0.5f), width_), width_ - 1);
+      triangle.min_y =
+          std::max(ClampToPixel(std::ceil(min_y - 0.5f), height_), 0);
+      triangle.max_y = std::min(
+          ClampToPixel(std::floor(max_y - 0.5f), height_), height_ - 1);
+      if (triangle.min_x > triangle.max_x ||
+          triangle.min_y > triangle.max_y) {
+        continue;
+      }
+
+      // Edge i runs between the other two vertices and is positive on the
+      // side of vertex i. Divided by the area, the edge functions are the
+      // barycentric weights, which interpolate the depth.
+      triangle.depth_a = 0.0f;
+      triangle.depth_b = 0.0f;
+      triangle.depth_c = 0.0f;
+      for (int e = 0; e < 3; e++) {
+        const glm::vec3& a = v[(e + 1) % 3];
+        const glm::vec3& b = v[(e + 2) % 3];
+        triangle.edge_a[e] = a.y - b.y;
+        triangle.edge_b[e] = b.x - a.x;
+        triangle.edge_c[e] =
+            -(triangle.edge_a[e] * a.x + triangle.edge_b[e] * a.y);
+        triangle.depth_a += triangle.edge_a[e] * v[e].z / area;
+        triangle.depth_b += triangle.edge_b[e] * v[e].z / area;
+        triangle.depth_c += triangle.edge_c[e] * v[e].z / area;
+      }
+      triangles_.push_back(triangle);
+    }
+  }
+}
+
+void OcclusionBuffer::RasterizeTile(int tile, bool simd) {
+  const int tile_min_x = (tile % tiles_x_) * kTileSize;
+  const int tile_min_y = (tile / tiles_x_) * kTileSize;
+  const int tile_max_x = std::min(tile_min_x + kTileSize, width_) - 1;
+  const int tile_max_y = std::min(tile_min_y + kTileSize, height_) - 1;
+
+  for (const std::uint32_t index : tile_triangles_[tile]) {
+    const ScreenTriangle& triangle = triangles_[index];
+    const int min_x = std::max(triangle.min_x, tile_min_x);
+    const int max_x = std::min(triangle.max_x, tile_max_x);
+    const int min_y = std::max(triangle.min_y, tile_min_y);
+    const int max_y = std::min(triangle.max_y, tile_max_y);
+
+    for (int y = min_y; y <= max_y; y++) {
+      const float center_y = y + 0.5f;
+      float row_edge[3];
+      for (int e = 0; e < 3; e++) {
+        row_edge[e] = triangle.edge_b[e] * center_y + triangle.edge_c[e];
+      }
+      const float row_depth =
+          triangle.depth_b * center_y + triangle.depth_c;
+      float* row = depth_.data() + static_cast<std::size_t>(y) * width_;
+
+      int x = min_x;
+#if defined(__AVX__)
+      // Only whole groups of 8 inside the tile; the pixels past it belong
+      // to another thread
+      if (simd) {
+        const __m256 lane_centers = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f,
+                                                   4.5f, 5.5f, 6.5f, 7.5f);
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 edge_a[3];
+        __m256 edge_row[3];
+        for (int e = 0; e < 3; e++) {
+          edge_a[e] = _mm256_set1_ps(triangle.edge_a[e]);
+          edge_row[e] = _mm256_set1_ps(row_edge[e]);
+        }
+        const __m256 depth_a = _mm256_set1_ps(triangle.depth_a);
+        const __m256 depth_row = _mm256_set1_ps(row_depth);
+        for (; x + 8 <= max_x + 1; x += 8) {
+          const __m256 center_x =
+              _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)),
+                            lane_centers);
+          __m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+          for (int e = 0; e < 3; e++) {
+            const __m256 edge = _mm256_add_ps(
+                _mm256_mul_ps(edge_a[e], center_x), edge_row[e]);
+            inside = _mm256_and_ps(inside,
+                                   _mm256_cmp_ps(edge, zero, _CMP_GE_OQ));
+          }
+          const __m256 depth =
+              _mm256_add_ps(_mm256_mul_ps(depth_a, center_x), depth_row);
+          const __m256 old_depth = _mm256_loadu_ps(row + x);
+          const __m256 closer = _mm256_and_ps(
+              inside, _mm256_cmp_ps(depth, old_depth, _CMP_LT_OQ));
+          _mm256_storeu_ps(row + x,
+                           _mm256_blendv_ps(old_depth, depth, closer));
+        }
+      }
+#else
+      (void)simd;
+#endif
+      for (; x <= max_x; x++) {
+        const float center_x = x + 0.5f;
+        if (triangle.edge_a[0] * center_x + row_edge[0] >= 0.0f &&
+            triangle.edge_a[1] * center_x + row_edge[1] >= 0.0f &&
+            triangle.edge_a[2] * center_x + row_edge[2] >= 0.0f) {
+          const float depth = triangle.depth_a * center_x + row_depth;
+          row[x] = std::min(row[x], depth);
+        }
+      }
+    }
+  }
+}
+
+bool OcclusionBuffer::SphereVisible(const glm::vec4& sphere) const {
+  // Project the corners of the sphere's box to a screen rectangle and the
+  // nearest depth of the box
+  float min_x = std::numeric_limits<float>::max();
+  float min_y = std::numeric_limits<float>::max();
+  float max_x = std::numeric_limits<float>::lowest();
+  float max_y = std::numeric_limits<float>::lowest();
+  float nearest = std::numeric_limits<float>::max();
+  for (int corner = 0; corner < 8; corner++) {
+    const glm::vec3 offset(corner & 1 ? sphere.w : -sphere.w,
+                           corner & 2 ? sphere.w : -sphere.w,
+                           corner & 4 ? sphere.w : -sphere.w);
+    const glm::vec4 clip =
+        view_projection_ * glm::vec4(glm::vec3(sphere) + offset, 1.0f);
+    if (clip.w <= 0.0f) {
+      return true;
+    }
+    const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    min_x = std::min(min_x, (ndc.x * 0.5f + 0.5f) * width_);
+    max_x = std::max(max_x, (ndc.x * 0.5f + 0.5f) * width_);
+    min_y = std::min(min_y, (ndc.y * 0.5f + 0.5f) * height_);
+    max_y = std::max(max_y, (ndc.y * 0.5f + 0.5f) * height_);
+    nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+  }
+
+  // Every pixel the rectangle touches must hold an occluder in front
+  const int first_x = std::max(ClampToPixel(std::floor(min_x), width_), 0);
+  const int last_x =
+      std::min(ClampToPixel(std::floor(max_x), width_), width_ - 1);
+  const int first_y = std::max(ClampToPixel(std::floor(min_y), height_), 0);
+  const int last_y =
+      std::min(ClampToPixel(std::floor(max_y), height_), height_ - 1);
+  if (first_x > last_x || first_y > last_y) {
+    // Off screen, which is for the frustum test to decide
+    return true;
+  }
+  for (int y = first_y; y <= last_y; y++) {
+    const float* row = depth_.data() + static_cast<std::size_t>(y) * width_;
+    for (int x = first_x; x <= last_x; x++) {
+      if (nearest < row[x]) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+float OcclusionBuffer::PixelSize(const glm::vec3& position) const {
+  // A pixel spans 2 / width of NDC x. Clip x changes by the length of the
+  // first row's xyz per world unit moved along the camera's right axis.
+  const float w = (view_projection_ * glm::vec4(position, 1.0f)).w;
+  const glm::vec3 row_x(view_projection_[0][0], view_projection_[1][0],
+                        view_projection_[2][0]);
+  const glm::vec3 row_y(view_projection_[0][1], view_projection_[1][1],
+                        view_projection_[2][1]);
+  return std::max(2.0f * w / (width_ * glm::length(row_x)),
+                  2.0f * w / (height_ * glm::length(row_y)));
+}
+
+float OcclusionBuffer::RasterTime() const {
+  return raster_time_;
+}
+
+std::size_t OcclusionBuffer::TriangleCount() const {
+  return triangles_.size();
+}
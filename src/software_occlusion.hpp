@@ -0,0 +1,112 @@
+#ifndef LEARNGL_SOFTWARE_OCCLUSION_HPP_
+#define LEARNGL_SOFTWARE_OCCLUSION_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+// The triangles of a simplified occluder in model space, counter-clockwise
+// when seen from outside. An occluder must fit inside the geometry it stands
+// in for, or it hides things that are visible. OcclusionBuffer covers every
+// pixel whose center an occluder covers, so the occluder also has to stay at
+// least OcclusionBuffer::PixelSize() inside that geometry's outline.
+struct OccluderMesh {
+  std::vector<glm::vec3> positions;
+  std::vector<unsigned int> indices;
+};
+
+// A UV sphere of `rings` x `segments` quads with its vertices on the sphere
+// (center, radius), so every face lies inside it.
+OccluderMesh MakeOccluderSphere(const glm::vec4& sphere, int rings,
+                                int segments);
+
+struct OcclusionOptions {
+  // Rasterize 8 pixels (AVX) per iteration instead of one at a time
+  bool simd = true;
+  // Rasterize the tiles across SharedThreadPool()
+  bool parallel = true;
+};
+
+// A small depth buffer rasterized on the CPU from a few large occluders, so
+// objects can be tested for occlusion before any draw is issued and without
+// waiting for the GPU.
+//
+// Triangles are set up once, binned into 32 x 32 pixel tiles and rasterized
+// tile by tile. Every tile is written by one thread only. Depths are window
+// space like the depth buffer, with 1 the far plane, and the buffer is
+// stored bottom row first.
+class OcclusionBuffer {
+ public:
+  explicit OcclusionBuffer(int width = 256, int height = 128);
+
+  // Clear the buffer and the occluders and set the camera for the frame.
+  void Begin(const glm::mat4& view_projection);
+
+  // Queue `mesh`, placed by `model`, to be rasterized. The mesh must stay
+  // alive until Rasterize() returns.
+  void AddOccluder(const OccluderMesh& mesh, const glm::mat4& model);
+
+  // Rasterize the queued occluders.
+  void Rasterize(const OcclusionOptions& options = {});
+
+  // Rasterize() on a SharedThreadPool() worker, so it overlaps with work on
+  // the calling thread. The buffer must not be used until the returned
+  // future is ready.
+  std::future<void> RasterizeAsync(const OcclusionOptions& options = {});
+
+  // Whether any part of the sphere (center, radius) may be in front of the
+  // occluders. Spheres reaching behind the camera are always visible.
+  bool SphereVisible(const glm::vec4& sphere) const;
+
+  // World space size of one pixel at `position` for the camera of the
+  // current frame, the larger of its width and height.
+  float PixelSize(const glm::vec3& position) const;
+
+  // Milliseconds the last Rasterize() took, set up and binning included
+  float RasterTime() const;
+  // Occluder triangles that faced the camera in the last Rasterize()
+  std::size_t TriangleCount() const;
+
+ private:
+  struct Occluder {
+    const OccluderMesh* mesh;
+    glm::mat4 model;
+  };
+
+  // Edge functions and depth plane of a triangle in pixel coordinates: at
+  // pixel center (x, y), edge i is edge_a[i] * x + edge_b[i] * y +
+  // edge_c[i], all three non-negative inside, and the depth is
+  // depth_a * x + depth_b * y + depth_c.
+  struct ScreenTriangle {
+    float edge_a[3];
+    float edge_b[3];
+    float edge_c[3];
+    float depth_a;
+    float depth_b;
+    float depth_c;
+    // Pixels whose centers the bounding box covers, inclusive
+    int min_x;
+    int min_y;
+    int max_x;
+    int max_y;
+  };
+
+  int width_;
+  int height_;
+  int tiles_x_;
+  int tiles_y_;
+  glm::mat4 view_projection_ = glm::mat4(1.0f);
+  std::vector<float> depth_;
+  std::vector<Occluder> occluders_;
+  std::vector<ScreenTriangle> triangles_;
+  std::vector<std::vector<std::uint32_t>> tile_triangles_;
+  float raster_time_ = 0.0f;
+
+  void SetupTriangles();
+  void RasterizeTile(int tile, bool simd);
+};
+
+#endif
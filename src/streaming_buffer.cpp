@@ -0,0 +1,73 @@
+#include "streaming_buffer.hpp"
+
+#include <chrono>
+
+#include "gpu_resources.hpp"
+
+namespace {
+
+constexpr GLbitfield kMapFlags =
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+}  // namespace
+
+StreamingBuffer::StreamingBuffer(std::size_t region_bytes,
+                                 const std::string& owner)
+    : region_bytes_(region_bytes) {
+  const std::size_t bytes = region_bytes_ * kRegionCount;
+  glGenBuffers(1, &id_);
+  glBindBuffer(GL_ARRAY_BUFFER, id_);
+  glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, kMapFlags);
+  mapping_ = static_cast<char*>(
+      glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, kMapFlags));
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  GpuResources().Track(GpuResourceKind::BUFFER, id_,
+                       {GpuResourceCategory::BUFFER, bytes, GL_NONE, owner});
+}
+
+void* StreamingBuffer::BeginFrame() {
+  region_ = (region_ + 1) % kRegionCount;
+  wait_time_ = 0.0f;
+  GLsync& fence = fences_[region_];
+  if (fence != nullptr) {
+    const auto start = std::chrono::steady_clock::now();
+    // The flush makes sure the fence is submitted, otherwise the wait could
+    // never end. Loop rather than trust a single timeout.
+    GLenum result = GL_TIMEOUT_EXPIRED;
+    while (result == GL_TIMEOUT_EXPIRED) {
+      result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                1000000000);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+    const std::chrono::duration<float, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    wait_time_ = elapsed.count();
+  }
+  return mapping_ + RegionOffset();
+}
+
+void StreamingBuffer::EndFrame() {
+  fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+unsigned int StreamingBuffer::Id() const {
+  return id_;
+}
+
+int StreamingBuffer::Region() const {
+  return region_;
+}
+
+std::size_t StreamingBuffer::RegionOffset() const {
+  return region_ * region_bytes_;
+}
+
+std::size_t StreamingBuffer::RegionBytes() const {
+  return region_bytes_;
+}
+
+float StreamingBuffer::WaitTime() const {
+  return wait_time_;
+}
@@ -0,0 +1,51 @@
+#ifndef LEARNGL_STREAMING_BUFFER_HPP_
+#define LEARNGL_STREAMING_BUFFER_HPP_
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <string>
+
+// A buffer the CPU rewrites every frame without stalling the GPU or
+// re-uploading. The storage is split into `kRegionCount` regions and
+// mapped once, persistently and coherently, for the lifetime of the buffer.
+// Each frame the CPU writes the next region while the GPU may still be
+// reading the previous two; a fence placed after the frame's last draw
+// guards the region against being overwritten before the GPU is done.
+//
+// The mapping is write-combined on most drivers: write it sequentially and
+// never read from it.
+class StreamingBuffer {
+ public:
+  static constexpr int kRegionCount = 3;
+
+  // `region_bytes` per region; `owner` names the buffer in GpuResources().
+  StreamingBuffer(std::size_t region_bytes, const std::string& owner);
+
+  StreamingBuffer(const StreamingBuffer&) = delete;
+  StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+  // Move on to the next region, waiting for the GPU to release it if it has
+  // not already, and return its mapped memory.
+  void* BeginFrame();
+  // Fence the current region. Call after the last draw that reads it.
+  void EndFrame();
+
+  unsigned int Id() const;
+  // The current region, to offset attribute or instance ranges by
+  int Region() const;
+  std::size_t RegionOffset() const;
+  std::size_t RegionBytes() const;
+  // Time the last BeginFrame() spent waiting on its fence
+  float WaitTime() const;
+
+ private:
+  unsigned int id_ = 0;
+  std::size_t region_bytes_;
+  char* mapping_ = nullptr;
+  GLsync fences_[kRegionCount] = {};
+  int region_ = kRegionCount - 1;
+  float wait_time_ = 0.0f;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "texture_array.hpp"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "mip_builder.hpp"
+
+TextureArrayPacker::TextureArrayPacker(GpuResourceCategory category)
+    : category_(category) {}
+
+TextureLayer TextureArrayPacker::Add(const unsigned char* rgba, int width,
+                                     int height, bool srgb) {
+  Array* target = nullptr;
+  for (auto& array : arrays_) {
+    if (!array.uploaded && array.width == width && array.height == height) {
+      target = &array;
+      break;
+    }
+  }
+  if (target == nullptr) {
+    Array array{0, width, height, false, {}};
+    glGenTextures(1, &array.id);
+    arrays_.push_back(std::move(array));
+    target = &arrays_.back();
+  }
+
+  PendingImage image;
+  image.pixels.assign(rgba,
+                      rgba + static_cast<std::size_t>(width) * height * 4);
+  image.srgb = srgb;
+  target->images.push_back(std::move(image));
+
+  TextureLayer result;
+  result.array_id = target->id;
+  result.layer = static_cast<int>(target->images.size()) - 1;
+  return result;
+}
+
+void TextureArrayPacker::Upload() {
+  for (auto& array : arrays_) {
+    if (array.uploaded) {
+      continue;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.id);
+    int level_count = 0;
+    for (std::size_t layer = 0; layer < array.images.size(); layer++) {
+      PendingImage& image = array.images[layer];
+      MipChainOptions options;
+      options.srgb = image.srgb;
+      const std::vector<MipLevel> levels = BuildMipChain(
+          image.pixels.data(), array.width, array.height, 4, options);
+      if (layer == 0) {
+        level_count = static_cast<int>(levels.size());
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY,
+                       static_cast<GLsizei>(levels.size()), GL_RGBA8,
+                       array.width, array.height,
+                       static_cast<GLsizei>(array.images.size()));
+      }
+      for (std::size_t level = 0; level < levels.size(); level++) {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), 0, 0,
+                        static_cast<GLint>(layer), levels[level].width,
+                        levels[level].height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                        levels[level].pixels.data());
+      }
+      // Release the source as soon as it is on the GPU
+      std::vector<unsigned char>().swap(image.pixels);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    array.uploaded = true;
+
+    GpuResources().Track(
+        GpuResourceKind::TEXTURE, array.id,
+        {category_,
+         TextureBytes(GL_RGBA8, array.width, array.height, level_count,
+                      static_cast<int>(array.images.size())),
+         GL_RGBA8,
+         "Texture array " + std::to_string(array.width) + "x" +
+             std::to_string(array.height)});
+  }
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+std::vector<unsigned int> TextureArrayPacker::ArrayIds() const {
+  std::vector<unsigned int> ids;
+  for (const auto& array : arrays_) {
+    ids.push_back(array.id);
+  }
+  return ids;
+}
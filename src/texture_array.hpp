@@ -0,0 +1,55 @@
+#ifndef LEARNGL_TEXTURE_ARRAY_HPP_
+#define LEARNGL_TEXTURE_ARRAY_HPP_
+
+#include <glad/glad.h>
+
+#include <vector>
+
+#include "gpu_resources.hpp"
+
+// One layer of a GL_TEXTURE_2D_ARRAY.
+struct TextureLayer {
+  unsigned int array_id = 0;
+  int layer = -1;
+};
+
+// Packs same-sized images into GL_TEXTURE_2D_ARRAY textures so meshes with
+// different materials can be drawn with the same bindings, selecting their
+// textures by layer. Array names are reserved by Add() so callers can keep the
+// returned layers right away; storage and mip chains are created by Upload().
+class TextureArrayPacker {
+ public:
+  // Storage is accounted under `category` in GpuResources().
+  explicit TextureArrayPacker(
+      GpuResourceCategory category = GpuResourceCategory::TEXTURE);
+
+  // `rgba` is copied. `srgb` filters the color channels in linear space when
+  // building mips; storage is always GL_RGBA8.
+  TextureLayer Add(const unsigned char* rgba, int width, int height,
+                   bool srgb);
+
+  // Allocate and fill every array created since the last call. Leaves
+  // GL_TEXTURE_2D_ARRAY unbound.
+  void Upload();
+
+  std::vector<unsigned int> ArrayIds() const;
+
+ private:
+  struct PendingImage {
+    std::vector<unsigned char> pixels;
+    bool srgb;
+  };
+
+  struct Array {
+    unsigned int id;
+    int width;
+    int height;
+    bool uploaded;
+    std::vector<PendingImage> images;
+  };
+
+  GpuResourceCategory category_;
+  std::vector<Array> arrays_;
+};
+
+#endif
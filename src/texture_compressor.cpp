@@ -0,0 +1,207 @@
+// Offline texture compressor. Decodes PNG/JPEG images, builds the full mip
+// chain and writes it block-compressed into a KTX2 container that
+// LoadKtx2Texture can upload without any decoding or mip generation.
+//
+// Usage:
+//   texture_compressor [options] <input> <output.ktx2>
+//   texture_compressor [options] --cubemap <output.ktx2> <+x> <-x> <+y> <-y>
+//                      <+z> <-z>
+//
+// Options:
+//   --format bc1|bc3|bc5|bc7  Block format (default: bc1 for opaque images,
+//                             bc3 for images with alpha)
+//   --srgb                    Treat color data as sRGB
+//   --flip                    Flip the image vertically (matches
+//                             stbi_set_flip_vertically_on_load(true))
+//   --no-mips                 Only write the base level
+//   --alpha-coverage          Preserve alpha tested coverage (cutoff 0.5) in
+//                             every mip level
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bc_encoder.hpp"
+#include "ktx2_texture.hpp"
+#include "mip_builder.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_include.hpp"
+
+namespace {
+
+struct Options {
+  bool has_format = false;
+  BlockFormat format = BlockFormat::BC1;
+  bool srgb = false;
+  bool flip = false;
+  bool mips = true;
+  bool alpha_coverage = false;
+  bool cubemap = false;
+  std::vector<std::string> paths;
+};
+
+struct RgbaImage {
+  int width = 0;
+  int height = 0;
+  bool has_alpha = false;
+  std::vector<unsigned char> pixels;
+};
+
+bool LoadImage(const std::string& path, bool flip, RgbaImage* image) {
+  stbi_set_flip_vertically_on_load(flip);
+  int component_count;
+  unsigned char* data =
+      stbi_load(path.c_str(), &image->width, &image->height, &component_count,
+                /*desired_channels=*/4);
+  if (!data) {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    return false;
+  }
+  image->has_alpha = component_count == 2 || component_count == 4;
+  image->pixels.assign(data, data + image->width * image->height * 4);
+  stbi_image_free(data);
+  return true;
+}
+
+std::uint32_t VkFormatFor(BlockFormat format, bool srgb) {
+  switch (format) {
+    case BlockFormat::BC1:
+      return srgb ? kVkFormatBc1RgbSrgb : kVkFormatBc1RgbUnorm;
+    case BlockFormat::BC3:
+      return srgb ? kVkFormatBc3Srgb : kVkFormatBc3Unorm;
+    case BlockFormat::BC5:
+      return kVkFormatBc5Unorm;
+    case BlockFormat::BC7:
+      return srgb ? kVkFormatBc7Srgb : kVkFormatBc7Unorm;
+  }
+  return 0;
+}
+
+bool ParseArguments(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; i++) {
+    const std::string argument = argv[i];
+    if (argument == "--format" && i + 1 < argc) {
+      const std::string format = argv[++i];
+      options->has_format = true;
+      if (format == "bc1") {
+        options->format = BlockFormat::BC1;
+      } else if (format == "bc3") {
+        options->format = BlockFormat::BC3;
+      } else if (format == "bc5") {
+        options->format = BlockFormat::BC5;
+      } else if (format == "bc7") {
+        options->format = BlockFormat::BC7;
+      } else {
+        std::cerr << "Unknown format: " << format << "\n";
+        return false;
+      }
+    } else if (argument == "--srgb") {
+      options->srgb = true;
+    } else if (argument == "--flip") {
+      options->flip = true;
+    } else if (argument == "--no-mips") {
+      options->mips = false;
+    } else if (argument == "--alpha-coverage") {
+      options->alpha_coverage = true;
+    } else if (argument == "--cubemap") {
+      options->cubemap = true;
+    } else {
+      options->paths.push_back(argument);
+    }
+  }
+  const std::size_t expected_paths = options->cubemap ? 7 : 2;
+  return options->paths.size() == expected_paths;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseArguments(argc, argv, &options)) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--format bc1|bc3|bc5|bc7] [--srgb] [--flip] [--no-mips]"
+                 " [--alpha-coverage] <input> <output.ktx2>\n"
+              << "       " << argv[0]
+              << " [options] --cubemap <output.ktx2> <+x> <-x> <+y> <-y> <+z>"
+                 " <-z>\n";
+    return 1;
+  }
+
+  std::string output_path;
+  std::vector<std::string> input_paths;
+  if (options.cubemap) {
+    output_path = options.paths[0];
+    input_paths.assign(options.paths.begin() + 1, options.paths.end());
+  } else {
+    input_paths.push_back(options.paths[0]);
+    output_path = options.paths[1];
+  }
+
+  MipChainOptions mip_options;
+  mip_options.srgb = options.srgb;
+  mip_options.preserve_alpha_coverage = options.alpha_coverage;
+
+  // Build every face's full mip chain first so the faces can be interleaved
+  // per level, as KTX2 expects.
+  bool has_alpha = false;
+  std::vector<std::vector<MipLevel>> face_chains;
+  for (const auto& path : input_paths) {
+    RgbaImage base;
+    if (!LoadImage(path, options.flip, &base)) {
+      return 1;
+    }
+    if (!face_chains.empty() && (base.width != face_chains[0][0].width ||
+                                 base.height != face_chains[0][0].height)) {
+      std::cerr << "Cubemap faces must share dimensions: " << path << "\n";
+      return 1;
+    }
+    has_alpha = has_alpha || base.has_alpha;
+    if (options.mips) {
+      face_chains.push_back(BuildMipChain(base.pixels.data(), base.width,
+                                          base.height, 4, mip_options));
+    } else {
+      face_chains.push_back(
+          {MipLevel{base.width, base.height, 4, std::move(base.pixels)}});
+    }
+  }
+
+  if (!options.has_format) {
+    options.format = has_alpha ? BlockFormat::BC3 : BlockFormat::BC1;
+  }
+
+  Ktx2Image image;
+  image.vk_format = VkFormatFor(options.format, options.srgb);
+  image.width = face_chains[0][0].width;
+  image.height = face_chains[0][0].height;
+  image.face_count = static_cast<std::uint32_t>(face_chains.size());
+  image.levels.resize(face_chains[0].size());
+
+  std::size_t uncompressed_size = 0;
+  for (std::size_t level = 0; level < image.levels.size(); level++) {
+    for (const auto& chain : face_chains) {
+      const MipLevel& mip = chain[level];
+      const auto blocks = CompressImage(mip.pixels.data(), mip.width,
+                                        mip.height, options.format);
+      image.levels[level].insert(image.levels[level].end(), blocks.begin(),
+                                 blocks.end());
+      uncompressed_size += mip.pixels.size();
+    }
+  }
+
+  if (!WriteKtx2(output_path, image)) {
+    return 1;
+  }
+
+  std::size_t compressed_size = 0;
+  for (const auto& level : image.levels) {
+    compressed_size += level.size();
+  }
+  std::cout << output_path << ": " << image.width << "x" << image.height
+            << ", " << image.levels.size() << " levels, "
+            << uncompressed_size / 1024 << " KiB -> "
+            << compressed_size / 1024 << " KiB\n";
+  return 0;
+}
@@ -0,0 +1,265 @@
+#include "texture_residency.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "stb_include.hpp"
+
+namespace {
+
+// Textures are never trimmed below this size; smaller ones are evicted whole
+constexpr int kMinTrimmedSize = 64;
+
+std::size_t ChainBytes(const std::vector<MipLevel>& levels) {
+  std::size_t bytes = 0;
+  for (const auto& level : levels) {
+    bytes += level.pixels.size();
+  }
+  return bytes;
+}
+
+void SetSamplingParameters() {
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+}  // namespace
+
+TextureResidencyManager::TextureResidencyManager(std::size_t budget_bytes,
+                                                 std::size_t cache_bytes)
+    : budget_bytes_(budget_bytes), cache_budget_bytes_(cache_bytes) {}
+
+TextureResidencyManager::~TextureResidencyManager() {
+  for (auto& entry : entries_) {
+    ReleaseTexture(entry);
+  }
+}
+
+TextureResidencyManager::Handle TextureResidencyManager::Register(
+    const std::string& path, bool color_data, GpuResourceCategory category) {
+  const auto existing = handles_by_path_.find(path);
+  if (existing != handles_by_path_.end()) {
+    return existing->second;
+  }
+  Entry entry;
+  entry.path = path;
+  entry.color_data = color_data;
+  entry.category = category;
+  const auto handle = static_cast<Handle>(entries_.size());
+  entries_.push_back(std::move(entry));
+  handles_by_path_[path] = handle;
+  return handle;
+}
+
+unsigned int TextureResidencyManager::Acquire(Handle handle) {
+  Entry& entry = entries_[handle];
+  entry.last_used_frame = frame_;
+  if (entry.texture_id != 0 && entry.first_level == 0) {
+    stats_.hits++;
+    return entry.texture_id;
+  }
+  stats_.misses++;
+  if (!Restore(entry)) {
+    return 0;
+  }
+  return entry.texture_id;
+}
+
+void TextureResidencyManager::EndFrame() {
+  if (resident_bytes_ > budget_bytes_) {
+    // Only textures that were not needed this frame are candidates
+    std::vector<Entry*> candidates;
+    for (auto& entry : entries_) {
+      if (entry.texture_id != 0 && entry.last_used_frame < frame_) {
+        candidates.push_back(&entry);
+      }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Entry* a, const Entry* b) {
+                return a->last_used_frame < b->last_used_frame;
+              });
+
+    // Trim one level at a time across all candidates so the reduction is
+    // spread over the stale set before anything is evicted outright
+    bool trimmed = true;
+    while (resident_bytes_ > budget_bytes_ && trimmed) {
+      trimmed = false;
+      for (Entry* entry : candidates) {
+        if (resident_bytes_ <= budget_bytes_) {
+          break;
+        }
+        if (CanDropTopLevel(*entry)) {
+          DropTopLevel(*entry);
+          trimmed = true;
+        }
+      }
+    }
+    for (Entry* entry : candidates) {
+      if (resident_bytes_ <= budget_bytes_) {
+        break;
+      }
+      Evict(*entry);
+    }
+  }
+  TrimCache();
+  frame_++;
+}
+
+void TextureResidencyManager::SetBudget(std::size_t budget_bytes) {
+  budget_bytes_ = budget_bytes;
+}
+
+std::size_t TextureResidencyManager::Budget() const { return budget_bytes_; }
+
+std::size_t TextureResidencyManager::ResidentBytes() const {
+  return resident_bytes_;
+}
+
+std::size_t TextureResidencyManager::CachedBytes() const {
+  return cached_bytes_;
+}
+
+const ResidencyStats& TextureResidencyManager::Stats() const {
+  return stats_;
+}
+
+bool TextureResidencyManager::Restore(Entry& entry) {
+  if (entry.cached_levels.empty()) {
+    int width;
+    int height;
+    int component_count;
+    unsigned char* data = stbi_load(entry.path.c_str(), &width, &height,
+                                    &component_count, 0);
+    if (!data) {
+      std::cerr << "Texture failed to load at path: " << entry.path << "\n";
+      return false;
+    }
+    MipChainOptions options;
+    options.srgb = entry.color_data;
+    entry.cached_levels =
+        BuildMipChain(data, width, height, component_count, options);
+    stbi_image_free(data);
+    entry.cached_bytes = ChainBytes(entry.cached_levels);
+    cached_bytes_ += entry.cached_bytes;
+    stats_.disk_loads++;
+  } else {
+    stats_.cache_loads++;
+  }
+  Upload(entry, entry.cached_levels);
+  return true;
+}
+
+void TextureResidencyManager::Upload(Entry& entry,
+                                     const std::vector<MipLevel>& levels) {
+  ReleaseTexture(entry);
+
+  entry.level_count = static_cast<int>(levels.size());
+  entry.channels = levels[0].channels;
+  entry.level_sizes.clear();
+  for (const auto& level : levels) {
+    entry.level_sizes.emplace_back(level.width, level.height);
+  }
+
+  glGenTextures(1, &entry.texture_id);
+  glBindTexture(GL_TEXTURE_2D, entry.texture_id);
+  UploadMipChain(levels, /*srgb_storage=*/false);
+  SetSamplingParameters();
+
+  const GLenum internal_format =
+      MipChainInternalFormat(entry.channels, /*srgb_storage=*/false);
+  entry.first_level = 0;
+  entry.resident_bytes = TextureBytes(internal_format, levels[0].width,
+                                      levels[0].height, entry.level_count);
+  resident_bytes_ += entry.resident_bytes;
+  GpuResources().Track(GpuResourceKind::TEXTURE, entry.texture_id,
+                       {entry.category, entry.resident_bytes,
+                        internal_format, entry.path});
+}
+
+bool TextureResidencyManager::CanDropTopLevel(const Entry& entry) const {
+  const int next = entry.first_level + 1;
+  if (next >= entry.level_count) {
+    return false;
+  }
+  const auto& size = entry.level_sizes[next];
+  return std::max(size.first, size.second) >= kMinTrimmedSize;
+}
+
+void TextureResidencyManager::DropTopLevel(Entry& entry) {
+  // Immutable storage cannot shrink in place, so copy the remaining levels
+  // into a smaller texture on the GPU
+  const int first_level = entry.first_level + 1;
+  const int level_count = entry.level_count - first_level;
+  const auto& base_size = entry.level_sizes[first_level];
+  const GLenum internal_format =
+      MipChainInternalFormat(entry.channels, /*srgb_storage=*/false);
+
+  unsigned int texture_id;
+  glGenTextures(1, &texture_id);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  glTexStorage2D(GL_TEXTURE_2D, level_count, internal_format,
+                 base_size.first, base_size.second);
+  SetSamplingParameters();
+  for (int level = 0; level < level_count; level++) {
+    const auto& size = entry.level_sizes[first_level + level];
+    glCopyImageSubData(entry.texture_id, GL_TEXTURE_2D, level + 1, 0, 0, 0,
+                       texture_id, GL_TEXTURE_2D, level, 0, 0, 0, size.first,
+                       size.second, 1);
+  }
+
+  ReleaseTexture(entry);
+  entry.texture_id = texture_id;
+  entry.first_level = first_level;
+  entry.resident_bytes = TextureBytes(internal_format, base_size.first,
+                                      base_size.second, level_count);
+  resident_bytes_ += entry.resident_bytes;
+  GpuResources().Track(GpuResourceKind::TEXTURE, entry.texture_id,
+                       {entry.category, entry.resident_bytes,
+                        internal_format, entry.path});
+  stats_.mip_evictions++;
+}
+
+void TextureResidencyManager::Evict(Entry& entry) {
+  ReleaseTexture(entry);
+  stats_.evictions++;
+}
+
+void TextureResidencyManager::ReleaseTexture(Entry& entry) {
+  if (entry.texture_id == 0) {
+    return;
+  }
+  GpuResources().Release(GpuResourceKind::TEXTURE, entry.texture_id);
+  glDeleteTextures(1, &entry.texture_id);
+  resident_bytes_ -= entry.resident_bytes;
+  entry.texture_id = 0;
+  entry.resident_bytes = 0;
+}
+
+void TextureResidencyManager::TrimCache() {
+  if (cached_bytes_ <= cache_budget_bytes_) {
+    return;
+  }
+  std::vector<Entry*> cached;
+  for (auto& entry : entries_) {
+    if (!entry.cached_levels.empty()) {
+      cached.push_back(&entry);
+    }
+  }
+  std::sort(cached.begin(), cached.end(), [](const Entry* a, const Entry* b) {
+    return a->last_used_frame < b->last_used_frame;
+  });
+  for (Entry* entry : cached) {
+    if (cached_bytes_ <= cache_budget_bytes_) {
+      break;
+    }
+    cached_bytes_ -= entry->cached_bytes;
+    entry->cached_bytes = 0;
+    std::vector<MipLevel>().swap(entry->cached_levels);
+  }
+}
@@ -0,0 +1,108 @@
+#ifndef LEARNGL_TEXTURE_RESIDENCY_HPP_
+#define LEARNGL_TEXTURE_RESIDENCY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gpu_resources.hpp"
+#include "mip_builder.hpp"
+
+struct ResidencyStats {
+  // Acquire() calls that found the full texture resident
+  std::uint64_t hits = 0;
+  // Acquire() calls that had to load the texture or restore dropped mips
+  std::uint64_t misses = 0;
+  // Misses served from decoded mip chains kept in system memory
+  std::uint64_t cache_loads = 0;
+  // Misses that decoded the file from disk again
+  std::uint64_t disk_loads = 0;
+  // Top mip levels dropped to meet the budget
+  std::uint64_t mip_evictions = 0;
+  // Whole textures dropped to meet the budget
+  std::uint64_t evictions = 0;
+};
+
+// Keeps image file textures within a GPU memory budget. Textures are loaded on
+// first use and remember the frame they were last used in. When the resident
+// total exceeds the budget, textures not used this frame lose their top mip
+// levels, least recently used first, and are dropped entirely once they are
+// down to a small tail. The next Acquire() of a trimmed or evicted texture
+// restores the full chain from the system memory cache, or from disk if the
+// cache has let go of it as well.
+//
+// Because trimming reallocates the texture, the GL name can change: call
+// Acquire() every frame instead of holding on to the returned id.
+class TextureResidencyManager {
+ public:
+  using Handle = std::uint32_t;
+
+  // `budget_bytes` bounds resident GPU storage, `cache_bytes` the decoded mip
+  // chains kept in system memory for fast reloads.
+  TextureResidencyManager(std::size_t budget_bytes, std::size_t cache_bytes);
+  ~TextureResidencyManager();
+
+  TextureResidencyManager(const TextureResidencyManager&) = delete;
+  TextureResidencyManager& operator=(const TextureResidencyManager&) = delete;
+
+  // Register an image file without loading it. Registering the same path
+  // again returns the same handle. `color_data` filters mips in linear space.
+  Handle Register(const std::string& path, bool color_data,
+                  GpuResourceCategory category = GpuResourceCategory::TEXTURE);
+
+  // The GL_TEXTURE_2D name holding the full texture, loading or restoring it
+  // as needed, and mark it used this frame. Returns 0 if the file fails to
+  // load.
+  unsigned int Acquire(Handle handle);
+
+  // Enforce the budget, then start a new frame.
+  void EndFrame();
+
+  void SetBudget(std::size_t budget_bytes);
+  std::size_t Budget() const;
+  std::size_t ResidentBytes() const;
+  std::size_t CachedBytes() const;
+  const ResidencyStats& Stats() const;
+
+ private:
+  struct Entry {
+    std::string path;
+    bool color_data;
+    GpuResourceCategory category;
+    // 0 while evicted
+    unsigned int texture_id = 0;
+    // Number of top levels of the full chain currently dropped
+    int first_level = 0;
+    int level_count = 0;
+    int channels = 0;
+    std::size_t resident_bytes = 0;
+    std::uint64_t last_used_frame = 0;
+    // Full decoded chain, empty when not cached
+    std::vector<MipLevel> cached_levels;
+    std::size_t cached_bytes = 0;
+    // Size of each level of the full chain, known after the first load
+    std::vector<std::pair<int, int>> level_sizes;
+  };
+
+  std::size_t budget_bytes_;
+  std::size_t cache_budget_bytes_;
+  std::size_t resident_bytes_ = 0;
+  std::size_t cached_bytes_ = 0;
+  std::uint64_t frame_ = 1;
+  ResidencyStats stats_;
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, Handle> handles_by_path_;
+
+  bool Restore(Entry& entry);
+  void Upload(Entry& entry, const std::vector<MipLevel>& levels);
+  bool CanDropTopLevel(const Entry& entry) const;
+  void DropTopLevel(Entry& entry);
+  void Evict(Entry& entry);
+  void ReleaseTexture(Entry& entry);
+  void TrimCache();
+};
+
+#endif
@@ -0,0 +1,274 @@
+#include "texture_streamer.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+#include "stb_include.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+// Levels up to this size are uploaded as soon as the file is decoded and
+// never released
+constexpr int kTailSize = 64;
+// Frames a texture keeps levels finer than requested before they are freed,
+// so objects moving back and forth do not thrash uploads
+constexpr int kReleaseDelayFrames = 120;
+// MIN_LOD step per frame while a new level fades in
+constexpr float kLodFadeStep = 0.125f;
+constexpr float kNotRequested = std::numeric_limits<float>::infinity();
+
+std::vector<MipLevel> DecodeMipChain(const std::string& path,
+                                     bool color_data) {
+  int width;
+  int height;
+  int component_count;
+  unsigned char* data =
+      stbi_load(path.c_str(), &width, &height, &component_count, 0);
+  if (!data) {
+    std::cerr << "Texture failed to load at path: " << path << "\n";
+    return {};
+  }
+  MipChainOptions options;
+  options.srgb = color_data;
+  std::vector<MipLevel> levels =
+      BuildMipChain(data, width, height, component_count, options);
+  stbi_image_free(data);
+  return levels;
+}
+
+}  // namespace
+
+StreamingView MakeStreamingView(const glm::vec3& camera_position,
+                                float field_of_view_radians,
+                                int viewport_height) {
+  return {camera_position,
+          viewport_height / (2.0f * std::tan(0.5f * field_of_view_radians))};
+}
+
+TextureStreamer::TextureStreamer(std::size_t upload_bytes_per_frame)
+    : upload_bytes_per_frame_(upload_bytes_per_frame) {}
+
+TextureStreamer::Handle TextureStreamer::Register(
+    const std::string& path, bool color_data, GpuResourceCategory category) {
+  const auto existing = handles_by_path_.find(path);
+  if (existing != handles_by_path_.end()) {
+    return existing->second;
+  }
+
+  Entry entry;
+  entry.path = path;
+  entry.category = category;
+  entry.uv_per_pixel = kNotRequested;
+  entry.pending = SharedThreadPool().Submit(
+      [path, color_data]() { return DecodeMipChain(path, color_data); });
+
+  // Mutable storage, so levels can be specified one at a time later
+  const unsigned char grey[] = {128, 128, 128, 255};
+  glGenTextures(1, &entry.texture_id);
+  glBindTexture(GL_TEXTURE_2D, entry.texture_id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, grey);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  const auto handle = static_cast<Handle>(entries_.size());
+  entries_.push_back(std::move(entry));
+  handles_by_path_[path] = handle;
+  return handle;
+}
+
+unsigned int TextureStreamer::TextureId(Handle handle) const {
+  return entries_[handle].texture_id;
+}
+
+void TextureStreamer::RequestFootprint(Handle handle, float uv_per_pixel) {
+  Entry& entry = entries_[handle];
+  entry.uv_per_pixel = std::min(entry.uv_per_pixel, uv_per_pixel);
+}
+
+void TextureStreamer::Update() {
+  std::vector<Entry*> streaming;
+  for (auto& entry : entries_) {
+    if (entry.pending.valid() &&
+        entry.pending.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready) {
+      Finish(entry);
+    }
+    if (entry.levels.empty()) {
+      continue;
+    }
+
+    const int target = TargetLevel(entry);
+    if (target < entry.base_level) {
+      entry.surplus_frames = 0;
+      streaming.push_back(&entry);
+    } else if (target > entry.base_level &&
+               ++entry.surplus_frames > kReleaseDelayFrames) {
+      entry.surplus_frames = 0;
+      glBindTexture(GL_TEXTURE_2D, entry.texture_id);
+      while (entry.base_level < target) {
+        ReleaseLevel(entry, entry.base_level);
+      }
+      Track(entry);
+    } else if (target == entry.base_level) {
+      entry.surplus_frames = 0;
+    }
+  }
+
+  // Textures missing the most levels first, one level per texture per round
+  // so a single large texture cannot starve the rest
+  std::sort(streaming.begin(), streaming.end(),
+            [this](const Entry* a, const Entry* b) {
+              return a->base_level - TargetLevel(*a) >
+                     b->base_level - TargetLevel(*b);
+            });
+  std::size_t uploaded_bytes = 0;
+  bool uploaded = true;
+  while (uploaded && uploaded_bytes < upload_bytes_per_frame_) {
+    uploaded = false;
+    for (Entry* entry : streaming) {
+      if (uploaded_bytes >= upload_bytes_per_frame_) {
+        break;
+      }
+      if (entry->base_level > TargetLevel(*entry)) {
+        glBindTexture(GL_TEXTURE_2D, entry->texture_id);
+        const int level = entry->base_level - 1;
+        UploadLevel(*entry, level);
+        uploaded_bytes += entry->levels[level].pixels.size();
+        uploaded = true;
+      }
+    }
+  }
+  for (Entry* entry : streaming) {
+    Track(*entry);
+  }
+
+  for (auto& entry : entries_) {
+    if (entry.min_lod > 0.0f) {
+      entry.min_lod = std::max(entry.min_lod - kLodFadeStep, 0.0f);
+      glBindTexture(GL_TEXTURE_2D, entry.texture_id);
+      glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, entry.min_lod);
+    }
+    entry.uv_per_pixel = kNotRequested;
+  }
+}
+
+std::size_t TextureStreamer::ResidentBytes() const { return resident_bytes_; }
+
+std::size_t TextureStreamer::FullChainBytes() const {
+  return full_chain_bytes_;
+}
+
+const StreamingStats& TextureStreamer::Stats() const { return stats_; }
+
+void TextureStreamer::Finish(Entry& entry) {
+  entry.levels = entry.pending.get();
+  if (entry.levels.empty()) {
+    return;
+  }
+
+  const int level_count = static_cast<int>(entry.levels.size());
+  entry.tail_level = level_count - 1;
+  while (entry.tail_level > 0 &&
+         std::max(entry.levels[entry.tail_level - 1].width,
+                  entry.levels[entry.tail_level - 1].height) <= kTailSize) {
+    entry.tail_level--;
+  }
+  const GLenum internal_format =
+      MipChainInternalFormat(entry.levels[0].channels, /*srgb_storage=*/false);
+  full_chain_bytes_ +=
+      TextureBytes(internal_format, entry.levels[0].width,
+                   entry.levels[0].height, level_count);
+
+  // Specify the tail before widening the level range so the texture stays
+  // complete; the placeholder in level 0 is ignored until level 0 arrives
+  glBindTexture(GL_TEXTURE_2D, entry.texture_id);
+  entry.base_level = level_count;
+  for (int level = level_count - 1; level >= entry.tail_level; level--) {
+    UploadLevel(entry, level);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level_count - 1);
+  // The tail replaces the placeholder outright
+  entry.min_lod = 0.0f;
+  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, 0.0f);
+  Track(entry);
+}
+
+int TextureStreamer::TargetLevel(const Entry& entry) const {
+  if (entry.uv_per_pixel == kNotRequested) {
+    return entry.tail_level;
+  }
+  // Trilinear filtering blends the level at the footprint with the next
+  // coarser one, so the finer of the two has to be resident
+  const float texels_per_pixel =
+      entry.uv_per_pixel *
+      std::max(entry.levels[0].width, entry.levels[0].height);
+  const int level =
+      texels_per_pixel > 1.0f
+          ? static_cast<int>(std::floor(std::log2(texels_per_pixel)))
+          : 0;
+  return std::min(level, entry.tail_level);
+}
+
+void TextureStreamer::UploadLevel(Entry& entry, int level) {
+  const MipLevel& source = entry.levels[level];
+  const GLenum internal_format =
+      MipChainInternalFormat(source.channels, /*srgb_storage=*/false);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, level, internal_format, source.width,
+               source.height, 0, MipChainPixelFormat(source.channels),
+               GL_UNSIGNED_BYTE, source.pixels.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  // Keep sampling the previous level, then let Update() fade the new one in
+  entry.base_level = level;
+  entry.min_lod += 1.0f;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, entry.min_lod);
+
+  const std::size_t bytes =
+      TextureBytes(internal_format, source.width, source.height);
+  entry.resident_bytes += bytes;
+  resident_bytes_ += bytes;
+  stats_.uploaded_levels++;
+  stats_.uploaded_bytes += bytes;
+}
+
+void TextureStreamer::ReleaseLevel(Entry& entry, int level) {
+  const MipLevel& source = entry.levels[level];
+  const GLenum internal_format =
+      MipChainInternalFormat(source.channels, /*srgb_storage=*/false);
+  // Respecifying a level as 0x0 frees its storage
+  entry.base_level = level + 1;
+  entry.min_lod = std::max(entry.min_lod - 1.0f, 0.0f);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.base_level);
+  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, entry.min_lod);
+  glTexImage2D(GL_TEXTURE_2D, level, internal_format, 0, 0, 0,
+               MipChainPixelFormat(source.channels), GL_UNSIGNED_BYTE,
+               nullptr);
+
+  const std::size_t bytes =
+      TextureBytes(internal_format, source.width, source.height);
+  entry.resident_bytes -= bytes;
+  resident_bytes_ -= bytes;
+  stats_.released_levels++;
+}
+
+void TextureStreamer::Track(const Entry& entry) {
+  const GLenum internal_format =
+      MipChainInternalFormat(entry.levels[0].channels, /*srgb_storage=*/false);
+  GpuResources().Track(GpuResourceKind::TEXTURE, entry.texture_id,
+                       {entry.category, entry.resident_bytes, internal_format,
+                        entry.path});
+}
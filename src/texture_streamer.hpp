@@ -0,0 +1,110 @@
+#ifndef LEARNGL_TEXTURE_STREAMER_HPP_
+#define LEARNGL_TEXTURE_STREAMER_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gpu_resources.hpp"
+#include "mip_builder.hpp"
+
+// How the camera projects the scene, for footprint estimates.
+struct StreamingView {
+  glm::vec3 camera_position;
+  // Pixels covered by one world unit at a distance of one unit
+  float pixels_per_unit;
+};
+
+StreamingView MakeStreamingView(const glm::vec3& camera_position,
+                                float field_of_view_radians,
+                                int viewport_height);
+
+struct StreamingStats {
+  std::uint64_t uploaded_levels = 0;
+  std::uint64_t uploaded_bytes = 0;
+  std::uint64_t released_levels = 0;
+};
+
+// Streams the mip levels of image file textures by how large they appear on
+// screen. Files are decoded and filtered on SharedThreadPool(); once ready
+// only the coarse tail of the chain is uploaded. Every frame callers report
+// the UV extent one pixel covers wherever the texture is drawn, Update()
+// turns the smallest of those into the finest level worth keeping, uploads
+// missing finer levels within a per-frame byte budget and releases levels
+// that have not been needed for a while.
+//
+// Textures use mutable storage so single levels can be added and freed in
+// place: GL_TEXTURE_BASE_LEVEL clamps sampling to the finest resident level,
+// and GL_TEXTURE_MIN_LOD fades a newly arrived level in over a few frames.
+// The GL name never changes.
+class TextureStreamer {
+ public:
+  using Handle = std::uint32_t;
+
+  explicit TextureStreamer(std::size_t upload_bytes_per_frame = 4 << 20);
+
+  TextureStreamer(const TextureStreamer&) = delete;
+  TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+  // Start loading an image file. Registering the same path again returns the
+  // same handle. `color_data` filters mips in linear space.
+  Handle Register(const std::string& path, bool color_data,
+                  GpuResourceCategory category = GpuResourceCategory::TEXTURE);
+
+  // GL_TEXTURE_2D name of the texture, valid right after Register(). Samples
+  // a grey placeholder until the coarse levels arrive.
+  unsigned int TextureId(Handle handle) const;
+
+  // Report that the texture is drawn this frame with one screen pixel
+  // covering `uv_per_pixel` of its UV range.
+  void RequestFootprint(Handle handle, float uv_per_pixel);
+
+  // Finish pending loads, stream levels towards this frame's requests and
+  // start a new frame. Call once per frame after all requests.
+  void Update();
+
+  std::size_t ResidentBytes() const;
+  // What the loaded textures would occupy with complete chains
+  std::size_t FullChainBytes() const;
+  const StreamingStats& Stats() const;
+
+ private:
+  struct Entry {
+    std::string path;
+    GpuResourceCategory category;
+    unsigned int texture_id = 0;
+    std::future<std::vector<MipLevel>> pending;
+    // Complete chain, the source of every upload. Empty until decoded.
+    std::vector<MipLevel> levels;
+    // Finest resident level; levels.size() until the coarse tail arrives
+    int base_level = 0;
+    // Coarsest level a texture is ever trimmed back to
+    int tail_level = 0;
+    // Smallest footprint requested this frame
+    float uv_per_pixel;
+    // Frames the texture has had finer levels than requested
+    int surplus_frames = 0;
+    float min_lod = 0.0f;
+    std::size_t resident_bytes = 0;
+  };
+
+  std::size_t upload_bytes_per_frame_;
+  std::size_t resident_bytes_ = 0;
+  std::size_t full_chain_bytes_ = 0;
+  StreamingStats stats_;
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, Handle> handles_by_path_;
+
+  void Finish(Entry& entry);
+  int TargetLevel(const Entry& entry) const;
+  void UploadLevel(Entry& entry, int level);
+  void ReleaseLevel(Entry& entry, int level);
+  void Track(const Entry& entry);
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+unsigned int DefaultWorkerCount() {
+  const unsigned int hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads > 1 ? hardware_threads - 1 : 1;
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool() : ThreadPool(DefaultWorkerCount()) {}
+
+ThreadPool::ThreadPool(unsigned int thread_count) {
+  thread_count = std::max(thread_count, 1u);
+  for (unsigned int i = 0; i < thread_count; i++) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Enqueue(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push(std::move(task));
+  }
+  condition_.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+      if (stopping_ && tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop();
+    }
+    task();
+  }
+}
+
+void ThreadPool::ParallelFor(
+    std::size_t count, std::size_t grain,
+    const std::function<void(std::size_t, std::size_t)>& function) {
+  if (count == 0) {
+    return;
+  }
+  grain = std::max<std::size_t>(grain, 1);
+  const std::size_t max_chunks = (count + grain - 1) / grain;
+  // A few chunks per thread so uneven chunks still balance out
+  const std::size_t chunk_count =
+      std::min<std::size_t>(max_chunks, Concurrency() * 4);
+  if (chunk_count <= 1) {
+    function(0, count);
+    return;
+  }
+  const std::size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+
+  // Helpers may still be queued after the calling thread returns, so the
+  // shared state must outlive this call.
+  struct State {
+    std::atomic<std::size_t> next_chunk{0};
+    std::atomic<std::size_t> finished_chunks{0};
+    std::mutex mutex;
+    std::condition_variable done;
+  };
+  auto state = std::make_shared<State>();
+
+  auto run_chunks = [state, chunk_count, chunk_size, count, &function]() {
+    std::size_t chunk;
+    while ((chunk = state->next_chunk.fetch_add(1)) < chunk_count) {
+      const std::size_t begin = chunk * chunk_size;
+      const std::size_t end = std::min(begin + chunk_size, count);
+      if (begin < end) {
+        function(begin, end);
+      }
+      if (state->finished_chunks.fetch_add(1) + 1 == chunk_count) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->done.notify_all();
+      }
+    }
+  };
+
+  const std::size_t helper_count =
+      std::min<std::size_t>(workers_.size(), chunk_count - 1);
+  for (std::size_t i = 0; i < helper_count; i++) {
+    // Helpers that start after all chunks are claimed exit immediately
+    // without touching `function`.
+    Enqueue(run_chunks);
+  }
+  run_chunks();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->done.wait(lock, [&state, chunk_count]() {
+    return state->finished_chunks.load() == chunk_count;
+  });
+}
+
+unsigned int ThreadPool::Concurrency() const {
+  return static_cast<unsigned int>(workers_.size()) + 1;
+}
+
+ThreadPool& SharedThreadPool() {
+  static ThreadPool pool;
+  return pool;
+}
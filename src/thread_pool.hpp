@@ -0,0 +1,64 @@
+#ifndef LEARNGL_THREAD_POOL_HPP_
+#define LEARNGL_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for CPU-side work that does not touch OpenGL.
+class ThreadPool {
+ public:
+  // By default one worker per hardware thread, minus the calling thread which
+  // participates in ParallelFor.
+  ThreadPool();
+  explicit ThreadPool(unsigned int thread_count);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Run `task` on a worker thread.
+  template <typename Task>
+  auto Submit(Task task) -> std::future<decltype(task())>;
+
+  // Split [0, count) into chunks of at least `grain` items and run
+  // function(begin, end) on every chunk across the workers and the calling
+  // thread. Blocks until all chunks have finished.
+  void ParallelFor(
+      std::size_t count, std::size_t grain,
+      const std::function<void(std::size_t, std::size_t)>& function);
+
+  // Workers plus the calling thread.
+  unsigned int Concurrency() const;
+
+ private:
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopping_ = false;
+
+  void Enqueue(std::function<void()> task);
+  void WorkerLoop();
+};
+
+// Process wide pool shared by the asset loaders and simulation kernels.
+ThreadPool& SharedThreadPool();
+
+template <typename Task>
+auto ThreadPool::Submit(Task task) -> std::future<decltype(task())> {
+  using Result = decltype(task());
+  auto packaged =
+      std::make_shared<std::packaged_task<Result()>>(std::move(task));
+  std::future<Result> result = packaged->get_future();
+  Enqueue([packaged]() { (*packaged)(); });
+  return result;
+}
+
+#endif
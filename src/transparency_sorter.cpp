@@ -0,0 +1,78 @@
+#include "transparency_sorter.hpp"
+
+#include <cstring>
+
+namespace {
+
+// Insertion sort gives up after this many moves per item on average, about
+// where it becomes slower than a radix sort of 32-bit keys
+constexpr std::size_t kMaxMovesPerItem = 16;
+
+// Larger for nearer items. Squared distances are never negative, so their
+// bits order the same way as the values.
+std::uint64_t DepthKey(const glm::vec3& position, const glm::vec3& eye) {
+  const glm::vec3 offset = position - eye;
+  const float distance2 = glm::dot(offset, offset);
+  std::uint32_t bits;
+  std::memcpy(&bits, &distance2, sizeof(bits));
+  return ~bits;
+}
+
+// Sort `items` by key in place, unless that takes more than `max_moves`
+// moves. Returns whether it finished.
+bool InsertionSort(std::vector<SortItem>* items, std::size_t max_moves) {
+  std::size_t moves = 0;
+  for (std::size_t i = 1; i < items->size(); i++) {
+    const SortItem item = (*items)[i];
+    std::size_t j = i;
+    while (j > 0 && (*items)[j - 1].key > item.key) {
+      (*items)[j] = (*items)[j - 1];
+      j--;
+    }
+    (*items)[j] = item;
+    moves += i - j;
+    if (moves > max_moves) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+void TransparencySorter::Sort(const glm::vec3* positions, std::size_t count,
+                              const glm::vec3& eye) {
+  if (items_.size() != count) {
+    items_.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+      items_[i].index = static_cast<std::uint32_t>(i);
+    }
+    incremental_ = false;
+  } else {
+    incremental_ = true;
+  }
+  for (SortItem& item : items_) {
+    item.key = DepthKey(positions[item.index], eye);
+  }
+
+  // A fresh order is rarely close; an abandoned insertion sort leaves the
+  // items partly sorted, which RadixSort() does not mind
+  if (!incremental_ ||
+      !InsertionSort(&items_, kMaxMovesPerItem * count)) {
+    RadixSort(&items_, &scratch_);
+    incremental_ = false;
+  }
+
+  order_.resize(count);
+  for (std::size_t i = 0; i < count; i++) {
+    order_[i] = items_[i].index;
+  }
+}
+
+const std::vector<std::uint32_t>& TransparencySorter::Order() const {
+  return order_;
+}
+
+bool TransparencySorter::LastSortIncremental() const {
+  return incremental_;
+}
@@ -0,0 +1,41 @@
+#ifndef LEARNGL_TRANSPARENCY_SORTER_HPP_
+#define LEARNGL_TRANSPARENCY_SORTER_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "radix_sort.hpp"
+
+// Orders transparent items back to front for blending, every frame. Each
+// item's key is its squared distance from the eye, whose float bits sort
+// like the distance itself, inverted so the farthest comes first.
+//
+// The camera moves little between frames, so last frame's order is usually
+// nearly right. Sort() starts from it and fixes it up with insertion sort;
+// if that takes too many moves per item it finishes with RadixSort()
+// instead. Both are stable, so items at the same distance keep a consistent
+// order rather than flickering or being lost.
+class TransparencySorter {
+ public:
+  // Order `count` items at `positions` as seen from `eye`. A different
+  // count than last time starts over from the submission order.
+  void Sort(const glm::vec3* positions, std::size_t count,
+            const glm::vec3& eye);
+
+  // Indices into the last Sort()'s positions, farthest first
+  const std::vector<std::uint32_t>& Order() const;
+  // Whether the last Sort() got by with insertion sort
+  bool LastSortIncremental() const;
+
+ private:
+  // Last frame's order, with this frame's keys while sorting
+  std::vector<SortItem> items_;
+  std::vector<SortItem> scratch_;
+  std::vector<std::uint32_t> order_;
+  bool incremental_ = false;
+};
+
+#endif
@@ -0,0 +1,256 @@
+#include "vegetation.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <string>
+
+#include "frustum_culling.hpp"
+#include "gpu_resources.hpp"
+#include "render_stats.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+// Matches the local size of the culling shader
+constexpr unsigned int kWorkGroupSize = 64;
+// Density grid cells per noise lattice cell
+constexpr int kNoiseCells = 8;
+constexpr float kMinScale = 0.6f;
+constexpr float kMaxScale = 1.4f;
+constexpr float kPi = 3.14159265f;
+
+// Layout of a glDrawArraysIndirect command
+struct DrawArraysIndirectCommand {
+  unsigned int count;
+  unsigned int instance_count;
+  unsigned int first;
+  unsigned int base_instance;
+};
+
+// Two quads crossed at right angles. Position (x, y, z), texture
+// coordinates (swapped y coordinate as texture is flipped upside down).
+const float kCardVertices[] = {
+    -0.5f, 1.0f, 0.0f,  0.0f, 0.0f,  //
+    -0.5f, 0.0f, 0.0f,  0.0f, 1.0f,  //
+    0.5f,  0.0f, 0.0f,  1.0f, 1.0f,  //
+    -0.5f, 1.0f, 0.0f,  0.0f, 0.0f,  //
+    0.5f,  0.0f, 0.0f,  1.0f, 1.0f,  //
+    0.5f,  1.0f, 0.0f,  1.0f, 0.0f,  //
+
+    0.0f,  1.0f, -0.5f, 0.0f, 0.0f,  //
+    0.0f,  0.0f, -0.5f, 0.0f, 1.0f,  //
+    0.0f,  0.0f, 0.5f,  1.0f, 1.0f,  //
+    0.0f,  1.0f, -0.5f, 0.0f, 0.0f,  //
+    0.0f,  0.0f, 0.5f,  1.0f, 1.0f,  //
+    0.0f,  1.0f, 0.5f,  1.0f, 0.0f   //
+};
+constexpr unsigned int kCardVertexCount = 12;
+
+std::uint32_t Hash(std::uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+std::uint32_t HashCell(std::uint32_t seed, int x, int z) {
+  return Hash(seed ^ Hash(static_cast<std::uint32_t>(x) ^
+                          Hash(static_cast<std::uint32_t>(z))));
+}
+
+// Smooth value noise in [0, 1] over the density grid
+float Noise(std::uint32_t seed, int x, int z) {
+  const auto lattice = [&](int lattice_x, int lattice_z) {
+    return (HashCell(seed, lattice_x, lattice_z) & 0xffffu) / 65535.0f;
+  };
+  const int lattice_x = x / kNoiseCells;
+  const int lattice_z = z / kNoiseCells;
+  const auto smooth = [](float t) { return t * t * (3.0f - 2.0f * t); };
+  const float u = smooth((x % kNoiseCells) / static_cast<float>(kNoiseCells));
+  const float v = smooth((z % kNoiseCells) / static_cast<float>(kNoiseCells));
+  const float near = lattice(lattice_x, lattice_z) * (1.0f - u) +
+                     lattice(lattice_x + 1, lattice_z) * u;
+  const float far = lattice(lattice_x, lattice_z + 1) * (1.0f - u) +
+                    lattice(lattice_x + 1, lattice_z + 1) * u;
+  return near * (1.0f - v) + far * v;
+}
+
+}  // namespace
+
+std::vector<GrassCard> GenerateVegetation(const VegetationOptions& options) {
+  const int cells =
+      std::max(static_cast<int>(options.extent / options.cell_size), 1);
+  const float cell_size = options.extent / cells;
+  const float cell_cards = options.density * cell_size * cell_size;
+  // Distinct from the cells' seeds
+  const std::uint32_t noise_seed = Hash(options.seed + 1);
+
+  // Every row of cells fills its own list; they are joined in order
+  std::vector<std::vector<GrassCard>> rows(cells);
+  SharedThreadPool().ParallelFor(
+      cells, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t row = begin; row < end; row++) {
+          const int z = static_cast<int>(row);
+          std::vector<GrassCard>& cards = rows[row];
+          for (int x = 0; x < cells; x++) {
+            std::minstd_rand random(HashCell(options.seed, x, z));
+            std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+            // Round the expected count up or down at random, so fractional
+            // densities come out right on average
+            const float expected =
+                cell_cards * 2.0f * Noise(noise_seed, x, z);
+            const int count =
+                static_cast<int>(expected + unit(random));
+            const float min_x = -0.5f * options.extent + x * cell_size;
+            const float min_z = -0.5f * options.extent + z * cell_size;
+            for (int i = 0; i < count; i++) {
+              cards.push_back(
+                  {min_x + unit(random) * cell_size,
+                   min_z + unit(random) * cell_size,
+                   unit(random) * kPi,
+                   kMinScale + unit(random) * (kMaxScale - kMinScale)});
+            }
+          }
+        }
+      });
+
+  std::size_t total = 0;
+  for (const auto& row : rows) {
+    total += row.size();
+  }
+  std::vector<GrassCard> cards;
+  cards.reserve(total);
+  for (const auto& row : rows) {
+    cards.insert(cards.end(), row.begin(), row.end());
+  }
+  return cards;
+}
+
+VegetationRenderer::VegetationRenderer(const std::vector<GrassCard>& cards,
+                                       const VegetationOptions& options)
+    : options_(options) {
+  glGenBuffers(1, &card_buffer_);
+  glGenBuffers(1, &visible_buffer_);
+  glGenBuffers(1, &command_buffer_);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DrawArraysIndirectCommand),
+               nullptr, GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  GpuResources().Track(GpuResourceKind::BUFFER, command_buffer_,
+                       {GpuResourceCategory::BUFFER,
+                        sizeof(DrawArraysIndirectCommand), GL_NONE,
+                        "Vegetation draw command"});
+
+  glGenVertexArrays(1, &vao_);
+  glBindVertexArray(vao_);
+  glGenBuffers(1, &vbo_);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(kCardVertices), kCardVertices,
+               GL_STATIC_DRAW);
+  GpuResources().Track(GpuResourceKind::BUFFER, vbo_,
+                       {GpuResourceCategory::MESH_BUFFER,
+                        sizeof(kCardVertices), GL_NONE, "Vegetation card"});
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
+                        (void*)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  // One visible card per instance
+  glBindBuffer(GL_ARRAY_BUFFER, visible_buffer_);
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(GrassCard),
+                        (void*)0);
+  glEnableVertexAttribArray(2);
+  glVertexAttribDivisor(2, 1);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  SetCards(cards);
+}
+
+void VegetationRenderer::SetCards(const std::vector<GrassCard>& cards) {
+  card_count_ = static_cast<unsigned int>(cards.size());
+  const std::size_t bytes = cards.size() * sizeof(GrassCard);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, card_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, cards.data(),
+               GL_STATIC_DRAW);
+  // Written by the compute shader only, room for every card
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, visible_buffer_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  GpuResources().Track(GpuResourceKind::BUFFER, card_buffer_,
+                       {GpuResourceCategory::BUFFER, bytes, GL_NONE,
+                        "Vegetation cards"});
+  GpuResources().Track(GpuResourceKind::BUFFER, visible_buffer_,
+                       {GpuResourceCategory::BUFFER, bytes, GL_NONE,
+                        "Vegetation visible cards"});
+}
+
+void VegetationRenderer::Cull(Shader& culling_shader,
+                              const glm::mat4& view_projection,
+                              const glm::vec3& camera_position) {
+  // Every card draws all of its vertices; the shader fills in the count
+  const DrawArraysIndirectCommand command = {kCardVertexCount, 0, 0, 0};
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer_);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(command), &command);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  const Frustum frustum = ExtractFrustum(view_projection);
+  culling_shader.Use();
+  for (int i = 0; i < 6; i++) {
+    culling_shader.SetVec4("frustumPlanes[" + std::to_string(i) + "]",
+                           frustum.planes[i]);
+  }
+  glUniform1ui(glGetUniformLocation(culling_shader.id(), "cardCount"),
+               card_count_);
+  culling_shader.SetFloat("groundHeight", options_.ground_height);
+  culling_shader.SetFloat("fadeEnd", options_.fade_end);
+  culling_shader.SetVec3("cameraPosition", camera_position);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, card_buffer_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visible_buffer_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, command_buffer_);
+  glDispatchCompute((card_count_ + kWorkGroupSize - 1) / kWorkGroupSize, 1,
+                    1);
+
+  // The draws read the command and the visible cards as attributes
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT |
+                  GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void VegetationRenderer::Draw(Shader& shader,
+                              const glm::vec3& camera_position) const {
+  shader.Use();
+  shader.SetFloat("groundHeight", options_.ground_height);
+  shader.SetFloat("fadeStart", options_.fade_start);
+  shader.SetFloat("fadeEnd", options_.fade_end);
+  shader.SetVec3("cameraPosition", camera_position);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+  glBindVertexArray(vao_);
+  glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+  FrameStats().draw_calls++;
+
+  // Always good practice to set everything back to defaults once configured
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+unsigned int VegetationRenderer::ReadVisibleCount() const {
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  unsigned int count = 0;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer_);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER,
+                     offsetof(DrawArraysIndirectCommand, instance_count),
+                     sizeof(count), &count);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  return count;
+}
+
+unsigned int VegetationRenderer::CardCount() const {
+  return card_count_;
+}
@@ -0,0 +1,91 @@
+#ifndef LEARNGL_VEGETATION_HPP_
+#define LEARNGL_VEGETATION_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "shader_m.hpp"
+
+struct VegetationOptions {
+  // The square of ground covered, centered on the origin, and its height
+  float extent = 200.0f;
+  float ground_height = -0.5f;
+  // Edge of a density grid cell. Every cell gets a card count of its own.
+  float cell_size = 2.0f;
+  // Average cards per square unit. A smooth noise over the density grid
+  // varies it between none and twice as many, for meadows and bare
+  // patches.
+  float density = 8.0f;
+  std::uint32_t seed = 1;
+  // Cards shrink into the ground between these distances from the camera
+  // and are culled beyond the end
+  float fade_start = 60.0f;
+  float fade_end = 90.0f;
+};
+
+// Two crossed, alpha-tested quads standing on the ground, one unit wide
+// and tall before scaling. 16 bytes.
+struct GrassCard {
+  float x;
+  float z;
+  // Rotation about the vertical axis, in radians
+  float yaw;
+  float scale;
+};
+
+// Scatter cards over the ground, across SharedThreadPool(). The cards of
+// every density grid cell come from a seed of their own, so the result
+// does not depend on the number of threads.
+std::vector<GrassCard> GenerateVegetation(const VegetationOptions& options);
+
+// Draws grass cards with GPU culling. A compute shader tests every card's
+// bounding sphere against the frustum and the fade distance and appends
+// the survivors to a visible card buffer, counting them into one
+// glDrawArraysIndirect command. The CPU does no per-card work.
+//
+// The culling shader (see shaders/17_5_vegetation_culling.cs) reads the
+// cards from shader storage binding 0 and writes the visible ones to
+// binding 1 and the draw command to binding 2. The vertex shader (see
+// shaders/17_5_vegetation.vs) reads the visible cards as a vec4 attribute
+// at location 2.
+class VegetationRenderer {
+ public:
+  // Upload `cards`, placed as `options` describe.
+  VegetationRenderer(const std::vector<GrassCard>& cards,
+                     const VegetationOptions& options);
+
+  VegetationRenderer(const VegetationRenderer&) = delete;
+  VegetationRenderer& operator=(const VegetationRenderer&) = delete;
+
+  // Replace the cards, e.g. after generating them at another density.
+  void SetCards(const std::vector<GrassCard>& cards);
+
+  // Find the cards in the frustum of `view_projection` and within the fade
+  // distance of `camera_position`.
+  void Cull(Shader& culling_shader, const glm::mat4& view_projection,
+            const glm::vec3& camera_position);
+
+  // Draw the cards that survived the last Cull() with `shader`, setting
+  // its ground and fade uniforms. Blending, depth and coverage state are
+  // up to the caller.
+  void Draw(Shader& shader, const glm::vec3& camera_position) const;
+
+  // The number of cards that survived the last Cull(). Reading it back
+  // waits for the GPU, so only call it for statistics.
+  unsigned int ReadVisibleCount() const;
+
+  unsigned int CardCount() const;
+
+ private:
+  VegetationOptions options_;
+  unsigned int card_count_ = 0;
+  unsigned int card_buffer_ = 0;
+  unsigned int visible_buffer_ = 0;
+  unsigned int command_buffer_ = 0;
+  unsigned int vao_ = 0;
+  unsigned int vbo_ = 0;
+};
+
+#endif
@@ -0,0 +1,366 @@
+#include "virtual_texture.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+
+#include "gpu_resources.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+// Texels per page side, without the border
+constexpr int kPageSize = 128;
+// One texel of neighboring data around every page lets bilinear filtering
+// cross page edges
+constexpr int kPageBorder = 1;
+constexpr int kPaddedPageSize = kPageSize + 2 * kPageBorder;
+// The feedback buffer is this many times smaller than the screen per side
+constexpr int kFeedbackDivisor = 8;
+// Page loads per Update(), bounding the time spent producing and uploading
+constexpr std::size_t kMaxPageLoadsPerFrame = 16;
+
+std::uint64_t PageKey(int level, int x, int y) {
+  return static_cast<std::uint64_t>(level) << 56 |
+         static_cast<std::uint64_t>(y) << 28 | static_cast<std::uint64_t>(x);
+}
+
+int KeyLevel(std::uint64_t key) { return static_cast<int>(key >> 56); }
+int KeyY(std::uint64_t key) { return static_cast<int>(key >> 28 & 0xfffffff); }
+int KeyX(std::uint64_t key) { return static_cast<int>(key & 0xfffffff); }
+
+std::uint64_t ParentKey(std::uint64_t key) {
+  return PageKey(KeyLevel(key) + 1, KeyX(key) / 2, KeyY(key) / 2);
+}
+
+int Log2(int value) {
+  int result = 0;
+  while ((1 << (result + 1)) <= value) {
+    result++;
+  }
+  return result;
+}
+
+}  // namespace
+
+VirtualTexture::VirtualTexture(int virtual_size, int cache_pages_per_side,
+                               PageSource source, int screen_width,
+                               int screen_height)
+    : virtual_size_(virtual_size),
+      pages_per_side_(virtual_size / kPageSize),
+      level_count_(Log2(virtual_size / kPageSize) + 1),
+      cache_pages_per_side_(cache_pages_per_side),
+      cache_size_(cache_pages_per_side * kPaddedPageSize),
+      source_(std::move(source)),
+      feedback_width_(std::max(screen_width / kFeedbackDivisor, 1)),
+      feedback_height_(std::max(screen_height / kFeedbackDivisor, 1)),
+      slots_(static_cast<std::size_t>(cache_pages_per_side) *
+             cache_pages_per_side) {
+  // Page table: (cache slot x, cache slot y, unused, resident)
+  glGenTextures(1, &page_table_);
+  glBindTexture(GL_TEXTURE_2D, page_table_);
+  glTexStorage2D(GL_TEXTURE_2D, level_count_, GL_RGBA8UI, pages_per_side_,
+                 pages_per_side_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  for (int level = 0; level < level_count_; level++) {
+    glClearTexImage(page_table_, level, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE,
+                    nullptr);
+  }
+  GpuResources().Track(
+      GpuResourceKind::TEXTURE, page_table_,
+      {GpuResourceCategory::TEXTURE,
+       TextureBytes(GL_RGBA8UI, pages_per_side_, pages_per_side_,
+                    level_count_),
+       GL_RGBA8UI, "Virtual texture page table"});
+
+  glGenTextures(1, &cache_);
+  glBindTexture(GL_TEXTURE_2D, cache_);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, cache_size_, cache_size_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  GpuResources().Track(GpuResourceKind::TEXTURE, cache_,
+                       {GpuResourceCategory::TEXTURE,
+                        TextureBytes(GL_RGBA8, cache_size_, cache_size_),
+                        GL_RGBA8, "Virtual texture page cache"});
+
+  // Feedback: (page x, page y, level, written)
+  glGenTextures(1, &feedback_texture_);
+  glBindTexture(GL_TEXTURE_2D, feedback_texture_);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16UI, feedback_width_,
+                 feedback_height_);
+  glGenRenderbuffers(1, &feedback_depth_);
+  glBindRenderbuffer(GL_RENDERBUFFER, feedback_depth_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24,
+                        feedback_width_, feedback_height_);
+  glGenFramebuffers(1, &feedback_fbo_);
+  glBindFramebuffer(GL_FRAMEBUFFER, feedback_fbo_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         feedback_texture_, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, feedback_depth_);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "Error::Framebuffer:: Virtual texture feedback framebuffer "
+                 "is not complete!\n";
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  GpuResources().Track(
+      GpuResourceKind::TEXTURE, feedback_texture_,
+      {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+       TextureBytes(GL_RGBA16UI, feedback_width_, feedback_height_),
+       GL_RGBA16UI, "Virtual texture feedback"});
+  GpuResources().Track(
+      GpuResourceKind::RENDERBUFFER, feedback_depth_,
+      {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+       RenderbufferBytes(GL_DEPTH_COMPONENT24, feedback_width_,
+                         feedback_height_),
+       GL_DEPTH_COMPONENT24, "Virtual texture feedback depth"});
+
+  const std::size_t readback_bytes =
+      static_cast<std::size_t>(feedback_width_) * feedback_height_ * 4 *
+      sizeof(unsigned short);
+  glGenBuffers(2, readback_buffers_);
+  for (unsigned int buffer : readback_buffers_) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, readback_bytes, nullptr,
+                 GL_STREAM_READ);
+    GpuResources().Track(GpuResourceKind::BUFFER, buffer,
+                         {GpuResourceCategory::BUFFER, readback_bytes,
+                          GL_NONE, "Virtual texture feedback readback"});
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  // The fallback every lookup ends at
+  LoadPages({PageKey(level_count_ - 1, 0, 0)});
+  slots_[slots_by_key_.begin()->second].pinned = true;
+}
+
+void VirtualTexture::SetUniforms(const Shader& shader, int page_table_unit,
+                                 int cache_unit, bool feedback) const {
+  glActiveTexture(GL_TEXTURE0 + page_table_unit);
+  glBindTexture(GL_TEXTURE_2D, page_table_);
+  glActiveTexture(GL_TEXTURE0 + cache_unit);
+  glBindTexture(GL_TEXTURE_2D, cache_);
+  glActiveTexture(GL_TEXTURE0);
+
+  shader.SetInt("pageTable", page_table_unit);
+  shader.SetInt("pageCache", cache_unit);
+  shader.SetFloat("virtualSize", static_cast<float>(virtual_size_));
+  shader.SetFloat("pageSize", static_cast<float>(kPageSize));
+  shader.SetFloat("pageBorder", static_cast<float>(kPageBorder));
+  shader.SetFloat("cacheSize", static_cast<float>(cache_size_));
+  shader.SetInt("maxLevel", level_count_ - 1);
+  // Screen space derivatives are kFeedbackDivisor times larger in the
+  // feedback buffer
+  shader.SetFloat("lodBias",
+                  feedback ? -std::log2(static_cast<float>(kFeedbackDivisor))
+                           : 0.0f);
+}
+
+void VirtualTexture::BeginFeedback() {
+  glBindFramebuffer(GL_FRAMEBUFFER, feedback_fbo_);
+  glViewport(0, 0, feedback_width_, feedback_height_);
+  const GLuint clear_value[] = {0, 0, 0, 0};
+  glClearBufferuiv(GL_COLOR, 0, clear_value);
+  glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void VirtualTexture::EndFeedback() {
+  // Asynchronous: glReadPixels into a pack buffer returns immediately and
+  // Update() maps it a frame later
+  const int buffer = static_cast<int>(frame_ % 2);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_buffers_[buffer]);
+  glReadPixels(0, 0, feedback_width_, feedback_height_, GL_RGBA_INTEGER,
+               GL_UNSIGNED_SHORT, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  readback_pending_[buffer] = true;
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void VirtualTexture::Update() {
+  const int buffer = static_cast<int>((frame_ + 1) % 2);
+  if (readback_pending_[buffer]) {
+    readback_pending_[buffer] = false;
+    std::vector<std::uint64_t> missing = ReadFeedback(buffer);
+    // Coarse pages first: they cover the most screen and are the fallback
+    // of the finer ones
+    std::sort(missing.begin(), missing.end(),
+              [](std::uint64_t a, std::uint64_t b) {
+                return KeyLevel(a) > KeyLevel(b);
+              });
+    if (missing.size() > kMaxPageLoadsPerFrame) {
+      missing.resize(kMaxPageLoadsPerFrame);
+    }
+    LoadPages(std::move(missing));
+  }
+  frame_++;
+}
+
+int VirtualTexture::ResidentPages() const {
+  return static_cast<int>(slots_by_key_.size());
+}
+
+int VirtualTexture::CachePages() const {
+  return static_cast<int>(slots_.size());
+}
+
+const VirtualTextureStats& VirtualTexture::Stats() const { return stats_; }
+
+std::vector<std::uint64_t> VirtualTexture::ReadFeedback(int buffer) {
+  std::unordered_set<std::uint64_t> requested;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_buffers_[buffer]);
+  const std::size_t texel_count =
+      static_cast<std::size_t>(feedback_width_) * feedback_height_;
+  const auto* texels = static_cast<const unsigned short*>(
+      glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                       texel_count * 4 * sizeof(unsigned short),
+                       GL_MAP_READ_BIT));
+  if (texels != nullptr) {
+    for (std::size_t i = 0; i < texel_count; i++) {
+      const unsigned short* texel = texels + 4 * i;
+      if (texel[3] == 0 || texel[2] >= level_count_) {
+        continue;
+      }
+      const std::uint64_t key = PageKey(texel[2], texel[0], texel[1]);
+      requested.insert(key);
+      // Trilinear filtering also reads the next coarser level
+      if (texel[2] + 1 < level_count_) {
+        requested.insert(ParentKey(key));
+      }
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  stats_.requested_pages = requested.size();
+
+  std::vector<std::uint64_t> missing;
+  for (std::uint64_t key : requested) {
+    // Touch the page the shader actually samples: the requested one or its
+    // closest resident ancestor
+    std::uint64_t current = key;
+    while (true) {
+      const auto slot = slots_by_key_.find(current);
+      if (slot != slots_by_key_.end()) {
+        slots_[slot->second].last_used_frame = frame_;
+        break;
+      }
+      if (current == key) {
+        missing.push_back(key);
+      }
+      current = ParentKey(current);
+    }
+  }
+  return missing;
+}
+
+void VirtualTexture::LoadPages(std::vector<std::uint64_t> keys) {
+  // Claim the slots first so the pages can be produced in parallel
+  std::vector<std::pair<std::uint64_t, int>> loads;
+  for (std::uint64_t key : keys) {
+    const int slot = FindSlot();
+    if (slot < 0) {
+      // Everything resident is in use this frame
+      break;
+    }
+    Slot& target = slots_[slot];
+    if (target.occupied) {
+      WritePageTable(target.key, -1);
+      slots_by_key_.erase(target.key);
+      stats_.evicted_pages++;
+    }
+    target.key = key;
+    target.occupied = true;
+    target.last_used_frame = frame_;
+    slots_by_key_[key] = slot;
+    loads.emplace_back(key, slot);
+  }
+  if (loads.empty()) {
+    return;
+  }
+
+  const std::size_t page_bytes =
+      static_cast<std::size_t>(kPaddedPageSize) * kPaddedPageSize * 4;
+  std::vector<unsigned char> pixels(loads.size() * page_bytes);
+  SharedThreadPool().ParallelFor(
+      loads.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+          const std::uint64_t key = loads[i].first;
+          source_(KeyLevel(key), KeyX(key) * kPageSize - kPageBorder,
+                  KeyY(key) * kPageSize - kPageBorder, kPaddedPageSize,
+                  pixels.data() + i * page_bytes);
+        }
+      });
+
+  glBindTexture(GL_TEXTURE_2D, cache_);
+  for (std::size_t i = 0; i < loads.size(); i++) {
+    const int slot = loads[i].second;
+    glTexSubImage2D(GL_TEXTURE_2D, 0,
+                    slot % cache_pages_per_side_ * kPaddedPageSize,
+                    slot / cache_pages_per_side_ * kPaddedPageSize,
+                    kPaddedPageSize, kPaddedPageSize, GL_RGBA,
+                    GL_UNSIGNED_BYTE, pixels.data() + i * page_bytes);
+    WritePageTable(loads[i].first, slot);
+    stats_.loaded_pages++;
+  }
+}
+
+int VirtualTexture::FindSlot() const {
+  int best = -1;
+  for (int i = 0; i < static_cast<int>(slots_.size()); i++) {
+    const Slot& slot = slots_[i];
+    if (!slot.occupied) {
+      return i;
+    }
+    if (slot.pinned || slot.last_used_frame >= frame_) {
+      continue;
+    }
+    if (best < 0 || slot.last_used_frame < slots_[best].last_used_frame) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+void VirtualTexture::WritePageTable(std::uint64_t key, int slot) {
+  // A slot of -1 marks the page as not resident
+  const unsigned char entry[] = {
+      static_cast<unsigned char>(slot < 0 ? 0 : slot % cache_pages_per_side_),
+      static_cast<unsigned char>(slot < 0 ? 0 : slot / cache_pages_per_side_),
+      0, static_cast<unsigned char>(slot < 0 ? 0 : 1)};
+  glBindTexture(GL_TEXTURE_2D, page_table_);
+  glTexSubImage2D(GL_TEXTURE_2D, KeyLevel(key), KeyX(key), KeyY(key), 1, 1,
+                  GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, entry);
+}
+
+VirtualTexture::PageSource TiledImageSource(std::vector<MipLevel> levels) {
+  auto shared_levels =
+      std::make_shared<const std::vector<MipLevel>>(std::move(levels));
+  return [shared_levels](int level, int x, int y, int size,
+                         unsigned char* rgba) {
+    const MipLevel& image = (*shared_levels)[std::min<std::size_t>(
+        level, shared_levels->size() - 1)];
+    for (int row = 0; row < size; row++) {
+      // Wrap, including the negative border coordinates
+      const int source_y =
+          ((y + row) % image.height + image.height) % image.height;
+      for (int column = 0; column < size; column++) {
+        const int source_x =
+            ((x + column) % image.width + image.width) % image.width;
+        const unsigned char* texel =
+            image.pixels.data() +
+            (static_cast<std::size_t>(source_y) * image.width + source_x) * 4;
+        std::copy(texel, texel + 4,
+                  rgba + (static_cast<std::size_t>(row) * size + column) * 4);
+      }
+    }
+  };
+}
@@ -0,0 +1,117 @@
+#ifndef LEARNGL_VIRTUAL_TEXTURE_HPP_
+#define LEARNGL_VIRTUAL_TEXTURE_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "mip_builder.hpp"
+#include "shader_m.hpp"
+
+struct VirtualTextureStats {
+  // Distinct pages the feedback pass asked for in the last frame
+  std::uint64_t requested_pages = 0;
+  std::uint64_t loaded_pages = 0;
+  std::uint64_t evicted_pages = 0;
+};
+
+// Software virtual texturing for textures far larger than GPU memory, on
+// plain GL 4.5 without sparse textures. The virtual texture is split into
+// square pages on every mip level. Resident pages live in one physical cache
+// texture; an integer page table with one texel per page and one mip per
+// virtual level maps pages to cache slots. Shaders walk up the page table
+// until they find a resident page, so missing pages fall back to coarser
+// data; the single page of the coarsest level is always resident.
+//
+// Each frame the scene is also drawn at low resolution into a feedback
+// buffer that records the page every pixel needs. The buffer is read back
+// through pixel buffer objects a frame later, and Update() loads missing
+// pages, coarsest first, replacing the least recently used ones.
+//
+// Sampling shaders declare the uniforms SetUniforms() sets:
+//   usampler2D pageTable; sampler2D pageCache; float virtualSize;
+//   float pageSize; float pageBorder; float cacheSize; int maxLevel;
+//   float lodBias;
+class VirtualTexture {
+ public:
+  // Fills a `size` x `size` block of RGBA8 texels of virtual mip `level`,
+  // starting at texel (x, y) of that level. Blocks include the page border,
+  // so coordinates can lie up to one texel outside the texture. Called from
+  // worker threads.
+  using PageSource = std::function<void(int level, int x, int y, int size,
+                                        unsigned char* rgba)>;
+
+  // `virtual_size` is the width and height of the virtual texture in texels
+  // and must be a power of two multiple of the page size. Page table entries
+  // address at most 256 x 256 cache slots. The feedback buffer is a fraction
+  // of `screen_width` x `screen_height`.
+  VirtualTexture(int virtual_size, int cache_pages_per_side, PageSource source,
+                 int screen_width, int screen_height);
+
+  VirtualTexture(const VirtualTexture&) = delete;
+  VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+  // Bind the page table and cache to the given texture units and set the
+  // sampling uniforms. With `feedback`, the LOD is biased to match the
+  // feedback buffer's resolution.
+  void SetUniforms(const Shader& shader, int page_table_unit, int cache_unit,
+                   bool feedback) const;
+
+  // Render the feedback pass between these two calls. BeginFeedback() binds
+  // and clears the feedback framebuffer and sets the viewport; EndFeedback()
+  // queues the readback and binds the default framebuffer again.
+  void BeginFeedback();
+  void EndFeedback();
+
+  // Consume the previous frame's feedback and load missing pages.
+  void Update();
+
+  int ResidentPages() const;
+  int CachePages() const;
+  const VirtualTextureStats& Stats() const;
+
+ private:
+  struct Slot {
+    std::uint64_t key = 0;
+    std::uint64_t last_used_frame = 0;
+    bool occupied = false;
+    // The coarsest page is never evicted
+    bool pinned = false;
+  };
+
+  int virtual_size_;
+  int pages_per_side_;
+  int level_count_;
+  int cache_pages_per_side_;
+  int cache_size_;
+  PageSource source_;
+
+  unsigned int page_table_ = 0;
+  unsigned int cache_ = 0;
+  unsigned int feedback_fbo_ = 0;
+  unsigned int feedback_texture_ = 0;
+  unsigned int feedback_depth_ = 0;
+  int feedback_width_;
+  int feedback_height_;
+  // Double buffered so the readback of one frame is mapped in the next
+  unsigned int readback_buffers_[2] = {0, 0};
+  bool readback_pending_[2] = {false, false};
+
+  std::uint64_t frame_ = 1;
+  std::vector<Slot> slots_;
+  std::unordered_map<std::uint64_t, int> slots_by_key_;
+  VirtualTextureStats stats_;
+
+  std::vector<std::uint64_t> ReadFeedback(int buffer);
+  void LoadPages(std::vector<std::uint64_t> keys);
+  int FindSlot() const;
+  void WritePageTable(std::uint64_t key, int slot);
+};
+
+// Page source that repeats `levels`, a 4 channel mip chain, across the whole
+// virtual texture. Virtual level N samples level N of the image, or its last
+// level once the chain runs out.
+VirtualTexture::PageSource TiledImageSource(std::vector<MipLevel> levels);
+
+#endif
@@ -0,0 +1,102 @@
+#include "weighted_oit.hpp"
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+#include "gpu_resources.hpp"
+
+namespace {
+
+// Half floats keep the weighted sums of many layers from clipping
+constexpr GLenum kAccumulationFormat = GL_RGBA16F;
+// An 8-bit product of many (1 - alpha) would band
+constexpr GLenum kRevealageFormat = GL_R16F;
+
+unsigned int CreateTarget(GLenum format, int width, int height,
+                          const char* owner) {
+  unsigned int texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+  // Read back texel for texel
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  GpuResources().Track(GpuResourceKind::TEXTURE, texture,
+                       {GpuResourceCategory::FRAMEBUFFER_ATTACHMENT,
+                        TextureBytes(format, width, height), format, owner});
+  return texture;
+}
+
+}  // namespace
+
+WeightedOit::WeightedOit(int width, int height, unsigned int depth_texture)
+    : width_(width), height_(height) {
+  accumulation_ = CreateTarget(kAccumulationFormat, width_, height_,
+                               "OIT accumulation");
+  revealage_ =
+      CreateTarget(kRevealageFormat, width_, height_, "OIT revealage");
+
+  glGenFramebuffers(1, &framebuffer_);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         accumulation_, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D,
+                         revealage_, 0);
+  // Shared with the opaque scene, so hidden surfaces are rejected
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+                         depth_texture, 0);
+  const GLenum draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  glDrawBuffers(2, draw_buffers);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "Unable to complete OIT framebuffer\n";
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  glGenVertexArrays(1, &vao_);
+}
+
+void WeightedOit::Begin() {
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glViewport(0, 0, width_, height_);
+  // Nothing accumulated, everything revealed
+  const float zero[] = {0.0f, 0.0f, 0.0f, 0.0f};
+  const float one[] = {1.0f, 0.0f, 0.0f, 0.0f};
+  glClearBufferfv(GL_COLOR, 0, zero);
+  glClearBufferfv(GL_COLOR, 1, one);
+
+  glEnable(GL_DEPTH_TEST);
+  glDepthMask(GL_FALSE);
+  glEnable(GL_BLEND);
+  glBlendEquation(GL_FUNC_ADD);
+  // Sum the weighted colors, multiply the revealage by (1 - alpha)
+  glBlendFunci(0, GL_ONE, GL_ONE);
+  glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+}
+
+void WeightedOit::Composite(Shader& composite_shader,
+                            unsigned int framebuffer) {
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  // The average color comes out with alpha 1 - revealage
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDisable(GL_DEPTH_TEST);
+
+  composite_shader.Use();
+  composite_shader.SetInt("accumulation", 0);
+  composite_shader.SetInt("revealage", 1);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, accumulation_);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, revealage_);
+
+  glBindVertexArray(vao_);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glEnable(GL_DEPTH_TEST);
+  glDepthMask(GL_TRUE);
+}
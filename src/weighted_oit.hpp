@@ -0,0 +1,49 @@
+#ifndef LEARNGL_WEIGHTED_OIT_HPP_
+#define LEARNGL_WEIGHTED_OIT_HPP_
+
+#include "shader_m.hpp"
+
+// Weighted blended order-independent transparency (McGuire and Bavoil,
+// 2013). Transparent surfaces are drawn in any order into two targets: the
+// sum of their premultiplied colors and alphas, each scaled by a weight
+// that favors near and opaque surfaces, and the product of their (1 -
+// alpha), the revealage. A fullscreen pass divides the color sum by the
+// alpha sum and blends that average over the opaque scene by the
+// revealage. Coverage is exact and one layer comes out exactly; where
+// differently colored layers overlap their colors are blended by weight
+// instead of in depth order. In exchange nothing is sorted.
+//
+// The accumulation pass writes the weighted color to output 0 and the
+// alpha to output 1 (see shaders/17_4_oit_accumulate.fs). It is depth
+// tested against the opaque scene but writes no depth.
+class WeightedOit {
+ public:
+  // Targets of `width` x `height`, depth tested against `depth_texture`,
+  // the opaque scene's depth attachment, of the same size.
+  WeightedOit(int width, int height, unsigned int depth_texture);
+
+  WeightedOit(const WeightedOit&) = delete;
+  WeightedOit& operator=(const WeightedOit&) = delete;
+
+  // Bind and clear the targets and set up blending for the accumulation
+  // pass.
+  void Begin();
+
+  // Blend the accumulated surfaces over `framebuffer`, which holds the
+  // opaque scene, with `composite_shader` (see
+  // shaders/17_4_oit_composite.fs). Leaves `framebuffer` bound with depth
+  // testing and writes on and the samples' usual GL_SRC_ALPHA,
+  // GL_ONE_MINUS_SRC_ALPHA blending.
+  void Composite(Shader& composite_shader, unsigned int framebuffer);
+
+ private:
+  int width_;
+  int height_;
+  unsigned int framebuffer_ = 0;
+  unsigned int accumulation_ = 0;
+  unsigned int revealage_ = 0;
+  // Empty; the composite pass makes its triangle from gl_VertexID
+  unsigned int vao_ = 0;
+};
+
+#endif